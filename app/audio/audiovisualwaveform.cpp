@@ -1,7 +1,11 @@
 #include "audiovisualwaveform.h"
 
 #include <QDebug>
+#include <QFile>
+#include <QSaveFile>
 #include <QtGlobal>
+#include <algorithm>
+#include <cmath>
 
 #include "config/config.h"
 
@@ -10,59 +14,92 @@ namespace olive {
 const rational AudioVisualWaveform::kMinimumSampleRate = rational(1, 8);
 const rational AudioVisualWaveform::kMaximumSampleRate = rational(1024);
 
-AudioVisualWaveform::AudioVisualWaveform() : channels_(0) {
-  for (rational i = kMinimumSampleRate; i <= kMaximumSampleRate; i *= rational(2)) {
-    mipmapped_data_.insert({i, Sample()});
-  }
-}
-
-void AudioVisualWaveform::OverwriteSamplesFromBuffer(const SampleBuffer &samples, int sample_rate,
-                                                     const rational &start, double target_rate, Sample &data,
-                                                     size_t &start_index, size_t &samples_length) {
-  start_index = time_to_samples(start, target_rate);
-  samples_length =
-      time_to_samples(static_cast<double>(samples.sample_count()) / static_cast<double>(sample_rate), target_rate);
+namespace {
+
+const char kPeaksMagic[4] = {'O', 'P', 'K', 'S'};
+const quint32 kPeaksVersion = 1;
+
+// Written in native byte order, peak files are a cache and never leave the machine that made them
+struct PeaksHeader {
+  char magic[4];
+  quint32 version;
+  qint32 channels;
+  qint32 level_count;
+  qint32 length_num;
+  qint32 length_den;
+  qint32 virtual_start_num;
+  qint32 virtual_start_den;
+};
+
+struct PeaksLevel {
+  qint32 rate_num;
+  qint32 rate_den;
+  quint64 count;  // Number of SamplePerChannel entries, each stored as two qint16s
+};
+
+qint16 QuantizePeak(float f) { return qint16(std::lround(std::clamp(f, -1.0f, 1.0f) * 32767.0f)); }
+
+/**
+ * Sets min_val and max_val to the minimum and maximum of a, which must have at least one element
+ */
+void ExpandMinMaxChannel(const float *a, size_t length, float &min_val, float &max_val) {
+  size_t i = 0;
+
+#if defined(OLIVE_PROCESSOR_X86) || defined(OLIVE_PROCESSOR_ARM)
+  if (length >= 8) {
+    // Two independent pairs of accumulators so consecutive iterations don't wait on each other
+    __m128 min0 = _mm_loadu_ps(a);
+    __m128 max0 = min0;
+    __m128 min1 = _mm_loadu_ps(a + 4);
+    __m128 max1 = min1;
+
+    for (i = 8; i + 8 <= length; i += 8) {
+      __m128 cur0 = _mm_loadu_ps(a + i);
+      __m128 cur1 = _mm_loadu_ps(a + i + 4);
+      min0 = _mm_min_ps(min0, cur0);
+      max0 = _mm_max_ps(max0, cur0);
+      min1 = _mm_min_ps(min1, cur1);
+      max1 = _mm_max_ps(max1, cur1);
+    }
 
-  size_t end_index = start_index + samples_length;
-  if (data.size() < end_index) {
-    data.resize(end_index);
-  }
+    // Whatever is left is covered by one last, overlapping, load of the final 8 elements
+    if (i < length) {
+      __m128 cur0 = _mm_loadu_ps(a + length - 8);
+      __m128 cur1 = _mm_loadu_ps(a + length - 4);
+      min0 = _mm_min_ps(min0, cur0);
+      max0 = _mm_max_ps(max0, cur0);
+      min1 = _mm_min_ps(min1, cur1);
+      max1 = _mm_max_ps(max1, cur1);
+    }
 
-  double chunk_size = double(sample_rate) / double(target_rate);
+    min0 = _mm_min_ps(min0, min1);
+    max0 = _mm_max_ps(max0, max1);
 
-  for (size_t i = 0; i < samples_length; i += channels_) {
-    size_t src_start = qRound((double(i) * chunk_size)) / channels_;
-    size_t src_end = qMin(size_t(qRound64((double(i + channels_) * chunk_size))) / channels_, samples.sample_count());
+    // Reduce the four lanes to one
+    min0 = _mm_min_ps(min0, _mm_shuffle_ps(min0, min0, _MM_SHUFFLE(1, 0, 3, 2)));
+    max0 = _mm_max_ps(max0, _mm_shuffle_ps(max0, max0, _MM_SHUFFLE(1, 0, 3, 2)));
+    min0 = _mm_min_ps(min0, _mm_shuffle_ps(min0, min0, _MM_SHUFFLE(2, 3, 0, 1)));
+    max0 = _mm_max_ps(max0, _mm_shuffle_ps(max0, max0, _MM_SHUFFLE(2, 3, 0, 1)));
 
-    Sample summary = SumSamples(samples, src_start, src_end - src_start);
-
-    memcpy(&data[i + start_index], summary.data(), summary.size() * sizeof(SamplePerChannel));
+    _mm_store_ss(&min_val, min0);
+    _mm_store_ss(&max_val, max0);
+    return;
   }
-}
-
-void AudioVisualWaveform::OverwriteSamplesFromMipmap(const AudioVisualWaveform::Sample &input, double input_sample_rate,
-                                                     size_t &input_start, size_t &input_length, const rational &start,
-                                                     double output_rate, AudioVisualWaveform::Sample &output_data) {
-  size_t start_index = time_to_samples(start, output_rate);
-  size_t samples_length =
-      time_to_samples(static_cast<double>(input_length / channels_) / input_sample_rate, output_rate);
+#endif
 
-  size_t end_index = start_index + samples_length;
-  if (output_data.size() < end_index) {
-    output_data.resize(end_index);
+  min_val = max_val = a[0];
+  for (i = 1; i < length; i++) {
+    min_val = std::min(min_val, a[i]);
+    max_val = std::max(max_val, a[i]);
   }
+}
 
-  // We guarantee mipmaps are powers of two so integer division should be perfectly accurate here
-  size_t chunk_size = input_sample_rate / output_rate;
-
-  for (size_t i = 0; i < samples_length; i += channels_) {
-    Sample summary = ReSumSamples(&input[input_start + (i * chunk_size)], chunk_size * channels_, channels_);
+}  // namespace
 
-    memcpy(&output_data[i + start_index], summary.data(), summary.size() * sizeof(SamplePerChannel));
+AudioVisualWaveform::AudioVisualWaveform() : channels_(0) {
+  for (rational i = kMinimumSampleRate; i <= kMaximumSampleRate; i *= rational(2)) {
+    mipmapped_data_.insert({i, Sample()});
   }
-
-  input_start = start_index;
-  input_length = samples_length;
 }
 
 void AudioVisualWaveform::ValidateVirtualStart(const rational &new_start) {
@@ -81,23 +118,95 @@ void AudioVisualWaveform::OverwriteSamples(const SampleBuffer &samples, int samp
 
   ValidateVirtualStart(start);
 
-  // Process the largest mipmap directly for the samples
-  auto current_mipmap = mipmapped_data_.rbegin();
-  size_t input_start, input_length;
-  OverwriteSamplesFromBuffer(samples, sample_rate, start - virtual_start_, current_mipmap->first.toDouble(),
-                             current_mipmap->second, input_start, input_length);
-
-  while (true) {
-    // For each smaller mipmap, we just process from the mipmap before it, making each one
-    // exponentially faster to create
-    auto previous_mipmap = current_mipmap;
-    current_mipmap++;
-    if (current_mipmap == mipmapped_data_.rend()) {
-      break;
+  // Every level is built in one pass over the samples. Each bucket of the highest rate is summarized straight from the
+  // buffer, then folded into a running min/max for each lower level, which is written out once it has covered two
+  // buckets of the level above. Nothing is allocated per bucket.
+  struct Level {
+    Sample *data;
+    size_t start;    // Index of our first bucket in data
+    size_t length;   // Number of entries (buckets * channels) we write
+    size_t written;  // Number of entries written so far
+    int pending;     // Buckets of the level above folded into the accumulator so far
+  };
+
+  std::vector<Level> levels;
+  levels.reserve(mipmapped_data_.size());
+
+  const rational relative_start = start - virtual_start_;
+
+  size_t previous_length = 0;
+  double previous_rate = 0;
+  for (auto it = mipmapped_data_.rbegin(); it != mipmapped_data_.rend(); it++) {
+    double rate = it->first.toDouble();
+
+    Level l;
+    l.data = &it->second;
+    l.start = time_to_samples(relative_start, rate);
+    if (levels.empty()) {
+      l.length = time_to_samples(double(samples.sample_count()) / double(sample_rate), rate);
+    } else {
+      l.length = time_to_samples(double(previous_length / channels_) / previous_rate, rate);
+    }
+    l.written = 0;
+    l.pending = 0;
+
+    if (l.data->size() < l.start + l.length) {
+      l.data->resize(l.start + l.length);
     }
 
-    OverwriteSamplesFromMipmap(previous_mipmap->second, previous_mipmap->first.toDouble(), input_start, input_length,
-                               start - virtual_start_, current_mipmap->first.toDouble(), current_mipmap->second);
+    levels.push_back(l);
+
+    previous_length = l.length;
+    previous_rate = rate;
+  }
+
+  // One accumulator per channel for every level below the highest
+  std::vector<SamplePerChannel> accumulators(levels.size() * channels_);
+
+  const Level &top = levels.front();
+  const double chunk_size = double(sample_rate) / kMaximumSampleRate.toDouble();
+  const int buffer_channels = std::min(channels_, samples.audio_params().channel_count());
+
+  for (size_t i = 0; i < top.length; i += channels_) {
+    size_t src_start = qRound((double(i) * chunk_size)) / channels_;
+    size_t src_end = qMin(size_t(qRound64((double(i + channels_) * chunk_size))) / channels_, samples.sample_count());
+
+    SamplePerChannel *bucket = &(*top.data)[top.start + i];
+    for (int c = 0; c < channels_; c++) {
+      if (c < buffer_channels && src_end > src_start) {
+        ExpandMinMaxChannel(samples.data(c) + src_start, src_end - src_start, bucket[c].min, bucket[c].max);
+      } else {
+        bucket[c] = {0, 0};
+      }
+    }
+
+    // Fold this bucket down through the lower levels for as long as each one completes a bucket of its own
+    const SamplePerChannel *input = bucket;
+    for (size_t j = 1; j < levels.size(); j++) {
+      Level &l = levels[j];
+      SamplePerChannel *acc = &accumulators[j * channels_];
+
+      if (l.pending == 0) {
+        // Lower levels start from silence, like ReSumSamples()
+        std::fill(acc, acc + channels_, SamplePerChannel{0, 0});
+      }
+
+      for (int c = 0; c < channels_; c++) {
+        acc[c].min = std::min(acc[c].min, input[c].min);
+        acc[c].max = std::max(acc[c].max, input[c].max);
+      }
+
+      if (++l.pending < 2 || l.written >= l.length) {
+        break;
+      }
+
+      SamplePerChannel *out = &(*l.data)[l.start + l.written];
+      std::copy(acc, acc + channels_, out);
+      l.written += channels_;
+      l.pending = 0;
+
+      input = out;
+    }
   }
 
   rational sample_length(samples.sample_count(), sample_rate);
@@ -245,6 +354,110 @@ void AudioVisualWaveform::TrimRange(const rational &in, const rational &length)
   Resize(length);
 }
 
+bool AudioVisualWaveform::SavePeaks(const QString &filename) const {
+  QSaveFile f(filename);
+  if (!f.open(QFile::WriteOnly)) {
+    return false;
+  }
+
+  PeaksHeader header;
+  memcpy(header.magic, kPeaksMagic, sizeof(header.magic));
+  header.version = kPeaksVersion;
+  header.channels = channels_;
+  header.level_count = int(mipmapped_data_.size());
+  header.length_num = length_.numerator();
+  header.length_den = length_.denominator();
+  header.virtual_start_num = virtual_start_.numerator();
+  header.virtual_start_den = virtual_start_.denominator();
+
+  bool ok = f.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header);
+
+  for (auto it = mipmapped_data_.cbegin(); ok && it != mipmapped_data_.cend(); it++) {
+    PeaksLevel level = {it->first.numerator(), it->first.denominator(), it->second.size()};
+    ok = f.write(reinterpret_cast<const char *>(&level), sizeof(level)) == sizeof(level);
+  }
+
+  std::vector<qint16> quantized;
+  for (auto it = mipmapped_data_.cbegin(); ok && it != mipmapped_data_.cend(); it++) {
+    quantized.resize(it->second.size() * 2);
+    for (size_t i = 0; i < it->second.size(); i++) {
+      quantized[i * 2] = QuantizePeak(it->second[i].min);
+      quantized[i * 2 + 1] = QuantizePeak(it->second[i].max);
+    }
+
+    qint64 bytes = qint64(quantized.size() * sizeof(qint16));
+    ok = f.write(reinterpret_cast<const char *>(quantized.data()), bytes) == bytes;
+  }
+
+  return ok && f.commit();
+}
+
+bool AudioVisualWaveform::LoadPeaks(const QString &filename) {
+  QFile f(filename);
+  if (!f.open(QFile::ReadOnly) || f.size() < qint64(sizeof(PeaksHeader))) {
+    return false;
+  }
+
+  // Mapped rather than read, so only the pages we convert are ever paged in
+  const uchar *data = f.map(0, f.size());
+  if (!data) {
+    return false;
+  }
+
+  const auto *header = reinterpret_cast<const PeaksHeader *>(data);
+  if (memcmp(header->magic, kPeaksMagic, sizeof(header->magic)) != 0 || header->version != kPeaksVersion ||
+      header->channels <= 0 || header->level_count != int(mipmapped_data_.size()) || header->length_den == 0 ||
+      header->virtual_start_den == 0) {
+    return false;
+  }
+
+  qint64 offset = sizeof(PeaksHeader);
+  if (f.size() < offset + qint64(sizeof(PeaksLevel)) * header->level_count) {
+    return false;
+  }
+
+  const auto *levels = reinterpret_cast<const PeaksLevel *>(data + offset);
+  offset += sizeof(PeaksLevel) * header->level_count;
+
+  // Validate everything before touching our own data
+  auto our_level = mipmapped_data_.cbegin();
+  qint64 expected_size = offset;
+  for (int i = 0; i < header->level_count; i++, our_level++) {
+    if (levels[i].rate_den == 0 || rational(levels[i].rate_num, levels[i].rate_den) != our_level->first ||
+        levels[i].count % header->channels != 0) {
+      return false;
+    }
+
+    // Checked before multiplying, a corrupt count could otherwise wrap around to a plausible size
+    if (levels[i].count > quint64(f.size() - expected_size) / (2 * sizeof(qint16))) {
+      return false;
+    }
+    expected_size += qint64(levels[i].count * 2 * sizeof(qint16));
+  }
+
+  if (f.size() != expected_size) {
+    return false;
+  }
+
+  const auto *peaks = reinterpret_cast<const qint16 *>(data + offset);
+  auto it = mipmapped_data_.begin();
+  for (int i = 0; i < header->level_count; i++, it++) {
+    Sample &s = it->second;
+    s.resize(levels[i].count);
+    for (size_t j = 0; j < s.size(); j++) {
+      s[j].min = float(peaks[j * 2]) / 32767.0f;
+      s[j].max = float(peaks[j * 2 + 1]) / 32767.0f;
+    }
+    peaks += levels[i].count * 2;
+  }
+
+  channels_ = header->channels;
+  length_ = rational(header->length_num, header->length_den);
+  virtual_start_ = rational(header->virtual_start_num, header->virtual_start_den);
+
+  return true;
+}
+
 AudioVisualWaveform::Sample AudioVisualWaveform::GetSummaryFromTime(const rational &start,
                                                                     const rational &length) const {
   // Find mipmap that requires
@@ -270,56 +483,16 @@ AudioVisualWaveform::Sample AudioVisualWaveform::GetSummaryFromTime(const ration
   return AudioVisualWaveform::Sample(channel_count(), {0, 0});
 }
 
-void ExpandMinMaxChannel(const float *a, size_t length, float &min_val, float &max_val) {
-#if defined(Q_PROCESSOR_X86) || defined(Q_PROCESSOR_ARM)
-  // SSE optimized
-
-  // load the first 4 elements of 'a' into min and max (they are 4 * 32 = 128 bits)
-  __m128 max = _mm_loadu_ps(a);
-  __m128 min = _mm_loadu_ps(a);
-
-  // loop over 'a' and compare current elements with min and max 4 by 4.
-  // we need to make sure we don't read out of boundaries should 'a' length be not mod. 4
-  for (size_t i = 4; i < length - 4; i += 4) {
-    __m128 cur = _mm_loadu_ps(a + i);
-    max = _mm_max_ps(max, cur);
-    min = _mm_min_ps(min, cur);
-  }
-  // so we read the last 4 (or less) elements in a safe manner.
-  __m128 cur = _mm_loadu_ps(a + length - 4);
-  max = _mm_max_ps(max, cur);
-  min = _mm_min_ps(min, cur);
-  // this potentially overlaps up to the last 3 elements but it's not an issue.
-
-  // min and max will contain 4 min and max. To get the absolute min and max
-  // we need to compare the 4 values over themselves by shuffling each time.
-  for (size_t i = 0; i < 3; i++) {
-    max = _mm_max_ps(max, _mm_shuffle_ps(max, max, 0x93));
-    min = _mm_min_ps(min, _mm_shuffle_ps(min, min, 0x93));
-  }
-  // now min and max contain 4 identical items each representing min and max value respectively.
-
-  // and we store the first one into a float variable.
-  _mm_store_ss(&max_val, max);
-  _mm_store_ss(&min_val, min);
-  // I bet you don't find annotated low level code very often.
-#else
-  // Standard unoptimized function
-  for (size_t i = 0; i < length; i++) {
-    min_val = std::min(min_val, a[i]);
-    max_val = std::max(max_val, a[i]);
-  }
-#endif
-}
-
 AudioVisualWaveform::Sample AudioVisualWaveform::SumSamples(const SampleBuffer &samples, size_t start_index,
                                                             size_t length) {
   int channels = samples.audio_params().channel_count();
   AudioVisualWaveform::Sample summed_samples(channels);
 
-  for (int channel = 0; channel < samples.audio_params().channel_count(); channel++) {
-    ExpandMinMaxChannel(samples.data(channel) + start_index, length, summed_samples[channel].min,
-                        summed_samples[channel].max);
+  if (length) {
+    for (int channel = 0; channel < samples.audio_params().channel_count(); channel++) {
+      ExpandMinMaxChannel(samples.data(channel) + start_index, length, summed_samples[channel].min,
+                          summed_samples[channel].max);
+    }
   }
 
   // for reference: this approximation is n x faster (and less accurate) for a n-tracks clip
@@ -64,6 +64,7 @@ class AudioVisualWaveform {
    *
    * 从指定的 `start` 时间点开始，用新的样本数据覆盖缓冲区中的任何现有数据。
    * 如果需要，会自动扩展缓冲区以容纳新的样本。
+   * 所有 mipmap 级别在一次遍历中生成，结果直接写入各级别的数组，不为每个区间分配内存。
    * @param samples 包含原始音频样本的 SampleBuffer 对象。
    * @param sample_rate 原始音频样本的采样率。
    * @param start 波形中开始写入样本的时间点，默认为0。
@@ -131,6 +132,18 @@ class AudioVisualWaveform {
    */
   [[nodiscard]] Sample GetSummaryFromTime(const rational &start, const rational &length) const;
 
+  /**
+   * @brief 将所有 mipmap 级别写入紧凑的峰值文件 (每个最小值/最大值量化为 16 位整数)。
+   * @return 如果文件无法写入，则返回 false。
+   */
+  bool SavePeaks(const QString &filename) const;
+
+  /**
+   * @brief 通过内存映射读取 SavePeaks() 写入的峰值文件，替换当前的所有数据。
+   * @return 如果文件不存在或格式不正确，则返回 false，此时波形保持不变。
+   */
+  bool LoadPeaks(const QString &filename);
+
   /**
    * @brief 根据给定的原始音频样本数据计算摘要信息（最小/最大值）。
    * @param samples 包含原始音频样本的 SampleBuffer。
@@ -182,32 +195,6 @@ class AudioVisualWaveform {
   static const rational kMaximumSampleRate;
 
  private:
-  /**
-   * @brief 从 SampleBuffer 覆盖样本数据到内部数据结构。
-   * @param samples 输入的 SampleBuffer。
-   * @param sample_rate 输入样本的采样率。
-   * @param start 在此波形中开始写入的时间点。
-   * @param target_rate 目标 mipmap 级别的采样率。
-   * @param data 目标 mipmap 级别的样本数据容器（输出）。
-   * @param start_index 处理的起始索引（输出）。
-   * @param samples_length 处理的样本长度（输出）。
-   */
-  void OverwriteSamplesFromBuffer(const SampleBuffer &samples, int sample_rate, const rational &start,
-                                  double target_rate, Sample &data, size_t &start_index, size_t &samples_length);
-
-  /**
-   * @brief 从一个已存在的 mipmap 级别覆盖样本数据到另一个 mipmap 级别。
-   * @param input 输入的 mipmap 样本数据。
-   * @param input_sample_rate 输入 mipmap 的采样率。
-   * @param input_start 输入 mipmap 中开始读取的索引（引用，会被修改）。
-   * @param input_length 从输入 mipmap 读取的长度（引用，会被修改）。
-   * @param start 在输出 mipmap 中开始写入的时间点。
-   * @param output_rate 输出 mipmap 的目标采样率。
-   * @param output_data 输出 mipmap 的样本数据容器（输出）。
-   */
-  void OverwriteSamplesFromMipmap(const Sample &input, double input_sample_rate, size_t &input_start,
-                                  size_t &input_length, const rational &start, double output_rate, Sample &output_data);
-
   /**
    * @brief 将时间点转换为相对于给定采样率的样本索引。
    * @param time 要转换的时间点 (rational 类型)。
@@ -1,7 +1,502 @@
 #include "cliexportmanager.h"
 
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QQueue>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "cli/clitask/clitaskdialog.h"
+#include "core.h"
+#include "node/color/colormanager/colormanager.h"
+#include "node/project.h"
+#include "node/project/sequence/sequence.h"
+#include "task/project/load/load.h"
+
 namespace olive {
 
-CLIExportManager::CLIExportManager() = default;
+const int CLIExportManager::kChunksPerWorker = 4;
+
+namespace {
+
+QString FFmpegErrorString(int error_code) {
+  char err[AV_ERROR_MAX_STRING_SIZE];
+  av_strerror(error_code, err, sizeof(err));
+  return QString::fromUtf8(err);
+}
+
+QString RangeToString(const TimeRange &range) {
+  return QStringLiteral("%1:%2").arg(QString::fromStdString(range.in().toString()),
+                                     QString::fromStdString(range.out().toString()));
+}
+
+}  // namespace
+
+CLIExportManager::CLIExportManager(QString project, QString preset)
+    : project_(std::move(project)), preset_(std::move(preset)), workers_(1), has_range_(false), streams_(kAllStreams) {}
+
+bool CLIExportManager::Run() {
+  if (project_.isEmpty()) {
+    qCritical().noquote() << tr("You must specify a project file to export");
+    return false;
+  }
+
+  if (!QFileInfo::exists(project_)) {
+    qCritical().noquote() << tr("Specified project does not exist");
+    return false;
+  }
+
+  if (preset_.isEmpty()) {
+    qCritical().noquote() << tr("You must specify an export preset with --preset");
+    return false;
+  }
+
+  EncodingParams params;
+  QFile preset_file(preset_);
+  if (!preset_file.open(QFile::ReadOnly) || !params.Load(&preset_file)) {
+    qCritical().noquote() << tr("Failed to load export preset: %1").arg(preset_);
+    return false;
+  }
+  preset_file.close();
+
+  if (!output_.isEmpty()) {
+    params.SetFilename(output_);
+  }
+
+  if (params.filename().isEmpty()) {
+    qCritical().noquote() << tr("No output file specified, set one with --output");
+    return false;
+  }
+
+  // Start a load task and try running it
+  ProjectLoadTask load_task(project_);
+  CLITaskDialog load_dialog(&load_task);
+  if (!load_dialog.Run()) {
+    qCritical().noquote() << tr("Project failed to load: %1").arg(load_task.GetError());
+    return false;
+  }
+
+  std::unique_ptr<Project> project(load_task.GetLoadedProject());
+
+  Sequence *sequence = nullptr;
+  foreach (Sequence *s, project->root()->ListChildrenOfType<Sequence>()) {
+    if (sequence_.isEmpty() || s->GetLabel() == sequence_) {
+      sequence = s;
+      break;
+    }
+  }
+
+  if (!sequence) {
+    if (sequence_.isEmpty()) {
+      qCritical().noquote() << tr("Project contains no sequences, nothing to export");
+    } else {
+      qCritical().noquote() << tr("Project contains no sequence named \"%1\"").arg(sequence_);
+    }
+    return false;
+  }
+
+  if (has_range_) {
+    params.set_custom_range(range_);
+  }
+
+  switch (streams_) {
+    case kAllStreams:
+      break;
+    case kVideoOnly:
+      params.DisableAudio();
+      params.DisableSubtitles();
+      break;
+    case kAudioOnly:
+      params.DisableVideo();
+      params.DisableSubtitles();
+      break;
+  }
+
+  if (workers_ > 1 && !has_range_) {
+    return RunFarm(sequence, params);
+  } else {
+    return RunLocal(sequence, params);
+  }
+}
+
+bool CLIExportManager::RunLocal(Sequence *sequence, EncodingParams params) {
+  ExportTask export_task(sequence, sequence->project()->color_manager(), params);
+  CLITaskDialog export_dialog(&export_task);
+
+  if (export_dialog.Run()) {
+    qInfo().noquote() << tr("Export succeeded");
+    return true;
+  } else {
+    qCritical().noquote() << tr("Export failed: %1").arg(export_task.GetError());
+    return false;
+  }
+}
+
+bool CLIExportManager::RunFarm(Sequence *sequence, EncodingParams params) {
+  // Chunks are joined by remuxing, which only works for a single FFmpeg container with every stream accounted for
+  if (!params.video_enabled() || params.video_is_image_sequence() || params.subtitles_enabled() ||
+      Encoder::GetTypeFromFormat(params.format()) != Encoder::kEncoderTypeFFmpeg) {
+    qInfo().noquote() << tr("This export can't be split between processes, exporting in a single process");
+    return RunLocal(sequence, params);
+  }
+
+  TimeRange range = params.has_custom_range() ? params.custom_range() : TimeRange(rational(0), sequence->GetLength());
+  rational timebase = params.video_params().frame_rate_as_time_base();
+
+  int64_t first_frame = Timecode::time_to_timestamp(range.in(), timebase, Timecode::kFloor);
+  int64_t last_frame = Timecode::time_to_timestamp(range.out(), timebase, Timecode::kCeil);
+
+  // Every chunk starts a new encoder and therefore a keyframe, so chunk lengths are kept to whole GOPs of a fixed
+  // size, by default one second
+  int64_t gop = params.video_option(QStringLiteral("ove_gop")).toLongLong();
+  if (gop <= 0) {
+    gop = std::max(1, qRound(params.video_params().frame_rate().toDouble()));
+  }
+  params.set_video_option(QStringLiteral("ove_gop"), QString::number(gop));
+
+  int64_t gop_count = (last_frame - first_frame + gop - 1) / gop;
+  int64_t chunk_count = std::clamp(int64_t(workers_) * kChunksPerWorker, int64_t(1), std::max(gop_count, int64_t(1)));
+
+  // Keep intermediate files next to the output so they're on the same disk and the final rename is cheap
+  QFileInfo output_info(params.filename());
+  QTemporaryDir temp(output_info.dir().filePath(QStringLiteral(".olive-export-XXXXXX")));
+  if (!temp.isValid()) {
+    qCritical().noquote() << tr("Failed to create temporary directory: %1").arg(temp.errorString());
+    return false;
+  }
+
+  // Workers load this copy of the preset, which carries the fixed GOP size
+  QString worker_preset = temp.filePath(QStringLiteral("preset.xml"));
+  {
+    QFile f(worker_preset);
+    if (!f.open(QFile::WriteOnly)) {
+      qCritical().noquote() << tr("Failed to write %1").arg(worker_preset);
+      return false;
+    }
+    params.Save(&f);
+  }
+
+  QString ext = output_info.suffix();
+  auto worker_args = [&](const QString &output, const TimeRange &r, const QString &streams) {
+    QStringList args;
+    args << QStringLiteral("--export") << QStringLiteral("--preset") << worker_preset << QStringLiteral("--output")
+         << output << QStringLiteral("--sequence") << sequence->GetLabel() << QStringLiteral("--export-range")
+         << RangeToString(r) << QStringLiteral("--export-streams") << streams << project_;
+    return args;
+  };
+
+  QQueue<QStringList> jobs;
+
+  // Audio is one serial pass over the whole range, queue it first so it overlaps with the video chunks
+  QString audio_file;
+  if (params.audio_enabled()) {
+    audio_file = temp.filePath(QStringLiteral("audio.%1").arg(ext));
+    jobs.enqueue(worker_args(audio_file, range, QStringLiteral("audio")));
+  }
+
+  QStringList chunks;
+  for (int64_t i = 0; i < chunk_count; i++) {
+    int64_t start = first_frame + gop_count * i / chunk_count * gop;
+    int64_t end = std::min(last_frame, first_frame + gop_count * (i + 1) / chunk_count * gop);
+
+    TimeRange r((i == 0) ? range.in() : Timecode::timestamp_to_time(start, timebase),
+                (i == chunk_count - 1) ? range.out() : Timecode::timestamp_to_time(end, timebase));
+
+    QString chunk = temp.filePath(QStringLiteral("chunk%1.%2").arg(i, 6, 10, QChar('0')).arg(ext));
+    chunks.append(chunk);
+    jobs.enqueue(worker_args(chunk, r, QStringLiteral("video")));
+  }
+
+  qInfo().noquote() << tr("Exporting %n chunk(s) with %1 worker processes", nullptr, int(chunk_count)).arg(workers_);
+
+  QEventLoop loop;
+  QVector<QProcess *> running;
+  int job_count = jobs.size();
+  int finished_count = 0;
+  bool failed = false;
+
+  std::function<void()> start_jobs = [&] {
+    while (!failed && running.size() < workers_ && !jobs.isEmpty()) {
+      QProcess *process = StartWorker(jobs.dequeue());
+
+      if (!process->waitForStarted()) {
+        qCritical().noquote() << tr("Failed to start worker process: %1").arg(process->errorString());
+        delete process;
+        failed = true;
+        break;
+      }
+
+      running.append(process);
+
+      connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), &loop,
+              [&, process](int exit_code, QProcess::ExitStatus status) {
+                running.removeOne(process);
+                process->deleteLater();
+
+                if (status != QProcess::NormalExit || exit_code != 0) {
+                  if (!failed) {
+                    qCritical().noquote() << tr("A worker process failed, stopping export");
+                    failed = true;
+                    foreach (QProcess *p, running) {
+                      p->kill();
+                    }
+                  }
+                } else {
+                  finished_count++;
+                  qInfo().noquote() << tr("Finished %1 of %2 jobs").arg(finished_count).arg(job_count);
+                }
+
+                start_jobs();
+
+                if (running.isEmpty()) {
+                  loop.quit();
+                }
+              });
+    }
+  };
+
+  start_jobs();
+
+  if (!running.isEmpty()) {
+    loop.exec();
+  }
+
+  if (failed) {
+    return false;
+  }
+
+  // Join into a temporary file first so an existing output is only replaced once everything succeeded
+  QString joined = temp.filePath(QStringLiteral("output.%1").arg(ext));
+  if (!Concatenate(chunks, audio_file, joined)) {
+    return false;
+  }
+
+  if (output_info.exists() && !QFile::remove(output_info.filePath())) {
+    qCritical().noquote() << tr("Failed to overwrite %1").arg(output_info.filePath());
+    return false;
+  }
+
+  if (!QFile::rename(joined, output_info.filePath())) {
+    qCritical().noquote() << tr("Failed to move export to %1").arg(output_info.filePath());
+    return false;
+  }
+
+  qInfo().noquote() << tr("Export succeeded");
+  return true;
+}
+
+QProcess *CLIExportManager::StartWorker(const QStringList &args) {
+  auto *process = new QProcess(this);
+
+  // Workers print their own progress, only let their errors through
+  process->setStandardOutputFile(QProcess::nullDevice());
+  process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+  QStringList a = args;
+  if (Core::instance()->core_params().software_render()) {
+    a.prepend(QStringLiteral("--software-render"));
+  }
+
+  process->start(QCoreApplication::applicationFilePath(), a);
+
+  return process;
+}
+
+bool CLIExportManager::Concatenate(const QStringList &chunks, const QString &audio, const QString &output) {
+  QString list_filename = QFileInfo(output).dir().filePath(QStringLiteral("chunks.txt"));
+  {
+    QFile list(list_filename);
+    if (!list.open(QFile::WriteOnly)) {
+      qCritical().noquote() << tr("Failed to write %1").arg(list_filename);
+      return false;
+    }
+
+    foreach (QString chunk, chunks) {
+      // The concat demuxer's list syntax quotes with ' and escapes it as '\''
+      chunk.replace(QStringLiteral("'"), QStringLiteral("'\\''"));
+      list.write(QStringLiteral("file '%1'\n").arg(chunk).toUtf8());
+    }
+  }
+
+  QVector<AVFormatContext *> inputs;
+  AVFormatContext *out_ctx = nullptr;
+  QVector<QVector<int> > stream_map;
+  bool success = false;
+  int r;
+
+  auto cleanup = [&] {
+    if (out_ctx) {
+      if (out_ctx->pb) {
+        avio_closep(&out_ctx->pb);
+      }
+      avformat_free_context(out_ctx);
+    }
+    for (AVFormatContext *ctx : inputs) {
+      avformat_close_input(&ctx);
+    }
+  };
+
+  // Open the chunk list and the separate audio file
+  {
+    AVFormatContext *ctx = nullptr;
+    AVDictionary *opts = nullptr;
+    av_dict_set(&opts, "safe", "0", 0);
+    r = avformat_open_input(&ctx, list_filename.toUtf8().constData(), av_find_input_format("concat"), &opts);
+    av_dict_free(&opts);
+    if (r < 0) {
+      qCritical().noquote() << tr("Failed to open chunks: %1").arg(FFmpegErrorString(r));
+      cleanup();
+      return false;
+    }
+    inputs.append(ctx);
+  }
+
+  if (!audio.isEmpty()) {
+    AVFormatContext *ctx = nullptr;
+    r = avformat_open_input(&ctx, audio.toUtf8().constData(), nullptr, nullptr);
+    if (r < 0) {
+      qCritical().noquote() << tr("Failed to open audio: %1").arg(FFmpegErrorString(r));
+      cleanup();
+      return false;
+    }
+    inputs.append(ctx);
+  }
+
+  r = avformat_alloc_output_context2(&out_ctx, nullptr, nullptr, output.toUtf8().constData());
+  if (r < 0) {
+    qCritical().noquote() << tr("Failed to allocate output context: %1").arg(FFmpegErrorString(r));
+    cleanup();
+    return false;
+  }
+
+  // Copy every stream as-is
+  stream_map.resize(inputs.size());
+  for (int i = 0; i < inputs.size(); i++) {
+    AVFormatContext *in_ctx = inputs.at(i);
+
+    r = avformat_find_stream_info(in_ctx, nullptr);
+    if (r < 0) {
+      qCritical().noquote() << tr("Failed to read stream info: %1").arg(FFmpegErrorString(r));
+      cleanup();
+      return false;
+    }
+
+    stream_map[i].fill(-1, int(in_ctx->nb_streams));
+    for (unsigned int j = 0; j < in_ctx->nb_streams; j++) {
+      AVStream *in_stream = in_ctx->streams[j];
+      AVStream *out_stream = avformat_new_stream(out_ctx, nullptr);
+      if (!out_stream || avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar) < 0) {
+        qCritical().noquote() << tr("Failed to create output stream");
+        cleanup();
+        return false;
+      }
+      out_stream->codecpar->codec_tag = 0;
+      out_stream->time_base = in_stream->time_base;
+      stream_map[i][j] = out_stream->index;
+    }
+  }
+
+  if (!(out_ctx->oformat->flags & AVFMT_NOFILE)) {
+    r = avio_open(&out_ctx->pb, output.toUtf8().constData(), AVIO_FLAG_WRITE);
+    if (r < 0) {
+      qCritical().noquote() << tr("Failed to open output file: %1").arg(FFmpegErrorString(r));
+      cleanup();
+      return false;
+    }
+  }
+
+  r = avformat_write_header(out_ctx, nullptr);
+  if (r < 0) {
+    qCritical().noquote() << tr("Failed to write header: %1").arg(FFmpegErrorString(r));
+    cleanup();
+    return false;
+  }
+
+  // Read the inputs in step by timestamp so the muxer's interleaving queue stays short
+  QVector<AVPacket *> pending(inputs.size(), nullptr);
+  QVector<bool> ended(inputs.size(), false);
+  success = true;
+
+  forever {
+    int next = -1;
+    for (int i = 0; i < inputs.size(); i++) {
+      if (!pending.at(i) && !ended.at(i)) {
+        AVPacket *p = av_packet_alloc();
+        if (av_read_frame(inputs.at(i), p) < 0) {
+          av_packet_free(&p);
+          ended[i] = true;
+        } else {
+          pending[i] = p;
+        }
+      }
+
+      if (pending.at(i)) {
+        if (next == -1) {
+          next = i;
+        } else {
+          AVPacket *a = pending.at(i);
+          AVPacket *b = pending.at(next);
+          if (av_compare_ts(a->dts, inputs.at(i)->streams[a->stream_index]->time_base, b->dts,
+                            inputs.at(next)->streams[b->stream_index]->time_base) < 0) {
+            next = i;
+          }
+        }
+      }
+    }
+
+    if (next == -1) {
+      break;
+    }
+
+    AVPacket *p = pending.at(next);
+    pending[next] = nullptr;
+
+    int out_index = stream_map.at(next).value(p->stream_index, -1);
+    if (out_index >= 0) {
+      av_packet_rescale_ts(p, inputs.at(next)->streams[p->stream_index]->time_base,
+                           out_ctx->streams[out_index]->time_base);
+      p->stream_index = out_index;
+      p->pos = -1;
+
+      r = av_interleaved_write_frame(out_ctx, p);
+      if (r < 0) {
+        qCritical().noquote() << tr("Failed to write packet: %1").arg(FFmpegErrorString(r));
+        success = false;
+      }
+    }
+
+    av_packet_free(&p);
+
+    if (!success) {
+      break;
+    }
+  }
+
+  for (AVPacket *p : pending) {
+    av_packet_free(&p);
+  }
+
+  if (success) {
+    r = av_write_trailer(out_ctx);
+    if (r < 0) {
+      qCritical().noquote() << tr("Failed to write trailer: %1").arg(FFmpegErrorString(r));
+      success = false;
+    }
+  }
+
+  cleanup();
+
+  return success;
+}
 
 }  // namespace olive
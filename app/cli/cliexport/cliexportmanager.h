@@ -1,34 +1,100 @@
 #ifndef CLIEXPORTMANAGER_H
 #define CLIEXPORTMANAGER_H
 
-#include "task/export/export.h"  // 假设 Export 类定义在此
+#include <QProcess>  // 工作进程
+
+#include "task/export/export.h"
 
 namespace olive {
 
+class Sequence;
+
 /**
  * @brief 管理命令行界面 (CLI) 导出操作的类。
  *
- * 此类负责处理通过命令行启动的导出任务的逻辑和流程。
- * 它通常会与导出任务 (Export) 类交互，以执行实际的导出工作。
- * 作为 QObject 的子类，它可以利用 Qt 的信号和槽机制。
+ * 读取项目和导出预设，在当前进程中导出整个序列，或者作为渲染农场把导出范围按 GOP 切分成若干区段，
+ * 交给多个本机工作进程 (以 --export-range 重新启动的本程序) 各自用独立的渲染管线编码。
+ * 视频区段全部完成后用 FFmpeg 的 concat 分离器无损拼接，音频则由一个单独的工作进程一次性导出并在拼接时混入。
+ *
+ * 每个区段由一个新的编码器编码，因此都从关键帧开始，拼接不需要重新编码。编码器的 GOP 长度被固定 (默认一秒)，
+ * 除最后一个区段外每个区段的长度都是 GOP 的整数倍，所以关键帧的位置与单进程导出相同。
+ * 图像序列、内嵌字幕和非 FFmpeg 格式无法这样拼接，此时退回单进程导出。
  */
 class CLIExportManager : public QObject {
- Q_OBJECT  // Qt元对象系统宏，如果需要信号槽等特性
-     public :
-     /**
-      * @brief 构造一个新的 CLIExportManager 对象。
-      */
-     CLIExportManager();
-
-  // 根据实际的功能，这里可能会有更多的方法，例如：
-  // - 初始化导出参数的方法
-  // - 开始导出过程的方法
-  // - 处理导出状态和进度的方法
-  // - 清理资源的方法
-  // 由于当前代码中只有构造函数，所以只注释构造函数。
-  // 如果未来添加其他成员（方法、变量、信号等），我会为它们添加相应的注释。
+  Q_OBJECT
+ public:
+  /**
+   * @brief 工作进程导出的流。
+   */
+  enum Streams {
+    kAllStreams,  // 预设中启用的所有流
+    kVideoOnly,   // 只导出视频 (渲染农场的区段)
+    kAudioOnly    // 只导出音频 (渲染农场的音频轨)
+  };
+
+  CLIExportManager(QString project, QString preset);
+
+  /**
+   * @brief 覆盖预设中的输出文件名。
+   */
+  void set_output(const QString &output) { output_ = output; }
+
+  /**
+   * @brief 要导出的序列名称，为空时导出项目中的第一个序列。
+   */
+  void set_sequence(const QString &sequence) { sequence_ = sequence; }
+
+  /**
+   * @brief 工作进程数量，不大于 1 时在当前进程中导出。
+   */
+  void set_workers(int workers) { workers_ = workers; }
+
+  /**
+   * @brief 只导出此范围 (工作进程使用)，覆盖预设中的范围。
+   */
+  void set_range(const TimeRange &range) {
+    range_ = range;
+    has_range_ = true;
+  }
+
+  void set_streams(Streams streams) { streams_ = streams; }
+
+  /**
+   * @brief 读取项目和预设并执行导出，返回前阻塞。
+   * @return 导出是否成功。
+   */
+  bool Run();
+
+  static const int kChunksPerWorker;  // 每个工作进程平均分到的区段数，区段越多负载越均衡
+
+ private:
+  bool RunLocal(Sequence *sequence, EncodingParams params);
+
+  bool RunFarm(Sequence *sequence, EncodingParams params);
+
+  /**
+   * @brief 以当前的启动参数加上 args 启动一个工作进程。
+   */
+  QProcess *StartWorker(const QStringList &args);
+
+  /**
+   * @brief 用 concat 分离器把 chunks 无损拼接到 output，如果 audio 不为空则同时混入其中的音频流。
+   */
+  static bool Concatenate(const QStringList &chunks, const QString &audio, const QString &output);
+
+  QString project_;   // 项目文件
+  QString preset_;    // 导出预设文件
+  QString output_;    // 覆盖预设的输出文件名
+  QString sequence_;  // 要导出的序列名称
+
+  int workers_;  // 工作进程数量
+
+  TimeRange range_;  // 覆盖预设的导出范围
+  bool has_range_;   // range_ 是否有效
+
+  Streams streams_;  // 要导出的流
 };
 
 }  // namespace olive
 
-#endif  // CLIEXPORTMANAGER_H
\ No newline at end of file
+#endif  // CLIEXPORTMANAGER_H
@@ -0,0 +1,181 @@
+#include "boxdownsampler.h"
+
+#include <Imath/half.h>
+
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <olive/core/util/cpuoptimize.h>
+
+namespace olive {
+
+namespace {
+
+template <typename T>
+void AccumulateRow(float *acc, const T *src, int count) {
+  for (int i = 0; i < count; i++) {
+    acc[i] += float(src[i]);
+  }
+}
+
+#if defined(OLIVE_PROCESSOR_X86) || defined(OLIVE_PROCESSOR_ARM)
+template <>
+void AccumulateRow(float *acc, const uint8_t *src, int count) {
+  const __m128i zero = _mm_setzero_si128();
+
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    // Widen 16 bytes to four vectors of 32-bit floats
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+
+    _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero))));
+    _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero))));
+    _mm_storeu_ps(acc + i + 8, _mm_add_ps(_mm_loadu_ps(acc + i + 8), _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero))));
+    _mm_storeu_ps(acc + i + 12, _mm_add_ps(_mm_loadu_ps(acc + i + 12), _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero))));
+  }
+
+  for (; i < count; i++) {
+    acc[i] += float(src[i]);
+  }
+}
+
+template <>
+void AccumulateRow(float *acc, const uint16_t *src, int count) {
+  const __m128i zero = _mm_setzero_si128();
+
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+
+    _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero))));
+    _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero))));
+  }
+
+  for (; i < count; i++) {
+    acc[i] += float(src[i]);
+  }
+}
+
+template <>
+void AccumulateRow(float *acc, const float *src, int count) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_loadu_ps(src + i)));
+  }
+
+  for (; i < count; i++) {
+    acc[i] += src[i];
+  }
+}
+#endif
+
+template <typename T>
+T FromAverage(float f) {
+  return T(f);
+}
+
+template <>
+uint8_t FromAverage(float f) {
+  return uint8_t(std::min(f + 0.5f, 255.0f));
+}
+
+template <>
+uint16_t FromAverage(float f) {
+  return uint16_t(std::min(f + 0.5f, 65535.0f));
+}
+
+}  // namespace
+
+BoxDownsampler::BoxDownsampler(int src_width, int src_height, Frame *dst)
+    : src_width_(src_width), src_height_(src_height), dst_(dst) {
+  int dst_width = dst_->width();
+
+  columns_.resize(dst_width + 1);
+  for (int x = 0; x <= dst_width; x++) {
+    columns_[x] = int(qint64(x) * src_width_ / dst_width);
+  }
+}
+
+int BoxDownsampler::SourceRowBegin(int dst_y) const { return int(qint64(dst_y) * src_height_ / dst_->height()); }
+
+int BoxDownsampler::SourceRowEnd(int dst_y) const {
+  return std::max(SourceRowBegin(dst_y) + 1, int(qint64(dst_y + 1) * src_height_ / dst_->height()));
+}
+
+void BoxDownsampler::Process(const char *src, int src_linesize, int src_y, int dst_begin, int dst_end) const {
+  switch (static_cast<PixelFormat::Format>(dst_->format())) {
+    case PixelFormat::U8:
+      ProcessInternal<uint8_t>(src, src_linesize, src_y, dst_begin, dst_end);
+      break;
+    case PixelFormat::U16:
+      ProcessInternal<uint16_t>(src, src_linesize, src_y, dst_begin, dst_end);
+      break;
+    case PixelFormat::F16:
+      ProcessInternal<Imath::half>(src, src_linesize, src_y, dst_begin, dst_end);
+      break;
+    case PixelFormat::F32:
+      ProcessInternal<float>(src, src_linesize, src_y, dst_begin, dst_end);
+      break;
+    case PixelFormat::INVALID:
+    case PixelFormat::COUNT:
+      break;
+  }
+}
+
+template <typename T>
+void BoxDownsampler::ProcessInternal(const char *src, int src_linesize, int src_y, int dst_begin,
+                                     int dst_end) const {
+  int channels = dst_->channel_count();
+  int row_values = src_width_ * channels;
+  int dst_width = dst_->width();
+
+  auto process_rows = [&](const QPair<int, int> &rows) {
+    // Sum the source rows vertically first so the inner loop runs over contiguous memory, then average across
+    // each destination pixel's columns
+    std::vector<float> acc(row_values);
+
+    for (int y = rows.first; y < rows.second; y++) {
+      int row_begin = SourceRowBegin(y);
+      int row_end = SourceRowEnd(y);
+
+      std::fill(acc.begin(), acc.end(), 0.0f);
+      for (int sy = row_begin; sy < row_end; sy++) {
+        AccumulateRow(acc.data(), reinterpret_cast<const T *>(src + qint64(sy - src_y) * src_linesize), row_values);
+      }
+
+      T *out = reinterpret_cast<T *>(dst_->data() + qint64(y) * dst_->linesize_bytes());
+
+      for (int x = 0; x < dst_width; x++) {
+        int col_begin = columns_[x];
+        int col_end = std::max(col_begin + 1, columns_[x + 1]);
+        float inv_area = 1.0f / float((row_end - row_begin) * (col_end - col_begin));
+
+        for (int c = 0; c < channels; c++) {
+          float sum = 0.0f;
+          for (int sx = col_begin; sx < col_end; sx++) {
+            sum += acc[sx * channels + c];
+          }
+          out[x * channels + c] = FromAverage<T>(sum * inv_area);
+        }
+      }
+    }
+  };
+
+  int row_count = dst_end - dst_begin;
+  int chunk_count = std::min(row_count, QThread::idealThreadCount() * 4);
+
+  if (chunk_count <= 1) {
+    process_rows({dst_begin, dst_end});
+    return;
+  }
+
+  QVector<QPair<int, int> > chunks(chunk_count);
+  for (int i = 0; i < chunk_count; i++) {
+    chunks[i] = {dst_begin + row_count * i / chunk_count, dst_begin + row_count * (i + 1) / chunk_count};
+  }
+
+  QtConcurrent::blockingMap(chunks, process_rows);
+}
+
+}  // namespace olive
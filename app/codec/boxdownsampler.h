@@ -0,0 +1,54 @@
+#ifndef BOXDOWNSAMPLER_H
+#define BOXDOWNSAMPLER_H
+
+#include <vector>  // 每个目标列对应的源列范围
+
+#include "codec/frame.h"
+
+namespace olive {
+
+/**
+ * @brief 用盒式滤波把图像缩小到目标帧的尺寸。
+ *
+ * 每个目标像素是它覆盖的源像素矩形的平均值，比最近邻采样少了混叠，比通用的重采样快得多。
+ * 源图像可以分条带输入 (Process() 的 src_y)，这样解码器不需要先把整幅全分辨率图像读进内存。
+ * 行的累加使用 SIMD，条带内的目标行在全局线程池中并行处理。
+ *
+ * 源图像和目标帧的像素格式、通道数必须相同。
+ */
+class BoxDownsampler {
+ public:
+  BoxDownsampler(int src_width, int src_height, Frame *dst);
+
+  /**
+   * @brief 目标行 dst_y 需要的第一个源行。
+   */
+  [[nodiscard]] int SourceRowBegin(int dst_y) const;
+
+  /**
+   * @brief 目标行 dst_y 需要的最后一个源行之后的行。
+   */
+  [[nodiscard]] int SourceRowEnd(int dst_y) const;
+
+  /**
+   * @brief 计算目标行 [dst_begin, dst_end)。
+   * @param src 源图像条带，第一行是源图像的第 src_y 行，必须包含这些目标行需要的所有源行。
+   * @param src_linesize 源条带每行的字节数。
+   */
+  void Process(const char *src, int src_linesize, int src_y, int dst_begin, int dst_end) const;
+
+ private:
+  template <typename T>
+  void ProcessInternal(const char *src, int src_linesize, int src_y, int dst_begin, int dst_end) const;
+
+  int src_width_;   // 源图像宽度
+  int src_height_;  // 源图像高度
+
+  Frame *dst_;  // 目标帧
+
+  std::vector<int> columns_;  // 目标列 x 覆盖源列 [columns_[x], columns_[x + 1])
+};
+
+}  // namespace olive
+
+#endif  // BOXDOWNSAMPLER_H
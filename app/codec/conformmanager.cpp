@@ -1,13 +1,25 @@
 #include "conformmanager.h"
 
+#include <QDebug>
 #include <QDir>
 
+#include "codec/conformmapcache.h"
 #include "task/taskmanager.h"
 
 namespace olive {
 
 ConformManager *ConformManager::instance_ = nullptr;
 
+const int ConformManager::kProgressInterval = 1000;
+
+// A minute's worth of progress timer ticks
+const int ConformManager::kMaximumRenameAttempts = 60;
+
+ConformManager::ConformManager() {
+  progress_timer_.setInterval(kProgressInterval);
+  connect(&progress_timer_, &QTimer::timeout, this, &ConformManager::CheckProgress);
+}
+
 ConformManager::Conform ConformManager::GetConformState(const QString &decoder_id, const QString &cache_path,
                                                         const Decoder::CodecStream &stream, const AudioParams &params,
                                                         bool wait) {
@@ -17,25 +29,35 @@ ConformManager::Conform ConformManager::GetConformState(const QString &decoder_i
   // Return existing conform if exists
   QVector<QString> filenames = GetConformedFilename(cache_path, stream, params);
   if (AllConformsExist(filenames)) {
-    return {kConformExists, filenames, nullptr};
+    return {kConformExists, filenames, nullptr, -1};
   }
 
   ConformTask *conforming_task = nullptr;
+  QVector<QString> working_filenames;
+  bool in_progress = false;
 
   foreach (const ConformData &data, conforming_) {
     if (data.stream == stream && data.params == params) {
-      // Already creating conform in a task
+      // Already creating conform in a task, or waiting to rename its finished files
       conforming_task = data.task;
+      working_filenames = data.working_filename;
+      in_progress = true;
       break;
     }
   }
 
-  if (!conforming_task) {
+  if (in_progress) {
+    if (conforming_task) {
+      // Something is waiting on this right now, so make sure it's the next conform to run if it hasn't started yet
+      QMetaObject::invokeMethod(TaskManager::instance(), "Prioritize", Qt::QueuedConnection,
+                                Q_ARG(Task *, conforming_task));
+    }
+  } else {
     // Not conforming yet, create a task to do so
 
     // We conform to a different filename until it's done to make it clear even across sessions
     // whether this conform is ready or not
-    QVector<QString> working_filenames = filenames;
+    working_filenames = filenames;
     for (auto &working_filename : working_filenames) {
       working_filename.append(QStringLiteral(".working"));
     }
@@ -46,16 +68,20 @@ ConformManager::Conform ConformManager::GetConformState(const QString &decoder_i
     QMetaObject::invokeMethod(TaskManager::instance(), "AddTask", Qt::QueuedConnection, Q_ARG(Task *, conforming_task));
 
     conforming_.append({stream, params, conforming_task, working_filenames, filenames});
+
+    QMetaObject::invokeMethod(&progress_timer_, "start", Qt::QueuedConnection);
   }
 
   if (wait) {
     do {
       conform_done_condition_.wait(&mutex_);
     } while (!AllConformsExist(filenames));
-    return {kConformExists, filenames, nullptr};
+    return {kConformExists, filenames, nullptr, -1};
   }
 
-  return {kConformGenerating, QVector<QString>(), conforming_task};
+  // Once the task has finished, nothing may map the working files until they've been renamed (Windows won't rename a
+  // mapped file), so report nothing readable and let renderers wait for the finished conform
+  return {kConformGenerating, working_filenames, conforming_task, conforming_task ? conforming_task->ready_bytes() : 0};
 }
 
 QVector<QString> ConformManager::GetConformedFilename(const QString &cache_path, const Decoder::CodecStream &stream,
@@ -85,39 +111,140 @@ bool ConformManager::AllConformsExist(const QVector<QString> &filenames) {
   return true;
 }
 
+bool ConformManager::RenameWorkingFiles(const ConformData &data) {
+  bool renamed = true;
+
+  // Move file to standard conform name, making it clear this conform is ready for use
+  for (int i = 0; i < data.finished_filename.size(); i++) {
+    const QString &finished = data.finished_filename.at(i);
+    const QString &working = data.working_filename.at(i);
+
+    if (!QFile::exists(working)) {
+      // Renamed on an earlier attempt
+      continue;
+    }
+
+    QFile::remove(finished);
+    if (!QFile::rename(working, finished)) {
+      // Most likely a render still has it mapped, which some platforms won't rename
+      renamed = false;
+    }
+  }
+
+  return renamed;
+}
+
+void ConformManager::RemoveConformFiles(const ConformData &data) {
+  for (const QString &fn : data.working_filename) {
+    QFile::remove(fn);
+  }
+
+  for (const QString &fn : data.finished_filename) {
+    QFile::remove(fn);
+  }
+}
+
 void ConformManager::ConformTaskFinished(Task *task, bool succeeded) {
   QMutexLocker locker(&mutex_);
 
-  ConformData data;
-
-  // Remove conform data from list
+  int index = -1;
   for (int i = 0; i < conforming_.size(); i++) {
-    const ConformData &c = conforming_.at(i);
-    if (c.task == task) {
-      data = c;
-      conforming_.removeAt(i);
+    if (conforming_.at(i).task == task) {
+      index = i;
       break;
     }
   }
 
-  if (succeeded) {
-    // Move file to standard conform name, making it clear this conform is ready for use
-    for (int i = 0; i < data.finished_filename.size(); i++) {
-      const QString &finished = data.finished_filename.at(i);
-      const QString &working = data.working_filename.at(i);
+  if (index == -1) {
+    return;
+  }
+
+  ConformData &data = conforming_[index];
+
+  // The task deletes itself once this returns
+  data.task = nullptr;
+
+  // Renderers may have mapped the working files while they were being written
+  ConformMapCache::instance()->Forget(data.working_filename);
 
-      QFile::remove(finished);
-      QFile::rename(working, finished);
+  bool ready = false;
+
+  if (!succeeded) {
+    // Failed, just delete the working filename if exists
+    for (const auto &i : data.working_filename) {
+      QFile::remove(i);
     }
+    conforming_.removeAt(index);
+  } else if (RenameWorkingFiles(data)) {
+    conforming_.removeAt(index);
+    ready = true;
+  } else {
+    // A render still has a working file mapped. Renderers are told to wait from now on, so CheckProgress() retries
+    // the rename once their mappings are released.
+    qWarning() << "Conform files still in use, will retry renaming" << data.working_filename;
+  }
 
+  if (conforming_.isEmpty()) {
+    progress_timer_.stop();
+  }
+
+  if (ready) {
     conform_done_condition_.wakeAll();
     locker.unlock();
     emit ConformReady();
-  } else {
-    // Failed, just delete the working filename if exists
-    for (const auto &i : data.working_filename) {
-      QFile::remove(i);
+  }
+}
+
+void ConformManager::CheckProgress() {
+  QMutexLocker locker(&mutex_);
+
+  bool progressed = false;
+  bool ready = false;
+
+  for (int i = 0; i < conforming_.size();) {
+    ConformData &data = conforming_[i];
+
+    if (data.task) {
+      qint64 ready_bytes = data.task->ready_bytes();
+      if (ready_bytes > data.announced_bytes) {
+        data.announced_bytes = ready_bytes;
+        progressed = true;
+      }
+      i++;
+      continue;
+    }
+
+    // Finished, but a working file couldn't be renamed yet. A read that started before the task finished may have
+    // put its mapping back in the cache.
+    ConformMapCache::instance()->Forget(data.working_filename);
+
+    if (RenameWorkingFiles(data)) {
+      ready = true;
+    } else if (++data.rename_attempts >= kMaximumRenameAttempts) {
+      // Never landed, so the conform failed. If the working files can't be removed either, the next attempt to
+      // conform this stream fails to open them and reports it.
+      qWarning() << "Failed to rename conform files" << data.working_filename;
+      RemoveConformFiles(data);
+    } else {
+      i++;
+      continue;
     }
+
+    conforming_.removeAt(i);
+  }
+
+  if (conforming_.isEmpty()) {
+    progress_timer_.stop();
+  }
+
+  if (ready) {
+    conform_done_condition_.wakeAll();
+  }
+
+  locker.unlock();
+
+  if (progressed || ready) {
+    emit ConformReady();
   }
 }
 
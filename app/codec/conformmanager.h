@@ -5,6 +5,7 @@
 #include <QObject>
 #include <QString>         // 包含 QString
 #include <QStringList>     // 如果 GetConformedFilename 返回 QStringList (当前是 QVector<QString>)
+#include <QTimer>          // 定期检查适配进度
 #include <QVector>         // 包含 QVector
 #include <QWaitCondition>  // 包含 QWaitCondition
 
@@ -27,6 +28,9 @@ namespace olive {
  *
  * ConformManager 负责确保音频流以特定参数（如采样率、格式）存在于缓存中。
  * 如果所需的适配版本不存在，它会启动一个 ConformTask 来生成它。
+ * 适配从文件开头顺序写入，生成过程中已经写入的部分 (Conform::ready_bytes 以下) 就可以读取，
+ * 所以导入长录音后不需要等整个文件适配完成才能播放开头。渲染请求的适配任务会被提到任务队列的最前面，
+ * 使播放头当前需要的素材先被适配。
  * 此类设计为线程安全的。
  */
 class ConformManager : public QObject {
@@ -71,7 +75,9 @@ class ConformManager : public QObject {
   struct Conform {
     ConformState state;          ///< @brief 当前的适配状态。
     QVector<QString> filenames;  ///< @brief 适配后的文件名列表 (可能包含多个文件，例如多通道音频的每个通道一个文件)。
+                                 ///< 生成中时是正在写入的临时文件。
     ConformTask *task;           ///< @brief 如果状态是 kConformGenerating，则指向关联的 ConformTask；否则为 nullptr。
+    qint64 ready_bytes;          ///< @brief 生成中时每个通道已经可以读取的字节数；已存在时为 -1 (整个文件)。
   };
 
   /**
@@ -91,15 +97,15 @@ class ConformManager : public QObject {
 
  signals:
   /**
-   * @brief 当一个或多个适配任务完成，并且相应的适配文件准备就绪时发出此信号。
+   * @brief 当一个或多个适配任务完成，或者生成中的适配文件有更多部分可以读取时发出此信号。
    */
   void ConformReady();
 
  private:
   /**
-   * @brief 私有构造函数，用于实现单例模式。默认为 default。
+   * @brief 私有构造函数，用于实现单例模式。
    */
-  ConformManager() = default;
+  ConformManager();
 
   /**
    * @brief ConformManager 的静态单例实例指针。
@@ -122,9 +128,11 @@ class ConformManager : public QObject {
   struct ConformData {
     Decoder::CodecStream stream;  ///< @brief 原始音频流信息。
     AudioParams params;           ///< @brief 目标音频参数。
-    ConformTask *task{};          ///< @brief 指向关联的 ConformTask 的指针，如果任务已完成或失败则可能为 nullptr。
+    ConformTask *task{};          ///< @brief 指向关联的 ConformTask 的指针，任务完成后 (等待重命名时) 为 nullptr。
     QVector<QString> working_filename;   ///< @brief 适配过程中使用的临时工作文件名。
     QVector<QString> finished_filename;  ///< @brief 适配完成后最终生成的文件名。
+    qint64 announced_bytes{};            ///< @brief 上次发出 ConformReady() 时的 ready_bytes。
+    int rename_attempts{};               ///< @brief 任务完成后重命名工作文件失败的次数。
   };
 
   /**
@@ -132,6 +140,22 @@ class ConformManager : public QObject {
    */
   QVector<ConformData> conforming_;
 
+  /**
+   * @brief 有适配任务进行时定期触发 CheckProgress()。
+   */
+  QTimer progress_timer_;
+
+  /**
+   * @brief progress_timer_ 的间隔 (毫秒)。
+   */
+  static const int kProgressInterval;
+
+  /**
+   * @brief 任务完成后工作文件仍无法重命名 (例如在 Windows 上仍被映射) 时，CheckProgress() 最多重试的次数，
+   * 超过后适配视为失败。
+   */
+  static const int kMaximumRenameAttempts;
+
   /**
    * @brief 根据缓存路径、原始流信息和目标参数，生成适配后文件的目标文件名。
    * @param cache_path 缓存目录的路径。
@@ -149,6 +173,17 @@ class ConformManager : public QObject {
    */
   static bool AllConformsExist(const QVector<QString> &filenames);
 
+  /**
+   * @brief 将工作文件重命名为最终的适配文件名 (之前的尝试中已经重命名的文件会被跳过)。
+   * @return 是否所有文件都已重命名。
+   */
+  static bool RenameWorkingFiles(const ConformData &data);
+
+  /**
+   * @brief 删除一个适配的所有工作文件和 (部分) 完成的文件。
+   */
+  static void RemoveConformFiles(const ConformData &data);
+
  private slots:
   /**
    * @brief 当一个 ConformTask 完成时调用的槽函数。
@@ -156,6 +191,11 @@ class ConformManager : public QObject {
    * @param succeeded 标记任务是否成功完成。
    */
   void ConformTaskFinished(Task *task, bool succeeded);
+
+  /**
+   * @brief 如果有生成中的适配文件可以读取的部分增加了，发出 ConformReady()。同时重试任务完成后未能重命名的工作文件。
+   */
+  void CheckProgress();
 };
 
 }  // namespace olive
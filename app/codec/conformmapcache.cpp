@@ -0,0 +1,132 @@
+#include "conformmapcache.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QStringList>
+
+namespace olive {
+
+MappedPlanarFile::~MappedPlanarFile() { close(); }
+
+bool MappedPlanarFile::open(const QVector<QString> &filenames) {
+  close();
+
+  if (filenames.isEmpty()) {
+    return false;
+  }
+
+  files_.resize(filenames.size());
+  files_.fill(nullptr);
+  maps_.resize(filenames.size());
+  maps_.fill(nullptr);
+
+  size_ = -1;
+
+  for (int i = 0; i < files_.size(); i++) {
+    files_[i] = new QFile(filenames.at(i));
+    if (!files_[i]->open(QFile::ReadOnly)) {
+      close();
+      return false;
+    }
+
+    qint64 file_size = files_[i]->size();
+
+    // QFile can't map empty files, but an empty conform is still valid (all silence)
+    if (file_size > 0) {
+      maps_[i] = files_[i]->map(0, file_size);
+      if (!maps_[i]) {
+        qWarning() << "Failed to map conform file" << filenames.at(i) << files_[i]->errorString();
+        close();
+        return false;
+      }
+    }
+
+    size_ = (size_ == -1) ? file_size : qMin(size_, file_size);
+  }
+
+  last_modified_ = QFileInfo(filenames.first()).lastModified().toMSecsSinceEpoch();
+
+  return true;
+}
+
+void MappedPlanarFile::close() {
+  for (int i = 0; i < files_.size(); i++) {
+    if (QFile *f = files_.at(i)) {
+      if (maps_.at(i)) {
+        f->unmap(maps_.at(i));
+      }
+      delete f;
+    }
+  }
+
+  files_.clear();
+  maps_.clear();
+  size_ = 0;
+}
+
+ConformMapCache *ConformMapCache::instance() {
+  static ConformMapCache cache;
+  return &cache;
+}
+
+MappedPlanarFilePtr ConformMapCache::Acquire(const QVector<QString> &filenames, qint64 minimum_size) {
+  if (filenames.isEmpty()) {
+    return nullptr;
+  }
+
+  QString key = QStringList(filenames.cbegin(), filenames.cend()).join('\n');
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  // A conform that's still being written is touched by every flush, so only its size says whether the mapping is
+  // still good enough
+  bool valid_when_mapped = (minimum_size >= 0);
+  qint64 last_modified = valid_when_mapped ? 0 : QFileInfo(filenames.first()).lastModified().toMSecsSinceEpoch();
+
+  QMutexLocker locker(&mutex_);
+
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    bool current = valid_when_mapped ? (it->file->size() >= minimum_size)
+                                     : (it->file->last_modified() == last_modified);
+    if (current) {
+      it->last_accessed = now;
+      return it->file;
+    }
+
+    // File was rewritten (or has grown) since we mapped it. Existing users keep their (now stale) mapping alive
+    // through their own reference, we just stop handing it out.
+    entries_.erase(it);
+  }
+
+  auto file = std::make_shared<MappedPlanarFile>();
+  if (!file->open(filenames)) {
+    return nullptr;
+  }
+
+  entries_.insert(key, {file, now});
+
+  return file;
+}
+
+void ConformMapCache::Forget(const QVector<QString> &filenames) {
+  QString key = QStringList(filenames.cbegin(), filenames.cend()).join('\n');
+
+  QMutexLocker locker(&mutex_);
+
+  entries_.remove(key);
+}
+
+void ConformMapCache::ClearUnused(qint64 min_age) {
+  QMutexLocker locker(&mutex_);
+
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    // A use count of 1 means only the cache holds the mapping
+    if (it->file.use_count() == 1 && it->last_accessed < min_age) {
+      it = entries_.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+}  // namespace olive
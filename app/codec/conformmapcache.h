@@ -0,0 +1,124 @@
+#ifndef CONFORMMAPCACHE_H
+#define CONFORMMAPCACHE_H
+
+#include <QDateTime>  // 用于记录文件修改时间和最后访问时间
+#include <QFile>      // 用于打开和映射文件
+#include <QHash>      // 缓存容器
+#include <QMutex>     // 保护缓存的互斥锁
+#include <QString>    // 用于文件名
+#include <QVector>    // 用于存储每个通道的映射
+#include <memory>     // std::shared_ptr
+
+namespace olive {
+
+/**
+ * @brief 一组以只读方式内存映射的平面音频文件 (每个通道一个文件)。
+ *
+ * 与 PlanarFileDevice 不同，数据通过 mmap 直接访问，读取时不需要 seek/read 系统调用。
+ * 所有通道文件的大小应当相同，size() 返回其中最小的大小。
+ */
+class MappedPlanarFile {
+ public:
+  MappedPlanarFile() = default;
+
+  ~MappedPlanarFile();
+
+  // 禁止拷贝 (持有文件句柄和映射)
+  MappedPlanarFile(const MappedPlanarFile &) = delete;
+  MappedPlanarFile &operator=(const MappedPlanarFile &) = delete;
+
+  /**
+   * @brief 打开并映射指定的一组文件。
+   * @param filenames 每个通道对应的文件路径。
+   * @return 如果所有文件都成功打开 (非空文件也成功映射)，则返回 true。
+   */
+  bool open(const QVector<QString> &filenames);
+
+  /**
+   * @brief 获取通道数 (即映射的文件数)。
+   */
+  [[nodiscard]] int channel_count() const { return files_.size(); }
+
+  /**
+   * @brief 获取每个通道可读取的字节数。
+   */
+  [[nodiscard]] qint64 size() const { return size_; }
+
+  /**
+   * @brief 获取指定通道映射数据的只读指针。
+   * @param channel 通道索引。
+   * @return 指向映射数据起始处的指针；如果文件为空，则返回 nullptr。
+   */
+  [[nodiscard]] const char *channel(int channel) const { return reinterpret_cast<const char *>(maps_.at(channel)); }
+
+  /**
+   * @brief 获取映射时第一个文件的修改时间，用于检测文件是否在映射后被重写。
+   */
+  [[nodiscard]] qint64 last_modified() const { return last_modified_; }
+
+ private:
+  void close();
+
+  QVector<QFile *> files_;    // 每个通道的文件
+  QVector<uchar *> maps_;     // 每个通道的映射地址
+  qint64 size_ = 0;           // 每个通道可读取的字节数
+  qint64 last_modified_ = 0;  // 映射时第一个文件的修改时间 (毫秒)
+};
+
+using MappedPlanarFilePtr = std::shared_ptr<MappedPlanarFile>;
+
+/**
+ * @brief 已适配 (conform) 音频文件的共享映射缓存。
+ *
+ * Decoder::RetrieveAudioFromConform() 在每次音频渲染请求时都需要读取适配文件，
+ * 此缓存使同一组文件只被打开和映射一次，并在所有解码器之间共享。
+ * 返回的 MappedPlanarFilePtr 是引用计数的，正在使用的映射不会被释放；
+ * 未被使用且长时间未访问的映射由 RenderManager 的解码器回收定时器通过 ClearUnused() 释放。
+ *
+ * 此类是线程安全的。
+ */
+class ConformMapCache {
+ public:
+  /**
+   * @brief 获取全局唯一的缓存实例。
+   */
+  static ConformMapCache *instance();
+
+  /**
+   * @brief 获取一组适配文件的映射，必要时打开并映射它们。
+   *
+   * 对已经完成的适配文件 (minimum_size 为 -1)，如果文件在映射之后被修改过则重新映射。
+   * 仍在写入的适配文件的修改时间一直在变，所以只在映射小于 minimum_size 时重新映射。
+   * @param filenames 每个通道对应的适配文件路径。
+   * @param minimum_size 仍在写入时调用者需要读取的每个通道的字节数；文件已经完成时为 -1。
+   * @return 映射的共享指针；如果无法打开文件，则返回 nullptr。
+   */
+  MappedPlanarFilePtr Acquire(const QVector<QString> &filenames, qint64 minimum_size = -1);
+
+  /**
+   * @brief 不再提供这组文件的映射 (例如文件即将被重命名)。正在使用的映射在最后一个引用释放时才会解除。
+   */
+  void Forget(const QVector<QString> &filenames);
+
+  /**
+   * @brief 释放当前没有被使用、并且在 min_age 之前最后一次被访问的映射。
+   * @param min_age 时间戳 (自纪元起的毫秒数)，早于此时间访问的未使用映射会被释放。
+   */
+  void ClearUnused(qint64 min_age);
+
+ private:
+  ConformMapCache() = default;
+
+  struct Entry {
+    MappedPlanarFilePtr file;  // 映射 (缓存持有一个引用)
+    qint64 last_accessed = 0;  // 最后一次被 Acquire 的时间
+  };
+
+  QMutex mutex_;  // 保护 entries_
+
+  QHash<QString, Entry> entries_;  // 以适配文件名 (多个通道以换行连接) 为键
+};
+
+}  // namespace olive
+
+#endif  // CONFORMMAPCACHE_H
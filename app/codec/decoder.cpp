@@ -5,8 +5,9 @@
 #include <QHash>
 
 #include "codec/ffmpeg/ffmpegdecoder.h"
+#include "codec/oiio/imagesequencedecoder.h"
 #include "codec/oiio/oiiodecoder.h"
-#include "codec/planarfiledevice.h"
+#include "codec/conformmapcache.h"
 #include "common/ffmpegutils.h"
 #include "common/filefunctions.h"
 #include "conformmanager.h"
@@ -94,6 +95,27 @@ TexturePtr Decoder::RetrieveVideo(const RetrieveVideoParams &p) {
   return cached_texture_;
 }
 
+void Decoder::PrepareVideo(const RetrieveVideoParams &p) {
+  QMutexLocker locker(&mutex_);
+
+  UpdateLastAccessed();
+
+  if (!stream_.IsValid() || !SupportsVideo()) {
+    return;
+  }
+
+  if (p.cancelled && p.cancelled->IsCancelled()) {
+    return;
+  }
+
+  if (cached_texture_ && cached_time_ == p.time && cached_divider_ == p.divider) {
+    // RetrieveVideo() won't need to decode anything
+    return;
+  }
+
+  PrepareVideoInternal(p);
+}
+
 Decoder::RetrieveAudioStatus Decoder::RetrieveAudio(SampleBuffer &dest, const TimeRange &range,
                                                     const AudioParams &params, const QString &cache_path,
                                                     LoopMode loop_mode, RenderMode::Mode mode) {
@@ -115,13 +137,22 @@ Decoder::RetrieveAudioStatus Decoder::RetrieveAudio(SampleBuffer &dest, const Ti
   ConformManager::Conform conform =
       ConformManager::instance()->GetConformState(id(), cache_path, stream_, params, (mode == RenderMode::kOnline));
   if (conform.state == ConformManager::kConformGenerating) {
-    // If we need the task, it's available in `conform.task`
-    return kWaitingForConform;
+    // The conform is written from the start of the file, so anything ending below what's been written so far can be
+    // served already. Looping needs the full length, so that has to wait for the finished conform.
+    qint64 needed = params.time_to_bytes(range.out() - GetAudioStartOffset()) / params.channel_count();
+    if (loop_mode == LoopMode::kLoopModeLoop || needed > conform.ready_bytes) {
+      // If we need the task, it's available in `conform.task`
+      return kWaitingForConform;
+    }
   }
 
   // See if we got the conform
-  if (RetrieveAudioFromConform(dest, conform.filenames, range, loop_mode, params)) {
+  if (RetrieveAudioFromConform(dest, conform.filenames, range, loop_mode, params, conform.ready_bytes)) {
     return kOK;
+  } else if (conform.state == ConformManager::kConformGenerating) {
+    // The conform finished and its working files were renamed since we asked, so try again rather than leave this
+    // range silent
+    return kWaitingForConform;
   } else {
     return kUnknownError;
   }
@@ -144,8 +175,9 @@ void Decoder::Close() {
   }
 }
 
-bool Decoder::ConformAudio(const QVector<QString> &output_filenames, const AudioParams &params, CancelAtom *cancelled) {
-  return ConformAudioInternal(output_filenames, params, cancelled);
+bool Decoder::ConformAudio(const QVector<QString> &output_filenames, const AudioParams &params, CancelAtom *cancelled,
+                           std::atomic<qint64> *ready_bytes) {
+  return ConformAudioInternal(output_filenames, params, cancelled, ready_bytes);
 }
 
 /*
@@ -168,6 +200,11 @@ DecoderPtr Decoder::CreateFromID(const QString &id) {
     return nullptr;
   }
 
+  // Image sequences are probed as individual images, so their decoder never appears in the probing list
+  if (id == QStringLiteral("imagesequence")) {
+    return std::make_shared<ImageSequenceDecoder>();
+  }
+
   // Create list to iterate through
   QVector<DecoderPtr> decoder_list = ReceiveListOfAllDecoders();
 
@@ -233,63 +270,70 @@ TexturePtr Decoder::RetrieveVideoInternal(const RetrieveVideoParams &p) {
   return nullptr;
 }
 
+void Decoder::PrepareVideoInternal(const RetrieveVideoParams &p) { Q_UNUSED(p) }
+
 bool Decoder::ConformAudioInternal(const QVector<QString> &filenames, const AudioParams &params,
-                                   CancelAtom *cancelled) {
+                                   CancelAtom *cancelled, std::atomic<qint64> *ready_bytes) {
   Q_UNUSED(filenames)
   Q_UNUSED(cancelled)
   Q_UNUSED(params)
+  Q_UNUSED(ready_bytes)
   return false;
 }
 
 bool Decoder::RetrieveAudioFromConform(SampleBuffer &sample_buffer, const QVector<QString> &conform_filenames,
-                                       TimeRange range, LoopMode loop_mode, const AudioParams &input_params) {
-  PlanarFileDevice input;
-  if (input.open(conform_filenames, QFile::ReadOnly)) {
-    // Offset range by audio start offset
-    range -= GetAudioStartOffset();
-
-    qint64 read_index = input_params.time_to_bytes(range.in()) / input_params.channel_count();
-    qint64 write_index = 0;
-
-    const qint64 buffer_length_in_bytes = sample_buffer.sample_count() * input_params.bytes_per_sample_per_channel();
-
-    while (write_index < buffer_length_in_bytes) {
-      if (loop_mode == LoopMode::kLoopModeLoop) {
-        while (read_index >= input.size()) {
-          read_index -= input.size();
-        }
-
-        while (read_index < 0) {
-          read_index += input.size();
-        }
-      }
+                                       TimeRange range, LoopMode loop_mode, const AudioParams &input_params,
+                                       qint64 available) {
+  // Conform files are mapped once and shared between every decoder, so this is just a copy out
+  // of the page cache rather than an open/seek/read of every channel file
+  MappedPlanarFilePtr input = ConformMapCache::instance()->Acquire(conform_filenames, available);
+  if (!input) {
+    return false;
+  }
+
+  // Offset range by audio start offset
+  range -= GetAudioStartOffset();
+
+  // A conform that's still being written may have a partially flushed tail past what was published as ready
+  const qint64 input_size = (available < 0) ? input->size() : qMin(input->size(), available);
+  const int channel_count = qMin(input->channel_count(), sample_buffer.channel_count());
 
-      qint64 write_count = 0;
+  qint64 read_index = input_params.time_to_bytes(range.in()) / input_params.channel_count();
+  qint64 write_index = 0;
 
+  const qint64 buffer_length_in_bytes = sample_buffer.sample_count() * input_params.bytes_per_sample_per_channel();
+
+  while (write_index < buffer_length_in_bytes) {
+    if (loop_mode == LoopMode::kLoopModeLoop && input_size > 0) {
+      read_index %= input_size;
       if (read_index < 0) {
-        // Reading before 0, write silence here until audio data would actually start
-        write_count = qMin(-read_index, buffer_length_in_bytes);
-        sample_buffer.silence_bytes(write_index, write_index + write_count);
-      } else if (read_index >= input.size()) {
-        // Reading after data length, write silence until the end of the buffer
-        write_count = buffer_length_in_bytes - write_index;
-        sample_buffer.silence_bytes(write_index, write_index + write_count);
-      } else {
-        write_count = qMin(input.size() - read_index, buffer_length_in_bytes - write_index);
-        input.seek(read_index);
-        input.read(reinterpret_cast<char **>(sample_buffer.to_raw_ptrs().data()), write_count, write_index);
+        read_index += input_size;
       }
-
-      read_index += write_count;
-      write_index += write_count;
     }
 
-    input.close();
+    qint64 write_count = 0;
 
-    return true;
+    if (read_index < 0) {
+      // Reading before 0, write silence here until audio data would actually start
+      write_count = qMin(-read_index, buffer_length_in_bytes - write_index);
+      sample_buffer.silence_bytes(write_index, write_index + write_count);
+    } else if (read_index >= input_size) {
+      // Reading after data length, write silence until the end of the buffer
+      write_count = buffer_length_in_bytes - write_index;
+      sample_buffer.silence_bytes(write_index, write_index + write_count);
+    } else {
+      write_count = qMin(input_size - read_index, buffer_length_in_bytes - write_index);
+      for (int i = 0; i < channel_count; i++) {
+        memcpy(reinterpret_cast<char *>(sample_buffer.data(i)) + write_index, input->channel(i) + read_index,
+               write_count);
+      }
+    }
+
+    read_index += write_count;
+    write_index += write_count;
   }
 
-  return false;
+  return true;
 }
 
 void Decoder::UpdateLastAccessed() { last_accessed_ = QDateTime::currentMSecsSinceEpoch(); }
@@ -22,6 +22,7 @@ extern "C" {
 #include "node/block/block.h"                         // 包含 Block
 #include "node/project/footage/footagedescription.h"  // 包含 FootageDescription
 #include "render/cancelatom.h"                        // 包含 CancelAtom
+#include "render/rendercache.h"                       // 包含 ShaderCache
 #include "render/rendermodes.h"                       // 包含 RenderMode::Mode 和 LoopMode
 
 namespace olive {
@@ -197,8 +198,9 @@ class Decoder : public QObject {
    * @brief 检索视频帧时使用的参数结构体。
    */
   struct RetrieveVideoParams {
-    Renderer* renderer = nullptr;  ///< @brief 指向渲染器的指针，可能用于特定渲染上下文。
-    rational time;                 ///< @brief 请求的视频帧的时间戳。
+    Renderer* renderer = nullptr;         ///< @brief 指向渲染器的指针，可能用于特定渲染上下文。
+    ShaderCache* shader_cache = nullptr;  ///< @brief renderer 的着色器缓存，解码器编译的着色器也保存在这里。
+    rational time;                        ///< @brief 请求的视频帧的时间戳。
     int divider =
         1;  ///< @brief 视频分辨率的除数，用于请求较低分辨率的预览 (例如，1 表示完整分辨率，2 表示一半分辨率)。
     PixelFormat maximum_format =
@@ -206,6 +208,8 @@ class Decoder : public QObject {
     CancelAtom* cancelled = nullptr;        ///< @brief 指向 CancelAtom 的指针，用于在操作过程中检查是否已请求取消。
     VideoParams::ColorRange force_range = VideoParams::kColorRangeDefault;   ///< @brief 强制使用的颜色范围。
     VideoParams::Interlacing src_interlacing = VideoParams::kInterlaceNone;  ///< @brief 源视频的隔行扫描模式。
+    int64_t frame_number = 0;  ///< @brief 图像序列中请求的帧号 (仅由 ImageSequenceDecoder 使用)。
+    QString cache_path;        ///< @brief 保存素材索引的缓存目录 (可能为空，仅由 FFmpegDecoder 使用)。
   };
 
   /**
@@ -221,6 +225,16 @@ class Decoder : public QObject {
    */
   TexturePtr RetrieveVideo(const RetrieveVideoParams& p);
 
+  /**
+   * @brief 提前完成 RetrieveVideo() 中不需要渲染器的部分 (解码、缩放、像素格式转换)。
+   *
+   * 可以在任意线程上调用，p.renderer 不会被使用。之后以相同的时间、除数和最大像素格式调用 RetrieveVideo() 时
+   * 只需要把准备好的帧上传为纹理，这样渲染线程可以先让多个解码器同时解码，再依次合成。
+   *
+   * 此函数是线程安全的，并且只能在解码器打开时运行。
+   */
+  void PrepareVideo(const RetrieveVideoParams& p);
+
   /**
    * @brief 表示检索音频数据状态的枚举。
    */
@@ -284,10 +298,11 @@ class Decoder : public QObject {
    * @param output_filenames 适配后输出文件的目标路径列表。
    * @param params 目标音频参数。
    * @param cancelled 指向 CancelAtom 的指针，用于在操作过程中检查是否已请求取消 (可选)。
+   * @param ready_bytes 如果不为空，适配过程中定期写入每个通道已经写入文件、可以读取的字节数 (可选)。
    * @return bool 如果适配成功则返回 true，否则返回 false。
    */
   bool ConformAudio(const QVector<QString>& output_filenames, const AudioParams& params,
-                    CancelAtom* cancelled = nullptr);
+                    CancelAtom* cancelled = nullptr, std::atomic<qint64>* ready_bytes = nullptr);
 
   /**
    * @brief 使用解码器 ID 创建一个 Decoder 实例。
@@ -356,15 +371,23 @@ class Decoder : public QObject {
    */
   virtual TexturePtr RetrieveVideoInternal(const RetrieveVideoParams& p);
 
+  /**
+   * @brief 内部帧准备函数，见 PrepareVideo()。默认什么都不做，帧在 RetrieveVideoInternal() 中解码。
+   *
+   * 此函数在调用时已被互斥锁保护。
+   */
+  virtual void PrepareVideoInternal(const RetrieveVideoParams& p);
+
   /**
    * @brief 内部音频适配函数，供子类实现。
    * @param filenames 适配后输出文件的目标路径列表。
    * @param params 目标音频参数。
    * @param cancelled 指向 CancelAtom 的指针，用于检查是否已请求取消。
+   * @param ready_bytes 可以为空，见 ConformAudio()。
    * @return bool 如果适配成功则返回 true，否则返回 false。
    */
   virtual bool ConformAudioInternal(const QVector<QString>& filenames, const AudioParams& params,
-                                    CancelAtom* cancelled);
+                                    CancelAtom* cancelled, std::atomic<qint64>* ready_bytes);
 
   /**
    * @brief 发送处理进度信号。
@@ -408,10 +431,11 @@ class Decoder : public QObject {
    * @param range 请求的音频数据的时间范围。
    * @param loop_mode 循环模式。
    * @param params 请求的音频参数。
+   * @param available 仍在生成的适配文件中每个通道可以读取的字节数，-1 表示文件已经完整。
    * @return bool 如果成功从适配文件检索到音频则返回 true，否则返回 false。
    */
   bool RetrieveAudioFromConform(SampleBuffer& sample_buffer, const QVector<QString>& conform_filenames, TimeRange range,
-                                LoopMode loop_mode, const AudioParams& params);
+                                LoopMode loop_mode, const AudioParams& params, qint64 available = -1);
 
   /**
    * @brief 当前打开的编解码器流。
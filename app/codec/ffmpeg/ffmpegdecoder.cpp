@@ -14,21 +14,49 @@ extern "C" {
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
+#include <QMutex>
 #include <QString>
 #include <QThread>
 #include <QtConcurrent/QtConcurrent>
 #include <QtMath>
+#include <algorithm>
 
 #include "codec/planarfiledevice.h"
 #include "common/ffmpegutils.h"
 #include "common/filefunctions.h"
+#include "config/config.h"
 #include "render/renderer.h"
 #include "render/subtitleparams.h"
+#include "render/tracerecorder.h"
 
 namespace olive {
 
-QVariant Yuv2RgbShader;
-QVariant DeinterlaceShader;
+// About 20 8-bit 1080p 4:2:0 frames, or 5 UHD ones
+const int FFmpegDecoder::kMaximumQueueBytes = 64 * 1024 * 1024;
+
+// Short enough that playback near the start of a long recording is available almost immediately, long enough that
+// the flushes don't slow the conform down
+const int FFmpegDecoder::kConformPublishInterval = 10;
+
+std::atomic<qint64> FFmpegDecoder::gop_cache_bytes_{0};
+
+// Kept in the renderer's own shader cache, since renderers on different render threads can't safely share a program
+// and the cache is destroyed along with its renderer
+QVariant GetDecoderShader(const Decoder::RetrieveVideoParams &p, const QString &filename) {
+  QString id = QStringLiteral("ffmpegdecoder:%1").arg(filename);
+
+  QMutexLocker locker(p.shader_cache->mutex());
+
+  QVariant shader = p.shader_cache->value(id);
+  if (shader.isNull()) {
+    shader = p.renderer->CreateNativeShader(ShaderCode(FileFunctions::ReadFileAsString(filename)));
+    if (!shader.isNull()) {
+      p.shader_cache->insert(id, shader);
+    }
+  }
+
+  return shader;
+}
 
 FFmpegDecoder::FFmpegDecoder()
     : sws_ctx_(nullptr), working_packet_(nullptr), cache_at_zero_(false), cache_at_eof_(false) {}
@@ -73,13 +101,9 @@ TexturePtr FFmpegDecoder::ProcessFrameIntoTexture(const AVFramePtr &f, const Ret
     case AV_PIX_FMT_YUV422P12LE:
     case AV_PIX_FMT_YUV444P12LE: {
       // Run through YUV to RGB shader
-      if (Yuv2RgbShader.isNull()) {
-        // Compile shader
-        Yuv2RgbShader = p.renderer->CreateNativeShader(
-            ShaderCode(FileFunctions::ReadFileAsString(QStringLiteral(":/shaders/yuv2rgb.frag"))));
-        if (Yuv2RgbShader.isNull()) {
-          return nullptr;
-        }
+      QVariant yuv2rgb_shader = GetDecoderShader(p, QStringLiteral(":/shaders/yuv2rgb.frag"));
+      if (yuv2rgb_shader.isNull()) {
+        return nullptr;
       }
 
       int px_size;
@@ -150,7 +174,7 @@ TexturePtr FFmpegDecoder::ProcessFrameIntoTexture(const AVFramePtr &f, const Ret
       job.Insert(QStringLiteral("yuv_cbu"), NodeValue(NodeValue::kFloat, yuv_coeffs[1] / 65536.0));
 
       tex = p.renderer->CreateTexture(vp);
-      p.renderer->BlitToTexture(Yuv2RgbShader, job, tex.get(), false);
+      p.renderer->BlitToTexture(yuv2rgb_shader, job, tex.get(), false);
       break;
     }
     case AV_PIX_FMT_RGBA:
@@ -162,13 +186,9 @@ TexturePtr FFmpegDecoder::ProcessFrameIntoTexture(const AVFramePtr &f, const Ret
 
   // Deinterlace if necessary
   if (p.src_interlacing != VideoParams::kInterlaceNone) {
-    if (DeinterlaceShader.isNull()) {
-      // Compile shader
-      DeinterlaceShader = p.renderer->CreateNativeShader(
-          ShaderCode(FileFunctions::ReadFileAsString(QStringLiteral(":/shaders/deinterlace2.frag"))));
-      if (DeinterlaceShader.isNull()) {
-        return nullptr;
-      }
+    QVariant deinterlace_shader = GetDecoderShader(p, QStringLiteral(":/shaders/deinterlace2.frag"));
+    if (deinterlace_shader.isNull()) {
+      return nullptr;
     }
 
     rational frame_rate_tb = rational(av_guess_frame_rate(instance_.fmt_ctx(), instance_.avstream(), original.get()));
@@ -195,7 +215,7 @@ TexturePtr FFmpegDecoder::ProcessFrameIntoTexture(const AVFramePtr &f, const Ret
     job.Insert(QStringLiteral("interlacing"), NodeValue(NodeValue::kInt, interlacing));
     job.Insert(QStringLiteral("pixel_height"), NodeValue(NodeValue::kInt, original->height));
 
-    p.renderer->BlitToTexture(DeinterlaceShader, job, deinterlaced.get(), false);
+    p.renderer->BlitToTexture(deinterlace_shader, job, deinterlaced.get(), false);
 
     tex = deinterlaced;
   }
@@ -204,9 +224,38 @@ TexturePtr FFmpegDecoder::ProcessFrameIntoTexture(const AVFramePtr &f, const Ret
 }
 
 TexturePtr FFmpegDecoder::RetrieveVideoInternal(const RetrieveVideoParams &p) {
+  // Decodes now unless PrepareVideo() already did it on another thread
+  PrepareVideoInternal(p);
+
+  if (!prepared_frame_ || (p.cancelled && p.cancelled->IsCancelled())) {
+    return nullptr;
+  }
+
+  // Hand the frames over so they don't sit in memory once they've been uploaded
+  AVFramePtr f = std::move(prepared_frame_);
+  AVFramePtr original = std::move(prepared_original_);
+
+  // Finally, perform any GPU processing required
+  return ProcessFrameIntoTexture(f, p, original);
+}
+
+void FFmpegDecoder::PrepareVideoInternal(const RetrieveVideoParams &p) {
+  if (prepared_frame_ && prepared_time_ == p.time && prepared_divider_ == p.divider &&
+      static_cast<PixelFormat::Format>(prepared_format_) == static_cast<PixelFormat::Format>(p.maximum_format)) {
+    return;
+  }
+
+  prepared_frame_ = nullptr;
+  prepared_original_ = nullptr;
+
+  if (!keyframe_index_ && p.time != kAnyTimecode) {
+    // Doesn't block, until the index is ready we seek the way we always have
+    keyframe_index_ = FFmpegKeyframeIndexCache::instance()->Get(stream().filename(), stream().stream(), p.cache_path);
+  }
+
   if (AVFramePtr f = RetrieveFrame(p.time, p.cancelled)) {
     if (p.cancelled && p.cancelled->IsCancelled()) {
-      return nullptr;
+      return;
     }
 
     AVFramePtr original = f;
@@ -221,14 +270,15 @@ TexturePtr FFmpegDecoder::RetrieveVideoInternal(const RetrieveVideoParams &p) {
     f = PreProcessFrame(f, p);
     if (!f) {
       // Error occurred while software scaling
-      return nullptr;
+      return;
     }
 
-    // Finally, perform any GPU processing required
-    return ProcessFrameIntoTexture(f, p, original);
+    prepared_frame_ = f;
+    prepared_original_ = original;
+    prepared_time_ = p.time;
+    prepared_divider_ = p.divider;
+    prepared_format_ = p.maximum_format;
   }
-
-  return nullptr;
 }
 
 void FFmpegDecoder::CloseInternal() {
@@ -240,6 +290,11 @@ void FFmpegDecoder::CloseInternal() {
   ClearFrameCache();
   FreeScaler();
 
+  prepared_frame_ = nullptr;
+  prepared_original_ = nullptr;
+
+  keyframe_index_ = nullptr;
+
   instance_.Close();
 }
 
@@ -494,7 +549,7 @@ QString FFmpegDecoder::FFmpegError(int error_code) {
 }
 
 bool FFmpegDecoder::ConformAudioInternal(const QVector<QString> &filenames, const AudioParams &params,
-                                         CancelAtom *cancelled) {
+                                         CancelAtom *cancelled, std::atomic<qint64> *ready_bytes) {
   // Iterate through each audio frame and extract the PCM data
 
   // Seek to starting point
@@ -536,6 +591,12 @@ bool FFmpegDecoder::ConformAudioInternal(const QVector<QString> &filenames, cons
     SampleBuffer data;
     data.set_audio_params(params);
 
+    // Bytes per channel written so far, and how many of them readers have been told about
+    qint64 written = 0;
+    qint64 published = 0;
+    const qint64 publish_interval =
+        params.samples_to_bytes(params.sample_rate() * kConformPublishInterval) / nb_channels;
+
     while (true) {
       // Check if we have a `cancelled` ptr and its value
       if (cancelled && cancelled->IsCancelled()) {
@@ -573,6 +634,15 @@ bool FFmpegDecoder::ConformAudioInternal(const QVector<QString> &filenames, cons
         // Write to files
         wave_out.write(const_cast<const char **>(reinterpret_cast<char **>(data.to_raw_ptrs().data())),
                        nb_bytes_per_channel);
+
+        written += nb_bytes_per_channel;
+
+        if (ready_bytes && written - published >= publish_interval) {
+          // Data has to be out of QFile's buffers before anyone is allowed to read it
+          wave_out.flush();
+          published = written;
+          ready_bytes->store(published);
+        }
       }
 
       // Free buffer
@@ -671,6 +741,8 @@ void FFmpegDecoder::ClearFrameCache() {
     cache_at_eof_ = false;
     cache_at_zero_ = false;
   }
+
+  retain_gop_ = false;
 }
 
 AVFramePtr FFmpegDecoder::PreProcessFrame(AVFramePtr f, const RetrieveVideoParams &p) {
@@ -736,7 +808,10 @@ AVFramePtr FFmpegDecoder::PreProcessFrame(AVFramePtr f, const RetrieveVideoParam
                              dest->color_range == AVCOL_RANGE_JPEG ? 1 : 0, 0, 0x10000, 0x10000);
   }
 
-  r = sws_scale(sws_ctx_, f->data, f->linesize, 0, f->height, dest->data, dest->linesize);
+  {
+    TraceScope trace("Pixel Conversion", "decode");
+    r = sws_scale(sws_ctx_, f->data, f->linesize, 0, f->height, dest->data, dest->linesize);
+  }
   if (r < 0) {
     FFmpegError(r);
     return nullptr;
@@ -746,6 +821,8 @@ AVFramePtr FFmpegDecoder::PreProcessFrame(AVFramePtr f, const RetrieveVideoParam
 }
 
 AVFramePtr FFmpegDecoder::RetrieveFrame(const rational &time, CancelAtom *cancelled) {
+  TraceScope trace("Decode", "decode");
+
   int64_t target_ts = Timecode::time_to_timestamp(time, rational(instance_.avstream()->time_base));
 
   if (instance_.fmt_ctx()->start_time != AV_NOPTS_VALUE) {
@@ -753,19 +830,39 @@ AVFramePtr FFmpegDecoder::RetrieveFrame(const rational &time, CancelAtom *cancel
   }
 
   const int64_t min_seek = 0;
-  int64_t seek_ts = std::max(min_seek, target_ts - MaximumQueueSize());
+  int64_t seek_ts;
+  if (keyframe_index_) {
+    // Go straight to the keyframe the target frame depends on
+    seek_ts = keyframe_index_->GetKeyframeAtOrBefore(target_ts);
+  } else {
+    seek_ts = std::max(min_seek, target_ts - MaximumQueueSize());
+  }
   bool still_seeking = false;
 
   if (time != kAnyTimecode) {
+    // Requests going back in time mean reverse playback or jogging backwards
+    bool reversing = (last_target_ts_ != AV_NOPTS_VALUE && target_ts < last_target_ts_);
+    last_target_ts_ = target_ts;
+
     // If the frame wasn't in the frame cache, see if this frame cache is too old to use
-    if (cached_frames_.empty() ||
-        (target_ts < cached_frames_.front()->pts || target_ts > cached_frames_.back()->pts + 2 * second_ts_)) {
+    bool cache_is_usable;
+    if (cached_frames_.empty() || target_ts < cached_frames_.front()->pts) {
+      cache_is_usable = false;
+    } else if (keyframe_index_) {
+      // Decoding onwards from the cache only makes sense if there's no keyframe between it and the target
+      cache_is_usable = (seek_ts <= cached_frames_.back()->pts);
+    } else {
+      cache_is_usable = (target_ts <= cached_frames_.back()->pts + 2 * second_ts_);
+    }
+
+    if (!cache_is_usable) {
       ClearFrameCache();
 
-      instance_.Seek(seek_ts);
-      if (seek_ts == min_seek) {
-        cache_at_zero_ = true;
-      }
+      // When reversing, the next requests will want the frames right before this one. Keeping everything from the
+      // keyframe onwards means each GOP is decoded once rather than once per frame.
+      retain_gop_ = reversing && keyframe_index_;
+
+      SeekTo(seek_ts);
 
       still_seeking = true;
     } else {
@@ -808,11 +905,13 @@ AVFramePtr FFmpegDecoder::RetrieveFrame(const rational &time, CancelAtom *cancel
       // Handle a failure to seek (occurs on some media)
       // We'll only be here if the frame cache was emptied earlier
       if (!cache_at_zero_ && (ret == AVERROR_EOF || filtered->best_effort_timestamp > target_ts)) {
-        seek_ts = qMax(min_seek, seek_ts - second_ts_);
-        instance_.Seek(seek_ts);
-        if (seek_ts == min_seek) {
-          cache_at_zero_ = true;
+        if (keyframe_index_) {
+          // Shouldn't happen with an index, but step back one GOP rather than one second if it does
+          seek_ts = keyframe_index_->GetKeyframeBefore(seek_ts);
+        } else {
+          seek_ts = qMax(min_seek, seek_ts - second_ts_);
         }
+        SeekTo(seek_ts);
         continue;
 
       } else {
@@ -833,8 +932,18 @@ AVFramePtr FFmpegDecoder::RetrieveFrame(const rational &time, CancelAtom *cancel
       break;
 
     } else {
+      if (retain_gop_) {
+        // Don't hold on to the codec's own buffers, it would have to allocate new ones for every frame we keep
+        if (AVFramePtr copy = CopyToCacheFrame(filtered.get())) {
+          filtered = copy;
+        } else {
+          // Out of budget, keep the frames we have but carry on as usual
+          retain_gop_ = false;
+        }
+      }
+
       // Cut down to thread count - 1 before we acquire a new frame
-      if (cached_frames_.size() > size_t(MaximumQueueSize())) {
+      if (!retain_gop_ && cached_frames_.size() > size_t(MaximumQueueSize())) {
         RemoveFirstFrame();
       }
 
@@ -914,12 +1023,85 @@ void FFmpegDecoder::RemoveFirstFrame() {
   cache_at_zero_ = false;
 }
 
-int FFmpegDecoder::MaximumQueueSize() {
-  // Fairly arbitrary size. This used to need to be the number of current threads to ensure any
-  // thread that arrived would have its frame available, but if we only have one render thread,
-  // that's no longer a concern. Now, this value could technically be 1, but some memory cache
-  // may be useful for reversing. This value may be tweaked over time.
-  return 2;
+int FFmpegDecoder::MaximumQueueSize() const {
+  // Without an index this is fairly arbitrary. It used to need to be the number of current threads to ensure any
+  // thread that arrived would have its frame available, but if we only have one render thread, that's no longer a
+  // concern. This value could technically be 1, but some memory cache may be useful for reversing.
+  const int kMinimumQueueSize = 2;
+
+  if (!keyframe_index_) {
+    return kMinimumQueueSize;
+  }
+
+  // With an index, keep as much of the GOP as the memory budget allows so that stepping backwards inside it doesn't
+  // need to decode from the keyframe again
+  const AVCodecParameters *codecpar = instance_.avstream()->codecpar;
+  int frame_bytes = av_image_get_buffer_size(static_cast<AVPixelFormat>(codecpar->format), codecpar->width,
+                                             codecpar->height, 1);
+  if (frame_bytes <= 0) {
+    return kMinimumQueueSize;
+  }
+
+  int affordable = std::max(kMinimumQueueSize, kMaximumQueueBytes / frame_bytes);
+  return std::clamp(keyframe_index_->gop_length(), kMinimumQueueSize, affordable);
+}
+
+AVFramePtr FFmpegDecoder::CopyToCacheFrame(const AVFrame *f) {
+  const int kAlignment = 32;
+
+  auto fmt = static_cast<AVPixelFormat>(f->format);
+  int size = av_image_get_buffer_size(fmt, f->width, f->height, kAlignment);
+  if (size <= 0) {
+    return nullptr;
+  }
+
+  qint64 budget = OLIVE_CONFIG("ReversePlaybackCacheSize").toLongLong() * 1024 * 1024;
+  if (gop_cache_bytes_.fetch_add(size) + size > budget) {
+    gop_cache_bytes_.fetch_sub(size);
+    return nullptr;
+  }
+
+  // The planes are only kAlignment aligned if the base pointer is, and FFmpeg's SIMD code may rely on it. av_malloc()
+  // aligns for the widest SIMD FFmpeg was built with. From here on the budget is given back by FreeCacheFrameBuffer()
+  // when the buffer is released.
+  auto *data = static_cast<uint8_t *>(av_malloc(size));
+  if (!data) {
+    gop_cache_bytes_.fetch_sub(size);
+    return nullptr;
+  }
+
+  AVBufferRef *buf = av_buffer_create(data, size, FreeCacheFrameBuffer, reinterpret_cast<void *>(intptr_t(size)), 0);
+  if (!buf) {
+    FreeCacheFrameBuffer(reinterpret_cast<void *>(intptr_t(size)), data);
+    return nullptr;
+  }
+
+  AVFramePtr copy = CreateAVFramePtr();
+  copy->format = f->format;
+  copy->width = f->width;
+  copy->height = f->height;
+  copy->buf[0] = buf;
+  av_image_fill_arrays(copy->data, copy->linesize, buf->data, fmt, f->width, f->height, kAlignment);
+
+  if (av_frame_copy(copy.get(), f) < 0 || av_frame_copy_props(copy.get(), f) < 0) {
+    return nullptr;
+  }
+
+  return copy;
+}
+
+void FFmpegDecoder::FreeCacheFrameBuffer(void *opaque, uint8_t *data) {
+  int size = int(reinterpret_cast<intptr_t>(opaque));
+  av_free(data);
+  gop_cache_bytes_.fetch_sub(size);
+}
+
+void FFmpegDecoder::SeekTo(int64_t ts) {
+  instance_.Seek(ts);
+
+  if (keyframe_index_ ? keyframe_index_->IsAtStart(ts) : (ts == 0)) {
+    cache_at_zero_ = true;
+  }
 }
 
 FFmpegDecoder::Instance::Instance() : fmt_ctx_(nullptr), codec_ctx_(nullptr), avstream_(nullptr), opts_(nullptr) {}
@@ -1077,6 +1259,8 @@ int FFmpegDecoder::Instance::GetPacket(AVPacket *pkt) {
 }
 
 void FFmpegDecoder::Instance::Seek(int64_t timestamp) {
+  TraceScope trace("Seek", "decode");
+
   avcodec_flush_buffers(codec_ctx_);
   av_seek_frame(fmt_ctx_, avstream_->index, timestamp, AVSEEK_FLAG_BACKWARD);
 }
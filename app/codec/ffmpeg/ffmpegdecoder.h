@@ -15,10 +15,12 @@ extern "C" {
 #include <QTimer>
 #include <QVector>
 #include <QWaitCondition>  // 虽然包含但在此头文件中未直接使用
+#include <atomic>          // GOP 缓存的全局内存计数
 #include <list>            // 为了 std::list
 
 #include "codec/decoder.h"
-#include "common/ffmpegutils.h"  // 包含 FFmpeg 相关的工具函数和类型定义，如 AVFramePtr
+#include "codec/ffmpeg/ffmpegkeyframeindex.h"  // 关键帧索引
+#include "common/ffmpegutils.h"               // 包含 FFmpeg 相关的工具函数和类型定义，如 AVFramePtr
 
 namespace olive {
 
@@ -82,15 +84,21 @@ class FFmpegDecoder : public Decoder {
    */
   TexturePtr RetrieveVideoInternal(const RetrieveVideoParams& p) override;
 
+  /**
+   * @brief 在 CPU 上解码并预处理帧，保存到 prepared_frame_ 中等待 RetrieveVideoInternal() 上传。
+   */
+  void PrepareVideoInternal(const RetrieveVideoParams& p) override;
+
   /**
    * @brief 内部处理音频适配（转码/重采样）的实现。
    * @param filenames （此参数在 FFmpeg 解码器中可能未使用，通常单个文件包含所有流）。
    * @param params 目标音频参数。
    * @param cancelled 指向 CancelAtom 的指针，用于检查是否已请求取消。
+   * @param ready_bytes 每写入约 kConformPublishInterval 秒的音频就刷新文件并更新一次 (可以为空)。
    * @return bool 如果成功适配音频则返回 true，否则返回 false。
    */
   bool ConformAudioInternal(const QVector<QString>& filenames, const AudioParams& params,
-                            CancelAtom* cancelled) override;
+                            CancelAtom* cancelled, std::atomic<qint64>* ready_bytes) override;
   /**
    * @brief 内部关闭解码器的实现。
    */
@@ -297,9 +305,36 @@ class FFmpegDecoder : public Decoder {
 
   /**
    * @brief 获取帧缓存队列的最大允许大小。
+   *
+   * 有关键帧索引时，队列最多保存一个完整的 GOP (受 kMaximumQueueBytes 限制)，
+   * 这样在 GOP 内向后跳转时不需要从关键帧重新解码。没有索引或全帧内编码的素材只保存 2 帧。
    * @return int 队列最大大小。
    */
-  static int MaximumQueueSize();
+  [[nodiscard]] int MaximumQueueSize() const;
+
+  /**
+   * @brief 定位到指定时间戳，并在从文件开头解码时设置 cache_at_zero_。
+   */
+  void SeekTo(int64_t ts);
+
+  /**
+   * @brief 将解码后的帧复制到 av_malloc() 分配的 (满足 SIMD 对齐要求的) 内存中，使其不再占用解码器内部的缓冲区。
+   *
+   * 所有解码器的 GOP 缓存共享一个内存预算 (配置项 "ReversePlaybackCacheSize"，MiB)。
+   * @return 如果超出预算或复制失败，则返回 nullptr。
+   */
+  static AVFramePtr CopyToCacheFrame(const AVFrame* f);
+
+  /**
+   * @brief CopyToCacheFrame() 创建的缓冲区的释放回调，释放内存并归还预算。
+   */
+  static void FreeCacheFrameBuffer(void* opaque, uint8_t* data);
+
+  static std::atomic<qint64> gop_cache_bytes_;  // 所有解码器的 GOP 缓存当前占用的字节数
+
+  static const int kMaximumQueueBytes;  // 帧缓存队列的内存上限
+
+  static const int kConformPublishInterval;  // 适配时每写入多少秒的音频公布一次可读取的字节数
 
   /**
    * @brief FFmpeg 图像缩放上下文。
@@ -353,6 +388,21 @@ class FFmpegDecoder : public Decoder {
    */
   std::list<AVFramePtr> cached_frames_;
 
+  /**
+   * @brief 关键帧索引，在后台建立完成前为空。
+   */
+  FFmpegKeyframeIndexPtr keyframe_index_;
+
+  /**
+   * @brief 上一次请求的时间戳，用于检测倒放或 J/K 向后穿梭。
+   */
+  int64_t last_target_ts_{AV_NOPTS_VALUE};
+
+  /**
+   * @brief 是否保留当前 GOP 中解码的所有帧 (倒放时，之后的请求会依次需要目标帧之前的帧)。
+   */
+  bool retain_gop_{false};
+
   /**
    * @brief 标记是否在时间点 0 缓存了帧。
    */
@@ -362,6 +412,19 @@ class FFmpegDecoder : public Decoder {
    */
   bool cache_at_eof_{false};
 
+  /**
+   * @brief PrepareVideoInternal() 解码并预处理好、还没有上传的帧，以及预处理之前的原始帧。
+   */
+  AVFramePtr prepared_frame_;
+  AVFramePtr prepared_original_;
+
+  /**
+   * @brief 准备 prepared_frame_ 时使用的参数，RetrieveVideoInternal() 的参数与之不同时重新解码。
+   */
+  rational prepared_time_;
+  int prepared_divider_{0};
+  PixelFormat prepared_format_{PixelFormat::INVALID};
+
   /**
    * @brief FFmpeg 流实例对象，用于实际的解码操作。
    */
@@ -618,6 +618,11 @@ bool FFmpegEncoder::InitializeStream(AVMediaType type, AVStream** stream_ptr, AV
       }
     }
 
+    // Fixed keyframe interval, used by distributed exports so every chunk boundary falls on a keyframe
+    if (params().has_video_opt(QStringLiteral("ove_gop"))) {
+      codec_ctx->gop_size = params().video_option(QStringLiteral("ove_gop")).toInt();
+    }
+
     // Set custom options
     {
       for (auto i = params().video_opts().begin(); i != params().video_opts().end(); i++) {
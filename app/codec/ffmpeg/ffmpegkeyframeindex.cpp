@@ -0,0 +1,239 @@
+#include "ffmpegkeyframeindex.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+
+#include "common/filefunctions.h"
+
+namespace olive {
+
+namespace {
+
+const quint32 kIndexMagic = 0x4F474F50;  // "OGOP"
+const quint32 kIndexVersion = 1;
+
+}  // namespace
+
+std::shared_ptr<FFmpegKeyframeIndex> FFmpegKeyframeIndex::Build(const QString &filename, int stream,
+                                                                CancelAtom *cancelled) {
+  AVFormatContext *fmt_ctx = nullptr;
+  if (avformat_open_input(&fmt_ctx, filename.toUtf8(), nullptr, nullptr) != 0) {
+    return nullptr;
+  }
+
+  std::shared_ptr<FFmpegKeyframeIndex> index;
+
+  if (avformat_find_stream_info(fmt_ctx, nullptr) >= 0 && stream >= 0 && stream < int(fmt_ctx->nb_streams)) {
+    // Only this stream's packets are needed, let the demuxer skip everything else
+    for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++) {
+      fmt_ctx->streams[i]->discard = (int(i) == stream) ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+
+    auto result = std::make_shared<FFmpegKeyframeIndex>();
+    AVPacket *pkt = av_packet_alloc();
+    int frames_in_gop = 0;
+    bool valid = true;
+
+    while (av_read_frame(fmt_ctx, pkt) >= 0) {
+      if (pkt->stream_index == stream) {
+        if (pkt->flags & AV_PKT_FLAG_KEY) {
+          int64_t ts = (pkt->pts != AV_NOPTS_VALUE) ? pkt->pts : pkt->dts;
+          if (ts == AV_NOPTS_VALUE) {
+            // Nothing we could seek to
+            valid = false;
+          } else {
+            if (!result->keyframes_.empty()) {
+              result->gop_length_ = std::max(result->gop_length_, frames_in_gop);
+            }
+            result->keyframes_.push_back(ts);
+          }
+
+          frames_in_gop = 0;
+        }
+
+        frames_in_gop++;
+      }
+
+      av_packet_unref(pkt);
+
+      if (!valid || (cancelled && cancelled->IsCancelled())) {
+        valid = false;
+        break;
+      }
+    }
+
+    av_packet_free(&pkt);
+
+    if (valid && !result->keyframes_.empty()) {
+      result->gop_length_ = std::max(result->gop_length_, frames_in_gop);
+
+      // Keyframes are almost always stored in presentation order, but nothing guarantees it
+      std::sort(result->keyframes_.begin(), result->keyframes_.end());
+      result->keyframes_.erase(std::unique(result->keyframes_.begin(), result->keyframes_.end()),
+                               result->keyframes_.end());
+
+      index = result;
+    }
+  }
+
+  avformat_close_input(&fmt_ctx);
+
+  return index;
+}
+
+std::shared_ptr<FFmpegKeyframeIndex> FFmpegKeyframeIndex::Load(const QString &filename) {
+  QFile f(filename);
+  if (!f.open(QFile::ReadOnly)) {
+    return nullptr;
+  }
+
+  QDataStream ds(&f);
+
+  quint32 magic, version, count;
+  qint32 gop_length;
+  ds >> magic >> version >> gop_length >> count;
+
+  // Reject anything that doesn't look exactly like what Save() writes
+  if (ds.status() != QDataStream::Ok || magic != kIndexMagic || version != kIndexVersion || count == 0 ||
+      gop_length <= 0 || f.size() != qint64(sizeof(quint32) * 3 + sizeof(qint32) + sizeof(qint64) * count)) {
+    return nullptr;
+  }
+
+  auto index = std::make_shared<FFmpegKeyframeIndex>();
+  index->gop_length_ = gop_length;
+  index->keyframes_.resize(count);
+  for (quint32 i = 0; i < count; i++) {
+    qint64 ts;
+    ds >> ts;
+    index->keyframes_[i] = ts;
+  }
+
+  if (ds.status() != QDataStream::Ok || !std::is_sorted(index->keyframes_.cbegin(), index->keyframes_.cend())) {
+    return nullptr;
+  }
+
+  return index;
+}
+
+bool FFmpegKeyframeIndex::Save(const QString &filename) const {
+  // Written under a temporary name, so that a crash can never leave a truncated index behind
+  QSaveFile f(filename);
+  if (!f.open(QFile::WriteOnly)) {
+    return false;
+  }
+
+  QDataStream ds(&f);
+
+  ds << kIndexMagic << kIndexVersion << qint32(gop_length_) << quint32(keyframes_.size());
+  for (int64_t ts : keyframes_) {
+    ds << qint64(ts);
+  }
+
+  return ds.status() == QDataStream::Ok && f.commit();
+}
+
+QString FFmpegKeyframeIndex::GetIndexFilename(const QString &cache_path, const QString &filename, int stream) {
+  QString id = FileFunctions::GetUniqueFileIdentifier(filename);
+  if (id.isEmpty()) {
+    return {};
+  }
+
+  return QDir(cache_path).filePath(QStringLiteral("%1-%2.gop").arg(id, QString::number(stream)));
+}
+
+int64_t FFmpegKeyframeIndex::GetKeyframeAtOrBefore(int64_t ts) const {
+  auto it = std::upper_bound(keyframes_.cbegin(), keyframes_.cend(), ts);
+  if (it == keyframes_.cbegin()) {
+    return keyframes_.front();
+  }
+  return *(it - 1);
+}
+
+int64_t FFmpegKeyframeIndex::GetKeyframeBefore(int64_t ts) const {
+  auto it = std::lower_bound(keyframes_.cbegin(), keyframes_.cend(), ts);
+  if (it == keyframes_.cbegin()) {
+    return keyframes_.front();
+  }
+  return *(it - 1);
+}
+
+FFmpegKeyframeIndexCache::FFmpegKeyframeIndexCache() {
+  // Indexing is I/O bound, running several at once would only make them compete for the disk
+  pool_.setMaxThreadCount(1);
+}
+
+FFmpegKeyframeIndexCache::~FFmpegKeyframeIndexCache() {
+  cancelled_.Cancel();
+  pool_.waitForDone();
+}
+
+FFmpegKeyframeIndexCache *FFmpegKeyframeIndexCache::instance() {
+  static FFmpegKeyframeIndexCache cache;
+  return &cache;
+}
+
+FFmpegKeyframeIndexPtr FFmpegKeyframeIndexCache::Get(const QString &filename, int stream, const QString &cache_path) {
+  // Include the modification time so that a file replaced during the session is indexed again
+  QString key = QStringLiteral("%1:%2:%3")
+                    .arg(filename, QString::number(stream),
+                         QString::number(QFileInfo(filename).lastModified().toMSecsSinceEpoch()));
+
+  QMutexLocker locker(&mutex_);
+
+  Entry &e = entries_[key];
+  if (e.index || e.pending || e.failed) {
+    return e.index;
+  }
+
+  e.pending = true;
+
+  locker.unlock();
+
+  QtConcurrent::run(&pool_,
+                    [this, key, filename, stream, cache_path] { LoadOrBuild(key, filename, stream, cache_path); });
+
+  return nullptr;
+}
+
+void FFmpegKeyframeIndexCache::LoadOrBuild(const QString &key, const QString &filename, int stream,
+                                           const QString &cache_path) {
+  QString index_fn;
+  if (!cache_path.isEmpty()) {
+    index_fn = FFmpegKeyframeIndex::GetIndexFilename(cache_path, filename, stream);
+  }
+
+  FFmpegKeyframeIndexPtr index;
+
+  if (!index_fn.isEmpty()) {
+    index = FFmpegKeyframeIndex::Load(index_fn);
+  }
+
+  if (!index) {
+    index = FFmpegKeyframeIndex::Build(filename, stream, &cancelled_);
+
+    if (index && !index_fn.isEmpty() && !index->Save(index_fn)) {
+      qWarning() << "Failed to save keyframe index:" << index_fn;
+    }
+  }
+
+  QMutexLocker locker(&mutex_);
+
+  Entry &e = entries_[key];
+  e.index = index;
+  e.pending = false;
+
+  // Don't try again if the file simply can't be indexed, but do if we were only interrupted
+  e.failed = !index && !cancelled_.IsCancelled();
+}
+
+}  // namespace olive
@@ -0,0 +1,133 @@
+#ifndef FFMPEGKEYFRAMEINDEX_H
+#define FFMPEGKEYFRAMEINDEX_H
+
+#include <QHash>        // 索引缓存
+#include <QMutex>       // 保护索引缓存
+#include <QString>      // 文件名
+#include <QThreadPool>  // 后台建立索引的线程池
+#include <cstdint>      // int64_t
+#include <memory>       // std::shared_ptr
+#include <vector>       // 关键帧列表
+
+#include "render/cancelatom.h"
+
+namespace olive {
+
+/**
+ * @brief 一个视频流中所有关键帧的位置 (pts，以流的时间基为单位)。
+ *
+ * 只需要读取数据包而不需要解码，因此建立索引很快。FFmpegDecoder 用它直接定位到目标帧之前的关键帧，
+ * 避免定位过头后反复后退重试；GOP 长度则用于调整解码帧队列的大小。
+ *
+ * 索引以 "<唯一文件标识>-<流索引>.gop" 的文件名保存在适配 (conform) 缓存目录中，文件被修改后标识会改变，索引自动失效。
+ */
+class FFmpegKeyframeIndex {
+ public:
+  FFmpegKeyframeIndex() = default;
+
+  /**
+   * @brief 读取流中的所有数据包并建立索引。
+   * @return 如果文件无法打开、已取消或时间戳不可用，则返回 nullptr。
+   */
+  static std::shared_ptr<FFmpegKeyframeIndex> Build(const QString &filename, int stream, CancelAtom *cancelled);
+
+  /**
+   * @brief 从文件读取索引。
+   * @return 如果文件不存在或格式不正确，则返回 nullptr。
+   */
+  static std::shared_ptr<FFmpegKeyframeIndex> Load(const QString &filename);
+
+  /**
+   * @brief 将索引写入文件。
+   */
+  bool Save(const QString &filename) const;
+
+  /**
+   * @brief 获取索引文件在缓存目录中的文件名。
+   * @return 如果素材文件不存在，则返回空字符串。
+   */
+  static QString GetIndexFilename(const QString &cache_path, const QString &filename, int stream);
+
+  /**
+   * @brief 获取不晚于 ts 的最后一个关键帧。
+   * @return 如果 ts 在第一个关键帧之前，则返回第一个关键帧。
+   */
+  [[nodiscard]] int64_t GetKeyframeAtOrBefore(int64_t ts) const;
+
+  /**
+   * @brief 获取严格早于 ts 的最后一个关键帧 (用于从 ts 处的关键帧再向前一个 GOP)。
+   * @return 如果没有更早的关键帧，则返回第一个关键帧。
+   */
+  [[nodiscard]] int64_t GetKeyframeBefore(int64_t ts) const;
+
+  /**
+   * @brief 检查 ts 是否不晚于第一个关键帧 (即从此处解码就是从文件开头解码)。
+   */
+  [[nodiscard]] bool IsAtStart(int64_t ts) const { return ts <= keyframes_.front(); }
+
+  /**
+   * @brief 获取最长的 GOP 包含的帧数 (全帧内编码的素材为 1)。
+   */
+  [[nodiscard]] int gop_length() const { return gop_length_; }
+
+  /**
+   * @brief 获取关键帧数量。
+   */
+  [[nodiscard]] int keyframe_count() const { return int(keyframes_.size()); }
+
+ private:
+  std::vector<int64_t> keyframes_;  // 关键帧的 pts，按升序排列
+  int gop_length_ = 0;              // 最长的 GOP 包含的帧数
+};
+
+using FFmpegKeyframeIndexPtr = std::shared_ptr<FFmpegKeyframeIndex>;
+
+/**
+ * @brief 所有解码器共享的关键帧索引缓存。
+ *
+ * Get() 从不阻塞：如果索引尚未就绪，它会从磁盘读取，或者在后台线程中建立并保存到缓存目录，
+ * 在此期间返回 nullptr，解码器回退到没有索引时的定位方式。
+ *
+ * 此类是线程安全的。
+ */
+class FFmpegKeyframeIndexCache {
+ public:
+  /**
+   * @brief 获取全局唯一的缓存实例。
+   */
+  static FFmpegKeyframeIndexCache *instance();
+
+  ~FFmpegKeyframeIndexCache();
+
+  /**
+   * @brief 获取文件中某个流的关键帧索引。
+   * @param filename 素材文件。
+   * @param stream 视频流索引。
+   * @param cache_path 保存索引的缓存目录，为空时索引只保存在内存中。
+   * @return 如果索引尚未就绪或无法建立，则返回 nullptr。
+   */
+  FFmpegKeyframeIndexPtr Get(const QString &filename, int stream, const QString &cache_path);
+
+ private:
+  FFmpegKeyframeIndexCache();
+
+  struct Entry {
+    FFmpegKeyframeIndexPtr index;  // 就绪的索引
+    bool pending = false;          // 是否正在读取或建立
+    bool failed = false;           // 无法建立索引，本次会话中不再重试
+  };
+
+  void LoadOrBuild(const QString &key, const QString &filename, int stream, const QString &cache_path);
+
+  QMutex mutex_;  // 保护 entries_
+
+  QHash<QString, Entry> entries_;  // 以 "文件名:流索引" 为键
+
+  CancelAtom cancelled_;  // 退出时取消正在建立的索引
+
+  QThreadPool pool_;  // 建立索引的线程池 (主要是磁盘 I/O)
+};
+
+}  // namespace olive
+
+#endif  // FFMPEGKEYFRAMEINDEX_H
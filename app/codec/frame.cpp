@@ -4,6 +4,7 @@
 #include <QDebug>
 #include <QtGlobal>
 #include <QtMath>
+#include <utility>
 
 #include "common/oiioutils.h"
 #include "render/framemanager.h"
@@ -94,9 +95,21 @@ bool Frame::allocate() {
   return true;
 }
 
+void Frame::set_external_data(char *data, std::shared_ptr<void> owner) {
+  destroy();
+
+  data_size_ = linesize_ * height();
+  data_ = data;
+  external_owner_ = std::move(owner);
+}
+
 void Frame::destroy() {
   if (is_allocated()) {
-    FrameManager::Deallocate(data_size_, data_);
+    if (external_owner_) {
+      external_owner_.reset();
+    } else {
+      FrameManager::Deallocate(data_size_, data_);
+    }
 
     data_size_ = 0;
     data_ = nullptr;
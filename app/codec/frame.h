@@ -175,6 +175,16 @@ class Frame {
    */
   bool allocate();
 
+  /**
+   * @brief 使用外部内存 (例如内存映射的缓存文件) 作为帧的数据缓冲区，不进行拷贝。
+   *
+   * 必须先设置视频参数，data 中至少要有 linesize_bytes() * height() 字节。
+   * owner 会一直被持有，直到帧被销毁或调用 destroy()，用于保证 data 在此期间有效。
+   * @param data 指向外部数据的指针。
+   * @param owner 拥有 data 的对象。
+   */
+  void set_external_data(char* data, std::shared_ptr<void> owner);
+
   /**
    * @brief 返回帧的数据缓冲区是否已分配。
    * @return bool 如果 data_ 指针非空 (即已分配内存) 则返回 true，否则返回 false。
@@ -217,6 +227,11 @@ class Frame {
    */
   int data_size_{0};
 
+  /**
+   * @brief 外部数据的拥有者 (见 set_external_data())。为空时 data_ 由 FrameManager 分配。
+   */
+  std::shared_ptr<void> external_owner_;
+
   /**
    * @brief 帧的时间戳，以秒为单位的有理数。
    */
@@ -0,0 +1,155 @@
+#include "imagesequencedecoder.h"
+
+#include <QFileInfo>
+#include <QtConcurrent/QtConcurrent>
+
+#include "codec/oiio/oiiodecoder.h"
+#include "render/renderer.h"
+
+namespace olive {
+
+const int ImageSequenceDecoder::kPrefetchFrameCount = 8;
+const int ImageSequenceDecoder::kMaximumCacheKilobytes = 512 * 1024;
+
+ImageSequenceDecoder::ImageSequenceDecoder()
+    : subimage_(0), cache_divider_(0), last_frame_(0), direction_(1), closing_(false) {
+  frames_.setMaxCost(kMaximumCacheKilobytes);
+}
+
+QString ImageSequenceDecoder::id() const { return QStringLiteral("imagesequence"); }
+
+FootageDescription ImageSequenceDecoder::Probe(const QString &filename, CancelAtom *cancelled) const {
+  Q_UNUSED(filename)
+  Q_UNUSED(cancelled)
+
+  return FootageDescription(id());
+}
+
+bool ImageSequenceDecoder::OpenInternal() {
+  QMutexLocker locker(&cache_mutex_);
+
+  filename_ = stream().filename();
+  subimage_ = stream().stream();
+  closing_ = false;
+
+  return GetImageSequenceDigitCount(filename_) > 0;
+}
+
+TexturePtr ImageSequenceDecoder::RetrieveVideoInternal(const RetrieveVideoParams &p) {
+  FramePtr frame = GetFrame(p.frame_number, p.divider, p.cancelled);
+
+  if (!frame) {
+    return nullptr;
+  }
+
+  return p.renderer->CreateTexture(frame->video_params(), frame->data(), frame->linesize_pixels());
+}
+
+void ImageSequenceDecoder::CloseInternal() {
+  QMutexLocker locker(&cache_mutex_);
+
+  // Queued prefetches reference this object, so wait for them to drain. Any that haven't started yet will see
+  // closing_ and return immediately.
+  closing_ = true;
+  while (!pending_.isEmpty()) {
+    cache_wait_.wait(&cache_mutex_);
+  }
+
+  frames_.clear();
+}
+
+QThreadPool *ImageSequenceDecoder::IOPool() {
+  static QThreadPool pool;
+  return &pool;
+}
+
+FramePtr ImageSequenceDecoder::GetFrame(int64_t frame, int divider, CancelAtom *cancelled) {
+  QMutexLocker locker(&cache_mutex_);
+
+  if (divider != cache_divider_) {
+    // Cached frames are the wrong size now
+    frames_.clear();
+    cache_divider_ = divider;
+  }
+
+  if (frame != last_frame_) {
+    direction_ = (frame > last_frame_) ? 1 : -1;
+    last_frame_ = frame;
+  }
+
+  // If a prefetch is already reading this frame, it's cheaper to wait for it than to read the file again
+  while (pending_.contains(frame) && !(cancelled && cancelled->IsCancelled())) {
+    cache_wait_.wait(&cache_mutex_);
+  }
+
+  FramePtr f;
+  if (FramePtr *cached = frames_.object(frame)) {
+    f = *cached;
+  }
+
+  QueuePrefetch(frame, divider);
+
+  if (!f) {
+    locker.unlock();
+
+    f = OIIODecoder::LoadFrame(TransformImageSequenceFileName(filename_, frame), subimage_, divider);
+
+    locker.relock();
+
+    if (f && divider == cache_divider_) {
+      InsertIntoCache(frame, f);
+    }
+  }
+
+  return f;
+}
+
+void ImageSequenceDecoder::QueuePrefetch(int64_t frame, int divider) {
+  if (closing_) {
+    return;
+  }
+
+  for (int i = 1; i <= kPrefetchFrameCount; i++) {
+    int64_t next = frame + direction_ * i;
+
+    if (next < 0 || pending_.contains(next) || frames_.contains(next)) {
+      continue;
+    }
+
+    pending_.insert(next);
+    QtConcurrent::run(IOPool(), [this, next, divider] { PrefetchWorker(next, divider); });
+  }
+}
+
+void ImageSequenceDecoder::PrefetchWorker(int64_t frame, int divider) {
+  FramePtr f;
+
+  cache_mutex_.lock();
+  bool skip = closing_ || divider != cache_divider_;
+  QString filename = filename_;
+  int subimage = subimage_;
+  cache_mutex_.unlock();
+
+  if (!skip) {
+    // Reading past either end of the sequence just fails to open the file, which is fine
+    QString frame_filename = TransformImageSequenceFileName(filename, frame);
+    if (QFileInfo::exists(frame_filename)) {
+      f = OIIODecoder::LoadFrame(frame_filename, subimage, divider);
+    }
+  }
+
+  QMutexLocker locker(&cache_mutex_);
+
+  if (f && !closing_ && divider == cache_divider_) {
+    InsertIntoCache(frame, f);
+  }
+
+  pending_.remove(frame);
+  cache_wait_.wakeAll();
+}
+
+void ImageSequenceDecoder::InsertIntoCache(int64_t frame, const FramePtr &f) {
+  frames_.insert(frame, new FramePtr(f), std::max(1, f->allocated_size() / 1024));
+}
+
+}  // namespace olive
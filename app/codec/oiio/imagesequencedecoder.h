@@ -0,0 +1,102 @@
+#ifndef IMAGESEQUENCEDECODER_H
+#define IMAGESEQUENCEDECODER_H
+
+#include <QCache>          // 已解码帧的有界 LRU
+#include <QSet>            // 正在预读的帧号集合
+#include <QThreadPool>     // 后台 I/O 线程池
+#include <QWaitCondition>  // 等待预读完成
+
+#include "codec/decoder.h"  // 基类 Decoder
+#include "codec/frame.h"    // FramePtr
+
+namespace olive {
+
+/**
+ * @brief 感知图像序列的解码器，每个序列只创建一个实例。
+ *
+ * 以前每渲染图像序列的一帧都会创建并打开一个新的 OIIODecoder。此类以序列的文件名为键
+ * 存放在 RenderManager 的解码器缓存中，按帧号读取对应的文件，并根据播放方向在共享的
+ * 后台 I/O 线程池上预读接下来的若干帧。解码后的帧 (CPU 内存) 保存在一个按字节数限制大小的
+ * LRU 缓存中，因此来回拖动或重复播放时不需要再次读取磁盘。
+ *
+ * 需要在 RetrieveVideoParams::frame_number 中提供请求的帧号。
+ */
+class ImageSequenceDecoder : public Decoder {
+  Q_OBJECT
+ public:
+  ImageSequenceDecoder();
+
+  DECODER_DEFAULT_DESTRUCTOR(ImageSequenceDecoder)
+
+  [[nodiscard]] QString id() const override;
+
+  bool SupportsVideo() override { return true; }
+
+  /**
+   * @brief 图像序列由 OIIODecoder 探测，此解码器从不参与探测，因此总是返回空描述。
+   */
+  FootageDescription Probe(const QString &filename, CancelAtom *cancelled) const override;
+
+  // 每次请求之后沿播放方向预读的帧数
+  static const int kPrefetchFrameCount;
+
+  // 已解码帧缓存的最大大小 (KiB，每个序列)
+  static const int kMaximumCacheKilobytes;
+
+ protected:
+  bool OpenInternal() override;
+
+  TexturePtr RetrieveVideoInternal(const RetrieveVideoParams &p) override;
+
+  void CloseInternal() override;
+
+ private:
+  /**
+   * @brief 获取所有图像序列共享的后台 I/O 线程池。
+   */
+  static QThreadPool *IOPool();
+
+  /**
+   * @brief 获取指定帧，优先从缓存中读取，如果正在预读则等待，否则同步读取。
+   */
+  FramePtr GetFrame(int64_t frame, int divider, CancelAtom *cancelled);
+
+  /**
+   * @brief 从请求的帧开始沿 direction_ 方向调度预读。调用时必须持有 cache_mutex_。
+   */
+  void QueuePrefetch(int64_t frame, int divider);
+
+  /**
+   * @brief 在 I/O 线程上运行，读取一帧并放入缓存。
+   */
+  void PrefetchWorker(int64_t frame, int divider);
+
+  /**
+   * @brief 将帧放入缓存。调用时必须持有 cache_mutex_。
+   */
+  void InsertIntoCache(int64_t frame, const FramePtr &f);
+
+  QMutex cache_mutex_;  // 保护以下所有成员 (Decoder::mutex_ 在预读线程中不可用)
+
+  QWaitCondition cache_wait_;  // 预读完成时唤醒等待的渲染线程
+
+  QCache<int64_t, FramePtr> frames_;  // 已解码帧的 LRU，开销以 KiB 计
+
+  QString filename_;  // 序列中任意一帧的文件名 (用于生成每帧的文件名)
+
+  int subimage_;  // 子图像索引
+
+  QSet<int64_t> pending_;  // 已调度但尚未完成的预读帧号
+
+  int cache_divider_;  // 缓存中帧使用的分辨率除数
+
+  int64_t last_frame_;  // 上一次请求的帧号，用于判断播放方向
+
+  int direction_;  // 播放方向，1 为正向，-1 为反向
+
+  bool closing_;  // 正在关闭，不再调度新的预读
+};
+
+}  // namespace olive
+
+#endif  // IMAGESEQUENCEDECODER_H
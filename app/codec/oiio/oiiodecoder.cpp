@@ -4,7 +4,9 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <algorithm>
 
+#include "codec/boxdownsampler.h"
 #include "common/define.h"
 #include "common/oiioutils.h"
 #include "config/config.h"
@@ -15,7 +17,10 @@ namespace olive {
 
 QStringList OIIODecoder::supported_formats_;
 
-OIIODecoder::OIIODecoder() : image_(nullptr) {}
+// Large enough that tiled files don't re-read many tiles at band edges, small enough to stay in cache-sized chunks
+const int OIIODecoder::kDownsampleBandRows = 256;
+
+OIIODecoder::OIIODecoder() : image_(nullptr), subimage_(0) {}
 
 QString OIIODecoder::id() const { return QStringLiteral("oiio"); }
 
@@ -92,39 +97,107 @@ bool OIIODecoder::OpenInternal() {
 }
 
 TexturePtr OIIODecoder::RetrieveVideoInternal(const RetrieveVideoParams &p) {
-  VideoParams vp = GetVideoParamsFromImageSpec(image_->spec());
-  vp.set_divider(p.divider);
+  PrepareVideoInternal(p);
+
+  if (!buffer_.is_allocated()) {
+    return nullptr;
+  }
+
+  return p.renderer->CreateTexture(buffer_.video_params(), buffer_.data(), buffer_.linesize_pixels());
+}
 
+void OIIODecoder::PrepareVideoInternal(const RetrieveVideoParams &p) {
   if (!buffer_.is_allocated() || last_params_.divider != p.divider) {
     last_params_ = p;
 
-    buffer_.destroy();
-    buffer_.set_video_params(vp);
-    buffer_.allocate();
-
-    if (p.divider == 1) {
-      // Just upload straight to the buffer
-      image_->read_image(oiio_pix_fmt_, buffer_.data(), OIIO::AutoStride, buffer_.linesize_bytes());
-    } else {
-      OIIO::ImageBuf buf(image_->spec());
-      image_->read_image(image_->spec().format, buf.localpixels(), buf.pixel_stride(), buf.scanline_stride(),
-                         buf.z_stride());
-
-      // Roughly downsample image for divider (for some reason OIIO::ImageBufAlgo::resample failed here)
-      int px_sz = vp.GetBytesPerPixel();
-      for (int dst_y = 0; dst_y < buffer_.height(); dst_y++) {
-        int src_y = dst_y * buf.spec().height / buffer_.height();
-
-        for (int dst_x = 0; dst_x < buffer_.width(); dst_x++) {
-          int src_x = dst_x * buf.spec().width / buffer_.width();
-          memcpy(buffer_.data() + buffer_.linesize_bytes() * dst_y + px_sz * dst_x,
-                 static_cast<uint8_t *>(buf.localpixels()) + buf.scanline_stride() * src_y + px_sz * src_x, px_sz);
-        }
-      }
+    ReadImage(p.divider, &buffer_);
+  }
+}
+
+FramePtr OIIODecoder::LoadFrame(const QString &filename, int subimage, int divider) {
+  OIIODecoder decoder;
+
+  if (!decoder.OpenImageHandler(filename, subimage)) {
+    return nullptr;
+  }
+
+  FramePtr frame = Frame::Create();
+  bool ok = decoder.ReadImage(divider, frame.get());
+  decoder.CloseImageHandle();
+
+  return ok ? frame : nullptr;
+}
+
+bool OIIODecoder::ReadImage(int divider, Frame *dst) {
+  VideoParams vp = GetVideoParamsFromImageSpec(image_->spec());
+  vp.set_divider(divider);
+
+  dst->destroy();
+  dst->set_video_params(vp);
+  dst->allocate();
+
+  bool ok;
+
+  if (divider == 1) {
+    // Just upload straight to the buffer
+    ok = image_->read_image(oiio_pix_fmt_, dst->data(), OIIO::AutoStride, dst->linesize_bytes());
+  } else {
+    ok = ReadDownsampled(dst);
+  }
+
+  if (!ok) {
+    // Rather than show whatever was left in the rows we never got to
+    qWarning() << "Failed to read image:" << QString::fromStdString(image_->geterror());
+    dst->destroy();
+  }
+
+  return ok;
+}
+
+bool OIIODecoder::ReadDownsampled(Frame *dst) {
+  // Files with MIP levels (tiled EXR/TIFF) already store reduced resolutions, so start from the smallest level that
+  // still covers the destination instead of the full resolution image
+  int level = 0;
+  OIIO::ImageSpec level_spec = image_->spec();
+  for (int m = 1;; m++) {
+    OIIO::ImageSpec s = image_->spec(subimage_, m);
+    if (s.format == OIIO::TypeUnknown || s.width < dst->width() || s.height < dst->height()) {
+      break;
     }
+
+    level = m;
+    level_spec = s;
+  }
+
+  int channels = level_spec.nchannels;
+
+  if (level_spec.width == dst->width() && level_spec.height == dst->height()) {
+    return image_->read_scanlines(subimage_, level, level_spec.y, level_spec.y + level_spec.height, level_spec.z, 0,
+                                  channels, oiio_pix_fmt_, dst->data(), OIIO::AutoStride, dst->linesize_bytes());
   }
 
-  return p.renderer->CreateTexture(vp, buffer_.data(), buffer_.linesize_pixels());
+  // Read and box filter in bands so the full resolution image never has to be in memory at once
+  BoxDownsampler downsampler(level_spec.width, level_spec.height, dst);
+  int src_linesize = Frame::generate_linesize_bytes(level_spec.width, pix_fmt_, channels);
+  int band_rows = std::max(1, kDownsampleBandRows * dst->height() / level_spec.height);
+  std::vector<char> band;
+
+  for (int dst_y = 0; dst_y < dst->height(); dst_y += band_rows) {
+    int dst_end = std::min(dst->height(), dst_y + band_rows);
+    int src_begin = downsampler.SourceRowBegin(dst_y);
+    int src_end = downsampler.SourceRowEnd(dst_end - 1);
+
+    band.resize(size_t(src_end - src_begin) * src_linesize);
+
+    if (!image_->read_scanlines(subimage_, level, level_spec.y + src_begin, level_spec.y + src_end, level_spec.z, 0,
+                                channels, oiio_pix_fmt_, band.data(), OIIO::AutoStride, src_linesize)) {
+      return false;
+    }
+
+    downsampler.Process(band.data(), src_linesize, src_begin, dst_y, dst_end);
+  }
+
+  return true;
 }
 
 void OIIODecoder::CloseInternal() { CloseImageHandle(); }
@@ -164,6 +237,8 @@ bool OIIODecoder::OpenImageHandler(const QString &fn, int subimage) {
     return false;
   }
 
+  subimage_ = subimage;
+
   // Check if we can work with this pixel format
   const OIIO::ImageSpec &spec = image_->spec();
 
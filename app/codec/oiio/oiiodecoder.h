@@ -53,6 +53,17 @@ class OIIODecoder : public Decoder {
    */
   FootageDescription Probe(const QString& filename, CancelAtom* cancelled) const override;
 
+  /**
+   * @brief 读取一个图像文件到新的 CPU 帧中，不需要渲染器。
+   *
+   * 供 ImageSequenceDecoder 在后台 I/O 线程上预读图像序列中的帧。此函数是线程安全的。
+   * @param filename 图像文件名。
+   * @param subimage 子图像索引。
+   * @param divider 分辨率除数。
+   * @return 解码后的帧；如果文件无法打开，则返回 nullptr。
+   */
+  static FramePtr LoadFrame(const QString& filename, int subimage, int divider);
+
  protected:
   /**
    * @brief 内部打开图像文件进行解码的实现。
@@ -67,6 +78,11 @@ class OIIODecoder : public Decoder {
    */
   TexturePtr RetrieveVideoInternal(const RetrieveVideoParams& p) override;
 
+  /**
+   * @brief 把图像读入 buffer_ (必要时缩小)，RetrieveVideoInternal() 只需要上传。
+   */
+  void PrepareVideoInternal(const RetrieveVideoParams& p) override;
+
   /**
    * @brief 内部关闭图像文件解码器的实现。
    */
@@ -78,6 +94,16 @@ class OIIODecoder : public Decoder {
    */
   std::unique_ptr<OIIO::ImageInput> image_;
 
+  /**
+   * @brief 当前打开的子图像索引。
+   */
+  int subimage_;
+
+  /**
+   * @brief 缩小读取时每个条带的源图像行数。
+   */
+  static const int kDownsampleBandRows;
+
   /**
    * @brief 检查给定的文件类型（通过扩展名）是否被此解码器支持。
    * @param fn 文件名。
@@ -98,6 +124,19 @@ class OIIODecoder : public Decoder {
    */
   void CloseImageHandle();
 
+  /**
+   * @brief 将当前打开的图像读取 (并按 divider 缩小) 到 dst 中，dst 会被重新分配。
+   *
+   * divider 大于 1 时优先读取文件自带的、不小于目标尺寸的最小 MIP 层级，再分条带读取并用 BoxDownsampler 缩小到目标尺寸。
+   * @return 如果读取失败则返回 false，此时 dst 被释放，不会留下部分读取的图像。
+   */
+  bool ReadImage(int divider, Frame* dst);
+
+  /**
+   * @brief ReadImage() 在 divider 大于 1 时的实现，dst 已经按目标尺寸分配。
+   */
+  bool ReadDownsampled(Frame* dst);
+
   /**
    * @brief 从 OIIO::ImageSpec 中提取视频参数信息。
    * @param spec OIIO 图像规范对象。
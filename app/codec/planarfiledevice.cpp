@@ -70,6 +70,16 @@ bool PlanarFileDevice::seek(qint64 pos) {
   return ret;
 }
 
+bool PlanarFileDevice::flush() {
+  bool ret = true;
+
+  for (auto &file : files_) {
+    ret = file->flush() & ret;
+  }
+
+  return ret;
+}
+
 void PlanarFileDevice::close() {
   for (auto f : files_) {
     if (f) {
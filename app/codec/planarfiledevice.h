@@ -86,6 +86,12 @@ class PlanarFileDevice : public QObject {
    */
   bool seek(qint64 pos);
 
+  /**
+   * @brief 把所有文件缓冲区中的数据写入操作系统，之后其他进程或映射可以读取到这些数据。
+   * @return bool 如果所有文件都成功刷新，则返回 true。
+   */
+  bool flush();
+
   /**
    * @brief 关闭所有打开的平面文件并释放相关资源。
    */
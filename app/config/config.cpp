@@ -44,6 +44,8 @@ void Config::SetDefaults() {
   SetEntryInternal(QStringLiteral("AutorecoveryInterval"), NodeValue::kInt, 1);
   SetEntryInternal(QStringLiteral("AutorecoveryMaximum"), NodeValue::kInt, 20);
   SetEntryInternal(QStringLiteral("DiskCacheSaveInterval"), NodeValue::kInt, 10000);
+  SetEntryInternal(QStringLiteral("FrameMemoryCacheSize"), NodeValue::kInt, 2048);
+  SetEntryInternal(QStringLiteral("ReversePlaybackCacheSize"), NodeValue::kInt, 512);
   SetEntryInternal(QStringLiteral("Language"), NodeValue::kText, QString());
   SetEntryInternal(QStringLiteral("ScrollZooms"), NodeValue::kBoolean, false);
   SetEntryInternal(QStringLiteral("EnableSeekToImport"), NodeValue::kBoolean, false);
@@ -92,6 +94,7 @@ void Config::SetDefaults() {
   SetEntryInternal(QStringLiteral("AntialiasSubtitles"), NodeValue::kBoolean, true);
 
   SetEntryInternal(QStringLiteral("AutoCacheDelay"), NodeValue::kInt, 1000);
+  SetEntryInternal(QStringLiteral("RenderThreadCount"), NodeValue::kInt, 0);
 
   SetEntryInternal(QStringLiteral("CatColor0"), NodeValue::kInt, ColorCoding::kRed);
   SetEntryInternal(QStringLiteral("CatColor1"), NodeValue::kInt, ColorCoding::kMaroon);
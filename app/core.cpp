@@ -16,6 +16,7 @@
 #endif
 
 #include "audio/audiomanager.h"
+#include "cli/cliexport/cliexportmanager.h"
 #include "cli/clitask/clitaskdialog.h"
 #include "codec/conformmanager.h"
 #include "common/filefunctions.h"
@@ -35,6 +36,7 @@
 #include "node/color/colormanager/colormanager.h"
 #include "node/factory.h"
 #include "node/nodeundo.h"
+#include "node/project/serializer/recoveryjournal.h"
 #include "node/project/serializer/serializer.h"
 #include "panel/panelmanager.h"
 #include "panel/project/project.h"
@@ -42,6 +44,7 @@
 #include "render/diskmanager.h"
 #include "render/framemanager.h"
 #include "render/rendermanager.h"
+#include "render/tracerecorder.h"
 #ifdef USE_OTIO
 #include "task/project/loadotio/loadotio.h"
 #include "task/project/saveotio/saveotio.h"
@@ -66,6 +69,7 @@ Core* Core::instance_ = nullptr;
 Core::Core(CoreParams params)
     : main_window_(nullptr),
       open_project_(nullptr),
+      autorecovery_journal_(nullptr),
       tool_(Tool::kPointer),
       addable_object_(Tool::kAddableEmpty),
       snapping_(true),
@@ -124,11 +128,23 @@ void Core::Start() {
   ConformManager::CreateInstance();
 
   // Initialize RenderManager
-  RenderManager::CreateInstance();
+  if (core_params_.software_render() && core_params_.run_mode() != CoreParams::kRunNormal) {
+    RenderManager::CreateInstance(RenderManager::kSoftware, core_params_.software_render_verify());
+  } else {
+    if (core_params_.software_render()) {
+      qWarning() << "Software rendering is only available in headless modes, using OpenGL";
+    }
+    RenderManager::CreateInstance();
+  }
 
   // Initialize FrameManager
   FrameManager::CreateInstance();
 
+  // Start recording render timings if requested
+  if (!core_params_.trace_file().isEmpty()) {
+    TraceRecorder::instance()->SetEnabled(true);
+  }
+
   // Initialize project serializers
   ProjectSerializer::Initialize();
 
@@ -147,7 +163,9 @@ void Core::Start() {
       QMetaObject::invokeMethod(this, "OpenStartupProject", Qt::QueuedConnection);
       break;
     case CoreParams::kHeadlessExport:
-      qInfo() << "Headless export is not fully implemented yet";
+      // Run once the event loop has started, worker processes are managed through it
+      QMetaObject::invokeMethod(
+          this, [this] { QCoreApplication::exit(StartHeadlessExport() ? 0 : 1); }, Qt::QueuedConnection);
       break;
     case CoreParams::kHeadlessPreCache:
       qInfo() << "Headless pre-cache is not fully implemented yet";
@@ -181,6 +199,15 @@ void Core::Stop() {
 
   RenderManager::DestroyInstance();
 
+  // All renders have finished by now, so the trace is complete
+  if (!core_params_.trace_file().isEmpty()) {
+    if (TraceRecorder::instance()->ExportChromeTrace(core_params_.trace_file())) {
+      qInfo() << "Wrote render trace to" << core_params_.trace_file();
+    } else {
+      qWarning() << "Failed to write render trace to" << core_params_.trace_file();
+    }
+  }
+
   MenuShared::DestroyInstance();
 
   TaskManager::DestroyInstance();
@@ -435,6 +462,10 @@ bool Core::AddOpenProjectFromTask(Task* task, bool add_to_recents) {
 void Core::SetActiveProject(Project* p) {
   if (open_project_) {
     disconnect(open_project_, &Project::ModifiedChanged, this, &Core::ProjectWasModified);
+
+    // Waits for anything it's still writing
+    delete autorecovery_journal_;
+    autorecovery_journal_ = nullptr;
   }
 
   open_project_ = p;
@@ -443,6 +474,8 @@ void Core::SetActiveProject(Project* p) {
 
   if (open_project_) {
     connect(open_project_, &Project::ModifiedChanged, this, &Core::ProjectWasModified);
+
+    autorecovery_journal_ = new RecoveryJournal(open_project_, GetAutoRecoveryDirectory(open_project_), this);
   }
 }
 
@@ -523,88 +556,23 @@ bool Core::ConfirmImageSequence(const QString& filename) {
 void Core::ProjectWasModified(bool e) { main_window_->setWindowModified(e); }
 
 bool Core::StartHeadlessExport() {
-  const QString& startup_project = core_params_.startup_project();
+  CLIExportManager manager(core_params_.startup_project(), core_params_.export_preset());
 
-  if (startup_project.isEmpty()) {
-    qCritical().noquote() << tr("You must specify a project file to export");
-    return false;
-  }
+  manager.set_output(core_params_.export_output());
+  manager.set_sequence(core_params_.export_sequence());
+  manager.set_workers(core_params_.export_workers());
 
-  if (!QFileInfo::exists(startup_project)) {
-    qCritical().noquote() << tr("Specified project does not exist");
-    return false;
+  if (core_params_.has_export_range()) {
+    manager.set_range(core_params_.export_range());
   }
 
-  // Start a load task and try running it
-  ProjectLoadTask plm(startup_project);
-  CLITaskDialog task_dialog(&plm);
-
-  /*
-  if (task_dialog.Run()) {
-    std::unique_ptr<Project> p = std::unique_ptr<Project>(plm.GetLoadedProject());
-    QVector<Item*> items = p->get_items_of_type(Item::kSequence);
-
-    // Check if this project contains sequences
-    if (items.isEmpty()) {
-      qCritical().noquote() << tr("Project contains no sequences, nothing to export");
-      return false;
-    }
-
-    Sequence* sequence = nullptr;
-
-    // Check if this project contains multiple sequences
-    if (items.size() > 1) {
-      qInfo().noquote() << tr("This project has multiple sequences. Which do you wish to export?");
-      for (int i=0;i<items.size();i++) {
-        std::cout << "[" << i << "] " << items.at(i)->GetLabel().toUtf8().constData();
-      }
-
-      QTextStream stream(stdin);
-      QString sequence_read;
-      int sequence_index = -1;
-      QString quit_code = QStringLiteral("q");
-      std::string prompt = tr("Enter number (or %1 to cancel): ").arg(quit_code).toUtf8().constData();
-      forever {
-        std::cout << prompt;
-
-        stream.readLineInto(&sequence_read);
-
-        if (!QString::compare(sequence_read, quit_code, Qt::CaseInsensitive)) {
-          return false;
-        }
-
-        bool ok;
-        sequence_index = sequence_read.toInt(&ok);
-
-        if (ok && sequence_index >= 0 && sequence_index < items.size()) {
-          break;
-        } else {
-          qCritical().noquote() << tr("Invalid sequence number");
-        }
-      }
-
-      sequence = static_cast<Sequence*>(items.at(sequence_index));
-    } else {
-      sequence = static_cast<Sequence*>(items.first());
-    }
-
-    ExportParams params;
-    ExportTask export_task(sequence->viewer_output(), p->color_manager(), params);
-    CLITaskDialog export_dialog(&export_task);
-    if (export_dialog.Run()) {
-      qInfo().noquote() << tr("Export succeeded");
-      return true;
-    } else {
-      qInfo().noquote() << tr("Export failed: %1").arg(export_task.GetError());
-      return false;
-    }
-  } else {
-    qCritical().noquote() << tr("Project failed to load: %1").arg(plm.GetError());
-    return false;
+  if (core_params_.export_streams() == QStringLiteral("video")) {
+    manager.set_streams(CLIExportManager::kVideoOnly);
+  } else if (core_params_.export_streams() == QStringLiteral("audio")) {
+    manager.set_streams(CLIExportManager::kAudioOnly);
   }
-  */
 
-  return false;
+  return manager.Run();
 }
 
 void Core::OpenStartupProject() {
@@ -697,6 +665,9 @@ void Core::StartGUI(bool full_screen) {
   connect(&autorecovery_timer_, &QTimer::timeout, this, &Core::SaveAutorecovery);
   autorecovery_timer_.start();
 
+  // Changes are journaled as they're committed rather than waiting for the timer
+  connect(&undo_stack_, &UndoStack::indexChanged, this, &Core::JournalAutorecovery);
+
   // Load recently opened projects list
   {
     QFile recent_projects_file(GetRecentProjectsFilePath());
@@ -736,11 +707,12 @@ void Core::SaveProjectInternal(const QString& override_filename) {
     }
   }
 
-  // We don't use a TaskDialog here because a model save dialog is annoying, particularly when
-  // saving auto-recoveries that the user can't anticipate. Doing this in the main thread will
-  // cause a brief (but often unnoticeable) pause in the GUI, which, while not ideal, is not that
-  // different from what already happened (modal dialog preventing use of the GUI) and in many ways
-  // less annoying (doesn't disrupt any current actions or pull focus from elsewhere).
+  // We don't use a TaskDialog here because a model save dialog is annoying. (Auto-recoveries don't
+  // come through here at all, they're journaled in the background by RecoveryJournal.) Doing this
+  // in the main thread will cause a brief (but often unnoticeable) pause in the GUI, which, while
+  // not ideal, is not that different from what already happened (modal dialog preventing use of
+  // the GUI) and in many ways less annoying (doesn't disrupt any current actions or pull focus from
+  // elsewhere).
   //
   // Ideally we could do this in a background thread and show progress in the status bar like
   // Microsoft Word, but that would be far more complex. If it becomes necessary in the future,
@@ -861,38 +833,58 @@ void Core::SaveRecentProjectsList() {
   }
 }
 
+QString Core::GetAutoRecoveryDirectory(const Project* p) {
+  return QDir(FileFunctions::GetAutoRecoveryRoot()).filePath(p->GetUuid().toString());
+}
+
+void Core::TrackAutorecovery(const QDir& dir) {
+  // Keep track of projects that where the "newest" save is the recovery project
+  if (!autorecovered_projects_.contains(open_project_->GetUuid())) {
+    autorecovered_projects_.append(open_project_->GetUuid());
+  }
+
+  // Write human-readable real name so it's not just a UUID
+  {
+    QFile realname_file(dir.filePath(QStringLiteral("realname.txt")));
+    realname_file.open(QFile::WriteOnly);
+    realname_file.write(open_project_->pretty_filename().toUtf8());
+    realname_file.close();
+  }
+}
+
+void Core::JournalAutorecovery() {
+  if (OLIVE_CONFIG("AutorecoveryEnabled").toBool() && open_project_ && open_project_->is_modified()) {
+    QDir project_autorecovery_dir(GetAutoRecoveryDirectory(open_project_));
+
+    // Flush() only serializes the nodes that changed and does the writing in the background, so this is cheap enough
+    // to do after every command
+    if (FileFunctions::DirectoryIsValid(project_autorecovery_dir) && autorecovery_journal_->Flush() &&
+        !autorecovered_projects_.contains(open_project_->GetUuid())) {
+      TrackAutorecovery(project_autorecovery_dir);
+      SaveUnrecoveredList();
+    }
+  }
+}
+
 void Core::SaveAutorecovery() {
   if (OLIVE_CONFIG("AutorecoveryEnabled").toBool()) {
     if (open_project_ && !open_project_->has_autorecovery_been_saved()) {
-      QDir project_autorecovery_dir(
-          QDir(FileFunctions::GetAutoRecoveryRoot()).filePath(open_project_->GetUuid().toString()));
+      QDir project_autorecovery_dir(GetAutoRecoveryDirectory(open_project_));
       if (FileFunctions::DirectoryIsValid(project_autorecovery_dir)) {
-        QString this_autorecovery_path = project_autorecovery_dir.filePath(
-            QStringLiteral("%1.ove").arg(QString::number(QDateTime::currentSecsSinceEpoch())));
-
-        SaveProjectInternal(this_autorecovery_path);
+        // Everything up to now is already in the journal, this just writes a fresh snapshot from the journal's copy
+        // of the project (on its own thread) so the journal doesn't grow forever
+        QString this_autorecovery_path = autorecovery_journal_->Compact(main_window_->SaveLayout());
 
         open_project_->set_autorecovery_saved(true);
 
-        // Keep track of projects that where the "newest" save is the recovery project
-        if (!autorecovered_projects_.contains(open_project_->GetUuid())) {
-          autorecovered_projects_.append(open_project_->GetUuid());
-        }
+        TrackAutorecovery(project_autorecovery_dir);
 
-        qDebug() << "Saved auto-recovery to:" << this_autorecovery_path;
-
-        // Write human-readable real name so it's not just a UUID
-        {
-          QFile realname_file(project_autorecovery_dir.filePath(QStringLiteral("realname.txt")));
-          realname_file.open(QFile::WriteOnly);
-          realname_file.write(open_project_->pretty_filename().toUtf8());
-          realname_file.close();
-        }
+        qDebug() << "Saving auto-recovery to:" << this_autorecovery_path;
 
         int64_t max_recoveries_per_file = OLIVE_CONFIG("AutorecoveryMaximum").toLongLong();
 
-        // Since we write an extra file, increment total allowed files by 1
-        max_recoveries_per_file++;
+        // Since we write extra files (the real name and the current journal), increment total allowed files by 2
+        max_recoveries_per_file += 2;
 
         // Delete old entries
         QStringList recovery_files = project_autorecovery_dir.entryList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name);
@@ -901,11 +893,16 @@ void Core::SaveAutorecovery() {
           for (int i = 0; i < recovery_files.size(); i++) {
             const QString& f = recovery_files.at(i);
 
-            if (f.endsWith(QStringLiteral(".ove"), Qt::CaseInsensitive)) {
+            if (f.endsWith(RecoveryJournal::kSnapshotExtension, Qt::CaseInsensitive)) {
               QString delete_full_path = project_autorecovery_dir.filePath(f);
               qDebug() << "Deleted old recovery:" << delete_full_path;
               QFile::remove(delete_full_path);
               recovery_files.removeAt(i);
+
+              // Its journal is useless without it
+              QString journal = RecoveryJournal::GetJournalFilename(delete_full_path);
+              QFile::remove(journal);
+              recovery_files.removeOne(QFileInfo(journal).fileName());
               deleted = true;
               break;
             }
@@ -1482,6 +1479,13 @@ void Core::OpenProject() {
   }
 }
 
-Core::CoreParams::CoreParams() : mode_(kRunNormal), run_fullscreen_(false), crash_(false) {}
+Core::CoreParams::CoreParams()
+    : mode_(kRunNormal),
+      run_fullscreen_(false),
+      crash_(false),
+      software_render_(false),
+      software_render_verify_(false),
+      export_workers_(1),
+      has_export_range_(false) {}
 
 }  // namespace olive
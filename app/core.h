@@ -2,6 +2,7 @@
 #define CORE_H
 
 #include <olive/core/core.h>  // 引入 Olive 核心库的基础定义 (例如 olive::core::rational, Timecode, SampleFormat)
+#include <QDir>               // 引入 QDir，用于自动恢复目录
 #include <QFileInfoList>      // 引入 QFileInfoList，用于处理文件和目录列表
 #include <QList>              // 引入 QList 容器
 #include <QObject>            // 引入 QObject 基类
@@ -22,6 +23,7 @@
 // 如果它们的完整定义已在上述头文件中，则可能非必需。
 namespace olive {
 class MainWindow;
+class RecoveryJournal;
 // class Folder; // 已在 node/project/footage/footage.h 中通过 project.h 间接包含
 // class ViewerOutput; // 通常是 Node 的派生类
 // class Node; // 已在 node/project.h 中包含
@@ -132,12 +134,98 @@ class Core : public QObject {
       crash_ = true;
     }  // 注意：这里无论 e 为何值，crash_ 都被设为 true。这可能是一个笔误，或者是有意为之的设计。
 
+    /**
+     * @brief 获取是否使用纯 CPU 的软件渲染器（仅在无头模式下生效）。
+     * @return 如果使用软件渲染器则返回 true。
+     */
+    [[nodiscard]] bool software_render() const { return software_render_; }
+
+    /**
+     * @brief 设置是否使用软件渲染器。
+     * @param e true 表示使用软件渲染器。
+     */
+    void set_software_render(bool e) { software_render_ = e; }
+
+    /**
+     * @brief 获取是否将软件渲染结果与 OpenGL 逐像素比较（需要可用的 OpenGL 上下文）。
+     * @return 如果启用校验则返回 true。
+     */
+    [[nodiscard]] bool software_render_verify() const { return software_render_verify_; }
+
+    /**
+     * @brief 设置是否启用软件渲染校验。
+     * @param e true 表示启用校验。
+     */
+    void set_software_render_verify(bool e) { software_render_verify_ = e; }
+
+    /**
+     * @brief 获取退出时写入渲染跟踪 (Chrome 跟踪事件 JSON) 的文件路径。
+     * @return 如果为空，则不在启动时启用跟踪。
+     */
+    [[nodiscard]] const QString& trace_file() const { return trace_file_; }
+
+    /**
+     * @brief 设置退出时写入渲染跟踪的文件路径，非空时会在启动时启用跟踪。
+     * @param f 文件路径。
+     */
+    void set_trace_file(const QString& f) { trace_file_ = f; }
+
+    /**
+     * @brief 无头导出使用的导出预设文件。
+     */
+    [[nodiscard]] const QString& export_preset() const { return export_preset_; }
+    void set_export_preset(const QString& f) { export_preset_ = f; }
+
+    /**
+     * @brief 无头导出的输出文件，为空时使用预设中的文件名。
+     */
+    [[nodiscard]] const QString& export_output() const { return export_output_; }
+    void set_export_output(const QString& f) { export_output_ = f; }
+
+    /**
+     * @brief 无头导出的序列名称，为空时导出第一个序列。
+     */
+    [[nodiscard]] const QString& export_sequence() const { return export_sequence_; }
+    void set_export_sequence(const QString& s) { export_sequence_ = s; }
+
+    /**
+     * @brief 无头导出使用的工作进程数量，大于 1 时把导出范围分给多个进程。
+     */
+    [[nodiscard]] int export_workers() const { return export_workers_; }
+    void set_export_workers(int n) { export_workers_ = n; }
+
+    /**
+     * @brief 只导出此范围 (由渲染农场的主进程传给工作进程)。
+     */
+    [[nodiscard]] bool has_export_range() const { return has_export_range_; }
+    [[nodiscard]] const TimeRange& export_range() const { return export_range_; }
+    void set_export_range(const TimeRange& r) {
+      export_range_ = r;
+      has_export_range_ = true;
+    }
+
+    /**
+     * @brief 工作进程要导出的流 ("video" 或 "audio")，为空时导出所有流。
+     */
+    [[nodiscard]] const QString& export_streams() const { return export_streams_; }
+    void set_export_streams(const QString& s) { export_streams_ = s; }
+
    private:
     RunMode mode_;              ///< 应用程序的运行模式。
     QString startup_project_;   ///< 启动时加载的项目路径。
     QString startup_language_;  ///< 启动时使用的语言。
     bool run_fullscreen_;       ///< 是否以全屏模式启动。
     bool crash_;                ///< 是否在启动时故意崩溃（用于测试）。
+    bool software_render_;         ///< 是否使用软件渲染器。
+    bool software_render_verify_;  ///< 是否将软件渲染结果与 OpenGL 比较。
+    QString trace_file_;           ///< 退出时写入渲染跟踪的文件。
+    QString export_preset_;        ///< 无头导出的预设文件。
+    QString export_output_;        ///< 无头导出的输出文件。
+    QString export_sequence_;      ///< 无头导出的序列名称。
+    int export_workers_;           ///< 无头导出的工作进程数量。
+    TimeRange export_range_;       ///< 工作进程导出的范围。
+    bool has_export_range_;        ///< export_range_ 是否有效。
+    QString export_streams_;       ///< 工作进程导出的流。
   };
 
   /**
@@ -623,6 +711,17 @@ class Core : public QObject {
    */
   void SaveUnrecoveredList();
 
+  /**
+   * @brief 获取项目的自动恢复目录 (自动恢复根目录下以项目 UUID 命名的子目录)。
+   */
+  static QString GetAutoRecoveryDirectory(const Project* p);
+
+  /**
+   * @brief 记录当前项目有自动恢复数据：写入其可读名称，并把它加入未恢复的项目列表。
+   * @param dir 项目的自动恢复目录。
+   */
+  void TrackAutorecovery(const QDir& dir);
+
   /**
    * @brief 恢复项目的内部实现。
    * @param by_opening_existing 如果为 true，表示恢复是通过打开一个已存在的（可能是备份）文件。
@@ -665,7 +764,8 @@ class Core : public QObject {
   QString selected_transition_;         ///< 当前“转场工具”选中的转场类型ID。
   bool snapping_;                       ///< 当前的吸附启用状态。
 
-  QTimer autorecovery_timer_;    ///< 用于触发自动保存恢复文件的定时器。
+  QTimer autorecovery_timer_;    ///< 用于触发自动恢复快照的定时器。
+  RecoveryJournal* autorecovery_journal_;  ///< 当前项目的自动恢复日志，每次撤销栈变化后追加增量。
   UndoStack undo_stack_;         ///< 应用程序范围内的撤销/重做栈实例。
   QStringList recent_projects_;  ///< 最近打开/保存的项目文件路径列表。
 
@@ -684,12 +784,20 @@ class Core : public QObject {
 
  private slots:
   /**
-   * @brief 保存自动恢复文件的槽函数。
+   * @brief 写出自动恢复快照的槽函数。
    *
-   * 由 autorecovery_timer_ 触发。
+   * 由 autorecovery_timer_ 触发。修改已经随时写入日志，这里只是在后台从日志的项目副本写出一个新的快照，
+   * 使日志不会无限增长。
    */
   void SaveAutorecovery();
 
+  /**
+   * @brief 把当前项目自上次写入以来的修改追加到自动恢复日志中。
+   *
+   * 撤销栈每次变化 (提交、撤销、重做) 后调用。
+   */
+  void JournalAutorecovery();
+
   /**
    * @brief 项目保存成功后调用的槽函数。
    * @param task 完成的项目保存任务。
@@ -723,8 +831,8 @@ class Core : public QObject {
   void ProjectWasModified(bool e);
 
   /**
-   * @brief 启动无头导出过程的槽函数。
-   * @return 如果导出过程成功启动，返回 true。
+   * @brief 执行无头导出 (单进程或分给多个工作进程)，完成前阻塞。
+   * @return 导出是否成功。
    */
   bool StartHeadlessExport();
 
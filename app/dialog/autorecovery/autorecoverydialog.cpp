@@ -3,11 +3,14 @@
 #include <QDateTime>
 #include <QDialogButtonBox>
 #include <QDir>
+#include <QFileInfo>
 #include <QLabel>
+#include <QMessageBox>
 #include <QPushButton>
 #include <QVBoxLayout>
 
 #include "core.h"
+#include "node/project/serializer/recoveryjournal.h"
 
 namespace olive {
 
@@ -25,6 +28,23 @@ void AutoRecoveryDialog::accept() {
   foreach (QTreeWidgetItem* checkable, checkable_items_) {
     if (checkable->checkState(0) == Qt::Checked) {
       QString filename = checkable->data(0, kFilenameRole).toString();
+
+      if (filename.endsWith(RecoveryJournal::kJournalExtension)) {
+        // Apply the journal to its snapshot to get a project we can open, without touching either of them in case
+        // the user wants to try again
+        QFileInfo info(filename);
+        QString replayed = QDir::temp().filePath(QStringLiteral("%1-%2%3").arg(
+            info.dir().dirName(), info.completeBaseName(), RecoveryJournal::kSnapshotExtension));
+
+        if (!RecoveryJournal::Replay(filename, replayed)) {
+          QMessageBox::critical(this, tr("Auto-Recovery Error"),
+                                tr("Failed to replay the changes in \"%1\".").arg(filename));
+          continue;
+        }
+
+        filename = replayed;
+      }
+
       Core::instance()->OpenRecoveryProject(filename);
     }
   }
@@ -80,8 +100,14 @@ void AutoRecoveryDialog::PopulateTree(const QStringList& recoveries, bool autoch
       // Populate with recoveries
       QStringList entries = recovery_dir.entryList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name | QDir::Reversed);
       for (const auto& entry : entries) {
-        if (entry.endsWith(QStringLiteral(".ove"), Qt::CaseInsensitive)) {
-          auto* entry_item = new QTreeWidgetItem(top_level);
+        if (entry.endsWith(RecoveryJournal::kSnapshotExtension, Qt::CaseInsensitive)) {
+          // Changes journaled after this snapshot are newer than it, so list them first. An empty journal is just
+          // its header.
+          QFileInfo journal(RecoveryJournal::GetJournalFilename(recovery_dir.filePath(entry)));
+          if (journal.size() > 4) {
+            AddEntry(top_level, journal.filePath(),
+                     tr("%1 (latest changes)").arg(journal.lastModified().toString()), autocheck_latest);
+          }
 
           bool ok;
           qint64 recovery_time = entry.left(entry.indexOf('.')).toLongLong(&ok);
@@ -95,18 +121,24 @@ void AutoRecoveryDialog::PopulateTree(const QStringList& recoveries, bool autoch
             entry_name = entry;
           }
 
-          entry_item->setText(0, entry_name);
-          entry_item->setData(0, kFilenameRole, recovery_dir.filePath(entry));
-
-          // Allow to be checked, auto-checking the first entry
-          entry_item->setCheckState(0,
-                                    (autocheck_latest && top_level->childCount() == 1) ? Qt::Checked : Qt::Unchecked);
-
-          checkable_items_.append(entry_item);
+          AddEntry(top_level, recovery_dir.filePath(entry), entry_name, autocheck_latest);
         }
       }
     }
   }
 }
 
+void AutoRecoveryDialog::AddEntry(QTreeWidgetItem* parent, const QString& filename, const QString& name,
+                                  bool autocheck_latest) {
+  auto* entry_item = new QTreeWidgetItem(parent);
+
+  entry_item->setText(0, name);
+  entry_item->setData(0, kFilenameRole, filename);
+
+  // Allow to be checked, auto-checking the first entry
+  entry_item->setCheckState(0, (autocheck_latest && parent->childCount() == 1) ? Qt::Checked : Qt::Unchecked);
+
+  checkable_items_.append(entry_item);
+}
+
 }  // namespace olive
@@ -55,6 +55,12 @@ class AutoRecoveryDialog : public QDialog {
    */
   void PopulateTree(const QStringList& recoveries, bool autocheck);
 
+  /**
+   * @brief 在 parent 下添加一个可勾选的恢复项 (快照，或者快照之后的日志)。
+   * @param autocheck_latest 如果为 true，parent 下的第一项会被自动勾选。
+   */
+  void AddEntry(QTreeWidgetItem* parent, const QString& filename, const QString& name, bool autocheck_latest);
+
   /**
    * @brief 指向 QTreeWidget 对象的指针，用于显示可恢复文件列表。
    * 使用 `{}` 进行值初始化，确保在构造时为 nullptr 或默认状态。
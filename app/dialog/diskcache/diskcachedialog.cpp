@@ -4,9 +4,11 @@
 #include <QGridLayout>
 #include <QLabel>
 #include <QMessageBox>
+#include <QTimer>
 
 #include "config/config.h"
 #include "core.h"
+#include "render/framememorycache.h"
 
 namespace olive {
 
@@ -43,6 +45,27 @@ DiskCacheDialog::DiskCacheDialog(DiskCacheFolder *folder, QWidget *parent) : QDi
 
   row++;
 
+  layout->addWidget(new QLabel(tr("Maximum Memory Cache:")), row, 0);
+
+  maximum_memory_slider_ = new FloatSlider();
+  maximum_memory_slider_->SetFormat(tr("%1 GB"));
+  maximum_memory_slider_->SetMinimum(0.0);
+  maximum_memory_slider_->SetValue(OLIVE_CONFIG("FrameMemoryCacheSize").toDouble() / 1024.0);
+  layout->addWidget(maximum_memory_slider_, row, 1);
+
+  row++;
+
+  memory_statistics_label_ = new QLabel();
+  layout->addWidget(memory_statistics_label_, row, 0, 1, 2);
+  UpdateMemoryStatistics();
+
+  auto *statistics_timer = new QTimer(this);
+  statistics_timer->setInterval(500);
+  connect(statistics_timer, &QTimer::timeout, this, &DiskCacheDialog::UpdateMemoryStatistics);
+  statistics_timer->start();
+
+  row++;
+
   auto *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
   connect(buttons, &QDialogButtonBox::accepted, this, &DiskCacheDialog::accept);
   connect(buttons, &QDialogButtonBox::rejected, this, &DiskCacheDialog::reject);
@@ -59,9 +82,31 @@ void DiskCacheDialog::accept() {
     folder_->SetClearOnClose(clear_disk_cache_->isChecked());
   }
 
+  int new_memory_cache_limit = qRound(maximum_memory_slider_->GetValue() * 1024.0);
+  if (new_memory_cache_limit != OLIVE_CONFIG("FrameMemoryCacheSize").toInt()) {
+    OLIVE_CONFIG("FrameMemoryCacheSize") = new_memory_cache_limit;
+    FrameMemoryCache::instance()->UpdateLimit();
+  }
+
   QDialog::accept();
 }
 
+void DiskCacheDialog::UpdateMemoryStatistics() {
+  FrameMemoryCache::Statistics s = FrameMemoryCache::instance()->GetStatistics();
+
+  qint64 lookups = s.hits + s.misses;
+  double hit_rate = lookups ? 100.0 * double(s.hits) / double(lookups) : 0.0;
+
+  memory_statistics_label_->setText(
+      tr("Memory Cache: %1 frames, %2 of %3 MB used\n"
+         "Hits: %4 (%5%), Misses: %6, Evictions: %7\n"
+         "Pending Disk Writes: %8, Failed Writes: %9")
+          .arg(QString::number(s.frame_count), QString::number(s.used_bytes / (1024 * 1024)),
+               QString::number(s.limit_bytes / (1024 * 1024)), QString::number(s.hits),
+               QString::number(hit_rate, 'f', 1), QString::number(s.misses), QString::number(s.evictions),
+               QString::number(s.pending_writes), QString::number(s.failed_writes)));
+}
+
 void DiskCacheDialog::ClearDiskCache() { ClearDiskCache(folder_->GetPath(), this, clear_cache_btn_); }
 
 void DiskCacheDialog::ClearDiskCache(const QString &path, QWidget *parent, QPushButton *clear_btn) {
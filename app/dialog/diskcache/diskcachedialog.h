@@ -3,6 +3,7 @@
 
 #include <QCheckBox>    // 复选框控件
 #include <QDialog>      // QDialog 基类
+#include <QLabel>       // 内存缓存统计标签
 #include <QPushButton>  // 按钮控件
 #include <QString>      // 为了路径参数
 #include <QWidget>      // 为了 QWidget* parent 参数
@@ -64,6 +65,16 @@ class DiskCacheDialog : public QDialog {
    */
   FloatSlider* maximum_cache_slider_;
 
+  /**
+   * @brief 设置内存缓存 (FrameMemoryCache) 大小的滑块，单位为 GB。
+   */
+  FloatSlider* maximum_memory_slider_;
+
+  /**
+   * @brief 显示内存缓存命中/未命中/淘汰等计数的标签。
+   */
+  QLabel* memory_statistics_label_;
+
   /**
    * @brief 指向 QCheckBox 控件的指针，可能用于在接受对话框时触发缓存清理。
    * (或者也可能是一个独立的“立即清理”选项，具体取决于UI设计)
@@ -81,6 +92,11 @@ class DiskCacheDialog : public QDialog {
    * 此函数将调用静态的 `ClearDiskCache` 方法来清理与 `folder_` 关联的磁盘缓存。
    */
   void ClearDiskCache();
+
+  /**
+   * @brief 刷新内存缓存的统计信息 (由定时器定期调用)。
+   */
+  void UpdateMemoryStatistics();
 };
 
 }  // namespace olive
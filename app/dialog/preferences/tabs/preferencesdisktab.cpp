@@ -60,6 +60,16 @@ PreferencesDiskTab::PreferencesDiskTab() {
   cache_behind_slider_->SetValue(OLIVE_CONFIG("DiskCacheBehind").value<rational>().toDouble());
   cache_behavior_layout->addWidget(cache_behind_slider_, row, 3);
 
+  row++;
+
+  cache_behavior_layout->addWidget(new QLabel(tr("Reverse Playback Memory:")), row, 0);
+
+  reverse_playback_memory_slider_ = new IntegerSlider();
+  reverse_playback_memory_slider_->SetMinimum(0);
+  reverse_playback_memory_slider_->SetFormat(tr("%1 MiB"));
+  reverse_playback_memory_slider_->SetValue(OLIVE_CONFIG("ReversePlaybackCacheSize").toLongLong());
+  cache_behavior_layout->addWidget(reverse_playback_memory_slider_, row, 1);
+
   outer_layout->addStretch();
 }
 
@@ -91,6 +101,7 @@ void PreferencesDiskTab::Accept(MultiUndoCommand* command) {
 
   OLIVE_CONFIG("DiskCacheBehind") = QVariant::fromValue(rational::fromDouble(cache_behind_slider_->GetValue()));
   OLIVE_CONFIG("DiskCacheAhead") = QVariant::fromValue(rational::fromDouble(cache_ahead_slider_->GetValue()));
+  OLIVE_CONFIG("ReversePlaybackCacheSize") = int(reverse_playback_memory_slider_->GetValue());
 }
 
 }  // namespace olive
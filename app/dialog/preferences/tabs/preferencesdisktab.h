@@ -9,6 +9,7 @@
 #include "render/diskmanager.h"                  // 引入磁盘管理器相关定义，可能用于管理磁盘缓存文件夹
 #include "widget/path/pathwidget.h"              // 引入路径选择控件
 #include "widget/slider/floatslider.h"           // 引入浮点数滑块控件
+#include "widget/slider/integerslider.h"         // 引入整数滑块控件
 
 namespace olive {
 
@@ -67,6 +68,13 @@ class PreferencesDiskTab : public ConfigDialogBaseTab {
    */
   FloatSlider* cache_behind_slider_;
 
+  /**
+   * @brief 指向倒放内存预算滑块控件的指针。
+   *
+   * 用于设置倒放或向后穿梭时解码器保留整个 GOP 可使用的内存 (MiB)。
+   */
+  IntegerSlider* reverse_playback_memory_slider_;
+
   /**
    * @brief 指向默认磁盘缓存文件夹对象的指针。
    *
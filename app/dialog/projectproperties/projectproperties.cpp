@@ -4,6 +4,7 @@
 #include <QDialogButtonBox>
 #include <QFileDialog>
 #include <QGroupBox>
+#include <QHBoxLayout>
 #include <QLabel>
 #include <QMessageBox>
 #include <QPushButton>
@@ -104,6 +105,17 @@ ProjectPropertiesDialog::ProjectPropertiesDialog(Project* p, QWidget* parent)
     // Check the radio button that should currently be active
     disk_cache_radios_[working_project_->GetCacheLocationSetting()]->setChecked(true);
 
+    // Cache frame format, trading disk space for playback speed
+    auto* cache_format_layout = new QHBoxLayout();
+    cache_format_layout->addWidget(new QLabel(tr("Frame Format:")));
+    cache_format_ = new QComboBox();
+    for (int i = 0; i < FrameHashCache::kCacheFormatCount; i++) {
+      cache_format_->addItem(FrameHashCache::GetCacheFormatName(static_cast<FrameHashCache::CacheFormat>(i)), i);
+    }
+    cache_format_->setCurrentIndex(cache_format_->findData(working_project_->GetCacheFormat()));
+    cache_format_layout->addWidget(cache_format_, 1);
+    cache_layout->addLayout(cache_format_layout);
+
     // Add disk cache settings button
     auto* disk_cache_settings_btn = new QPushButton(tr("Disk Cache Settings"));
     connect(disk_cache_settings_btn, &QPushButton::clicked, this, &ProjectPropertiesDialog::OpenDiskCacheSettings);
@@ -155,6 +167,12 @@ void ProjectPropertiesDialog::accept() {
     emit DiskManager::instance() -> InvalidateProject(working_project_);
   }
 
+  // Frames already cached in another format stay readable, so changing this doesn't invalidate anything
+  auto cache_format = static_cast<FrameHashCache::CacheFormat>(cache_format_->currentData().toInt());
+  if (cache_format != working_project_->GetCacheFormat()) {
+    working_project_->SetCacheFormat(cache_format);
+  }
+
   // This should ripple changes throughout the graph/cache that the color config has changed, and
   // therefore should be done after the cache path is changed
   if (working_project_->color_manager()->GetConfigFilename() != ocio_filename_->text()) {
@@ -93,6 +93,11 @@ class ProjectPropertiesDialog : public QDialog {
    */
   QRadioButton* disk_cache_radios_[kDiskCacheRadioCount]{};
 
+  /**
+   * @brief 缓存帧格式的下拉列表框。
+   */
+  QComboBox* cache_format_;
+
  private slots:
   /**
    * @brief 私有槽函数：浏览并选择 OCIO 配置文件。
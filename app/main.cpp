@@ -143,6 +143,29 @@ int main(int argc, char *argv[]) {
   auto export_option = parser.AddOption({QStringLiteral("x"), QStringLiteral("-export")},
                                         QCoreApplication::translate("main", "Export only (No GUI)"));
 
+  auto preset_option = parser.AddOption({QStringLiteral("-preset")},
+                                        QCoreApplication::translate("main", "Export preset to use (Export only)"), true,
+                                        QCoreApplication::translate("main", "xml-file"));
+
+  auto output_option = parser.AddOption(
+      {QStringLiteral("o"), QStringLiteral("-output")},
+      QCoreApplication::translate("main", "Override the preset's output file (Export only)"), true,
+      QCoreApplication::translate("main", "file"));
+
+  auto sequence_option =
+      parser.AddOption({QStringLiteral("-sequence")},
+                       QCoreApplication::translate("main", "Name of the sequence to export (Export only)"), true,
+                       QCoreApplication::translate("main", "name"));
+
+  auto workers_option = parser.AddOption(
+      {QStringLiteral("-workers")},
+      QCoreApplication::translate("main", "Split the export between this many worker processes (Export only)"), true,
+      QCoreApplication::translate("main", "count"));
+
+  // Passed by the main export process to its workers
+  auto export_range_option = parser.AddOption({QStringLiteral("-export-range")}, QString(), true, QString(), true);
+  auto export_streams_option = parser.AddOption({QStringLiteral("-export-streams")}, QString(), true, QString(), true);
+
   auto ts_option =
       parser.AddOption({QStringLiteral("-ts")}, QCoreApplication::translate("main", "Override language with file"),
                        true, QCoreApplication::translate("main", "qm-file"));
@@ -150,6 +173,19 @@ int main(int argc, char *argv[]) {
   auto decompress_option = parser.AddOption({QStringLiteral("d"), QStringLiteral("-decompress")},
                                             QCoreApplication::translate("main", "Decompress project file (No GUI)"));
 
+  auto software_render_option =
+      parser.AddOption({QStringLiteral("-software-render")},
+                       QCoreApplication::translate("main", "Render on the CPU instead of the GPU (Export only)"));
+
+  auto software_verify_option = parser.AddOption(
+      {QStringLiteral("-software-render-verify")},
+      QCoreApplication::translate("main", "Compare software rendered frames against OpenGL (Export only)"));
+
+  auto trace_option = parser.AddOption(
+      {QStringLiteral("-trace")},
+      QCoreApplication::translate("main", "Record render timings and write them as a Chrome trace on exit"), true,
+      QCoreApplication::translate("main", "json-file"));
+
 #ifdef _WIN32
   auto console_option = parser.AddOption({QStringLiteral("c"), QStringLiteral("-console")},
                                          QCoreApplication::translate("main", "Launch with debug console"));
@@ -201,6 +237,26 @@ int main(int argc, char *argv[]) {
     startup_params.set_run_mode(olive::Core::CoreParams::kHeadlessExport);
   }
 
+  startup_params.set_export_preset(preset_option->GetSetting());
+  startup_params.set_export_output(output_option->GetSetting());
+  startup_params.set_export_sequence(sequence_option->GetSetting());
+  startup_params.set_export_streams(export_streams_option->GetSetting());
+
+  if (workers_option->IsSet()) {
+    startup_params.set_export_workers(workers_option->GetSetting().toInt());
+  }
+
+  if (export_range_option->IsSet()) {
+    QStringList range = export_range_option->GetSetting().split(':');
+    if (range.size() == 2) {
+      startup_params.set_export_range(
+          olive::core::TimeRange(olive::core::rational::fromString(range.at(0).toStdString()),
+                                 olive::core::rational::fromString(range.at(1).toStdString())));
+    } else {
+      qWarning() << "--export-range must be in the form in:out";
+    }
+  }
+
   if (ts_option->IsSet()) {
     if (ts_option->GetSetting().isEmpty()) {
       qWarning() << "--ts was set but no translation file was provided";
@@ -215,8 +271,15 @@ int main(int argc, char *argv[]) {
 
   startup_params.set_fullscreen(fullscreen_option->IsSet());
 
+  startup_params.set_software_render(software_render_option->IsSet() || software_verify_option->IsSet());
+  startup_params.set_software_render_verify(software_verify_option->IsSet());
+
   startup_params.set_startup_project(project_argument->GetSetting());
 
+  if (trace_option->IsSet()) {
+    startup_params.set_trace_file(trace_option->GetSetting());
+  }
+
   // Set OpenGL display profile
   QSurfaceFormat format;
 
@@ -251,6 +314,10 @@ int main(int argc, char *argv[]) {
 #endif  // _WIN32
 
     a = std::make_unique<QApplication>(argc, argv);
+  } else if (startup_params.software_render_verify()) {
+    // Verification renders every frame with OpenGL too, which needs a GUI application for its
+    // offscreen surface
+    a = std::make_unique<QGuiApplication>(argc, argv);
   } else {
     a = std::make_unique<QCoreApplication>(argc, argv);
   }
@@ -1,5 +1,9 @@
 #include "pan.h"
 
+#include <olive/core/util/cpuoptimize.h>
+
+#include <algorithm>
+
 #include "widget/slider/floatslider.h"
 
 namespace olive {
@@ -49,7 +53,9 @@ void PanNode::Value(const NodeValueRow &value, const NodeGlobals &globals, NodeV
         table->Push(NodeValue(NodeValue::kSamples, samples, this));
       } else {
         // Requires job
-        table->Push(NodeValue::kSamples, SampleJob(globals.time(), kSamplesInput, value), this);
+        SampleJob job(globals.time(), kSamplesInput, value);
+        job.Insert(kPanningInput, value);
+        table->Push(NodeValue::kSamples, QVariant::fromValue(job), this);
       }
     } else {
       // Pass right through
@@ -73,6 +79,42 @@ void PanNode::ProcessSamples(const NodeValueRow &values, const SampleBuffer &inp
   }
 }
 
+void PanNode::ProcessSamples(const SampleParameterBlock &values, const SampleBuffer &input,
+                             SampleBuffer &output) const {
+  for (int i = 0; i < output.audio_params().channel_count(); i++) {
+    output.set(i, input.data(i), output.sample_count());
+  }
+
+  const float *pan = values.Get(kPanningInput);
+  if (!pan || output.audio_params().channel_count() != 2) {
+    return;
+  }
+
+  // Positive pan attenuates the left channel, negative pan attenuates the right
+  size_t count = output.sample_count();
+  std::vector<float> left(count), right(count);
+  size_t unopt_start = 0;
+
+#if defined(OLIVE_PROCESSOR_X86) || defined(OLIVE_PROCESSOR_ARM)
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.0F);
+  unopt_start = (count / 4) * 4;
+  for (size_t j = 0; j < unopt_start; j += 4) {
+    __m128 p = _mm_loadu_ps(pan + j);
+    _mm_storeu_ps(left.data() + j, _mm_sub_ps(one, _mm_max_ps(p, zero)));
+    _mm_storeu_ps(right.data() + j, _mm_add_ps(one, _mm_min_ps(p, zero)));
+  }
+#endif
+
+  for (size_t j = unopt_start; j < count; j++) {
+    left[j] = 1.0F - std::max(pan[j], 0.0F);
+    right[j] = 1.0F + std::min(pan[j], 0.0F);
+  }
+
+  output.transform_volume_for_channel(0, left.data());
+  output.transform_volume_for_channel(1, right.data());
+}
+
 void PanNode::Retranslate() {
   super::Retranslate();
 
@@ -73,6 +73,14 @@ class PanNode : public Node {
   void ProcessSamples(const NodeValueRow &values, const SampleBuffer &input, SampleBuffer &output,
                       int index) const override;
 
+  /**
+   * @brief 块版本的采样处理。
+   *
+   * 根据逐采样的声像值计算左右声道增益，并一次性应用到整个缓冲区 (使用 SSE/NEON 加速)。
+   */
+  void ProcessSamples(const SampleParameterBlock &values, const SampleBuffer &input,
+                      SampleBuffer &output) const override;
+
   /**
    * @brief 重新翻译节点的名称和描述等用户可见的文本。
    *
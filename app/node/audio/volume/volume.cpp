@@ -56,6 +56,17 @@ void VolumeNode::ProcessSamples(const NodeValueRow &values, const SampleBuffer &
   return ProcessSamplesInternal(values, kOpMultiply, kSamplesInput, kVolumeInput, input, output, index);
 }
 
+void VolumeNode::ProcessSamples(const SampleParameterBlock &values, const SampleBuffer &input,
+                                SampleBuffer &output) const {
+  for (int i = 0; i < output.audio_params().channel_count(); i++) {
+    output.set(i, input.data(i), output.sample_count());
+  }
+
+  if (const float *volume = values.Get(kVolumeInput)) {
+    output.transform_volume(volume);
+  }
+}
+
 void VolumeNode::Retranslate() {
   super::Retranslate();
 
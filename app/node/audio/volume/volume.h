@@ -73,6 +73,14 @@ class VolumeNode : public MathNodeBase {
   void ProcessSamples(const NodeValueRow &values, const SampleBuffer &input, SampleBuffer &output,
                       int index) const override;
 
+  /**
+   * @brief 块版本的采样处理。
+   *
+   * 将逐采样的音量包络一次性应用到整个缓冲区 (使用 SSE/NEON 加速)。
+   */
+  void ProcessSamples(const SampleParameterBlock &values, const SampleBuffer &input,
+                      SampleBuffer &output) const override;
+
   /**
    * @brief 重新翻译节点的名称和描述等用户可见的文本。
    *
@@ -40,6 +40,7 @@ CropDistortNode::CropDistortNode() {
 
   SetFlag(kVideoEffect);
   SetEffectInput(kTextureInput);
+  SetFlag(kTimeInvariant);
 }
 
 void CropDistortNode::Retranslate() {
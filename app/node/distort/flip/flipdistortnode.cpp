@@ -17,6 +17,7 @@ FlipDistortNode::FlipDistortNode() {
 
   SetFlag(kVideoEffect);
   SetEffectInput(kTextureInput);
+  SetFlag(kTimeInvariant);
 }
 
 QString FlipDistortNode::Name() const { return tr("Flip"); }
@@ -45,6 +45,7 @@ TransformDistortNode::TransformDistortNode() {
 
   SetFlag(kVideoEffect);
   SetEffectInput(kTextureInput);
+  SetFlag(kTimeInvariant);
 }
 
 void TransformDistortNode::Retranslate() {
@@ -29,6 +29,7 @@ MatrixGenerator::MatrixGenerator() {
            InputFlags(kInputFlagNotConnectable | kInputFlagNotKeyframable));
 
   AddInput(kAnchorInput, NodeValue::kVec2, QVector2D(0.0, 0.0));
+  SetFlag(kTimeInvariant);
 }
 
 QString MatrixGenerator::Name() const { return tr("Orthographic Matrix"); }
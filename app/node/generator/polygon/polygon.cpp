@@ -36,6 +36,7 @@ PolygonGenerator::PolygonGenerator() {
 
   // Initiate gizmos
   poly_gizmo_ = new PathGizmo(this);
+  SetFlag(kTimeInvariant);
 }
 
 QString PolygonGenerator::Name() const { return tr("Polygon"); }
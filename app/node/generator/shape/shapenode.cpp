@@ -12,6 +12,7 @@ ShapeNode::ShapeNode() {
 
   AddInput(kRadiusInput, NodeValue::kFloat, 20.0);
   SetInputProperty(kRadiusInput, QStringLiteral("min"), 0.0);
+  SetFlag(kTimeInvariant);
 }
 
 QString ShapeNode::Name() const { return tr("Shape"); }
@@ -9,6 +9,7 @@ const QString SolidGenerator::kColorInput = QStringLiteral("color_in");
 SolidGenerator::SolidGenerator() {
   // Default to a color that isn't black
   AddInput(kColorInput, NodeValue::kColor, QVariant::fromValue(Color(1.0f, 0.0f, 0.0f, 1.0f)));
+  SetFlag(kTimeInvariant);
 }
 
 QString SolidGenerator::Name() const { return tr("Solid"); }
@@ -34,6 +34,7 @@ TextGeneratorV1::TextGeneratorV1() {
   AddInput(kFontSizeInput, NodeValue::kFloat, 72.0f);
 
   SetFlag(kDontShowInCreateMenu);
+  SetFlag(kTimeInvariant);
 }
 
 QString TextGeneratorV1::Name() const { return tr("Text (Legacy)"); }
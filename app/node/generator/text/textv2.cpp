@@ -36,6 +36,7 @@ TextGeneratorV2::TextGeneratorV2() {
   SetStandardValue(kSizeInput, QVector2D(400, 300));
 
   SetFlag(kDontShowInCreateMenu);
+  SetFlag(kTimeInvariant);
 }
 
 QString TextGeneratorV2::Name() const { return tr("Text (Legacy)"); }
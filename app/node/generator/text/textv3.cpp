@@ -42,6 +42,7 @@ TextGeneratorV3::TextGeneratorV3() : ShapeNodeBase(false), dont_emit_valign_(fal
   text_gizmo_->SetInput(NodeKeyframeTrackReference(NodeInput(this, kTextInput)));
   connect(text_gizmo_, &TextGizmo::Activated, this, &TextGeneratorV3::GizmoActivated);
   connect(text_gizmo_, &TextGizmo::Deactivated, this, &TextGeneratorV3::GizmoDeactivated);
+  SetFlag(kTimeInvariant);
 }
 
 QString TextGeneratorV3::Name() const { return tr("Text"); }
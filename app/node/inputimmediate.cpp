@@ -8,7 +8,7 @@
 namespace olive {
 
 NodeInputImmediate::NodeInputImmediate(NodeValue::Type type, SplitValue default_val)
-    : default_value_(std::move(default_val)), keyframing_(false) {
+    : default_value_(std::move(default_val)), type_(type), keyframing_(false) {
   set_data_type(type);
 }
 
@@ -145,9 +145,38 @@ bool NodeInputImmediate::has_keyframe_at_time(const rational& time) const {
   return false;
 }
 
+KeyframeCurvePtr NodeInputImmediate::get_keyframe_curve(int track) const {
+  const NodeKeyframeTrack& key_track = keyframe_tracks_.at(track);
+  if (key_track.isEmpty()) {
+    return nullptr;
+  }
+
+  QMutexLocker locker(&curve_lock_);
+
+  if (keyframe_curves_.size() != keyframe_tracks_.size()) {
+    keyframe_curves_.resize(keyframe_tracks_.size());
+  }
+
+  KeyframeCurvePtr& curve = keyframe_curves_[track];
+  if (!curve) {
+    curve = std::make_shared<KeyframeCurve>(key_track, type_);
+  }
+
+  return curve;
+}
+
+void NodeInputImmediate::invalidate_keyframe_curves() {
+  QMutexLocker locker(&curve_lock_);
+
+  keyframe_curves_.clear();
+}
+
 void NodeInputImmediate::set_data_type(NodeValue::Type type) {
   int track_size = NodeValue::get_number_of_keyframe_tracks(type);
 
+  type_ = type;
+  invalidate_keyframe_curves();
+
   keyframe_tracks_.resize(track_size);
   standard_value_.resize(track_size);
 
@@ -204,6 +233,7 @@ void NodeInputImmediate::insert_keyframe(NodeKeyframe* key) {
   }
 
   key_track.insert(insert_index, key);
+  invalidate_keyframe_curves();
 
   NodeKeyframe* previous = insert_index > 0 ? key_track.at(insert_index - 1) : nullptr;
   NodeKeyframe* next = insert_index < key_track.size() - 1 ? key_track.at(insert_index + 1) : nullptr;
@@ -233,6 +263,7 @@ void NodeInputImmediate::remove_keyframe(NodeKeyframe* key) {
   key->set_next(nullptr);
 
   keyframe_tracks_[key->track()].removeOne(key);
+  invalidate_keyframe_curves();
 }
 
 void NodeInputImmediate::delete_all_keyframes(QObject* parent) {
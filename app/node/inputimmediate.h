@@ -1,10 +1,13 @@
 #ifndef NODEINPUTIMMEDIATE_H  // 防止头文件被多次包含的宏定义开始
 #define NODEINPUTIMMEDIATE_H
 
-#include "common/xmlutils.h"  // 通用 XML 工具类 (在此头文件中似乎未直接使用，可能在 .cpp 中或间接依赖)
-#include "node/keyframe.h"    // 引入 NodeKeyframe 和 NodeKeyframeTrack 定义
-#include "node/value.h"       // 引入 NodeValue::Type 枚举定义
-#include "splitvalue.h"       // 引入 SplitValue 定义，用于存储和处理多通道参数值
+#include <QMutex>  // 保护编译后的关键帧曲线
+
+#include "common/xmlutils.h"     // 通用 XML 工具类 (在此头文件中似乎未直接使用，可能在 .cpp 中或间接依赖)
+#include "node/keyframe.h"       // 引入 NodeKeyframe 和 NodeKeyframeTrack 定义
+#include "node/keyframecurve.h"  // 编译后的关键帧曲线
+#include "node/value.h"          // 引入 NodeValue::Type 枚举定义
+#include "splitvalue.h"          // 引入 SplitValue 定义，用于存储和处理多通道参数值
 
 // 可能需要的前向声明
 // class NodeInput; // NodeInput 在此被前向声明
@@ -134,6 +137,19 @@ class NodeInputImmediate {
    */
   [[nodiscard]] const QVector<NodeKeyframeTrack>& keyframe_tracks() const { return keyframe_tracks_; }
 
+  /**
+   * @brief 获取一个通道/轨道编译后的关键帧曲线，没有缓存时会先编译。
+   *  编译后的曲线在关键帧被修改前一直有效，此函数可以从多个线程同时调用。
+   * @param track 通道/轨道的索引。
+   * @return KeyframeCurvePtr 编译后的曲线；如果该轨道没有关键帧则为 nullptr。
+   */
+  [[nodiscard]] KeyframeCurvePtr get_keyframe_curve(int track) const;
+
+  /**
+   * @brief 丢弃编译后的关键帧曲线。关键帧的时间、值、类型或贝塞尔控制点改变后必须调用。
+   */
+  void invalidate_keyframe_curves();
+
   /**
    * @brief 检查此输入参数当前是否启用了关键帧动画。
    * @return 如果启用了关键帧则返回 true，否则返回 false (此时使用 standard_value_)。
@@ -202,6 +218,18 @@ class NodeInputImmediate {
    */
   QVector<NodeKeyframeTrack> keyframe_tracks_;
 
+  /**
+   * @brief 此输入参数的数据类型，编译关键帧曲线时用于转换关键帧的值。
+   */
+  NodeValue::Type type_;
+
+  /**
+   * @brief 每个关键帧轨道编译后的曲线，按需编译，由 curve_lock_ 保护。
+   */
+  mutable QVector<KeyframeCurvePtr> keyframe_curves_;
+
+  mutable QMutex curve_lock_;
+
   /**
    * @brief 标记此输入参数当前是否启用了关键帧动画的内部设置。
    */
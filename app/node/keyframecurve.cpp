@@ -0,0 +1,219 @@
+#include "keyframecurve.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/lerp.h"
+
+namespace olive {
+
+namespace {
+
+// Far below a sample at any sample rate we support, and tighter than the 1e-6 the old bisection stopped at
+const double kBezierTolerance = 1e-9;
+const int kBezierMaximumIterations = 64;
+
+double KeyframeValueToDouble(const NodeKeyframe *key, NodeValue::Type type) {
+  if (type == NodeValue::kRational) {
+    return key->value().value<rational>().toDouble();
+  } else {
+    return key->value().toDouble();
+  }
+}
+
+double Polynomial(const double c[4], double t) { return ((c[3] * t + c[2]) * t + c[1]) * t + c[0]; }
+
+void CubicToPolynomial(double a, double b, double c, double d, double out[4]) {
+  out[0] = a;
+  out[1] = 3.0 * (b - a);
+  out[2] = 3.0 * (a - 2.0 * b + c);
+  out[3] = d - a + 3.0 * (b - c);
+}
+
+void QuadraticToPolynomial(double a, double b, double c, double out[4]) {
+  out[0] = a;
+  out[1] = 2.0 * (b - a);
+  out[2] = a - 2.0 * b + c;
+  out[3] = 0.0;
+}
+
+}  // namespace
+
+KeyframeCurve::KeyframeCurve(const NodeKeyframeTrack &track, NodeValue::Type type) : constant_(true) {
+  bool can_interpolate = NodeValue::type_can_be_interpolated(type);
+
+  times_.resize(track.size());
+  values_.resize(track.size());
+  for (int i = 0; i < track.size(); i++) {
+    times_[i] = track.at(i)->time().toDouble();
+    values_[i] = KeyframeValueToDouble(track.at(i), type);
+
+    if (values_[i] != values_.front()) {
+      constant_ = false;
+    }
+  }
+
+  if (!track.isEmpty()) {
+    segments_.resize(track.size() - 1);
+  }
+
+  for (size_t i = 0; i < segments_.size(); i++) {
+    const NodeKeyframe *before = track.at(int(i));
+    const NodeKeyframe *after = track.at(int(i) + 1);
+    Segment &s = segments_[i];
+
+    double before_time = times_[i];
+    double before_val = values_[i];
+    double after_time = times_[i + 1];
+    double after_val = values_[i + 1];
+
+    if (!can_interpolate || before->type() == NodeKeyframe::kHold) {
+      s.interpolation = kHold;
+    } else if (before->type() == NodeKeyframe::kBezier && after->type() == NodeKeyframe::kBezier) {
+      // Cubic bezier with two control points
+      s.interpolation = kBezier;
+      CubicToPolynomial(before_time, before_time + before->valid_bezier_control_out().x(),
+                        after_time + after->valid_bezier_control_in().x(), after_time, s.x);
+      CubicToPolynomial(before_val, before_val + before->valid_bezier_control_out().y(),
+                        after_val + after->valid_bezier_control_in().y(), after_val, s.y);
+    } else if (before->type() == NodeKeyframe::kBezier || after->type() == NodeKeyframe::kBezier) {
+      // Quadratic bezier with only one control point
+      QPointF control_point;
+      if (before->type() == NodeKeyframe::kBezier) {
+        control_point = before->valid_bezier_control_out() + QPointF(before_time, before_val);
+      } else {
+        control_point = after->valid_bezier_control_in() + QPointF(after_time, after_val);
+      }
+
+      s.interpolation = kBezier;
+      QuadraticToPolynomial(before_time, control_point.x(), after_time, s.x);
+      QuadraticToPolynomial(before_val, control_point.y(), after_val, s.y);
+    } else {
+      s.interpolation = kLinear;
+    }
+
+    if (s.interpolation == kBezier && (s.y[1] != 0.0 || s.y[2] != 0.0 || s.y[3] != 0.0)) {
+      // Control points can pull the curve away from the keyframe values
+      constant_ = false;
+    }
+  }
+}
+
+double KeyframeCurve::Cursor::ValueAt(double time, int *held_key) {
+  const std::vector<double> &times = curve_->times_;
+  int count = int(times.size());
+
+  if (next_ > 0 && times[next_ - 1] > time) {
+    // Time went backwards, start over from a binary search
+    next_ = int(std::upper_bound(times.begin(), times.end(), time) - times.begin());
+  } else {
+    while (next_ < count && times[next_] <= time) {
+      next_++;
+    }
+  }
+
+  return curve_->ValueInSegment(next_, time, held_key);
+}
+
+double KeyframeCurve::ValueAt(double time, int *held_key) const {
+  int next = int(std::upper_bound(times_.begin(), times_.end(), time) - times_.begin());
+
+  return ValueInSegment(next, time, held_key);
+}
+
+void KeyframeCurve::ValuesAt(double start, double step, float *out, size_t count) const {
+  ValuesAtInternal(start, step, out, count);
+}
+
+void KeyframeCurve::ValuesAt(double start, double step, double *out, size_t count) const {
+  ValuesAtInternal(start, step, out, count);
+}
+
+template <typename T>
+void KeyframeCurve::ValuesAtInternal(double start, double step, T *out, size_t count) const {
+  if (constant_) {
+    std::fill(out, out + count, T(values_.empty() ? 0.0 : values_.front()));
+    return;
+  }
+
+  Cursor cursor(this);
+
+  for (size_t i = 0; i < count; i++) {
+    out[i] = T(cursor.ValueAt(start + step * double(i)));
+  }
+}
+
+double KeyframeCurve::ValueInSegment(int next, double time, int *held_key) const {
+  int count = int(times_.size());
+  int key;
+
+  if (count == 0) {
+    if (held_key) {
+      *held_key = -1;
+    }
+    return 0.0;
+  }
+
+  if (next == 0) {
+    // This time precedes any keyframe, so we just return the first value
+    key = 0;
+  } else if (next == count) {
+    // This time is after any keyframes so we return the last value
+    key = count - 1;
+  } else {
+    int before = next - 1;
+    const Segment &s = segments_[before];
+
+    if (times_[before] == time || s.interpolation == kHold) {
+      key = before;
+    } else {
+      if (held_key) {
+        *held_key = -1;
+      }
+
+      if (s.interpolation == kLinear) {
+        double progress = (time - times_[before]) / (times_[next] - times_[before]);
+        return lerp(values_[before], values_[next], progress);
+      } else {
+        return Polynomial(s.y, SolveBezierT(s, time));
+      }
+    }
+  }
+
+  if (held_key) {
+    *held_key = key;
+  }
+
+  return values_[key];
+}
+
+double KeyframeCurve::SolveBezierT(const Segment &s, double x) {
+  // Newton's method converges in a handful of iterations for the monotonic curves valid_bezier_control_*() produces,
+  // the bracket falls back to bisection whenever a step would leave it
+  double low = 0.0;
+  double high = 1.0;
+  double width = s.x[1] + s.x[2] + s.x[3];
+  double t = width > 0.0 ? std::clamp((x - s.x[0]) / width, 0.0, 1.0) : 0.5;
+
+  for (int i = 0; i < kBezierMaximumIterations; i++) {
+    double error = Polynomial(s.x, t) - x;
+    if (std::abs(error) < kBezierTolerance) {
+      break;
+    }
+
+    if (error > 0.0) {
+      high = t;
+    } else {
+      low = t;
+    }
+
+    double derivative = (3.0 * s.x[3] * t + 2.0 * s.x[2]) * t + s.x[1];
+    double next = derivative != 0.0 ? t - error / derivative : low - 1.0;
+
+    t = (next > low && next < high) ? next : (low + high) * 0.5;
+  }
+
+  return t;
+}
+
+}  // namespace olive
@@ -0,0 +1,103 @@
+#ifndef KEYFRAMECURVE_H
+#define KEYFRAMECURVE_H
+
+#include <memory>  // 共享已编译的曲线
+#include <vector>  // 关键帧时间和区段
+
+#include "node/keyframe.h"
+#include "node/value.h"
+
+namespace olive {
+
+/**
+ * @brief 一条关键帧轨道编译后的分段表示，用于快速计算参数值。
+ *
+ * 编译时关键帧的时间和值一次性转换为 double，贝塞尔区段转换为多项式系数，
+ * 求值时不再访问 NodeKeyframe 或 QVariant。贝塞尔区段用带区间保护的牛顿迭代求解 t，
+ * 而不是逐次二分。
+ *
+ * 编译后的曲线是不可变的，可以在多个线程之间共享。关键帧被修改后由 NodeInputImmediate 丢弃并重新编译。
+ *
+ * 结果与 Node::GetSplitValueAtTimeOnTrack() 的定义一致：第一个关键帧之前取第一个值，最后一个关键帧之后取最后一个值，
+ * 保持区段和不可插值的类型取前一个关键帧的值。
+ */
+class KeyframeCurve {
+ public:
+  KeyframeCurve(const NodeKeyframeTrack &track, NodeValue::Type type);
+
+  /**
+   * @brief 顺序求值的游标。
+   *
+   * 记住上一次所在的区段，时间单调递增时每次求值的均摊开销为 O(1)；时间回退时退回二分查找。
+   */
+  class Cursor {
+   public:
+    explicit Cursor(const KeyframeCurve *curve) : curve_(curve) {}
+
+    /**
+     * @brief 计算给定时间的值。
+     * @param held_key 如果不为空，则写入值完全等于某个关键帧时该关键帧的索引，插值得到的值写入 -1。
+     */
+    double ValueAt(double time, int *held_key = nullptr);
+
+   private:
+    const KeyframeCurve *curve_;  // 所属的曲线
+    int next_ = 0;                // 第一个时间大于上次请求时间的关键帧索引
+  };
+
+  /**
+   * @brief 计算单个时间的值 (二分查找区段)。
+   * @param held_key 同 Cursor::ValueAt()。
+   */
+  [[nodiscard]] double ValueAt(double time, int *held_key = nullptr) const;
+
+  /**
+   * @brief 在 start, start + step, ... 共 count 个时间点上批量求值，结果写入 out。
+   */
+  void ValuesAt(double start, double step, float *out, size_t count) const;
+  void ValuesAt(double start, double step, double *out, size_t count) const;
+
+  /**
+   * @brief 曲线是否在所有时间上都是同一个值。
+   */
+  [[nodiscard]] bool IsConstant() const { return constant_; }
+
+  [[nodiscard]] int GetKeyframeCount() const { return int(times_.size()); }
+
+ private:
+  enum Interpolation {
+    kHold,    // 保持前一个关键帧的值
+    kLinear,  // 线性插值
+    kBezier   // 二次或三次贝塞尔，二次的三次项系数为 0
+  };
+
+  struct Segment {
+    Interpolation interpolation;
+    double x[4];  // 贝塞尔 x(t) 的多项式系数，x[0] 为常数项
+    double y[4];  // 贝塞尔 y(t) 的多项式系数
+  };
+
+  /**
+   * @brief 计算 next (第一个时间大于 time 的关键帧索引) 所确定区段内的值。
+   */
+  double ValueInSegment(int next, double time, int *held_key) const;
+
+  template <typename T>
+  void ValuesAtInternal(double start, double step, T *out, size_t count) const;
+
+  /**
+   * @brief 求贝塞尔区段上 x(t) == x 的 t。
+   */
+  static double SolveBezierT(const Segment &s, double x);
+
+  std::vector<double> times_;      // 各关键帧的时间 (秒)
+  std::vector<double> values_;     // 各关键帧的值
+  std::vector<Segment> segments_;  // 区段 i 位于关键帧 i 和 i + 1 之间
+  bool constant_;                  // 所有关键帧的值相同且没有会越出范围的贝塞尔
+};
+
+using KeyframeCurvePtr = std::shared_ptr<const KeyframeCurve>;
+
+}  // namespace olive
+
+#endif  // KEYFRAMECURVE_H
@@ -95,6 +95,7 @@ class MathNode : public MathNodeBase {
    */
   void ProcessSamples(const NodeValueRow &values, const SampleBuffer &input, SampleBuffer &output,
                       int index) const override;
+  using Node::ProcessSamples;  // 块版本使用 Node 的默认实现
 
   // --- 静态常量，用作节点输入参数的键名 ---
   static const QString kMethodIn;  ///< "Operation" 或 "Method" - 选择数学运算类型的参数键名。
@@ -15,6 +15,7 @@ MergeNode::MergeNode() {
   AddInput(kBlendIn, NodeValue::kTexture, InputFlags(kInputFlagNotKeyframable));
 
   SetFlag(kDontShowInParamView);
+  SetFlag(kTimeInvariant);
 }
 
 QString MergeNode::Name() const { return tr("Merge"); }
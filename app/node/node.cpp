@@ -6,7 +6,6 @@
 #include <QGuiApplication>
 #include <ranges>
 
-#include "common/lerp.h"
 #include "config/config.h"
 #include "core.h"
 #include "node/group/group.h"
@@ -23,7 +22,19 @@ namespace olive {
 
 const QString Node::kEnabledInput = QStringLiteral("enabled_in");
 
-Node::Node() : override_color_(-1), folder_(nullptr), flags_(kNone), caches_enabled_(true) {
+namespace {
+
+// Shared by all nodes so a generation never repeats, even for a node reallocated at a freed node's address
+std::atomic<uint64_t> render_generation_counter(0);
+
+}  // namespace
+
+Node::Node()
+    : override_color_(-1),
+      folder_(nullptr),
+      flags_(kNone),
+      render_generation_(++render_generation_counter),
+      caches_enabled_(true) {
   AddInput(kEnabledInput, NodeValue::kBoolean, true);
 
   video_cache_ = new FrameHashCache(this);
@@ -352,111 +363,51 @@ SplitValue Node::GetSplitValueAtTime(const QString &input, const rational &time,
 
 QVariant Node::GetSplitValueAtTimeOnTrack(const QString &input, const rational &time, int track, int element) const {
   if (!IsUsingStandardValue(input, track, element)) {
-    const NodeKeyframeTrack &key_track = GetKeyframeTracks(input, element).at(track);
+    KeyframeCurvePtr curve = GetKeyframeCurve(input, track, element);
 
-    if (key_track.first()->time() >= time) {
-      // This time precedes any keyframe, so we just return the first value
-      return key_track.first()->value();
-    }
+    int held_key;
+    double interpolated = curve->ValueAt(time.toDouble(), &held_key);
 
-    if (key_track.last()->time() <= time) {
-      // This time is after any keyframes so we return the last value
-      return key_track.last()->value();
+    if (held_key != -1) {
+      // The value is exactly a keyframe's, return it as stored so non-numeric types and exact rationals are preserved
+      return GetKeyframeTracks(input, element).at(track).at(held_key)->value();
     }
 
-    NodeValue::Type type = GetInputDataType(input);
-
-    // If we're here, the time must be somewhere in between the keyframes
-    NodeKeyframe *before = nullptr, *after = nullptr;
-
-    int low = 0;
-    int high = key_track.size() - 1;
-    while (low <= high) {
-      int mid = low + (high - low) / 2;
-      NodeKeyframe *mid_key = key_track.at(mid);
-      NodeKeyframe *next_key = key_track.at(mid + 1);
-
-      if (mid_key->time() <= time && next_key->time() > time) {
-        before = mid_key;
-        after = next_key;
-        break;
-      } else if (mid_key->time() < time) {
-        low = mid + 1;
-      } else {
-        high = mid - 1;
-      }
+    if (GetInputDataType(input) == NodeValue::kRational) {
+      return QVariant::fromValue(rational::fromDouble(interpolated));
+    } else {
+      return interpolated;
     }
+  }
 
-    if (before) {
-      if (before->time() == time ||
-          ((!NodeValue::type_can_be_interpolated(type) || before->type() == NodeKeyframe::kHold) &&
-           after->time() > time)) {
-        // Time == keyframe time, so value is precise
-        return before->value();
-
-      } else if (after->time() == time) {
-        // Time == keyframe time, so value is precise
-        return after->value();
-
-      } else if (before->time() < time && after->time() > time) {
-        // We must interpolate between these keyframes
-
-        double before_val, after_val, interpolated;
-        if (type == NodeValue::kRational) {
-          before_val = before->value().value<rational>().toDouble();
-          after_val = after->value().value<rational>().toDouble();
-        } else {
-          before_val = before->value().toDouble();
-          after_val = after->value().toDouble();
-        }
-
-        if (before->type() == NodeKeyframe::kBezier && after->type() == NodeKeyframe::kBezier) {
-          // Perform a cubic bezier with two control points
-          interpolated =
-              Bezier::CubicXtoY(time.toDouble(), Imath::V2d(before->time().toDouble(), before_val),
-                                Imath::V2d(before->time().toDouble() + before->valid_bezier_control_out().x(),
-                                           before_val + before->valid_bezier_control_out().y()),
-                                Imath::V2d(after->time().toDouble() + after->valid_bezier_control_in().x(),
-                                           after_val + after->valid_bezier_control_in().y()),
-                                Imath::V2d(after->time().toDouble(), after_val));
-
-        } else if (before->type() == NodeKeyframe::kBezier || after->type() == NodeKeyframe::kBezier) {
-          // Perform a quadratic bezier with only one control point
-
-          Imath::V2d control_point;
+  return GetSplitStandardValueOnTrack(input, track, element);
+}
 
-          if (before->type() == NodeKeyframe::kBezier) {
-            control_point.x = (before->valid_bezier_control_out().x() + before->time().toDouble());
-            control_point.y = (before->valid_bezier_control_out().y() + before_val);
-          } else {
-            control_point.x = (after->valid_bezier_control_in().x() + after->time().toDouble());
-            control_point.y = (after->valid_bezier_control_in().y() + after_val);
-          }
+KeyframeCurvePtr Node::GetKeyframeCurve(const QString &input, int track, int element) const {
+  if (IsUsingStandardValue(input, track, element)) {
+    return nullptr;
+  }
 
-          // Interpolate value using quadratic beziers
-          interpolated = Bezier::QuadraticXtoY(time.toDouble(), Imath::V2d(before->time().toDouble(), before_val),
-                                               control_point, Imath::V2d(after->time().toDouble(), after_val));
+  return GetImmediate(input, element)->get_keyframe_curve(track);
+}
 
-        } else {
-          // To have arrived here, the keyframes must both be linear
-          qreal period_progress =
-              (time.toDouble() - before->time().toDouble()) / (after->time().toDouble() - before->time().toDouble());
+bool Node::GetNumericValuesAtTimes(const QString &input, double start, double step, float *out, size_t count,
+                                   int element) const {
+  NodeValue::Type type = GetInputDataType(input);
 
-          interpolated = lerp(before_val, after_val, period_progress);
-        }
+  if ((type != NodeValue::kFloat && type != NodeValue::kInt && type != NodeValue::kRational) ||
+      GetNumberOfKeyframeTracks(input) != 1) {
+    return false;
+  }
 
-        if (type == NodeValue::kRational) {
-          return QVariant::fromValue(rational::fromDouble(interpolated));
-        } else {
-          return interpolated;
-        }
-      }
-    } else {
-      qWarning() << "Binary search for keyframes failed";
-    }
+  if (KeyframeCurvePtr curve = GetKeyframeCurve(input, 0, element)) {
+    curve->ValuesAt(start, step, out, count);
+  } else {
+    QVariant v = GetSplitStandardValueOnTrack(input, 0, element);
+    std::fill(out, out + count, float(type == NodeValue::kRational ? v.value<rational>().toDouble() : v.toDouble()));
   }
 
-  return GetSplitStandardValueOnTrack(input, track, element);
+  return true;
 }
 
 QVariant Node::GetDefaultValue(const QString &input) const {
@@ -824,6 +775,9 @@ void Node::InvalidateCache(const TimeRange &range, const QString &from, int elem
   Q_UNUSED(from)
   Q_UNUSED(element)
 
+  // Renderers holding results of this node from previous frames compare against this
+  render_generation_ = ++render_generation_counter;
+
   if (AreCachesEnabled()) {
     if (range.in() != range.out()) {
       TimeRange vr = range.Intersected(GetVideoCacheRange());
@@ -1867,6 +1821,13 @@ ShaderCode Node::GetShaderCode(const ShaderRequest &request) const { return Shad
 
 void Node::ProcessSamples(const NodeValueRow &, const SampleBuffer &, SampleBuffer &, int) const {}
 
+void Node::ProcessSamples(const SampleParameterBlock &values, const SampleBuffer &input, SampleBuffer &output) const {
+  // Nodes without a block implementation still get pre-evaluated parameters, just one row at a time
+  for (size_t i = 0; i < values.sample_count(); i++) {
+    ProcessSamples(values.GetRowAt(i), input, output, int(i));
+  }
+}
+
 void Node::GenerateFrame(FramePtr frame, const GenerateJob &job) const {
   Q_UNUSED(frame)
   Q_UNUSED(job)
@@ -2090,6 +2051,8 @@ void Node::childEvent(QChildEvent *event) {
 
 void Node::InvalidateFromKeyframeBezierInChange() {
   auto *key = dynamic_cast<NodeKeyframe *>(sender());
+  GetImmediate(key->input(), key->element())->invalidate_keyframe_curves();
+
   const NodeKeyframeTrack &track = GetTrackFromKeyframe(key);
   int keyframe_index = track.indexOf(key);
 
@@ -2105,6 +2068,8 @@ void Node::InvalidateFromKeyframeBezierInChange() {
 
 void Node::InvalidateFromKeyframeBezierOutChange() {
   auto *key = dynamic_cast<NodeKeyframe *>(sender());
+  GetImmediate(key->input(), key->element())->invalidate_keyframe_curves();
+
   const NodeKeyframeTrack &track = GetTrackFromKeyframe(key);
   int keyframe_index = track.indexOf(key);
 
@@ -2121,6 +2086,8 @@ void Node::InvalidateFromKeyframeBezierOutChange() {
 void Node::InvalidateFromKeyframeTimeChange() {
   auto *key = dynamic_cast<NodeKeyframe *>(sender());
   NodeInputImmediate *immediate = GetImmediate(key->input(), key->element());
+  immediate->invalidate_keyframe_curves();
+
   TimeRange original_range = GetRangeAffectedByKeyframe(key);
 
   TimeRangeList invalidate_range;
@@ -2148,6 +2115,8 @@ void Node::InvalidateFromKeyframeTimeChange() {
 
 void Node::InvalidateFromKeyframeValueChange() {
   auto *key = dynamic_cast<NodeKeyframe *>(sender());
+  GetImmediate(key->input(), key->element())->invalidate_keyframe_curves();
+
   ParameterValueChanged(key->key_track_ref().input(), GetRangeAffectedByKeyframe(key));
 
   emit KeyframeValueChanged(key);
@@ -2155,6 +2124,8 @@ void Node::InvalidateFromKeyframeValueChange() {
 
 void Node::InvalidateFromKeyframeTypeChanged() {
   auto *key = dynamic_cast<NodeKeyframe *>(sender());
+  GetImmediate(key->input(), key->element())->invalidate_keyframe_curves();
+
   const NodeKeyframeTrack &track = GetTrackFromKeyframe(key);
 
   if (track.size() == 1) {
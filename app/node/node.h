@@ -6,6 +6,7 @@
 #include <QPainter>          // Qt 绘图类
 #include <QPointF>           // Qt 二维浮点坐标点类
 #include <QXmlStreamWriter>  // Qt XML流写入类
+#include <atomic>            // 渲染代数
 #include <map>               // 标准库 map 容器
 #include <utility>           // 标准库 utility 头文件，提供 pair 等
 
@@ -15,6 +16,7 @@
 #include "node/globals.h"               // 节点相关的全局定义
 #include "node/inputimmediate.h"        // 节点立即输入相关
 #include "node/keyframe.h"              // 关键帧数据结构
+#include "node/keyframecurve.h"         // 编译后的关键帧曲线
 #include "node/param.h"                 // 参数相关
 #include "render/audioplaybackcache.h"  // 音频播放缓存
 #include "render/audiowaveformcache.h"  // 音频波形缓存
@@ -87,7 +89,8 @@ class Node : public QObject {  // Node 类继承自 QObject 以使用 Qt 的元
     kVideoEffect = 0x2,           // 标记为视频效果
     kAudioEffect = 0x4,           // 标记为音频效果
     kDontShowInCreateMenu = 0x8,  // 不在创建菜单中显示
-    kIsItem = 0x10                // 标记为时间轴上的一个项目/片段 (Item)
+    kIsItem = 0x10,               // 标记为时间轴上的一个项目/片段 (Item)
+    kTimeInvariant = 0x20         // 输出只取决于输入值而不取决于时间 (没有关键帧时结果可以跨帧缓存)
   };
 
   // 上下文节点对结构体，通常用于表示一个节点和它所在的上下文环境中的另一个节点
@@ -129,6 +132,14 @@ class Node : public QObject {  // Node 类继承自 QObject 以使用 Qt 的元
    */
   [[nodiscard]] const uint64_t& GetFlags() const { return flags_; }
 
+  /**
+   * @brief 获取渲染代数，每次 InvalidateCache() 时更新。
+   *
+   * 代数来自全局计数器，所以不同节点 (包括先后分配在同一地址的节点) 的代数也不会重复。
+   * 渲染线程用它判断跨帧缓存的结果是否仍然有效。此函数是线程安全的。
+   */
+  [[nodiscard]] uint64_t GetRenderGeneration() const { return render_generation_; }
+
   /**
    * @brief 返回节点的名称。
    *
@@ -531,6 +542,34 @@ class Node : public QObject {  // Node 类继承自 QObject 以使用 Qt 的元
     return GetSplitValueAtTimeOnTrack(input.input(), time, input.track());
   }
 
+  /**
+   * @brief 获取指定输入一个轨道编译后的关键帧曲线，用于批量或顺序求值。
+   *
+   * 曲线在关键帧被修改前会被缓存，修改后再次调用时重新编译。调用者持有的曲线不会随之改变。
+   * @return 如果该轨道没有使用关键帧，则返回 nullptr。
+   */
+  [[nodiscard]] KeyframeCurvePtr GetKeyframeCurve(const QString& input, int track, int element = -1) const;
+  // NodeKeyframeTrackReference 重载版本
+  [[nodiscard]] KeyframeCurvePtr GetKeyframeCurve(const NodeKeyframeTrackReference& input) const {
+    return GetKeyframeCurve(input.input().input(), input.track(), input.input().element());
+  }
+
+  /**
+   * @brief 在一组等间隔的时间点上批量计算一个数值输入的值。
+   *
+   * 用于音频块处理：通过 GetKeyframeCurve() 顺序求值，而不是对每个采样做一次二分查找。
+   * 结果与对每个时间点调用 GetValueAtTime() 一致。
+   * @param input 输入端口的ID。
+   * @param start 第一个采样的时间 (秒)。
+   * @param step 相邻采样之间的时间间隔 (秒)。
+   * @param out 输出数组，长度至少为 count。
+   * @param count 采样数。
+   * @param element 元素的索引。
+   * @return 如果输入不是单轨数值类型 (float/int/rational)，则返回 false 且不写入 out。
+   */
+  bool GetNumericValuesAtTimes(const QString& input, double start, double step, float* out, size_t count,
+                               int element = -1) const;
+
   // 获取指定输入的默认值
   [[nodiscard]] QVariant GetDefaultValue(const QString& input) const;
   // 获取指定输入的分离形式的默认值
@@ -838,6 +877,18 @@ class Node : public QObject {  // Node 类继承自 QObject 以使用 Qt 的元
   virtual void ProcessSamples(const NodeValueRow& values, const SampleBuffer& input, SampleBuffer& output,
                               int index) const;
 
+  /**
+   * @brief ProcessSamples() 的块版本，一次处理整个采样缓冲区。
+   *
+   * 参数已经由渲染器针对块中的每个采样预先计算好。默认实现会针对每个采样调用逐采样版本，
+   * 需要更高性能的节点 (例如 VolumeNode、PanNode) 应重写此函数并对整个缓冲区进行向量化处理。
+   * @param values 每个参数的逐采样值。
+   * @param input 输入采样缓冲区。
+   * @param output 输出采样缓冲区 (与 input 大小相同，已分配)。
+   */
+  virtual void ProcessSamples(const SampleParameterBlock& values, const SampleBuffer& input,
+                              SampleBuffer& output) const;
+
   /**
    * @brief 如果 Value() 推送了一个 GenerateJob (通常用于生成器节点)，则重写此函数以创建图像。
    * @param frame 目标帧缓冲区。它将已经被分配并准备好写入。
@@ -1469,6 +1520,8 @@ class Node : public QObject {  // Node 类继承自 QObject 以使用 Qt 的元
 
   uint64_t flags_;  // 节点的标志位 (使用 Flag 枚举按位组合)
 
+  std::atomic<uint64_t> render_generation_;  // 渲染代数，见 GetRenderGeneration()
+
   QVector<NodeGizmo*> gizmos_;  // 此节点拥有的 Gizmo 列表
 
   QString effect_input_;  // 特殊输入端口的ID，标记为“效果输入”
@@ -3,6 +3,7 @@
 #include <QApplication>
 #include <QDebug>
 #include <QFontMetrics>
+#include <algorithm>
 
 #include "audio/audioprocessor.h"
 #include "node/block/clip/clip.h"
@@ -208,64 +209,54 @@ void Track::SetIndex(const int &index) {
   emit IndexChanged(old, index_);
 }
 
+// Blocks are contiguous and sorted, so both their in and out points are in ascending order and every lookup below is a
+// binary search over blocks_ rather than a walk from the start of the track
+
 Block *Track::BlockContainingTime(const rational &time) const {
-  foreach (Block *block, blocks_) {
-    if (block->in() < time && block->out() > time) {
-      return block;
-    } else if (block->out() == time) {
-      break;
-    }
+  auto it = std::lower_bound(blocks_.cbegin(), blocks_.cend(), time,
+                             [](const Block *b, const rational &t) { return b->out() < t; });
+
+  if (it != blocks_.cend() && (*it)->in() < time && (*it)->out() > time) {
+    return *it;
   }
 
   return nullptr;
 }
 
 Block *Track::NearestBlockBefore(const rational &time) const {
-  foreach (Block *block, blocks_) {
-    // Blocks are sorted by time, so the first Block who's out point is at/after this time is the correct Block
-    if (block->in() == time) {
-      break;
-    }
+  // The first Block whose out point is at/after this time is the correct Block, unless it starts exactly at this time
+  auto it = std::lower_bound(blocks_.cbegin(), blocks_.cend(), time,
+                             [](const Block *b, const rational &t) { return b->out() < t; });
 
-    if (block->out() >= time) {
-      return block;
-    }
+  if (it != blocks_.cend() && (*it)->in() != time) {
+    return *it;
   }
 
   return nullptr;
 }
 
 Block *Track::NearestBlockBeforeOrAt(const rational &time) const {
-  foreach (Block *block, blocks_) {
-    // Blocks are sorted by time, so the first Block who's out point is at/after this time is the correct Block
-    if (block->out() > time) {
-      return block;
-    }
-  }
+  // The first Block whose out point is after this time is the correct Block
+  auto it = std::upper_bound(blocks_.cbegin(), blocks_.cend(), time,
+                             [](const rational &t, const Block *b) { return t < b->out(); });
 
-  return nullptr;
+  return (it == blocks_.cend()) ? nullptr : *it;
 }
 
 Block *Track::NearestBlockAfterOrAt(const rational &time) const {
-  foreach (Block *block, blocks_) {
-    // Blocks are sorted by time, so the first Block after this time is the correct Block
-    if (block->in() >= time) {
-      return block;
-    }
-  }
+  // The first Block starting at/after this time is the correct Block
+  auto it = std::lower_bound(blocks_.cbegin(), blocks_.cend(), time,
+                             [](const Block *b, const rational &t) { return b->in() < t; });
 
-  return nullptr;
+  return (it == blocks_.cend()) ? nullptr : *it;
 }
 
 Block *Track::NearestBlockAfter(const rational &time) const {
-  foreach (Block *block, blocks_) {
-    // Blocks are sorted by time, so the first Block after this time is the correct Block
-    if (block->in() > time) {
-      return block;
-    }
-  }
+  // The first Block starting after this time is the correct Block
+  auto it = std::upper_bound(blocks_.cbegin(), blocks_.cend(), time,
+                             [](const rational &t, const Block *b) { return t < b->in(); });
 
-  return nullptr;
+  return (it == blocks_.cend()) ? nullptr : *it;
 }
 
 bool Track::IsRangeFree(const TimeRange &range) const {
@@ -19,6 +19,7 @@ namespace olive {
 
 const QString Project::kCacheLocationSettingKey = QStringLiteral("cachesetting");
 const QString Project::kCachePathKey = QStringLiteral("customcachepath");
+const QString Project::kCacheFormatKey = QStringLiteral("cacheformat");
 const QString Project::kColorConfigFilename = QStringLiteral("colorconfigfilename");
 const QString Project::kDefaultInputColorSpaceKey = QStringLiteral("defaultinputcolorspace");
 const QString Project::kColorReferenceSpace = QStringLiteral("colorreferencespace");
@@ -146,6 +147,10 @@ void Project::Save(QXmlStreamWriter *writer) const {
     writer->writeEndElement();  // nodes
   }
 
+  SaveSettings(writer);
+}
+
+void Project::SaveSettings(QXmlStreamWriter *writer) const {
   if (!this->settings_.isEmpty()) {
     writer->writeStartElement(QStringLiteral("settings"));
 
@@ -62,6 +62,9 @@ class Project : public QObject {  // Project 类继承自 QObject 以使用 Qt 
   // 将项目数据保存到 XML 流
   // @param writer XML 流写入器。
   void Save(QXmlStreamWriter *writer) const;
+  // 将项目设置保存为 <settings> 元素 (没有设置时不写入任何内容)，Save() 和自动恢复日志共用
+  // @param writer XML 流写入器。
+  void SaveSettings(QXmlStreamWriter *writer) const;
 
   // 获取一个节点存在于多少个上下文 (其他节点的内部图) 中
   // @param node 要检查的节点。
@@ -139,6 +142,7 @@ class Project : public QObject {  // Project 类继承自 QObject 以使用 Qt 
   // 项目设置相关的键名常量
   static const QString kCacheLocationSettingKey;    // 缓存位置设置的键
   static const QString kCachePathKey;               // 自定义缓存路径设置的键
+  static const QString kCacheFormatKey;             // 缓存帧格式设置的键
   static const QString kColorConfigFilename;        // OCIO 颜色配置文件名的键
   static const QString kColorReferenceSpace;        // 颜色参考空间的键 (例如场景线性)
   static const QString kDefaultInputColorSpaceKey;  // 默认输入颜色空间的键
@@ -161,6 +165,17 @@ class Project : public QObject {  // Project 类继承自 QObject 以使用 Qt 
   // 设置自定义缓存路径
   void SetCustomCachePath(const QString &path) { SetSetting(kCachePathKey, path); }
 
+  // 获取缓存帧格式 (未设置时为 EXR)
+  [[nodiscard]] FrameHashCache::CacheFormat GetCacheFormat() const {
+    int f = GetSetting(kCacheFormatKey).toInt();
+    if (f < 0 || f >= FrameHashCache::kCacheFormatCount) {
+      return FrameHashCache::kCacheFormatEXR;
+    }
+    return static_cast<FrameHashCache::CacheFormat>(f);
+  }
+  // 设置缓存帧格式
+  void SetCacheFormat(FrameHashCache::CacheFormat f) { SetSetting(kCacheFormatKey, QString::number(f)); }
+
   // 获取 OCIO 颜色配置文件名
   [[nodiscard]] QString GetColorConfigFilename() const { return GetSetting(kColorConfigFilename); }
   // 设置 OCIO 颜色配置文件名
@@ -208,6 +208,7 @@ void Footage::Value(const NodeValueRow &value, const NodeGlobals &globals, NodeV
         }
 
         job.set_video_params(vp);
+        job.set_cache_path(project()->cache_path());
 
         table->Push(NodeValue::kTexture, Texture::Job(vp, job), this, ref.ToString());
       } else if (ref.type() == Track::kAudio) {
@@ -0,0 +1,500 @@
+#include "recoveryjournal.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QtConcurrent/QtConcurrent>
+#include <utility>
+
+#include "common/xmlutils.h"
+#include "node/group/group.h"
+#include "node/output/track/track.h"
+#include "node/output/viewer/viewer.h"
+#include "serializer.h"
+
+namespace olive {
+
+const QString RecoveryJournal::kSnapshotExtension = QStringLiteral(".ove");
+const QString RecoveryJournal::kJournalExtension = QStringLiteral(".journal");
+
+namespace {
+
+const char *kJournalMagic = "OVEJ";
+
+// Fixed so journals written by a build against one Qt version can be replayed by another
+const QDataStream::Version kStreamVersion = QDataStream::Qt_5_12;
+
+quint64 NodePtr(const Node *node) { return reinterpret_cast<quintptr>(node); }
+
+QByteArray SerializeNode(const Node *node) {
+  QByteArray b;
+  QXmlStreamWriter writer(&b);
+
+  writer.writeStartElement(QStringLiteral("node"));
+  node->Save(&writer);
+  writer.writeEndElement();  // node
+
+  return b;
+}
+
+// Copies the element the reader is currently at (including its children) into a standalone fragment
+QByteArray CopyElement(QXmlStreamReader *reader) {
+  QByteArray b;
+  QXmlStreamWriter writer(&b);
+
+  writer.writeCurrentToken(*reader);
+
+  // Leaves the reader at the element's end, the same as QXmlStreamReader::skipCurrentElement()
+  int depth = 1;
+  while (depth > 0 && !reader->atEnd()) {
+    reader->readNext();
+
+    if (reader->isStartElement()) {
+      depth++;
+    } else if (reader->isEndElement()) {
+      depth--;
+    }
+
+    writer.writeCurrentToken(*reader);
+  }
+
+  return b;
+}
+
+// Writes a fragment made by SerializeNode() or CopyElement() into a larger document
+void WriteFragment(QXmlStreamWriter *writer, const QByteArray &fragment) {
+  if (fragment.isEmpty()) {
+    return;
+  }
+
+  QXmlStreamReader reader(fragment);
+
+  while (!reader.atEnd() && !reader.hasError()) {
+    reader.readNext();
+
+    if (!reader.isStartDocument() && !reader.isEndDocument()) {
+      writer->writeCurrentToken(reader);
+    }
+  }
+}
+
+}  // namespace
+
+RecoveryJournal::RecoveryJournal(Project *project, QString directory, QObject *parent)
+    : QObject(parent),
+      project_(project),
+      directory_(std::move(directory)),
+      settings_dirty_(false),
+      has_snapshot_(false) {
+  io_pool_.setMaxThreadCount(1);
+
+  connect(project_, &Project::NodeAdded, this, &RecoveryJournal::NodeAdded);
+  connect(project_, &Project::NodeRemoved, this, &RecoveryJournal::NodeRemoved);
+  connect(project_, &Project::InputConnected, this,
+          [this](Node *, const NodeInput &input) { MarkDirty(input.node()); });
+  connect(project_, &Project::InputDisconnected, this,
+          [this](Node *, const NodeInput &input) { MarkDirty(input.node()); });
+  connect(project_, &Project::ValueChanged, this, [this](const NodeInput &input) { MarkDirty(input.node()); });
+  connect(project_, &Project::InputValueHintChanged, this,
+          [this](const NodeInput &input) { MarkDirty(input.node()); });
+  connect(project_, &Project::GroupAddedInputPassthrough, this,
+          [this](NodeGroup *group, const NodeInput &) { MarkDirty(group); });
+  connect(project_, &Project::GroupRemovedInputPassthrough, this,
+          [this](NodeGroup *group, const NodeInput &) { MarkDirty(group); });
+  connect(project_, &Project::GroupChangedOutputPassthrough, this,
+          [this](NodeGroup *group, Node *) { MarkDirty(group); });
+  connect(project_, &Project::SettingChanged, this, [this] { settings_dirty_ = true; });
+
+  // The pool hasn't been given anything yet, so the copy can be filled in directly
+  graph_.uuid = project_->GetUuid().toString();
+
+  foreach (Node *node, project_->nodes()) {
+    Watch(node);
+
+    graph_.order.append(NodePtr(node));
+    graph_.nodes.insert(NodePtr(node), SerializeNode(node));
+  }
+
+  QXmlStreamWriter settings_writer(&graph_.settings);
+  project_->SaveSettings(&settings_writer);
+}
+
+RecoveryJournal::~RecoveryJournal() { io_pool_.waitForDone(); }
+
+bool RecoveryJournal::Flush() {
+  if (dirty_.isEmpty() && removed_.isEmpty() && !settings_dirty_) {
+    return false;
+  }
+
+  Delta delta = TakeDelta();
+
+  if (has_snapshot_) {
+    QtConcurrent::run(&io_pool_, [this, delta] { AppendInternal(delta); });
+  } else {
+    // A journal is only useful on top of a snapshot, so the first change writes one
+    QString snapshot = CreateSnapshotFilename();
+    QtConcurrent::run(&io_pool_, [this, delta, snapshot] { CompactInternal(delta, snapshot); });
+    has_snapshot_ = true;
+  }
+
+  return true;
+}
+
+QString RecoveryJournal::Compact(const MainWindowLayoutInfo &layout) {
+  Delta delta = TakeDelta();
+
+  QByteArray layout_xml;
+  {
+    QXmlStreamWriter writer(&layout_xml);
+    writer.writeStartElement(QStringLiteral("layout"));
+    layout.toXml(&writer);
+    writer.writeEndElement();  // layout
+  }
+
+  QString snapshot = CreateSnapshotFilename();
+
+  QtConcurrent::run(&io_pool_, [this, delta, snapshot, layout_xml] {
+    graph_.layout = layout_xml;
+    CompactInternal(delta, snapshot);
+  });
+
+  has_snapshot_ = true;
+
+  return snapshot;
+}
+
+bool RecoveryJournal::Replay(const QString &journal, const QString &output) {
+  QFileInfo info(journal);
+  QString snapshot = QDir(info.path()).filePath(info.completeBaseName() + kSnapshotExtension);
+
+  Graph graph;
+  if (!graph.Load(snapshot)) {
+    qWarning() << "Failed to load auto-recovery snapshot" << snapshot;
+    return false;
+  }
+
+  QFile journal_file(journal);
+  if (!journal_file.open(QFile::ReadOnly) || journal_file.read(4) != kJournalMagic) {
+    qWarning() << "Failed to open auto-recovery journal" << journal;
+    return false;
+  }
+
+  QDataStream stream(&journal_file);
+  stream.setVersion(kStreamVersion);
+
+  while (!stream.atEnd()) {
+    QByteArray compressed;
+    stream >> compressed;
+
+    // A short read means we crashed while writing this record, everything before it is still good
+    if (stream.status() != QDataStream::Ok) {
+      qWarning() << "Auto-recovery journal" << journal << "ends with an incomplete record, ignoring it";
+      break;
+    }
+
+    QByteArray record = qUncompress(compressed);
+
+    Delta delta;
+    QDataStream record_stream(record);
+    record_stream.setVersion(kStreamVersion);
+    record_stream >> delta.nodes >> delta.removed >> delta.settings_changed >> delta.settings;
+
+    if (record.isEmpty() || record_stream.status() != QDataStream::Ok) {
+      qWarning() << "Auto-recovery journal" << journal << "has a corrupt record, ignoring everything after it";
+      break;
+    }
+
+    graph.Apply(delta);
+  }
+
+  return graph.Write(output);
+}
+
+QString RecoveryJournal::GetJournalFilename(const QString &snapshot) {
+  QFileInfo info(snapshot);
+  return QDir(info.path()).filePath(info.completeBaseName() + kJournalExtension);
+}
+
+RecoveryJournal::Delta RecoveryJournal::TakeDelta() {
+  Delta delta;
+
+  for (Node *node : std::as_const(dirty_)) {
+    delta.nodes.append({NodePtr(node), SerializeNode(node)});
+  }
+  delta.removed = QVector<quint64>(removed_.cbegin(), removed_.cend());
+
+  if (settings_dirty_) {
+    delta.settings_changed = true;
+
+    QXmlStreamWriter writer(&delta.settings);
+    project_->SaveSettings(&writer);
+  }
+
+  dirty_.clear();
+  removed_.clear();
+  settings_dirty_ = false;
+
+  return delta;
+}
+
+QString RecoveryJournal::CreateSnapshotFilename() const {
+  return QDir(directory_).filePath(QString::number(QDateTime::currentSecsSinceEpoch()) + kSnapshotExtension);
+}
+
+void RecoveryJournal::AppendInternal(const Delta &delta) {
+  graph_.Apply(delta);
+
+  QByteArray record;
+  {
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream.setVersion(kStreamVersion);
+    stream << delta.nodes << delta.removed << delta.settings_changed << delta.settings;
+  }
+
+  QFile journal_file(journal_path_);
+
+  if (journal_file.open(QFile::WriteOnly | QFile::Append)) {
+    QDataStream stream(&journal_file);
+    stream.setVersion(kStreamVersion);
+    stream << qCompress(record);
+    journal_file.close();
+  } else {
+    qWarning() << "Failed to append to auto-recovery journal" << journal_path_;
+  }
+}
+
+void RecoveryJournal::CompactInternal(const Delta &delta, const QString &snapshot) {
+  graph_.Apply(delta);
+
+  QDir().mkpath(directory_);
+
+  if (!graph_.Write(snapshot)) {
+    // Keep appending to the old journal, its snapshot is still the last good one
+    qWarning() << "Failed to write auto-recovery snapshot" << snapshot;
+    return;
+  }
+
+  QString old_journal = journal_path_;
+  journal_path_ = GetJournalFilename(snapshot);
+
+  QFile journal_file(journal_path_);
+  if (journal_file.open(QFile::WriteOnly | QFile::Truncate)) {
+    journal_file.write(kJournalMagic, 4);
+    journal_file.close();
+  } else {
+    qWarning() << "Failed to create auto-recovery journal" << journal_path_;
+  }
+
+  // The new snapshot already contains everything the old journal did
+  if (!old_journal.isEmpty() && old_journal != journal_path_) {
+    QFile::remove(old_journal);
+  }
+}
+
+void RecoveryJournal::Watch(Node *node) {
+  // Changes that Project doesn't already forward from its nodes
+  auto mark = [this, node] { MarkDirty(node); };
+
+  connect(node, &Node::LabelChanged, this, mark);
+  connect(node, &Node::ColorChanged, this, mark);
+  connect(node, &Node::LinksChanged, this, mark);
+  connect(node, &Node::InputArraySizeChanged, this, mark);
+  connect(node, &Node::InputPropertyChanged, this, mark);
+  connect(node, &Node::KeyframeAdded, this, mark);
+  connect(node, &Node::KeyframeRemoved, this, mark);
+  connect(node, &Node::KeyframeTimeChanged, this, mark);
+  connect(node, &Node::KeyframeTypeChanged, this, mark);
+  connect(node, &Node::KeyframeValueChanged, this, mark);
+  connect(node, &Node::KeyframeEnableChanged, this, mark);
+  connect(node, &Node::NodeAddedToContext, this, mark);
+  connect(node, &Node::NodePositionInContextChanged, this, mark);
+  connect(node, &Node::NodeRemovedFromContext, this, mark);
+
+  // State saved by SaveCustom() that isn't stored in inputs
+  if (auto *viewer = dynamic_cast<ViewerOutput *>(node)) {
+    connect(viewer->GetMarkers(), &TimelineMarkerList::MarkerAdded, this, mark);
+    connect(viewer->GetMarkers(), &TimelineMarkerList::MarkerRemoved, this, mark);
+    connect(viewer->GetMarkers(), &TimelineMarkerList::MarkerModified, this, mark);
+    connect(viewer->GetWorkArea(), &TimelineWorkArea::EnabledChanged, this, mark);
+    connect(viewer->GetWorkArea(), &TimelineWorkArea::RangeChanged, this, mark);
+  }
+
+  if (auto *track = dynamic_cast<Track *>(node)) {
+    connect(track, &Track::TrackHeightChanged, this, mark);
+  }
+}
+
+void RecoveryJournal::Unwatch(Node *node) {
+  disconnect(node, nullptr, this, nullptr);
+
+  if (auto *viewer = dynamic_cast<ViewerOutput *>(node)) {
+    disconnect(viewer->GetMarkers(), nullptr, this, nullptr);
+    disconnect(viewer->GetWorkArea(), nullptr, this, nullptr);
+  }
+}
+
+void RecoveryJournal::MarkDirty(Node *node) {
+  // Signals can arrive for nodes that are being added or removed, those are handled by NodeAdded/NodeRemoved
+  if (node && node->parent() == project_) {
+    dirty_.insert(node);
+  }
+}
+
+void RecoveryJournal::NodeAdded(Node *node) {
+  Watch(node);
+
+  removed_.remove(NodePtr(node));
+  dirty_.insert(node);
+}
+
+void RecoveryJournal::NodeRemoved(Node *node) {
+  Unwatch(node);
+
+  dirty_.remove(node);
+  removed_.insert(NodePtr(node));
+}
+
+void RecoveryJournal::Graph::Apply(const Delta &delta) {
+  for (quint64 ptr : delta.removed) {
+    if (nodes.remove(ptr)) {
+      order.removeOne(ptr);
+    }
+  }
+
+  for (const auto &node : delta.nodes) {
+    if (!nodes.contains(node.first)) {
+      order.append(node.first);
+    }
+    nodes.insert(node.first, node.second);
+  }
+
+  if (delta.settings_changed) {
+    settings = delta.settings;
+  }
+}
+
+bool RecoveryJournal::Graph::Load(const QString &filename) {
+  QFile file(filename);
+  if (!file.open(QFile::ReadOnly)) {
+    return false;
+  }
+
+  QByteArray b;
+  if (ProjectSerializer::CheckCompressedID(&file)) {
+    b = qUncompress(file.readAll());
+  } else {
+    file.seek(0);
+    b = file.readAll();
+  }
+
+  QXmlStreamReader reader(b);
+
+  // <olive><project><project>...</project><layout>...</layout></project></olive>
+  if (!XMLReadNextStartElement(&reader) || reader.name() != QStringLiteral("olive")) {
+    return false;
+  }
+
+  while (XMLReadNextStartElement(&reader)) {
+    if (reader.name() != QStringLiteral("project")) {
+      reader.skipCurrentElement();
+      continue;
+    }
+
+    while (XMLReadNextStartElement(&reader)) {
+      if (reader.name() == QStringLiteral("project")) {
+        while (XMLReadNextStartElement(&reader)) {
+          if (reader.name() == QStringLiteral("uuid")) {
+            uuid = reader.readElementText();
+          } else if (reader.name() == QStringLiteral("nodes")) {
+            while (XMLReadNextStartElement(&reader)) {
+              if (reader.name() == QStringLiteral("node")) {
+                quint64 ptr = 0;
+                XMLAttributeLoop((&reader), attr) {
+                  if (attr.name() == QStringLiteral("ptr")) {
+                    ptr = attr.value().toULongLong();
+                  }
+                }
+
+                order.append(ptr);
+                nodes.insert(ptr, CopyElement(&reader));
+              } else {
+                reader.skipCurrentElement();
+              }
+            }
+          } else if (reader.name() == QStringLiteral("settings")) {
+            settings = CopyElement(&reader);
+          } else {
+            reader.skipCurrentElement();
+          }
+        }
+      } else if (reader.name() == QStringLiteral("layout")) {
+        layout = CopyElement(&reader);
+      } else {
+        reader.skipCurrentElement();
+      }
+    }
+  }
+
+  return !reader.hasError();
+}
+
+bool RecoveryJournal::Graph::Write(const QString &filename) const {
+  // Same document ProjectSerializer::Save() produces for a whole project
+  QByteArray b;
+  QXmlStreamWriter writer(&b);
+
+  writer.setAutoFormatting(true);
+  writer.writeStartDocument();
+
+  writer.writeStartElement(QStringLiteral("olive"));
+  writer.writeAttribute(QStringLiteral("version"), QString::number(ProjectSerializer::LatestVersion()));
+  writer.writeAttribute(QStringLiteral("url"), filename);
+
+  writer.writeStartElement(QStringLiteral("project"));
+
+  writer.writeStartElement(QStringLiteral("project"));
+  writer.writeAttribute(QStringLiteral("version"), QString::number(1));
+  writer.writeTextElement(QStringLiteral("uuid"), uuid);
+
+  if (!order.isEmpty()) {
+    writer.writeStartElement(QStringLiteral("nodes"));
+    for (quint64 ptr : order) {
+      WriteFragment(&writer, nodes.value(ptr));
+    }
+    writer.writeEndElement();  // nodes
+  }
+
+  WriteFragment(&writer, settings);
+
+  writer.writeEndElement();  // project
+
+  WriteFragment(&writer, layout);
+
+  writer.writeEndElement();  // project
+
+  writer.writeEndElement();  // olive
+
+  writer.writeEndDocument();
+
+  if (writer.hasError()) {
+    return false;
+  }
+
+  QSaveFile file(filename);
+
+  if (!file.open(QFile::WriteOnly)) {
+    return false;
+  }
+
+  file.write("OVEC");
+  file.write(qCompress(b));
+
+  return file.commit();
+}
+
+}  // namespace olive
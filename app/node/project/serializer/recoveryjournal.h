@@ -0,0 +1,157 @@
+#ifndef RECOVERYJOURNAL_H
+#define RECOVERYJOURNAL_H
+
+#include <QByteArray>   // 序列化后的节点和记录
+#include <QHash>        // 节点指针到其 XML 片段的映射
+#include <QSet>         // 自上次写入以来被修改/删除的节点
+#include <QThreadPool>  // 后台写入线程
+#include <QVector>
+
+#include "node/project.h"
+#include "window/mainwindow/mainwindowlayoutinfo.h"
+
+namespace olive {
+
+/**
+ * @brief 以日志形式增量保存项目的自动恢复数据。
+ *
+ * 不再在 GUI 线程中定期把整个项目序列化成 XML 写盘，而是跟踪自上次写入以来被修改的节点，
+ * 每次撤销栈变化 (提交、撤销、重做) 后只序列化这些节点，连同被删除节点的指针作为一条增量记录追加到日志中。
+ * 压缩和写盘都在一个后台线程中进行。
+ *
+ * 后台线程同时维护整个项目的序列化副本 (每个节点一段 XML)，Compact() 用它写出完整的快照，
+ * 不需要再访问节点图。快照和之后的日志在自动恢复目录中同名，扩展名分别是 .ove 和 .journal，
+ * Replay() 把两者合并成一个可以直接打开的项目文件。
+ *
+ * 节点的所有持久状态 (包括 SaveCustom() 保存的数据) 的改变都必须通过某个信号体现出来并在 Watch() 中连接，
+ * 否则不会被记录，直到该节点下一次被修改。
+ * 所有公开方法都必须在项目所在的线程 (GUI 线程) 中调用。
+ */
+class RecoveryJournal : public QObject {
+  Q_OBJECT
+ public:
+  /**
+   * @brief 开始跟踪 project。所有节点会在这里序列化一次，作为后台副本的初始状态。
+   * @param directory 写入快照和日志的目录 (不存在时会被创建)。
+   */
+  RecoveryJournal(Project *project, QString directory, QObject *parent = nullptr);
+
+  /**
+   * @brief 等待所有排队的写入完成。
+   */
+  ~RecoveryJournal() override;
+
+  /**
+   * @brief 把自上次写入以来的修改作为一条记录追加到日志中。
+   *
+   * 如果还没有快照，会先写出一个快照，之后的修改再追加到它的日志中。
+   * @return 是否有修改需要写入。
+   */
+  bool Flush();
+
+  /**
+   * @brief 写出当前状态的完整快照并开始一个新的日志，旧的日志会被删除。
+   * @param layout 保存在快照中的窗口布局。
+   * @return 快照的文件名。
+   */
+  QString Compact(const MainWindowLayoutInfo &layout);
+
+  /**
+   * @brief 把日志 journal 应用到与其同名的快照上，并把结果写成一个完整的项目文件。
+   *
+   * 日志末尾不完整的记录 (例如写入时程序崩溃) 会被忽略。
+   * @return 是否成功。
+   */
+  static bool Replay(const QString &journal, const QString &output);
+
+  /**
+   * @brief 返回与快照 snapshot 对应的日志文件名。
+   */
+  static QString GetJournalFilename(const QString &snapshot);
+
+  static const QString kSnapshotExtension;  // 快照的扩展名
+  static const QString kJournalExtension;   // 日志的扩展名
+
+ private:
+  /**
+   * @brief 一条日志记录。
+   */
+  struct Delta {
+    QVector<QPair<quint64, QByteArray> > nodes;  // 新增或修改的节点 (指针和 <node> 元素)
+    QVector<quint64> removed;                    // 被删除的节点的指针
+    bool settings_changed = false;               // 项目设置是否改变
+    QByteArray settings;                         // 改变后的 <settings> 元素
+  };
+
+  /**
+   * @brief 项目的序列化副本，可以写成完整的项目文件。
+   */
+  struct Graph {
+    void Apply(const Delta &delta);
+
+    bool Load(const QString &filename);
+
+    [[nodiscard]] bool Write(const QString &filename) const;
+
+    QString uuid;                       // 项目 UUID
+    QVector<quint64> order;             // 节点的写入顺序
+    QHash<quint64, QByteArray> nodes;   // 每个节点的 <node> 元素
+    QByteArray settings;                // <settings> 元素
+    QByteArray layout;                  // <layout> 元素
+  };
+
+  /**
+   * @brief 取出自上次调用以来的所有修改。
+   */
+  Delta TakeDelta();
+
+  /**
+   * @brief 在 directory_ 中为新的快照生成文件名。
+   */
+  [[nodiscard]] QString CreateSnapshotFilename() const;
+
+  /**
+   * @brief (后台线程) 应用 delta 并追加到当前日志中。
+   */
+  void AppendInternal(const Delta &delta);
+
+  /**
+   * @brief (后台线程) 应用 delta，写出快照 snapshot 并以它开始新的日志。
+   */
+  void CompactInternal(const Delta &delta, const QString &snapshot);
+
+  /**
+   * @brief 连接 node 的修改信号，包括 Project 不会转发的信号 (例如标记、工作区和轨道高度)。
+   */
+  void Watch(Node *node);
+
+  /**
+   * @brief 断开 Watch() 建立的所有连接。
+   */
+  void Unwatch(Node *node);
+
+  void MarkDirty(Node *node);
+
+  Project *project_;  // 被跟踪的项目
+
+  QString directory_;  // 快照和日志所在的目录
+
+  QSet<Node *> dirty_;      // 自上次写入以来被修改的节点
+  QSet<quint64> removed_;   // 自上次写入以来被删除的节点
+  bool settings_dirty_;     // 项目设置是否被修改
+  bool has_snapshot_;       // 是否已经写出过快照 (即日志是否已经开始)
+
+  QThreadPool io_pool_;  // 后台写入线程 (只有一个线程，所以记录按提交顺序写入)
+
+  Graph graph_;           // 项目的序列化副本，只在 io_pool_ 中访问
+  QString journal_path_;  // 当前日志的文件名，只在 io_pool_ 中访问
+
+ private slots:
+  void NodeAdded(Node *node);
+
+  void NodeRemoved(Node *node);
+};
+
+}  // namespace olive
+
+#endif  // RECOVERYJOURNAL_H
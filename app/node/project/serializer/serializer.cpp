@@ -213,6 +213,8 @@ ProjectSerializer::Result ProjectSerializer::Copy(const SaveData &data) {
   return res;
 }
 
+uint ProjectSerializer::LatestVersion() { return instances_.last()->Version(); }
+
 bool ProjectSerializer::CheckCompressedID(QFile *file) {
   QByteArray b = file->read(4);
   return !memcmp(b.data(), "OVEC", 4);
@@ -239,6 +239,11 @@ class ProjectSerializer {
    */
   static bool CheckCompressedID(QFile *file);
 
+  /**
+   * @brief (静态方法) 最新的项目文件格式版本，即 Save() 写入 <olive> 元素的 version 属性。
+   */
+  static uint LatestVersion();
+
  protected:
   /**
    * @brief (纯虚保护函数) 派生类必须实现的加载逻辑。
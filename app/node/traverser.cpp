@@ -4,6 +4,7 @@
 #include "node/block/clip/clip.h"
 #include "render/job/footagejob.h"
 #include "render/rendermanager.h"
+#include "render/staticvaluecache.h"
 
 namespace olive {
 
@@ -248,6 +249,21 @@ NodeValueTable NodeTraverser::GenerateTable(const Node *n, const TimeRange &rang
     }
   }
 
+  // Subgraphs that look the same at every time can reuse what a previous frame rendered. Gizmo transforms need
+  // every node's Value() to run, so they always take the regular path.
+  StaticValueCache *static_cache = transform_ ? nullptr : GetStaticValueCache();
+  if (static_cache && !IsTimeInvariant(n)) {
+    static_cache = nullptr;
+  }
+
+  if (static_cache) {
+    NodeValueTable cached;
+    if (static_cache->Get(n, video_params_, &cached)) {
+      value_cache_[n][range] = cached;
+      return cached;
+    }
+  }
+
   // Generate row for node
   NodeValueDatabase database = GenerateDatabase(n, range);
 
@@ -298,11 +314,63 @@ NodeValueTable NodeTraverser::GenerateTable(const Node *n, const TimeRange &rang
     table.Push(primary);
   }
 
+  if (static_cache && !table.Has(NodeValue::kSamples)) {
+    // Store textures rather than jobs, otherwise every frame would still run the shaders
+    table = ResolveTableJobs(table);
+    static_cache->Insert(n, video_params_, table);
+  }
+
   value_cache_[n][range] = table;
 
   return table;
 }
 
+bool NodeTraverser::IsTimeInvariant(const Node *node) {
+  auto it = time_invariant_.constFind(node);
+  if (it != time_invariant_.constEnd()) {
+    return it.value();
+  }
+
+  bool invariant = node->GetFlags() & Node::kTimeInvariant;
+
+  for (int i = 0; invariant && i < node->inputs().size(); i++) {
+    const QString &input = node->inputs().at(i);
+
+    if (node->IsInputConnectedForRender(input)) {
+      invariant = IsTimeInvariant(node->GetConnectedRenderOutput(input));
+    } else if (node->InputIsArray(input)) {
+      int sz = node->InputArraySize(input);
+      for (int j = 0; invariant && j < sz; j++) {
+        if (node->IsInputConnectedForRender(input, j)) {
+          invariant = IsTimeInvariant(node->GetConnectedRenderOutput(input, j));
+        } else {
+          invariant = !node->IsInputKeyframing(input, j);
+        }
+      }
+    } else {
+      invariant = !node->IsInputKeyframing(input);
+    }
+  }
+
+  time_invariant_.insert(node, invariant);
+
+  return invariant;
+}
+
+NodeValueTable NodeTraverser::ResolveTableJobs(const NodeValueTable &table) {
+  NodeValueTable resolved;
+
+  for (int i = 0; i < table.Count(); i++) {
+    NodeValue v = table.at(i);
+    if (v.type() == NodeValue::kTexture) {
+      ResolveJobs(v);
+    }
+    resolved.Push(v);
+  }
+
+  return resolved;
+}
+
 TexturePtr NodeTraverser::ProcessVideoCacheJob(const CacheJob *val) { return nullptr; }
 
 QVector2D NodeTraverser::GenerateResolution() const {
@@ -15,6 +15,7 @@
 namespace olive {  // olive 项目的命名空间
 
 class Node;  // 向前声明 Node 类，避免循环依赖
+class StaticValueCache;
 
 /**
  * @brief NodeTraverser 类负责遍历节点图并计算节点在特定时间或时间范围内的值。
@@ -292,10 +293,25 @@ class NodeTraverser {
   // (虚) 检查当前遍历是否应该使用缓存
   [[nodiscard]] virtual bool UseCache() const { return false; }  // 默认不使用缓存
 
+  /**
+   * @brief 跨帧保存不随时间变化的子图结果的缓存，默认没有 (每帧都重新计算)。
+   */
+  [[nodiscard]] virtual StaticValueCache *GetStaticValueCache() const { return nullptr; }
+
  private:
   // (静态) 创建一个虚拟/占位纹理 (用于默认实现或错误情况)
   static TexturePtr CreateDummyTexture(const VideoParams &p);
 
+  /**
+   * @brief 节点的输出是否在所有时间上都相同：节点标记为 Node::kTimeInvariant、没有关键帧，且所有连接的上游节点都满足同样的条件。
+   */
+  bool IsTimeInvariant(const Node *node);
+
+  /**
+   * @brief 把要跨帧保存的值表中的纹理任务解析为实际的纹理。
+   */
+  NodeValueTable ResolveTableJobs(const NodeValueTable &table);
+
   VideoParams video_params_;  // 当前遍历上下文的视频参数 (分辨率、帧率等)
   AudioParams audio_params_;  // 当前遍历上下文的音频参数 (采样率、通道等)
 
@@ -319,6 +335,8 @@ class NodeTraverser {
   // 内部缓存，用于存储已解析 (实际渲染出来) 的纹理，避免重复渲染相同的Job
   // QHash: 某个 Job 产生的临时纹理标识 (或 Job 指针) -> 实际的 TexturePtr
   QHash<Texture *, TexturePtr> resolved_texture_cache_;
+
+  QHash<const Node *, bool> time_invariant_;  // IsTimeInvariant() 的结果
 };
 
 }  // namespace olive
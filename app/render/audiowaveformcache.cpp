@@ -1,10 +1,17 @@
 #include "audiowaveformcache.h"
 
+#include <QDir>
+#include <QtConcurrent/QtConcurrent>
+
+#include "common/filefunctions.h"
+#include "node/output/viewer/viewer.h"
+#include "node/project/footage/footage.h"
+
 namespace olive {
 
 #define super PlaybackCache
 
-AudioWaveformCache::AudioWaveformCache(QObject *parent) : super{parent} {
+AudioWaveformCache::AudioWaveformCache(QObject *parent) : super{parent}, peaks_state_(kPeaksLoading) {
   waveforms_ = std::make_shared<AudioVisualWaveform>();
 }
 
@@ -18,6 +25,8 @@ void AudioWaveformCache::WriteWaveform(const TimeRange &range, const TimeRangeLi
 
     Validate(r);
   }
+
+  SavePeaksIfComplete();
 }
 
 void DrawSubRect(QPainter *painter, const QRect &rect, const double &scale, const TimeRange &wave_range,
@@ -77,8 +86,131 @@ void AudioWaveformCache::SetPassthrough(PlaybackCache *cache) {
   SetSavingEnabled(c->IsSavingEnabled());
 }
 
+bool AudioWaveformCache::LoadPeaks(ViewerOutput *context, const TimeRange &range, const AudioParams &params) {
+  QString fn = GetPeakFilename(params);
+  if (fn.isEmpty() || range.in() < rational(0)) {
+    return false;
+  }
+
+  SetParameters(params);
+
+  if (fn != peaks_filename_) {
+    // Only try each file once, if it doesn't exist yet it will be written once everything has been rendered
+    peaks_filename_ = fn;
+    peaks_state_ = kPeaksLoading;
+    peaks_pending_.clear();
+
+    // Converting every level takes a while for long media, so keep it off the GUI thread
+    auto *watcher = new QFutureWatcher<WaveformPtr>(this);
+    connect(watcher, &QFutureWatcher<WaveformPtr>::finished, this, [this, watcher, fn] {
+      PeaksLoaded(fn, watcher->result());
+      watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run([fn] {
+      auto p = std::make_shared<AudioVisualWaveform>();
+      return p->LoadPeaks(fn) ? p : nullptr;
+    }));
+  }
+
+  switch (peaks_state_) {
+    case kPeaksLoading:
+      peaks_context_ = context;
+      peaks_pending_.insert(range);
+      return true;
+    case kPeaksLoaded:
+    case kPeaksSaved:
+      // waveforms_ already holds the whole media
+      if (range.out() <= peaks_length_) {
+        Validate(range);
+        return true;
+      }
+      break;
+    case kPeaksFailed:
+      break;
+  }
+
+  return false;
+}
+
+void AudioWaveformCache::PeaksLoaded(const QString &fn, const WaveformPtr &loaded) {
+  if (fn != peaks_filename_ || peaks_state_ != kPeaksLoading) {
+    // The footage changed while we were reading
+    return;
+  }
+
+  TimeRangeList pending = peaks_pending_;
+  peaks_pending_.clear();
+
+  if (loaded) {
+    peaks_state_ = kPeaksLoaded;
+    peaks_length_ = loaded->length();
+    waveforms_->OverwriteSums(*loaded, rational(0), rational(0), peaks_length_);
+  } else {
+    peaks_state_ = kPeaksFailed;
+  }
+
+  for (const TimeRange &r : pending) {
+    if (loaded && r.out() <= peaks_length_) {
+      Validate(r);
+    } else if (peaks_context_) {
+      // Not in the file, so have it rendered after all
+      Request(peaks_context_, r);
+    }
+  }
+}
+
+QString AudioWaveformCache::GetPeakFilename(const AudioParams &params) const {
+  // Anything other than footage can change along with the project, so can't be keyed by its media
+  auto *footage = dynamic_cast<Footage *>(parent());
+  if (!footage || !footage->IsValid() || !params.is_valid()) {
+    return {};
+  }
+
+  AudioParams stream = footage->GetFirstEnabledAudioStream();
+  if (!stream.is_valid()) {
+    return {};
+  }
+
+  QString id = FileFunctions::GetUniqueFileIdentifier(footage->filename());
+  if (id.isEmpty()) {
+    return {};
+  }
+
+  // Named like the conformed audio it's generated from
+  return QDir(GetCacheDirectory())
+      .filePath(QStringLiteral("%1-%2.%3.peaks")
+                    .arg(id, QString::number(stream.stream_index()), QString::number(params.channel_layout())));
+}
+
+void AudioWaveformCache::SavePeaksIfComplete() {
+  QString fn = GetPeakFilename(params_);
+
+  // A file we failed to load is missing, corrupt or stale, so replace it
+  if (fn.isEmpty() || (fn == peaks_filename_ && peaks_state_ != kPeaksFailed)) {
+    return;
+  }
+
+  rational length = static_cast<Footage *>(parent())->GetAudioLength();
+  if (length.isNull() || !GetValidatedRanges().contains(TimeRange(rational(0), length))) {
+    return;
+  }
+
+  peaks_filename_ = fn;
+  peaks_state_ = kPeaksSaved;
+  peaks_length_ = length;
+
+  // The copy keeps the data unchanged while it's written and is freed once it has been
+  auto copy = std::make_shared<AudioVisualWaveform>(*waveforms_);
+  QtConcurrent::run([copy, fn] {
+    if (!copy->SavePeaks(fn)) {
+      qWarning() << "Failed to save waveform peaks:" << fn;
+    }
+  });
+}
+
 void AudioWaveformCache::InvalidateEvent(const TimeRange &range) {
   TimeRangeList::util_remove(&passthroughs_, range);
+  peaks_pending_.remove(range);
 
   super::InvalidateEvent(range);
 }
@@ -1,6 +1,8 @@
 #ifndef AUDIOWAVEFORMCACHE_H  // 防止头文件被重复包含的宏
 #define AUDIOWAVEFORMCACHE_H  // 定义 AUDIOWAVEFORMCACHE_H 宏
 
+#include <QPointer>  // 读取峰值文件期间保存请求的上下文
+
 #include "audio/audiovisualwaveform.h"  // 包含 AudioVisualWaveform 类的定义
 #include "playbackcache.h"              // 包含 PlaybackCache 基类的定义
 
@@ -85,6 +87,19 @@ class AudioWaveformCache : public PlaybackCache {  // AudioWaveformCache 继承
    */
   void SetPassthrough(PlaybackCache *cache) override;
 
+  /**
+   * @brief 尝试用之前保存的峰值文件填充指定范围，而不是重新渲染音频。
+   *
+   * 只有素材 (Footage) 的波形会被保存：它只取决于媒体文件本身，因此峰值文件与适配 (conform) 音频一样
+   * 以媒体的唯一标识命名并保存在项目缓存目录中。峰值文件在第一次被请求时才在后台线程中读取
+   * (例如轨道滚动到可见区域时)，读取期间的请求在读取完成后被验证；如果文件不存在或无效，这些范围会被重新请求并正常渲染。
+   * @param context 发出请求的上下文，用于重新请求峰值文件无法提供的范围。
+   * @param range 请求的时间范围。
+   * @param params 渲染波形时使用的音频参数 (决定通道数)。
+   * @return 如果范围已被填充或将在读取完成后被填充，则返回 true；返回 false 时调用者需要渲染该范围。
+   */
+  bool LoadPeaks(ViewerOutput *context, const TimeRange &range, const AudioParams &params);
+
  protected:
   /**
    * @brief (重写 PlaybackCache::InvalidateEvent) 当缓存的某个时间范围失效时调用的事件处理函数。
@@ -115,6 +130,39 @@ class AudioWaveformCache : public PlaybackCache {  // AudioWaveformCache 继承
 
   // 存储从透传缓存中获取或生成的波形片段及其对应时间范围的列表
   std::vector<WaveformPassthrough> passthroughs_;
+
+  /**
+   * @brief 获取此缓存的峰值文件名。
+   * @return 如果此缓存不属于有效的素材，则返回空字符串。
+   */
+  [[nodiscard]] QString GetPeakFilename(const AudioParams &params) const;
+
+  /**
+   * @brief 如果整个素材的波形都已渲染，并且其峰值文件没有被成功读取过，则在后台将其保存为峰值文件。
+   */
+  void SavePeaksIfComplete();
+
+  /**
+   * @brief 后台线程读取 fn 完成后在 GUI 线程中调用。
+   * @param loaded 读取到的波形；如果读取失败则为 nullptr。
+   */
+  void PeaksLoaded(const QString &fn, const WaveformPtr &loaded);
+
+  /**
+   * @brief peaks_filename_ 的状态。
+   */
+  enum PeaksState {
+    kPeaksLoading,  // 正在后台读取
+    kPeaksLoaded,   // 已读取并写入 waveforms_
+    kPeaksFailed,   // 文件不存在或无效，需要在渲染完成后重新保存
+    kPeaksSaved     // 已从渲染结果保存
+  };
+
+  QString peaks_filename_;                // 已经尝试读取或保存过的峰值文件
+  PeaksState peaks_state_;                // peaks_filename_ 的状态
+  rational peaks_length_;                 // waveforms_ 中来自峰值文件 (或已保存) 的完整波形的长度
+  TimeRangeList peaks_pending_;           // 读取期间被请求的范围
+  QPointer<ViewerOutput> peaks_context_;  // 读取期间请求的上下文
 };
 
 }  // namespace olive
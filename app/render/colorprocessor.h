@@ -73,6 +73,12 @@ class ColorProcessor {
    */
   OCIO::ConstProcessorRcPtr GetProcessor();
 
+  /**
+   * @brief 获取 OCIO 的 CPU 处理器 (用于不支持 GLSL 的后端，例如软件渲染器)。
+   * @return 返回 OCIO::ConstCPUProcessorRcPtr。
+   */
+  [[nodiscard]] OCIO::ConstCPUProcessorRcPtr GetCPUProcessor() const { return cpu_processor_; }
+
   /**
    * @brief 对给定的图像帧 (通过 FramePtr) 应用颜色转换 (通常在CPU上)。
    * @param f 指向要转换的帧的共享指针 (FramePtr)。帧数据会被原地修改。
@@ -0,0 +1,225 @@
+#include "decoderpool.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <algorithm>
+#include <cmath>
+
+namespace olive {
+
+// Enough for a few clips of the same source playing at once (picture-in-picture, multicam angles from one file)
+const int DecoderPool::kMaximumDecodersPerStream = 4;
+const int DecoderPool::kMaximumIdleDecodersPerStream = 2;
+
+// A forward jump this size is usually cheaper to decode through than to seek
+const rational DecoderPool::kNearbyThreshold = rational(2);
+
+DecoderPool::Lease &DecoderPool::Lease::operator=(Lease &&other) noexcept {
+  if (this != &other) {
+    Release();
+
+    pool_ = other.pool_;
+    key_ = std::move(other.key_);
+    decoder_ = std::move(other.decoder_);
+    time_ = other.time_;
+    is_new_ = other.is_new_;
+
+    other.pool_ = nullptr;
+    other.decoder_ = nullptr;
+  }
+
+  return *this;
+}
+
+void DecoderPool::Lease::Release() {
+  if (pool_ && decoder_) {
+    pool_->Release(key_, decoder_, time_);
+  }
+
+  pool_ = nullptr;
+  decoder_ = nullptr;
+}
+
+DecoderPool::Lease DecoderPool::Acquire(const QString &decoder_id, const Decoder::CodecStream &stream,
+                                        const rational &time) {
+  if (!stream.IsValid()) {
+    qWarning() << "Attempted to resolve the decoder of a null stream";
+    return {};
+  }
+
+  // Clips cut from the same file share decoders, so the block isn't part of the key
+  Decoder::CodecStream key(stream.filename(), stream.stream(), nullptr);
+
+  qint64 file_last_modified = QFileInfo(stream.filename()).lastModified().toMSecsSinceEpoch();
+
+  QMutexLocker locker(&mutex_);
+
+  while (true) {
+    std::vector<Entry> &entries = streams_[key];
+
+    // Decoders for an older version of the file are of no use anymore, leased ones are closed when the lease holder
+    // drops its reference
+    auto stale = [file_last_modified](const Entry &e) { return e.last_modified != file_last_modified; };
+    entries.erase(std::remove_if(entries.begin(), entries.end(), stale), entries.end());
+
+    // Prefer idle decoders, then the one whose last position is closest to this request
+    Entry *best = nullptr;
+    double best_distance = 0;
+    for (Entry &e : entries) {
+      if (e.opening) {
+        // Not usable until Open() has returned
+        continue;
+      }
+
+      double distance = std::abs((time - e.last_time).toDouble());
+      if (!best || (e.leases == 0 && best->leases > 0) ||
+          ((e.leases == 0) == (best->leases == 0) && distance < best_distance)) {
+        best = &e;
+        best_distance = distance;
+      }
+    }
+
+    bool nearby_idle = best && best->leases == 0 && best_distance <= kNearbyThreshold.toDouble();
+    bool at_limit = int(entries.size()) >= kMaximumDecodersPerStream;
+
+    if (best && (nearby_idle || at_limit)) {
+      best->leases++;
+      best->last_time = time;
+      return {this, key, best->decoder, time, false};
+    }
+
+    if (!at_limit) {
+      break;
+    }
+
+    // Every decoder this stream may have is still opening, wait for one of them rather than opening yet another
+    open_finished_.wait(&mutex_);
+  }
+
+  Entry e;
+  e.decoder = Decoder::CreateFromID(decoder_id);
+  e.last_modified = file_last_modified;
+  e.last_time = time;
+  e.leases = 1;
+  e.opening = true;
+
+  if (!e.decoder) {
+    return {};
+  }
+
+  DecoderPtr dec = e.decoder;
+  streams_[key].push_back(e);
+
+  locker.unlock();
+
+  bool opened = dec->Open(stream);
+
+  locker.relock();
+
+  std::vector<Entry> &current = streams_[key];
+  auto it = std::find_if(current.begin(), current.end(), [&dec](const Entry &x) { return x.decoder == dec; });
+
+  // Either way, anyone waiting for this stream can pick again
+  open_finished_.wakeAll();
+
+  if (!opened) {
+    qWarning() << "Failed to open decoder for" << stream.filename() << "::" << stream.stream();
+
+    if (it != current.end()) {
+      current.erase(it);
+    }
+    return {};
+  }
+
+  // May have been dropped in the meantime if the file changed, in which case it just isn't shared
+  if (it != current.end()) {
+    it->opening = false;
+  }
+
+  return {this, key, dec, time, true};
+}
+
+void DecoderPool::ClearOld(qint64 min_age) {
+  std::vector<DecoderPtr> evicted;
+
+  QMutexLocker locker(&mutex_);
+
+  for (auto it = streams_.begin(); it != streams_.end();) {
+    std::vector<Entry> &entries = it.value();
+
+    for (auto jt = entries.begin(); jt != entries.end();) {
+      if (jt->leases == 0 && jt->decoder->GetLastAccessedTime() < min_age) {
+        evicted.push_back(jt->decoder);
+        jt = entries.erase(jt);
+      } else {
+        jt++;
+      }
+    }
+
+    if (entries.empty()) {
+      it = streams_.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  locker.unlock();
+
+  // Closing can take a while, so it's done without blocking other threads that want a decoder
+  for (const DecoderPtr &d : evicted) {
+    d->Close();
+  }
+}
+
+void DecoderPool::Release(const Decoder::CodecStream &key, const DecoderPtr &decoder, const rational &time) {
+  std::vector<DecoderPtr> evicted;
+
+  QMutexLocker locker(&mutex_);
+
+  auto it = streams_.find(key);
+  if (it == streams_.end()) {
+    return;
+  }
+
+  std::vector<Entry> &entries = it.value();
+  for (Entry &e : entries) {
+    if (e.decoder == decoder) {
+      e.leases--;
+      e.last_time = time;
+      break;
+    }
+  }
+
+  EvictIdle(entries, evicted);
+
+  locker.unlock();
+
+  for (const DecoderPtr &d : evicted) {
+    d->Close();
+  }
+}
+
+void DecoderPool::EvictIdle(std::vector<Entry> &entries, std::vector<DecoderPtr> &evicted) {
+  while (true) {
+    int idle = 0;
+    auto oldest = entries.end();
+
+    for (auto it = entries.begin(); it != entries.end(); it++) {
+      if (it->leases == 0) {
+        idle++;
+        if (oldest == entries.end() || it->decoder->GetLastAccessedTime() < oldest->decoder->GetLastAccessedTime()) {
+          oldest = it;
+        }
+      }
+    }
+
+    if (idle <= kMaximumIdleDecodersPerStream) {
+      break;
+    }
+
+    evicted.push_back(oldest->decoder);
+    entries.erase(oldest);
+  }
+}
+
+}  // namespace olive
@@ -0,0 +1,113 @@
+#ifndef DECODERPOOL_H
+#define DECODERPOOL_H
+
+#include <QHash>           // 按流索引解码器
+#include <QMutex>          // 保护解码器列表
+#include <QWaitCondition>  // 等待正在打开的解码器
+#include <vector>          // 每个流的解码器列表
+
+#include "codec/decoder.h"
+
+namespace olive {
+
+/**
+ * @brief 所有渲染线程共享的解码器池，按 (文件, 流) 索引。
+ *
+ * 从同一个素材剪切出的所有片段共享这里的解码器，而不是每个片段各自打开一个。
+ * 渲染时通过 Acquire() 租用一个解码器：优先选择空闲且上次解码位置与请求时间相近的解码器，
+ * 这样相邻片段的请求由同一个解码器连续解码；相距较远的请求 (例如多机位中同一素材的不同段落)
+ * 则使用另一个解码器，避免互相打断。
+ *
+ * 每个流最多打开 kMaximumDecodersPerStream 个解码器 (包括正在打开的)，全部被租用时请求会共享最近的一个
+ * (解码器本身是线程安全的)；如果全部都还在打开，请求会等待其中一个打开完成。
+ * 归还后空闲的解码器超过 kMaximumIdleDecodersPerStream 个时，最久未使用的会被关闭。
+ *
+ * 此类是线程安全的。
+ */
+class DecoderPool {
+ public:
+  /**
+   * @brief 一次解码器租用，析构时自动归还。
+   */
+  class Lease {
+   public:
+    Lease() = default;
+
+    ~Lease() { Release(); }
+
+    Lease(Lease &&other) noexcept { *this = std::move(other); }
+
+    Lease &operator=(Lease &&other) noexcept;
+
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+
+    [[nodiscard]] const DecoderPtr &decoder() const { return decoder_; }
+
+    /**
+     * @brief 解码器是否是本次租用时新打开的。
+     */
+    [[nodiscard]] bool is_new() const { return is_new_; }
+
+    /**
+     * @brief 提前归还解码器。
+     */
+    void Release();
+
+   private:
+    friend class DecoderPool;
+
+    Lease(DecoderPool *pool, Decoder::CodecStream key, DecoderPtr decoder, const rational &time, bool is_new)
+        : pool_(pool), key_(std::move(key)), decoder_(std::move(decoder)), time_(time), is_new_(is_new) {}
+
+    DecoderPool *pool_ = nullptr;  // 所属的解码器池
+    Decoder::CodecStream key_;     // 解码器在池中的键
+    DecoderPtr decoder_;           // 租用的解码器
+    rational time_;                // 请求的时间，归还后作为解码器的当前位置
+    bool is_new_ = false;          // 是否是新打开的解码器
+  };
+
+  /**
+   * @brief 租用一个能解码指定流的解码器，必要时打开一个新的。
+   * @param decoder_id 需要新建解码器时使用的解码器 ID。
+   * @param stream 要解码的流 (其中的 Block 会被忽略)。
+   * @param time 请求的时间，用于选择位置最近的解码器。
+   * @return 如果流无效或无法打开，则返回空的租用。
+   */
+  Lease Acquire(const QString &decoder_id, const Decoder::CodecStream &stream, const rational &time);
+
+  /**
+   * @brief 关闭 min_age (毫秒时间戳) 之后没有使用过的空闲解码器。
+   */
+  void ClearOld(qint64 min_age);
+
+  static const int kMaximumDecodersPerStream;      // 每个流最多打开的解码器数量
+  static const int kMaximumIdleDecodersPerStream;  // 每个流最多保留的空闲解码器数量
+  static const rational kNearbyThreshold;          // 请求时间与解码器位置相差不超过此值时视为相近
+
+ private:
+  struct Entry {
+    DecoderPtr decoder;    // 解码器
+    qint64 last_modified;  // 打开时文件的修改时间，文件被替换后解码器作废
+    rational last_time;    // 上次请求的时间
+    int leases;            // 当前的租用数量
+    bool opening;          // 是否仍在 (不持有 mutex_ 的情况下) 打开，打开完成之前不能被其他请求选中
+  };
+
+  void Release(const Decoder::CodecStream &key, const DecoderPtr &decoder, const rational &time);
+
+  /**
+   * @brief 如果空闲的解码器过多，则将最久未使用的移出 entries 并加入 evicted。调用时必须持有 mutex_。
+   */
+  static void EvictIdle(std::vector<Entry> &entries, std::vector<DecoderPtr> &evicted);
+
+  QMutex mutex_;  // 保护 streams_
+
+  QWaitCondition open_finished_;  // 每当一个解码器打开完成 (无论成功与否) 时唤醒
+
+  QHash<Decoder::CodecStream, std::vector<Entry>> streams_;  // 以不含 Block 的流为键
+};
+
+}  // namespace olive
+
+#endif  // DECODERPOOL_H
@@ -1,19 +1,33 @@
 #include "diskmanager.h"
 
+#include <QCoreApplication>
 #include <QDataStream>
 #include <QDir>
+#include <QDirIterator>
 #include <QFile>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <QSaveFile>
 #include <QStandardPaths>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
 
 #include "common/filefunctions.h"
 #include "config/config.h"
 #include "core.h"
 #include "dialog/diskcache/diskcachedialog.h"
+#include "render/framememorycache.h"
 
 namespace olive {
 
+namespace {
+
+// Appended (with a counter) to evicted files while they wait for deletion. Specific enough that the crash recovery
+// sweep can't mistake anything else in a user-chosen cache folder for one of them.
+const QString kEvictedMarker = QStringLiteral(".olive-evicted.");
+
+}  // namespace
+
 DiskManager *DiskManager::instance_ = nullptr;
 
 DiskManager::DiskManager() {
@@ -67,6 +81,10 @@ DiskManager::~DiskManager() {
 void DiskManager::CreateInstance() { instance_ = new DiskManager(); }
 
 void DiskManager::DestroyInstance() {
+  // Let background cache writes finish and register their files before the index is saved
+  FrameMemoryCache::instance()->WaitForPendingWrites();
+  QCoreApplication::sendPostedEvents(instance_);
+
   delete instance_;
   instance_ = nullptr;
 }
@@ -92,6 +110,11 @@ void DiskManager::DeleteSpecificFile(const QString &filename) {
 }
 
 bool DiskManager::ClearDiskCache(const QString &cache_folder) {
+  // Otherwise frames still being written would reappear after the clear
+  FrameMemoryCache::instance()->WaitForPendingWrites();
+  QCoreApplication::sendPostedEvents(this);
+  FrameMemoryCache::instance()->Clear();
+
   DiskCacheFolder *f = GetOpenFolder(cache_folder);
 
   return f->ClearCache();
@@ -151,6 +174,9 @@ void DiskManager::ShowDiskCacheSettingsDialog(const QString &path, QWidget *pare
 }
 
 DiskCacheFolder::DiskCacheFolder(const QString &path, QObject *parent) : QObject(parent) {
+  // One thread keeps deletions and index writes in the order they were queued
+  io_pool_.setMaxThreadCount(1);
+
   SetPath(path);
 
   save_timer_.setInterval(OLIVE_CONFIG("DiskCacheSaveInterval").toInt());
@@ -163,15 +189,21 @@ DiskCacheFolder::~DiskCacheFolder() { CloseCacheFolder(); }
 bool DiskCacheFolder::ClearCache() {
   bool deleted_files = true;
 
-  auto i = disk_data_.begin();
+  // Anything still queued for deletion should be gone before we report the cache as cleared
+  io_pool_.waitForDone();
 
-  while (i != disk_data_.end()) {
+  auto i = lru_.begin();
+
+  while (i != lru_.end()) {
     // We return a false result if any of the files fail to delete, but still try to delete as many as we can
-    QString filename = i.key();
+    QString filename = i->filename;
 
     if (QFile::remove(filename) || !QFileInfo::exists(filename)) {
       emit DeletedFrame(path_, filename);
-      i = disk_data_.erase(i);
+      consumption_ -= i->file_size;
+      disk_data_.remove(filename);
+      MarkDirty(filename);
+      i = lru_.erase(i);
     } else {
       qWarning() << "Failed to delete" << filename;
       deleted_files = false;
@@ -183,22 +215,38 @@ bool DiskCacheFolder::ClearCache() {
 }
 
 void DiskCacheFolder::Accessed(const QString &filename) {
-  if (!disk_data_.contains(filename)) {
+  auto it = disk_data_.constFind(filename);
+  if (it == disk_data_.constEnd()) {
     return;
   }
 
-  disk_data_[filename].access_time = QDateTime::currentMSecsSinceEpoch();
+  EntryList::iterator entry = it.value();
+  entry->access_time = QDateTime::currentMSecsSinceEpoch();
+  lru_.splice(lru_.end(), lru_, entry);
+
+  MarkDirty(filename);
 }
 
 void DiskCacheFolder::CreatedFile(const QString &filename) {
   qint64 file_size = QFile(filename).size();
 
-  disk_data_.insert(filename, {file_size, QDateTime::currentMSecsSinceEpoch()});
+  auto existing = disk_data_.constFind(filename);
+  if (existing != disk_data_.constEnd()) {
+    // Overwritten, so replace the old size
+    consumption_ -= existing.value()->file_size;
+    lru_.erase(existing.value());
+  }
+
+  lru_.push_back({filename, file_size, QDateTime::currentMSecsSinceEpoch()});
+  disk_data_.insert(filename, std::prev(lru_.end()));
+  MarkDirty(filename);
 
   consumption_ += file_size;
 
   while (consumption_ > limit_) {
-    DeleteLeastRecent();
+    if (!DeleteLeastRecent()) {
+      break;
+    }
   }
 }
 
@@ -207,12 +255,14 @@ void DiskCacheFolder::SetPath(const QString &path) {
   CloseCacheFolder();
 
   // Signal that disk cache is gone
-  if (!disk_data_.empty()) {
-    for (auto it = disk_data_.cbegin(); it != disk_data_.cend(); it++) {
-      emit DeletedFrame(path_, it.key());
+  if (!lru_.empty()) {
+    for (const HashTime &ht : lru_) {
+      emit DeletedFrame(path_, ht.filename);
     }
+    lru_.clear();
     disk_data_.clear();
   }
+  dirty_.clear();
 
   // Set defaults
   clear_on_close_ = false;
@@ -227,8 +277,15 @@ void DiskCacheFolder::SetPath(const QString &path) {
   FileFunctions::DirectoryIsValid(path_dir);
 
   index_path_ = path_dir.filePath(QStringLiteral("index"));
+  journal_path_ = path_dir.filePath(QStringLiteral("index.journal"));
 
   // Try to load any current cache index from file
+  LoadDiskCacheIndex();
+}
+
+void DiskCacheFolder::LoadDiskCacheIndex() {
+  QHash<QString, HashTime> loaded;
+
   QFile cache_index_file(index_path_);
 
   if (cache_index_file.open(QFile::ReadOnly)) {
@@ -238,76 +295,141 @@ void DiskCacheFolder::SetPath(const QString &path) {
     ds >> clear_on_close_;
 
     while (!cache_index_file.atEnd()) {
-      QString filename;
       HashTime h{};
 
-      ds >> filename;
+      ds >> h.filename;
       ds >> h.file_size;
       ds >> h.access_time;
 
-      if (QFileInfo::exists(filename)) {
-        consumption_ += h.file_size;
-        disk_data_.insert(filename, h);
-      }
+      loaded.insert(h.filename, h);
     }
 
     cache_index_file.close();
   }
-}
 
-bool DiskCacheFolder::DeleteFileInternal(QMap<QString, HashTime>::iterator hash_to_delete) {
-  // Cache HashTime object
-  const QString &filename = hash_to_delete.key();
-  HashTime ht = hash_to_delete.value();
+  saved_limit_ = limit_;
+  saved_clear_on_close_ = clear_on_close_;
 
-  // Remove from disk
-  QFile f(filename);
+  // Replay everything that changed since the snapshot was written
+  journal_records_ = 0;
 
-  if (!f.exists() || f.remove()) {
-    // Remove from internal map
-    disk_data_.erase(hash_to_delete);
+  QFile journal_file(journal_path_);
 
-    // Reduce consumption
-    consumption_ -= ht.file_size;
+  if (journal_file.open(QFile::ReadOnly)) {
+    QDataStream ds(&journal_file);
 
-    emit DeletedFrame(path_, filename);
-    return true;
-  }
+    while (!journal_file.atEnd()) {
+      quint8 op;
+      HashTime h{};
 
-  return false;
-}
+      ds >> op;
+      ds >> h.filename;
 
-bool DiskCacheFolder::DeleteSpecificFile(const QString &f) {
-  for (auto it = disk_data_.begin(); it != disk_data_.end(); it++) {
-    if (it.key() == f) {
-      // Break out of this loop, assuming we'll only have one instance of each filename
-      return DeleteFileInternal(it);
+      if (op == kJournalUpdate) {
+        ds >> h.file_size;
+        ds >> h.access_time;
+      }
+
+      if (ds.status() != QDataStream::Ok) {
+        // Truncated by a crash mid-write, everything before this is still good
+        break;
+      }
+
+      if (op == kJournalUpdate) {
+        loaded.insert(h.filename, h);
+      } else {
+        loaded.remove(h.filename);
+      }
+
+      journal_records_++;
     }
+
+    journal_file.close();
   }
 
-  return false;
-}
+  std::vector<HashTime> entries;
+  entries.reserve(loaded.size());
+  for (auto it = loaded.cbegin(); it != loaded.cend(); it++) {
+    if (QFileInfo::exists(it.key())) {
+      entries.push_back(it.value());
+    }
+  }
 
-bool DiskCacheFolder::DeleteLeastRecent() {
-  auto hash_to_delete = disk_data_.begin();
+  std::sort(entries.begin(), entries.end(),
+            [](const HashTime &a, const HashTime &b) { return a.access_time < b.access_time; });
+
+  for (const HashTime &h : entries) {
+    consumption_ += h.file_size;
+    lru_.push_back(h);
+    disk_data_.insert(h.filename, std::prev(lru_.end()));
+  }
 
-  if (disk_data_.begin() != disk_data_.end()) {
-    for (auto it = disk_data_.begin() + 1; it != disk_data_.end(); it++) {
-      if (it->access_time < hash_to_delete->access_time) {
-        hash_to_delete = it;
+  // Evicted files that were renamed but never deleted because the last session crashed first. If one of ours is
+  // renamed before this runs it gets swept up too, which is fine since it was going to be deleted anyway.
+  QString path = path_;
+  QtConcurrent::run(&io_pool_, [path] {
+    QDirIterator it(path, {QStringLiteral("*") + kEvictedMarker + QStringLiteral("*")}, QDir::Files,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+      QString doomed = it.next();
+      if (!QFile::remove(doomed)) {
+        qWarning() << "Failed to delete" << doomed;
       }
     }
+  });
+}
+
+bool DiskCacheFolder::DeleteFileInternal(EntryList::iterator hash_to_delete) {
+  // Cache HashTime object
+  HashTime ht = *hash_to_delete;
 
-    bool e = DeleteFileInternal(hash_to_delete);
+  // Move the file out of the way first so a frame re-cached under the same name can't be deleted by the worker
+  QString doomed = ht.filename + kEvictedMarker + QString::number(++deleted_count_);
 
-    if (e) {
-      Core::instance()->WarnCacheFull();
-    }
+  if (QFile::rename(ht.filename, doomed)) {
+    QtConcurrent::run(&io_pool_, [doomed] {
+      if (!QFile::remove(doomed) && QFile::exists(doomed)) {
+        qWarning() << "Failed to delete" << doomed;
+      }
+    });
+  } else if (QFile::exists(ht.filename) && !QFile::remove(ht.filename)) {
+    // Couldn't rename (e.g. the file is still open on Windows) and removing it right away failed too
+    return false;
+  }
 
-    return e;
-  } else {
+  // Remove from internal map
+  disk_data_.remove(ht.filename);
+  lru_.erase(hash_to_delete);
+  MarkDirty(ht.filename);
+
+  // Reduce consumption
+  consumption_ -= ht.file_size;
+
+  emit DeletedFrame(path_, ht.filename);
+  return true;
+}
+
+bool DiskCacheFolder::DeleteSpecificFile(const QString &f) {
+  auto it = disk_data_.constFind(f);
+  if (it == disk_data_.constEnd()) {
     return false;
   }
+
+  return DeleteFileInternal(it.value());
+}
+
+bool DiskCacheFolder::DeleteLeastRecent() {
+  if (lru_.empty()) {
+    return false;
+  }
+
+  bool e = DeleteFileInternal(lru_.begin());
+
+  if (e) {
+    Core::instance()->WarnCacheFull();
+  }
+
+  return e;
 }
 
 void DiskCacheFolder::CloseCacheFolder() {
@@ -321,30 +443,93 @@ void DiskCacheFolder::CloseCacheFolder() {
     ClearCache();
   }
 
-  // Save current cache index
-  SaveDiskCacheIndex();
+  // Save current cache index, and leave a clean snapshot behind so the next load doesn't need to replay anything
+  CompactDiskCacheIndex(true);
 }
 
 void DiskCacheFolder::SaveDiskCacheIndex() {
-  QFile cache_index_file(index_path_);
-
-  if (cache_index_file.open(QFile::WriteOnly)) {
-    QDataStream ds(&cache_index_file);
+  if (journal_records_ + dirty_.size() > qMax(qint64(disk_data_.size()), qint64(1024)) || limit_ != saved_limit_ ||
+      clear_on_close_ != saved_clear_on_close_) {
+    // The journal would outgrow the snapshot (or the settings in the snapshot's header changed)
+    CompactDiskCacheIndex(false);
+    return;
+  }
 
-    ds << limit_;
-    ds << clear_on_close_;
+  if (dirty_.isEmpty()) {
+    return;
+  }
 
-    for (auto it = disk_data_.cbegin(); it != disk_data_.cend(); it++) {
-      const HashTime &ht = it.value();
+  QByteArray records;
+  QDataStream ds(&records, QIODevice::WriteOnly);
 
-      ds << it.key();
+  for (const QString &filename : qAsConst(dirty_)) {
+    auto it = disk_data_.constFind(filename);
+    if (it == disk_data_.constEnd()) {
+      ds << quint8(kJournalRemove);
+      ds << filename;
+    } else {
+      const HashTime &ht = *it.value();
+      ds << quint8(kJournalUpdate);
+      ds << filename;
       ds << ht.file_size;
       ds << ht.access_time;
     }
+  }
 
-    cache_index_file.close();
-  } else {
-    qWarning() << "Failed to write cache index:" << index_path_;
+  journal_records_ += dirty_.size();
+  dirty_.clear();
+
+  QString journal_path = journal_path_;
+  QtConcurrent::run(&io_pool_, [journal_path, records] {
+    QFile journal_file(journal_path);
+
+    if (journal_file.open(QFile::WriteOnly | QFile::Append)) {
+      journal_file.write(records);
+      journal_file.close();
+    } else {
+      qWarning() << "Failed to write cache index journal:" << journal_path;
+    }
+  });
+}
+
+void DiskCacheFolder::CompactDiskCacheIndex(bool wait) {
+  QByteArray snapshot;
+  QDataStream ds(&snapshot, QIODevice::WriteOnly);
+
+  ds << limit_;
+  ds << clear_on_close_;
+
+  for (const HashTime &ht : lru_) {
+    ds << ht.filename;
+    ds << ht.file_size;
+    ds << ht.access_time;
+  }
+
+  saved_limit_ = limit_;
+  saved_clear_on_close_ = clear_on_close_;
+  journal_records_ = 0;
+  dirty_.clear();
+
+  QString index_path = index_path_;
+  QString journal_path = journal_path_;
+  QtConcurrent::run(&io_pool_, [index_path, journal_path, snapshot] {
+    QSaveFile cache_index_file(index_path);
+
+    if (cache_index_file.open(QFile::WriteOnly)) {
+      cache_index_file.write(snapshot);
+
+      if (cache_index_file.commit()) {
+        // Only once the snapshot is safely in place can we drop what it replaces
+        QFile::remove(journal_path);
+        return;
+      }
+    }
+
+    qWarning() << "Failed to write cache index:" << index_path;
+  });
+
+  if (wait) {
+    io_pool_.waitForDone();
   }
 }
 
@@ -1,10 +1,13 @@
 #ifndef DISKMANAGER_H  // 防止头文件被重复包含的宏
 #define DISKMANAGER_H  // 定义 DISKMANAGER_H 宏
 
-#include <QMap>     // Qt 映射容器 (有序哈希表)
-#include <QMutex>   // Qt 互斥锁 (虽然在此头文件中未直接使用，但具体实现中可能需要)
-#include <QObject>  // Qt 对象模型基类
-#include <QTimer>   // Qt 定时器类
+#include <QHash>        // 文件名到 LRU 节点的映射
+#include <QMutex>       // Qt 互斥锁 (虽然在此头文件中未直接使用，但具体实现中可能需要)
+#include <QObject>      // Qt 对象模型基类
+#include <QSet>         // 上次保存索引后改变过的文件
+#include <QThreadPool>  // 后台删除文件和写入索引
+#include <QTimer>       // Qt 定时器类
+#include <list>         // LRU 链表
 
 #include "common/define.h"  // 可能包含项目通用的定义或宏
 #include "node/project.h"   // 包含 Project 类的定义 (DiskManager 可能需要与项目交互)
@@ -17,6 +20,11 @@ namespace olive {  // olive 项目的命名空间
  * 它跟踪文件夹中的文件、它们的访问时间、文件大小，并根据设定的限制 (大小限制、关闭时清除等)
  * 来管理缓存的清理。当缓存大小超过限制时，它会删除最近最少使用的文件。
  * 它还会定期将缓存索引（文件列表及其元数据）保存到磁盘。
+ *
+ * 文件保存在按访问顺序排列的链表中并以文件名索引，所以访问、创建和淘汰都是 O(1)。
+ * 被淘汰的文件先重命名 (这样同名的新缓存帧不会被误删)，再由后台 I/O 线程删除。
+ * 索引分为快照 (index) 和只追加的日志 (index.journal)：定期保存时只把改变过的文件追加到日志中，
+ * 日志比快照还大时才重写快照。
  */
 class DiskCacheFolder : public QObject {  // DiskCacheFolder 继承自 QObject
  Q_OBJECT                                 // 声明此类使用 Qt 的元对象系统
@@ -107,12 +115,21 @@ class DiskCacheFolder : public QObject {  // DiskCacheFolder 继承自 QObject
  private:
   // 内部结构体，用于存储缓存文件的元数据
   struct HashTime {
+    QString filename;    // 文件名
     qint64 file_size;    // 文件大小 (字节)
     qint64 access_time;  // 文件的最后访问时间戳
   };
 
+  using EntryList = std::list<HashTime>;
+
+  // 日志记录的类型
+  enum JournalOp : quint8 {
+    kJournalUpdate,  // 文件被创建或访问，后跟文件大小和访问时间
+    kJournalRemove   // 文件被删除
+  };
+
   // 内部辅助函数：删除指定的缓存文件 (通过迭代器指向的文件)
-  bool DeleteFileInternal(QMap<QString, HashTime>::iterator hash_to_delete);
+  bool DeleteFileInternal(EntryList::iterator hash_to_delete);
 
   // 删除最近最少使用的文件，直到缓存大小低于限制
   bool DeleteLeastRecent();
@@ -120,11 +137,33 @@ class DiskCacheFolder : public QObject {  // DiskCacheFolder 继承自 QObject
   // 关闭缓存文件夹时调用的清理函数 (例如保存索引)
   void CloseCacheFolder();
 
-  QString path_;        // 缓存文件夹的完整路径
-  QString index_path_;  // 缓存索引文件的路径
+  // 从快照和日志中读取索引，并在后台删除上次运行留下的待删除文件
+  void LoadDiskCacheIndex();
+
+  // 重写完整的快照并清空日志。wait 为 true 时阻塞直到写入完成
+  void CompactDiskCacheIndex(bool wait);
+
+  // 标记文件在上次保存索引后改变过
+  void MarkDirty(const QString& filename) { dirty_.insert(filename); }
+
+  QString path_;          // 缓存文件夹的完整路径
+  QString index_path_;    // 缓存索引文件的路径
+  QString journal_path_;  // 缓存索引日志文件的路径
+
+  EntryList lru_;  // 磁盘上的缓存文件，最久未访问的在前
+
+  QHash<QString, EntryList::iterator> disk_data_;  // 文件名到 LRU 节点的映射
+
+  QSet<QString> dirty_;  // 上次保存索引后改变过的文件
+
+  qint64 journal_records_{};  // 日志中的记录数
+
+  qint64 saved_limit_{};         // 快照中保存的 limit_
+  bool saved_clear_on_close_{};  // 快照中保存的 clear_on_close_
+
+  quint64 deleted_count_{};  // 用于生成待删除文件的唯一名称
 
-  // 存储磁盘上缓存文件及其元数据 (文件名 -> HashTime) 的映射
-  QMap<QString, HashTime> disk_data_;
+  QThreadPool io_pool_;  // 后台 I/O 线程 (只有一个线程，所以删除和索引写入按提交顺序执行)
 
   qint64 consumption_{};  // 当前缓存已占用的磁盘空间 (字节)
   qint64 limit_{};        // 缓存大小限制 (字节)
@@ -7,19 +7,55 @@
 #include <OpenEXR/ImfInputFile.h>
 #include <OpenEXR/ImfIntAttribute.h>
 #include <OpenEXR/ImfOutputFile.h>
+#include <zlib.h>
 #include <QDir>
 #include <QFileInfo>
+#include <QSaveFile>
 #include <utility>
+#include <vector>
+
+#ifndef Q_OS_WINDOWS
+#include <sys/mman.h>
+#endif
 
 #include "codec/frame.h"
 #include "common/filefunctions.h"
 #include "common/oiioutils.h"
+#include "node/project.h"
 #include "render/diskmanager.h"
+#include "render/framememorycache.h"
 
 namespace olive {
 
 #define super PlaybackCache
 
+namespace {
+
+const char kRawCacheMagic[8] = {'O', 'L', 'V', 'R', 'A', 'W', 'F', '1'};
+
+enum RawCacheCompression { kRawUncompressed, kRawZlib };
+
+// Padded to 64 bytes so that mapped pixel data is suitably aligned for SIMD
+struct RawCacheHeader {
+  char magic[8];
+  uint32_t compression;
+  int32_t width;
+  int32_t height;
+  int32_t format;
+  int32_t channel_count;
+  int32_t par_num;
+  int32_t par_den;
+  int32_t divider;
+  int32_t linesize;
+  uint32_t reserved0;
+  uint64_t payload_size;
+  uint64_t reserved1;
+};
+
+static_assert(sizeof(RawCacheHeader) == 64, "Raw cache header must be 64 bytes");
+
+}  // namespace
+
 FrameHashCache::FrameHashCache(QObject *parent) : super(parent) {
   if (DiskManager::instance()) {
     connect(DiskManager::instance(), &DiskManager::DeletedFrame, this, &FrameHashCache::HashDeleted);
@@ -36,6 +72,29 @@ void FrameHashCache::ValidateTimestamp(const int64_t &ts) {
 
 void FrameHashCache::ValidateTime(const rational &time) { Validate(TimeRange(time, time + timebase_)); }
 
+FrameHashCache::CacheFormat FrameHashCache::GetCacheFormat() const {
+  if (Project *p = GetProject()) {
+    return p->GetCacheFormat();
+  }
+
+  return kCacheFormatEXR;
+}
+
+QString FrameHashCache::GetCacheFormatName(CacheFormat f) {
+  switch (f) {
+    case kCacheFormatEXR:
+      return tr("OpenEXR/JPEG (Smallest)");
+    case kCacheFormatRaw:
+      return tr("Uncompressed (Fastest)");
+    case kCacheFormatRawCompressed:
+      return tr("Compressed Raw (Lossless)");
+    case kCacheFormatCount:
+      break;
+  }
+
+  return {};
+}
+
 QString FrameHashCache::GetValidCacheFilename(const rational &time) const {
   if (IsFrameCached(time)) {
     return CachePathName(time);
@@ -51,11 +110,11 @@ QString FrameHashCache::GetValidCacheFilename(const rational &time) const {
 }
 
 bool FrameHashCache::SaveCacheFrame(const int64_t &time, FramePtr frame) const {
-  return SaveCacheFrame(GetCacheDirectory(), GetUuid(), time, std::move(frame));
+  return SaveCacheFrame(GetCacheDirectory(), GetUuid(), time, std::move(frame), GetCacheFormat());
 }
 
 bool FrameHashCache::SaveCacheFrame(const QString &cache_path, const QUuid &uuid, const int64_t &time,
-                                    const FramePtr &frame) {
+                                    const FramePtr &frame, CacheFormat format) {
   if (cache_path.isEmpty()) {
     qWarning() << "Failed to save cache frame with empty path";
     return false;
@@ -63,39 +122,26 @@ bool FrameHashCache::SaveCacheFrame(const QString &cache_path, const QUuid &uuid
 
   QString fn = CachePathName(cache_path, uuid, time);
 
-  bool ret = SaveCacheFrame(fn, frame);
-
-  // Register frame with the disk manager
-  if (ret) {
-    QMetaObject::invokeMethod(DiskManager::instance(), "CreatedFile", Q_ARG(QString, cache_path), Q_ARG(QString, fn));
-  }
+  // Keep the decoded frame in memory and write it to disk in the background. The memory cache registers the file
+  // with the disk manager once it's written.
+  FrameMemoryCache::instance()->Insert(fn, cache_path, uuid, time, frame, format);
 
-  return ret;
+  return true;
 }
 
 bool FrameHashCache::SaveCacheFrame(const QString &cache_path, const QUuid &uuid, const rational &time,
-                                    const rational &tb, const FramePtr &frame) {
+                                    const rational &tb, const FramePtr &frame, CacheFormat format) {
   if (cache_path.isEmpty()) {
     qWarning() << "Failed to save cache frame with empty path";
     return false;
   }
 
-  QString fn = CachePathName(cache_path, uuid, time, tb);
-
-  bool ret = SaveCacheFrame(fn, frame);
-
-  // Register frame with the disk manager
-  if (ret) {
-    QMetaObject::invokeMethod(DiskManager::instance(), "CreatedFile", Q_ARG(QString, cache_path), Q_ARG(QString, fn));
-  }
-
-  return ret;
+  return SaveCacheFrame(cache_path, uuid, Timecode::time_to_timestamp(time, tb, Timecode::kRound), frame, format);
 }
 
 FramePtr FrameHashCache::LoadCacheFrame(const QString &cache_path, const QUuid &uuid, const int64_t &time) {
-  // Minor optimization, we store frames currently being saved just in case something tries to load
-  // while we're saving. This should *occasionally* optimize and also prevent scenarios where
-  // we try to load a frame that's half way through being saved.
+  // Computing the filename also registers the access with the disk manager, so its LRU stays accurate even when
+  // the frame comes from memory
   QString filename = CachePathName(cache_path, uuid, time);
 
   if (cache_path.isEmpty()) {
@@ -103,7 +149,17 @@ FramePtr FrameHashCache::LoadCacheFrame(const QString &cache_path, const QUuid &
     return nullptr;
   }
 
-  return LoadCacheFrame(filename);
+  // Frames currently being saved are also served from memory, which prevents reading a half-written file
+  if (FramePtr frame = FrameMemoryCache::instance()->Get(uuid, time)) {
+    return frame;
+  }
+
+  FramePtr frame = LoadCacheFrameFromDisk(filename);
+  if (frame) {
+    FrameMemoryCache::instance()->Put(uuid, time, frame);
+  }
+
+  return frame;
 }
 
 FramePtr FrameHashCache::LoadCacheFrame(const int64_t &hash) const {
@@ -111,9 +167,55 @@ FramePtr FrameHashCache::LoadCacheFrame(const int64_t &hash) const {
 }
 
 FramePtr FrameHashCache::LoadCacheFrame(const QString &fn) {
+  QUuid uuid;
+  int64_t timestamp;
+  if (!FrameMemoryCache::ParseFilename(fn, &uuid, &timestamp)) {
+    return LoadCacheFrameFromDisk(fn);
+  }
+
+  if (FramePtr frame = FrameMemoryCache::instance()->Get(uuid, timestamp)) {
+    return frame;
+  }
+
+  FramePtr frame = LoadCacheFrameFromDisk(fn);
+  if (frame) {
+    FrameMemoryCache::instance()->Put(uuid, timestamp, frame);
+  }
+
+  return frame;
+}
+
+bool FrameHashCache::CacheFrameExists(const QString &fn) {
+  QUuid uuid;
+  int64_t timestamp;
+  if (FrameMemoryCache::ParseFilename(fn, &uuid, &timestamp) && FrameMemoryCache::instance()->Contains(uuid, timestamp)) {
+    return true;
+  }
+
+  return QFileInfo::exists(fn);
+}
+
+FramePtr FrameHashCache::LoadCacheFrameFromDisk(const QString &fn) {
   FramePtr frame = nullptr;
 
   if (!fn.isEmpty() && QFileInfo::exists(fn)) {
+    // Raw frames are identified by their header, so frames written before the format was changed still load
+    QFile raw_file(fn);
+    if (raw_file.open(QFile::ReadOnly) && raw_file.peek(sizeof(kRawCacheMagic)) ==
+                                              QByteArray::fromRawData(kRawCacheMagic, sizeof(kRawCacheMagic))) {
+      frame = LoadRawCacheFrame(&raw_file);
+
+      if (!frame) {
+        qCritical() << "Failed to read raw cache frame:" << fn;
+
+        // Assume this frame is corrupt in some way and delete it
+        QMetaObject::invokeMethod(DiskManager::instance(), "DeleteSpecificFile", Q_ARG(QString, fn));
+      }
+
+      return frame;
+    }
+    raw_file.close();
+
     try {
       Imf::InputFile file(fn.toUtf8(), 0);
 
@@ -244,6 +346,7 @@ void FrameHashCache::HashDeleted(const QString &path, const QString &filename) {
   }
 
   int64_t timestamp = info.fileName().toLongLong();
+  FrameMemoryCache::instance()->Remove(GetUuid(), timestamp);
   Invalidate(TimeRange(ToTime(timestamp), ToTime(timestamp + 1)));
 }
 
@@ -278,13 +381,17 @@ QString FrameHashCache::CachePathName(const QString &cache_path, const QUuid &ca
   return CachePathName(cache_path, cache_id, Timecode::time_to_timestamp(time, tb, Timecode::kRound));
 }
 
-bool FrameHashCache::SaveCacheFrame(const QString &filename, const FramePtr &frame) {
+bool FrameHashCache::SaveCacheFrame(const QString &filename, const FramePtr &frame, CacheFormat format) {
   // Ensure directory is created
   QDir cache_dir = QFileInfo(filename).dir();
   if (!FileFunctions::DirectoryIsValid(cache_dir)) {
     return false;
   }
 
+  if (format == kCacheFormatRaw || format == kCacheFormatRawCompressed) {
+    return SaveRawCacheFrame(filename, frame, format == kCacheFormatRawCompressed);
+  }
+
   if (VideoParams::FormatIsFloat(frame->format())) {
     // Floating point types are stored in EXR
     Imf::PixelType pix_type;
@@ -368,4 +475,129 @@ bool FrameHashCache::SaveCacheFrame(const QString &filename, const FramePtr &fra
   }
 }
 
+bool FrameHashCache::SaveRawCacheFrame(const QString &filename, const FramePtr &frame, bool compress) {
+  RawCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kRawCacheMagic, sizeof(kRawCacheMagic));
+  header.width = frame->video_params().width();
+  header.height = frame->video_params().height();
+  header.format = static_cast<PixelFormat::Format>(frame->format());
+  header.channel_count = frame->channel_count();
+  header.par_num = frame->video_params().pixel_aspect_ratio().numerator();
+  header.par_den = frame->video_params().pixel_aspect_ratio().denominator();
+  header.divider = frame->video_params().divider();
+  header.linesize = frame->linesize_bytes();
+
+  const auto *src = reinterpret_cast<const Bytef *>(frame->const_data());
+  uLong src_size = uLong(frame->linesize_bytes()) * uLong(frame->height());
+
+  std::vector<Bytef> compressed;
+  if (compress) {
+    uLongf compressed_size = compressBound(src_size);
+    compressed.resize(compressed_size);
+
+    if (compress2(compressed.data(), &compressed_size, src, src_size, Z_BEST_SPEED) != Z_OK) {
+      qCritical() << "Failed to compress cache frame";
+      return false;
+    }
+
+    compressed.resize(compressed_size);
+    src = compressed.data();
+    src_size = compressed_size;
+    header.compression = kRawZlib;
+  } else {
+    header.compression = kRawUncompressed;
+  }
+
+  header.payload_size = src_size;
+
+  // Uncompressed frames may currently be mapped by a reader, so never truncate an existing file in place. QSaveFile
+  // writes to a temporary file and renames it over the old one, which POSIX mappings survive. Windows can't replace a
+  // file with a mapped view, which is why frames aren't mapped there (see LoadRawCacheFrame()).
+  QSaveFile f(filename);
+  if (!f.open(QFile::WriteOnly)) {
+    qCritical() << "Failed to write cache frame:" << f.errorString();
+    return false;
+  }
+
+  if (f.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header) ||
+      f.write(reinterpret_cast<const char *>(src), qint64(src_size)) != qint64(src_size)) {
+    qCritical() << "Failed to write cache frame:" << f.errorString();
+    f.cancelWriting();
+    return false;
+  }
+
+  return f.commit();
+}
+
+FramePtr FrameHashCache::LoadRawCacheFrame(QFile *file) {
+  RawCacheHeader header;
+  if (file->read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)) {
+    return nullptr;
+  }
+
+  if (header.width <= 0 || header.height <= 0 || header.divider <= 0 || header.channel_count <= 0 ||
+      header.par_den == 0 || header.format <= PixelFormat::INVALID || header.format >= PixelFormat::COUNT) {
+    return nullptr;
+  }
+
+  FramePtr frame = Frame::Create();
+  frame->set_video_params(VideoParams(header.width, header.height,
+                                      PixelFormat(static_cast<PixelFormat::Format>(header.format)),
+                                      header.channel_count, rational(header.par_num, header.par_den),
+                                      VideoParams::kInterlaceNone, header.divider));
+
+  // The stride is part of the file, so it must match what this build would allocate
+  if (frame->linesize_bytes() != header.linesize) {
+    return nullptr;
+  }
+
+  qint64 data_size = qint64(frame->linesize_bytes()) * frame->height();
+
+  if (header.compression == kRawUncompressed) {
+    if (qint64(header.payload_size) != data_size || file->size() < qint64(sizeof(header)) + data_size) {
+      return nullptr;
+    }
+
+#ifdef Q_OS_WINDOWS
+    // A mapped view would stop the file from being replaced until the frame is gone, which could be a long time
+    // while it sits in the memory cache, so read it instead
+    if (!frame->allocate() || file->read(frame->data(), data_size) != data_size) {
+      return nullptr;
+    }
+#else
+    // Private (copy-on-write) mapping so anything writing into the frame doesn't touch the file. The header is mapped
+    // too since the offset has to be page aligned, and being 64 bytes it keeps the pixel data aligned.
+    size_t map_size = sizeof(header) + data_size;
+    void *map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file->handle(), 0);
+    if (map == MAP_FAILED) {
+      return nullptr;
+    }
+
+    // The mapping doesn't need the descriptor, so the file is closed as usual and cached frames don't each hold one
+    // open. The frame (and anything sharing its data) unmaps it when done.
+    std::shared_ptr<void> owner(map, [map_size](void *p) { munmap(p, map_size); });
+    frame->set_external_data(static_cast<char *>(map) + sizeof(header), owner);
+#endif
+  } else if (header.compression == kRawZlib) {
+    QByteArray compressed = file->read(qint64(header.payload_size));
+    if (compressed.size() != qint64(header.payload_size)) {
+      return nullptr;
+    }
+
+    frame->allocate();
+
+    uLongf dest_size = data_size;
+    if (uncompress(reinterpret_cast<Bytef *>(frame->data()), &dest_size,
+                   reinterpret_cast<const Bytef *>(compressed.constData()), compressed.size()) != Z_OK ||
+        qint64(dest_size) != data_size) {
+      return nullptr;
+    }
+  } else {
+    return nullptr;
+  }
+
+  return frame;
+}
+
 }  // namespace olive
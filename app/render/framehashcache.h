@@ -1,6 +1,8 @@
 #ifndef VIDEORENDERFRAMECACHE_H  // 防止头文件被重复包含的宏
 #define VIDEORENDERFRAMECACHE_H  // 定义 VIDEORENDERFRAMECACHE_H 宏
 
+#include <QFile>  // 读取原始格式的缓存帧
+
 #include "codec/frame.h"           // 包含 Frame (或 FramePtr) 相关的定义
 #include "render/playbackcache.h"  // 包含 PlaybackCache 基类的定义
 #include "render/videoparams.h"    // 包含 VideoParams (视频参数) 相关的定义 (虽然未直接使用，但逻辑上相关)
@@ -28,6 +30,18 @@ class FrameHashCache : public PlaybackCache {  // FrameHashCache 继承自 Playb
  Q_OBJECT                                      // 声明此类使用 Qt 的元对象系统
 
      public :
+     /**
+      * @brief 缓存帧在磁盘上的存储格式 (项目设置，见 Project::GetCacheFormat())。
+      *
+      * 数值会保存在项目文件中，因此只能在末尾添加新值。
+      */
+     enum CacheFormat {
+       kCacheFormatEXR,            // 浮点帧使用 DWAA 压缩的 EXR，8 位帧使用 JPEG (有损，占用空间最小)
+       kCacheFormatRaw,            // 未压缩的原始像素，读取时直接内存映射，不需要拷贝和解码
+       kCacheFormatRawCompressed,  // 使用快速无损压缩的原始像素
+       kCacheFormatCount
+     };
+
      /**
       * @brief 构造函数。
       * @param parent 父对象指针，默认为 nullptr。
@@ -73,15 +87,26 @@ class FrameHashCache : public PlaybackCache {  // FrameHashCache 继承自 Playb
    */
   [[nodiscard]] QString GetValidCacheFilename(const rational &time) const;
 
+  /**
+   * @brief 获取此缓存所属项目设置的缓存帧格式。如果缓存不属于任何项目，则返回 kCacheFormatEXR。
+   */
+  [[nodiscard]] CacheFormat GetCacheFormat() const;
+
+  /**
+   * @brief 获取缓存帧格式的显示名称。
+   */
+  static QString GetCacheFormatName(CacheFormat f);
+
   // --- 静态和成员函数，用于保存和加载缓存帧 ---
 
   /**
-   * @brief (静态) 将给定的视频帧保存到指定的文件名。
+   * @brief (静态) 将给定的视频帧同步编码并保存到指定的文件名 (由 FrameMemoryCache 的写入线程调用)。
    * @param filename 要保存到的完整文件路径。
    * @param frame 指向要保存的帧数据的 FramePtr。
+   * @param format 存储格式。
    * @return 如果保存成功，返回 true。
    */
-  static bool SaveCacheFrame(const QString &filename, const FramePtr &frame);
+  static bool SaveCacheFrame(const QString &filename, const FramePtr &frame, CacheFormat format = kCacheFormatEXR);
   /**
    * @brief 将给定的视频帧保存到由此缓存实例管理的位置，使用时间戳作为标识。
    * @param time 帧对应的时间戳 (整数)。
@@ -95,14 +120,16 @@ class FrameHashCache : public PlaybackCache {  // FrameHashCache 继承自 Playb
    * @param uuid 缓存的唯一标识符 (通常与特定节点或项目关联)。
    * @param time 帧对应的时间戳 (整数)。
    * @param frame 指向要保存的帧数据的 FramePtr。
-   * @return 如果保存成功，返回 true。
+   * @param format 后台写入磁盘时使用的存储格式。
+   * @return 帧会被放入 FrameMemoryCache 并在后台写入磁盘，因此总是立即返回 true。
    */
-  static bool SaveCacheFrame(const QString &cache_path, const QUuid &uuid, const int64_t &time, const FramePtr &frame);
+  static bool SaveCacheFrame(const QString &cache_path, const QUuid &uuid, const int64_t &time, const FramePtr &frame,
+                             CacheFormat format = kCacheFormatEXR);
   /**
    * @brief (静态) 将给定的视频帧保存到指定的缓存路径，使用 UUID、rational 时间和时间基准作为标识。
    */
   static bool SaveCacheFrame(const QString &cache_path, const QUuid &uuid, const rational &time, const rational &tb,
-                             const FramePtr &frame);
+                             const FramePtr &frame, CacheFormat format = kCacheFormatEXR);
   /**
    * @brief (静态) 从指定的缓存路径加载由 UUID 和时间戳标识的缓存帧。
    * @param cache_path 缓存的根路径。
@@ -124,6 +151,12 @@ class FrameHashCache : public PlaybackCache {  // FrameHashCache 继承自 Playb
    */
   static FramePtr LoadCacheFrame(const QString &fn);
 
+  /**
+   * @brief (静态) 检查缓存帧是否可用 (在内存中、正在写入或已存在于磁盘上)。
+   * @param fn 缓存文件的完整路径。
+   */
+  static bool CacheFrameExists(const QString &fn);
+
   /**
    * @brief (重写 PlaybackCache::SetPassthrough) 设置一个“透传”缓存。
    * 对于帧缓存，这可能意味着如果当前缓存未命中，会尝试从透传缓存中获取数据。
@@ -145,6 +178,26 @@ class FrameHashCache : public PlaybackCache {  // FrameHashCache 继承自 Playb
   void SaveStateEvent(QDataStream &stream) override;
 
  private:
+  /**
+   * @brief (静态) 从磁盘读取并解码缓存帧 (原始格式、EXR 或 JPEG)，不经过内存缓存。
+   */
+  static FramePtr LoadCacheFrameFromDisk(const QString &fn);
+
+  /**
+   * @brief (静态) 以原始格式保存帧 (可选压缩)。
+   */
+  static bool SaveRawCacheFrame(const QString &filename, const FramePtr &frame, bool compress);
+
+  /**
+   * @brief (静态) 读取原始格式的缓存帧。
+   *
+   * 未压缩的帧直接内存映射，不拷贝像素数据 (映射不依赖文件描述符，file 可以立即关闭)。
+   * Windows 上被映射的文件无法被替换，因此在 Windows 上改为读取到内存中。
+   * @param file 已打开的缓存文件。
+   * @return 如果文件已损坏，返回 nullptr。
+   */
+  static FramePtr LoadRawCacheFrame(QFile *file);
+
   /**
    * @brief 将整数时间戳转换为 rational 类型的时间 (基于当前 timebase_)。
    */
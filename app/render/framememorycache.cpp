@@ -0,0 +1,196 @@
+#include "framememorycache.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QtConcurrent/QtConcurrent>
+
+#include "config/config.h"
+#include "render/diskmanager.h"
+#include "render/tracerecorder.h"
+
+namespace olive {
+
+const int FrameMemoryCache::kMaximumPendingWrites = 64;
+
+FrameMemoryCache::FrameMemoryCache() {
+  // EXR compression is CPU bound, two writers keep up with real-time rendering without starving the renderers (raw
+  // frames are I/O bound and don't need more)
+  write_pool_.setMaxThreadCount(2);
+
+  stats_.limit_bytes = OLIVE_CONFIG("FrameMemoryCacheSize").toLongLong() * 1024 * 1024;
+}
+
+FrameMemoryCache *FrameMemoryCache::instance() {
+  static FrameMemoryCache cache;
+  return &cache;
+}
+
+FramePtr FrameMemoryCache::Get(const QUuid &uuid, int64_t timestamp) {
+  Key key = {uuid, timestamp};
+
+  QMutexLocker locker(&mutex_);
+
+  auto it = map_.find(key);
+  if (it != map_.end()) {
+    // Move to front of LRU
+    lru_.splice(lru_.begin(), lru_, it.value());
+    stats_.hits++;
+    return it.value()->frame;
+  }
+
+  // Frames that were evicted before their write finished are still readable
+  FramePtr pending = pending_.value(key);
+  if (pending) {
+    stats_.hits++;
+  } else {
+    stats_.misses++;
+  }
+
+  return pending;
+}
+
+bool FrameMemoryCache::Contains(const QUuid &uuid, int64_t timestamp) {
+  Key key = {uuid, timestamp};
+
+  QMutexLocker locker(&mutex_);
+
+  return map_.contains(key) || pending_.contains(key);
+}
+
+void FrameMemoryCache::Insert(const QString &filename, const QString &cache_path, const QUuid &uuid,
+                              int64_t timestamp, const FramePtr &frame, FrameHashCache::CacheFormat format) {
+  Key key = {uuid, timestamp};
+
+  QMutexLocker locker(&mutex_);
+
+  // Back-pressure: if the disk can't keep up, let the renderer wait rather than queueing unbounded memory
+  while (pending_.size() >= kMaximumPendingWrites) {
+    pending_wait_.wait(&mutex_);
+  }
+
+  InsertIntoLRU(key, frame);
+
+  pending_.insert(key, frame);
+
+  QtConcurrent::run(&write_pool_, [this, filename, cache_path, key, frame, format] {
+    WriteFrame(filename, cache_path, key, frame, format);
+  });
+}
+
+void FrameMemoryCache::Put(const QUuid &uuid, int64_t timestamp, const FramePtr &frame) {
+  QMutexLocker locker(&mutex_);
+
+  InsertIntoLRU({uuid, timestamp}, frame);
+}
+
+void FrameMemoryCache::Remove(const QUuid &uuid, int64_t timestamp) {
+  Key key = {uuid, timestamp};
+
+  QMutexLocker locker(&mutex_);
+
+  auto it = map_.find(key);
+  if (it != map_.end()) {
+    stats_.used_bytes -= it.value()->bytes;
+    lru_.erase(it.value());
+    map_.erase(it);
+  }
+}
+
+void FrameMemoryCache::Clear() {
+  QMutexLocker locker(&mutex_);
+
+  lru_.clear();
+  map_.clear();
+  stats_.used_bytes = 0;
+}
+
+void FrameMemoryCache::WaitForPendingWrites() { write_pool_.waitForDone(); }
+
+void FrameMemoryCache::UpdateLimit() {
+  QMutexLocker locker(&mutex_);
+
+  stats_.limit_bytes = OLIVE_CONFIG("FrameMemoryCacheSize").toLongLong() * 1024 * 1024;
+  Trim();
+}
+
+FrameMemoryCache::Statistics FrameMemoryCache::GetStatistics() {
+  QMutexLocker locker(&mutex_);
+
+  Statistics s = stats_;
+  s.frame_count = map_.size();
+  s.pending_writes = pending_.size();
+  return s;
+}
+
+bool FrameMemoryCache::ParseFilename(const QString &filename, QUuid *uuid, int64_t *timestamp) {
+  QFileInfo info(filename);
+
+  bool ok;
+  *timestamp = info.fileName().toLongLong(&ok);
+  if (!ok) {
+    return false;
+  }
+
+  *uuid = QUuid(info.dir().dirName());
+  return !uuid->isNull();
+}
+
+void FrameMemoryCache::InsertIntoLRU(const Key &key, const FramePtr &frame) {
+  auto it = map_.find(key);
+  if (it != map_.end()) {
+    stats_.used_bytes -= it.value()->bytes;
+    lru_.erase(it.value());
+    map_.erase(it);
+  }
+
+  qint64 bytes = frame->allocated_size();
+
+  // A frame bigger than the whole budget is never kept
+  if (bytes <= stats_.limit_bytes) {
+    lru_.push_front({key, frame, bytes});
+    map_.insert(key, lru_.begin());
+    stats_.used_bytes += bytes;
+    Trim();
+  }
+}
+
+void FrameMemoryCache::Trim() {
+  while (stats_.used_bytes > stats_.limit_bytes && !lru_.empty()) {
+    const Entry &e = lru_.back();
+    stats_.used_bytes -= e.bytes;
+    map_.remove(e.key);
+    lru_.pop_back();
+    stats_.evictions++;
+  }
+}
+
+void FrameMemoryCache::WriteFrame(const QString &filename, const QString &cache_path, const Key &key,
+                                  const FramePtr &frame, FrameHashCache::CacheFormat format) {
+  mutex_.lock();
+  // If the same frame was re-rendered in the meantime, the newer write supersedes this one
+  bool superseded = pending_.value(key) != frame;
+  mutex_.unlock();
+
+  if (!superseded) {
+    TraceScope trace("Cache Write", "cache", filename);
+
+    if (FrameHashCache::SaveCacheFrame(filename, frame, format)) {
+      // Register frame with the disk manager
+      QMetaObject::invokeMethod(DiskManager::instance(), "CreatedFile", Q_ARG(QString, cache_path),
+                                Q_ARG(QString, filename));
+    } else {
+      QMutexLocker locker(&mutex_);
+      stats_.failed_writes++;
+    }
+  }
+
+  QMutexLocker locker(&mutex_);
+
+  if (pending_.value(key) == frame) {
+    pending_.remove(key);
+  }
+
+  pending_wait_.wakeAll();
+}
+
+}  // namespace olive
@@ -0,0 +1,163 @@
+#ifndef FRAMEMEMORYCACHE_H
+#define FRAMEMEMORYCACHE_H
+
+#include <QHash>           // 键到 LRU 节点的映射
+#include <QMutex>          // 保护缓存的互斥锁
+#include <QThreadPool>     // 异步写入磁盘的线程池
+#include <QUuid>           // 缓存 UUID
+#include <QWaitCondition>  // 写入队列的背压
+#include <list>            // LRU 链表
+
+#include "codec/frame.h"            // FramePtr
+#include "render/framehashcache.h"  // FrameHashCache::CacheFormat
+
+namespace olive {
+
+/**
+ * @brief 位于 FrameHashCache 磁盘缓存之前的内存层。
+ *
+ * 以 (缓存 UUID, 时间戳) 为键保存已解码的 Frame，总大小受字节预算 (配置项 "FrameMemoryCacheSize"，MiB) 限制，
+ * 超出时淘汰最久未使用的帧。FrameHashCache::SaveCacheFrame() 会把帧放入此缓存并立即返回，
+ * 实际的编码 (格式见 FrameHashCache::CacheFormat) 和写盘在后台线程中完成 (写穿)。写盘完成前，帧会一直保存在待写入表中，
+ * 因此即使它已被 LRU 淘汰也仍然可以读取。
+ *
+ * 已渲染范围的回放因此完全不需要访问磁盘或 EXR 解码器。
+ *
+ * 此类是线程安全的。
+ */
+class FrameMemoryCache {
+ public:
+  /**
+   * @brief 缓存的统计计数，显示在磁盘缓存对话框中。
+   */
+  struct Statistics {
+    qint64 hits = 0;           // 命中内存 (包括待写入的帧) 的读取次数
+    qint64 misses = 0;         // 需要从磁盘读取的次数
+    qint64 evictions = 0;      // 因超出预算被淘汰的帧数
+    qint64 used_bytes = 0;     // 当前占用的字节数
+    qint64 limit_bytes = 0;    // 字节预算
+    int frame_count = 0;       // 当前缓存的帧数
+    int pending_writes = 0;    // 尚未写入磁盘的帧数
+    qint64 failed_writes = 0;  // 写盘失败的次数
+  };
+
+  /**
+   * @brief 获取全局唯一的缓存实例。
+   */
+  static FrameMemoryCache *instance();
+
+  /**
+   * @brief 查找帧 (包括尚未写入磁盘的帧)，并更新命中/未命中计数。
+   * @return 如果内存中没有此帧，则返回 nullptr。
+   */
+  FramePtr Get(const QUuid &uuid, int64_t timestamp);
+
+  /**
+   * @brief 检查内存中是否有此帧，不影响 LRU 顺序和计数。
+   */
+  bool Contains(const QUuid &uuid, int64_t timestamp);
+
+  /**
+   * @brief 将帧放入缓存，并在后台将其写入磁盘。
+   * @param filename 磁盘缓存中的文件名。
+   * @param cache_path 磁盘缓存目录 (用于在写入成功后向 DiskManager 注册文件)。
+   * @param uuid 缓存 UUID。
+   * @param timestamp 帧的时间戳。
+   * @param frame 要缓存的帧。
+   * @param format 写入磁盘时使用的存储格式。
+   */
+  void Insert(const QString &filename, const QString &cache_path, const QUuid &uuid, int64_t timestamp,
+              const FramePtr &frame, FrameHashCache::CacheFormat format);
+
+  /**
+   * @brief 将从磁盘读取的帧放入缓存 (不会写回磁盘)。
+   */
+  void Put(const QUuid &uuid, int64_t timestamp, const FramePtr &frame);
+
+  /**
+   * @brief 从内存中移除一帧 (磁盘上的文件已被删除时使用)。
+   */
+  void Remove(const QUuid &uuid, int64_t timestamp);
+
+  /**
+   * @brief 清空内存中的所有帧 (不影响待写入的帧)。
+   */
+  void Clear();
+
+  /**
+   * @brief 阻塞直到所有待写入的帧都已写入磁盘。应在程序退出前调用。
+   */
+  void WaitForPendingWrites();
+
+  /**
+   * @brief 从配置中重新读取字节预算，必要时淘汰帧。
+   */
+  void UpdateLimit();
+
+  /**
+   * @brief 获取当前的统计计数。
+   */
+  Statistics GetStatistics();
+
+  /**
+   * @brief 从磁盘缓存文件名 (<缓存目录>/<UUID>/<时间戳>) 中解析出键。
+   * @return 如果文件名不是缓存帧，则返回 false。
+   */
+  static bool ParseFilename(const QString &filename, QUuid *uuid, int64_t *timestamp);
+
+ private:
+  FrameMemoryCache();
+
+  struct Key {
+    QUuid uuid;
+    int64_t timestamp;
+
+    bool operator==(const Key &rhs) const { return uuid == rhs.uuid && timestamp == rhs.timestamp; }
+
+    friend uint qHash(const Key &key, uint seed = 0) { return ::qHash(key.uuid, seed) ^ ::qHash(key.timestamp, seed); }
+  };
+
+  struct Entry {
+    Key key;
+    FramePtr frame;
+    qint64 bytes;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  /**
+   * @brief 将帧放到 LRU 的最前面并按预算淘汰。调用时必须持有 mutex_。
+   */
+  void InsertIntoLRU(const Key &key, const FramePtr &frame);
+
+  /**
+   * @brief 淘汰最久未使用的帧直到总大小不超过预算。调用时必须持有 mutex_。
+   */
+  void Trim();
+
+  /**
+   * @brief 在后台线程中将帧写入磁盘。
+   */
+  void WriteFrame(const QString &filename, const QString &cache_path, const Key &key, const FramePtr &frame,
+                  FrameHashCache::CacheFormat format);
+
+  QMutex mutex_;  // 保护以下所有成员
+
+  EntryList lru_;  // 最近使用的帧在前
+
+  QHash<Key, EntryList::iterator> map_;  // 键到 LRU 节点的映射
+
+  QHash<Key, FramePtr> pending_;  // 已放入缓存但尚未写入磁盘的帧
+
+  QWaitCondition pending_wait_;  // 待写入的帧减少时唤醒
+
+  static const int kMaximumPendingWrites;  // 待写入的帧超过此数量时 Insert() 会阻塞，防止内存无限增长
+
+  Statistics stats_;  // 统计计数 (frame_count/pending_writes 在 GetStatistics 中填充)
+
+  QThreadPool write_pool_;  // 写穿使用的线程池
+};
+
+}  // namespace olive
+
+#endif  // FRAMEMEMORYCACHE_H
@@ -1,6 +1,9 @@
 #ifndef SAMPLEJOB_H  // 防止头文件被重复包含的宏
 #define SAMPLEJOB_H  // 定义 SAMPLEJOB_H 宏
 
+#include <QHash>   // 参数块中按输入ID存储的哈希表
+#include <vector>  // 逐采样参数数组
+
 #include "acceleratedjob.h"  // 包含 AcceleratedJob 基类的定义
                              // 也可能间接包含 NodeValue, SampleBuffer, TimeRange (通过 AcceleratedJob 或其他常用头文件)
 // 为了明确，SampleJob 使用 SampleBuffer 和 TimeRange，这些通常定义在与 value.h 或 render/texture.h 相关的地方。
@@ -73,6 +76,70 @@ class SampleJob : public AcceleratedJob {  // SampleJob 继承自 AcceleratedJob
   TimeRange time_;  // 音频样本对应的时间范围
 };
 
+/**
+ * @brief 一个音频块中每个数值参数的逐采样值。
+ *
+ * RenderProcessor 对每个音频块只计算一次 SampleJob 的参数 (关键帧在整个块上批量采样)，
+ * 然后将结果以浮点数组的形式交给 Node::ProcessSamples() 的块版本，
+ * 而不是为每个采样重新遍历节点图。
+ */
+class SampleParameterBlock {
+ public:
+  explicit SampleParameterBlock(size_t sample_count = 0) : sample_count_(sample_count) {}
+
+  /**
+   * @brief 获取块中的采样数 (每个参数数组的长度)。
+   */
+  [[nodiscard]] size_t sample_count() const { return sample_count_; }
+
+  /**
+   * @brief 为指定输入分配一个逐采样数组并返回其指针，调用者负责填充。
+   * @param input 输入端口ID。
+   * @param type 输入的原始数据类型 (用于回退到逐采样接口时还原 NodeValue)。
+   */
+  float *Insert(const QString &input, NodeValue::Type type) {
+    Parameter &p = values_[input];
+    p.type = type;
+    p.values.resize(sample_count_);
+    return p.values.data();
+  }
+
+  /**
+   * @brief 获取指定输入的逐采样数组。
+   * @return 如果块中没有此输入，则返回 nullptr。
+   */
+  [[nodiscard]] const float *Get(const QString &input) const {
+    auto it = values_.constFind(input);
+    return (it == values_.cend()) ? nullptr : it->values.data();
+  }
+
+  /**
+   * @brief 将第 index 个采样处的所有参数还原为 NodeValueRow (用于逐采样的回退路径)。
+   */
+  [[nodiscard]] NodeValueRow GetRowAt(size_t index) const {
+    NodeValueRow row;
+    for (auto it = values_.cbegin(); it != values_.cend(); it++) {
+      double v = it->values[index];
+      if (it->type == NodeValue::kRational) {
+        row.insert(it.key(), NodeValue(it->type, rational::fromDouble(v)));
+      } else {
+        row.insert(it.key(), NodeValue(it->type, v));
+      }
+    }
+    return row;
+  }
+
+ private:
+  struct Parameter {
+    NodeValue::Type type = NodeValue::kFloat;  // 原始数据类型
+    std::vector<float> values;                 // 每个采样的值
+  };
+
+  size_t sample_count_;  // 每个参数数组的长度
+
+  QHash<QString, Parameter> values_;  // 以输入ID为键的参数
+};
+
 }  // namespace olive
 
 // 声明 SampleJob 类型为元类型，以便在 QVariant 中使用或在信号槽中传递
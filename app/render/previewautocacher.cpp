@@ -307,6 +307,13 @@ void PreviewAutoCacher::StartCachingAudioRange(ViewerOutput *context, PlaybackCa
 
   cache->ClearRequestRange(range);
 
+  // Footage waveforms saved by an earlier session only need to be read back in
+  if (auto *wave = dynamic_cast<AudioWaveformCache *>(cache)) {
+    if (wave->LoadPeaks(context, range, context->GetAudioParams())) {
+      return;
+    }
+  }
+
   pending_audio_jobs_.push_back({node, context, cache, range});
   audio_cache_data_[cache].job_tracker.insert(range, copier_->GetGraphChangeTime());
   TryRender();
@@ -433,8 +440,9 @@ void PreviewAutoCacher::TryRender() {
   }
 
   if (!pause_renders_) {
-    // Completely arbitrary number. I don't know what's optimal for this yet.
-    const int max_tasks = 4;
+    // Keep every video render thread busy, with one frame queued behind the one being rendered so
+    // threads that finish early have something to steal
+    const int max_tasks = std::max(4, RenderManager::instance()->GetMaximumFramesInFlight());
 
     // Handle video tasks
     if (!pause_thumbnails_) {
@@ -566,13 +574,16 @@ void PreviewAutoCacher::ConformFinished() {
   // Got an audio conform, requeue all the audio currently needing a conform
   last_conform_task_.Acquire();
 
-  qDebug() << "CONFORM RESPONSE TEMPORARILY DISABLED";
-  /*for (auto it=audio_cache_data_.begin(); it!=audio_cache_data_.end(); it++) {
-    foreach (const TimeRange &range, it.value().needs_conform) {
-      it.key()->Request(range);
-    }
+  // This is also signalled while a conform is still being written, ranges that still aren't covered will simply end
+  // up back in needs_conform
+  for (auto it = audio_cache_data_.begin(); it != audio_cache_data_.end(); it++) {
+    TimeRangeList needs_conform = it.value().needs_conform;
     it.value().needs_conform.clear();
-  }*/
+
+    foreach (const TimeRange &range, needs_conform) {
+      it.key()->Invalidate(range);
+    }
+  }
 }
 
 void PreviewAutoCacher::CacheProxyTaskCancelled() {
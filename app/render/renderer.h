@@ -97,8 +97,10 @@ class Renderer : public QObject {  // Renderer 继承自 QObject
    * @param color_job 描述颜色转换和输入源的 ColorTransformJob。
    * @param destination 指向目标 olive::Texture 对象的指针。
    * @param params 目标纹理的视频参数。
+   *
+   * 默认实现会编译 OCIO 的 GLSL 着色器并调用 Blit()；不支持着色器的后端 (例如软件渲染器) 可以重写此函数。
    */
-  void BlitColorManaged(const ColorTransformJob &color_job, Texture *destination, const VideoParams &params);
+  virtual void BlitColorManaged(const ColorTransformJob &color_job, Texture *destination, const VideoParams &params);
   /**
    * @brief 便捷重载，目标参数从 `destination` 纹理获取。
    */
@@ -4,9 +4,11 @@
 #include <QMatrix4x4>
 #include <QThread>
 
+#include "codec/conformmapcache.h"
 #include "config/config.h"
 #include "core.h"
 #include "render/opengl/openglrenderer.h"
+#include "render/software/softwarerenderer.h"
 #include "renderprocessor.h"
 #include "task/conform/conform.h"
 #include "task/taskmanager.h"
@@ -17,19 +19,34 @@ namespace olive {
 RenderManager *RenderManager::instance_ = nullptr;
 const rational RenderManager::kDryRunInterval = rational(10);
 
-RenderManager::RenderManager(QObject *parent) : backend_(kOpenGL), aggressive_gc_(0) {
-  if (backend_ == kOpenGL) {
-    context_ = new OpenGLRenderer();
-    decoder_cache_ = new DecoderCache();
-    shader_cache_ = new ShaderCache();
+RenderManager::RenderManager(Backend backend, bool verify, QObject *parent) : backend_(backend), aggressive_gc_(0) {
+  if (backend_ == kOpenGL || backend_ == kSoftware) {
+    decoder_pool_ = new DecoderPool();
+
+    int video_thread_count = OLIVE_CONFIG("RenderThreadCount").toInt();
+    if (video_thread_count <= 0) {
+      video_thread_count = std::clamp(QThread::idealThreadCount() / 2, 1, kMaximumDefaultVideoThreads);
+    }
+
+    // Each video thread gets its own renderer, since contexts can only be current on one thread
+    for (int i = 0; i < video_thread_count; i++) {
+      contexts_.push_back(CreateRenderer(verify));
+      shader_caches_.push_back(new ShaderCache());
+      static_value_caches_.push_back(new StaticValueCache());
+    }
   } else {
     qCritical() << "Tried to initialize unknown graphics backend";
-    context_ = nullptr;
-    decoder_cache_ = nullptr;
+    decoder_pool_ = nullptr;
   }
 
-  if (context_) {
-    video_thread_ = CreateThread(context_);
+  if (!contexts_.empty()) {
+    for (size_t i = 0; i < contexts_.size(); i++) {
+      video_threads_.push_back(CreateThread(contexts_[i], shader_caches_[i], static_value_caches_[i]));
+    }
+    for (RenderThread *t : video_threads_) {
+      t->SetPeers(video_threads_);
+    }
+
     dry_run_thread_ = CreateThread();
     audio_thread_ = CreateThread();
 
@@ -48,22 +65,46 @@ RenderManager::RenderManager(QObject *parent) : backend_(kOpenGL), aggressive_gc
 }
 
 RenderManager::~RenderManager() {
-  if (context_) {
-    delete shader_cache_;
-    delete decoder_cache_;
-
+  if (!contexts_.empty()) {
     for (RenderThread *rt : render_threads_) {
       rt->quit();
       rt->wait();
     }
 
-    context_->PostDestroy();
-    delete context_;
+    // Only once no thread can be holding a lease
+    delete decoder_pool_;
+
+    for (Renderer *ctx : contexts_) {
+      ctx->PostDestroy();
+      delete ctx;
+    }
+
+    qDeleteAll(shader_caches_);
+    qDeleteAll(static_value_caches_);
+  }
+}
+
+Renderer *RenderManager::CreateRenderer(bool verify) const {
+  switch (backend_) {
+    case kOpenGL:
+      return new OpenGLRenderer();
+    case kSoftware: {
+      auto software = new SoftwareRenderer();
+      if (verify) {
+        software->SetVerifyRenderer(new OpenGLRenderer());
+      }
+      return software;
+    }
+    case kDummy:
+      break;
   }
+
+  return nullptr;
 }
 
-RenderThread *RenderManager::CreateThread(Renderer *renderer) {
-  auto t = new RenderThread(renderer, decoder_cache_, shader_cache_, this);
+RenderThread *RenderManager::CreateThread(Renderer *renderer, ShaderCache *shader_cache,
+                                          StaticValueCache *static_cache) {
+  auto t = new RenderThread(renderer, decoder_pool_, shader_cache, static_cache, this);
   render_threads_.push_back(t);
   t->start(QThread::IdlePriority);
   return t;
@@ -91,12 +132,16 @@ RenderTicketPtr RenderManager::RenderFrame(const RenderVideoParams &params) {
   ticket->setProperty("cache", params.cache_dir);
   ticket->setProperty("cachetimebase", QVariant::fromValue(params.cache_timebase));
   ticket->setProperty("cacheid", QVariant::fromValue(params.cache_id));
+  ticket->setProperty("cacheformat", params.cache_format);
   ticket->setProperty("multicam", QtUtils::PtrToValue(params.multicam));
 
   if (params.return_type == ReturnType::kNull) {
     dry_run_thread_->AddTicket(ticket);
   } else {
-    video_thread_->AddTicket(ticket);
+    // Idle threads will steal from this one if it falls behind, so simple round-robin is enough here
+    RenderThread *thread = video_threads_[last_video_thread_ % video_threads_.size()];
+    thread->AddTicket(ticket);
+    last_video_thread_++;
   }
 
   return ticket;
@@ -147,28 +192,24 @@ void RenderManager::SetAggressiveGarbageCollection(bool enabled) {
 }
 
 void RenderManager::ClearOldDecoders() {
-  QMutexLocker locker(decoder_cache_->mutex());
-
   qint64 min_age = QDateTime::currentMSecsSinceEpoch() - kDecoderMaximumInactivity;
 
-  for (auto it = decoder_cache_->begin(); it != decoder_cache_->end();) {
-    DecoderPair decoder = it.value();
+  decoder_pool_->ClearOld(min_age);
 
-    if (decoder.decoder->GetLastAccessedTime() < min_age) {
-      decoder.decoder->Close();
-      it = decoder_cache_->erase(it);
-    } else {
-      it++;
-    }
-  }
+  // Unmap conform audio nobody has read from recently
+  ConformMapCache::instance()->ClearUnused(min_age);
 }
 
-RenderThread::RenderThread(Renderer *renderer, DecoderCache *decoder_cache, ShaderCache *shader_cache, QObject *parent)
+RenderThread::RenderThread(Renderer *renderer, DecoderPool *decoder_pool, ShaderCache *shader_cache,
+                           StaticValueCache *static_cache, QObject *parent)
     : QThread(parent),
       cancelled_(false),
+      idle_(false),
+      next_victim_(0),
       context_(renderer),
-      decoder_cache_(decoder_cache),
-      shader_cache_(shader_cache) {
+      decoder_pool_(decoder_pool),
+      shader_cache_(shader_cache),
+      static_cache_(static_cache) {
   if (context_) {
     context_->Init();
     context_->moveToThread(this);
@@ -176,10 +217,18 @@ RenderThread::RenderThread(Renderer *renderer, DecoderCache *decoder_cache, Shad
 }
 
 void RenderThread::AddTicket(const RenderTicketPtr &ticket) {
-  QMutexLocker locker(&mutex_);
-  ticket->moveToThread(this);
-  queue_.push_back(ticket);
-  wait_.wakeOne();
+  {
+    QMutexLocker locker(&mutex_);
+    ticket->moveToThread(this);
+    queue_.push_back(ticket);
+    wait_.wakeOne();
+  }
+
+  // Give idle peers a chance to take this ticket if we're busy. Our own lock must be released
+  // first, since a waking peer will lock it to steal from us.
+  for (RenderThread *peer : peers_) {
+    peer->WakeIfIdle();
+  }
 }
 
 bool RenderThread::RemoveTicket(const RenderTicketPtr &ticket) {
@@ -200,6 +249,58 @@ void RenderThread::quit() {
   wait_.wakeOne();
 }
 
+void RenderThread::SetPeers(const std::vector<RenderThread *> &peers) {
+  peers_.clear();
+  for (RenderThread *p : peers) {
+    if (p != this) {
+      peers_.push_back(p);
+    }
+  }
+}
+
+RenderTicketPtr RenderThread::StealTicket() {
+  QMutexLocker locker(&mutex_);
+
+  if (queue_.empty()) {
+    return nullptr;
+  }
+
+  // Take from the back, the owner keeps working from the front
+  RenderTicketPtr ticket = queue_.back();
+  queue_.pop_back();
+  return ticket;
+}
+
+void RenderThread::WakeIfIdle() {
+  QMutexLocker locker(&mutex_);
+  if (idle_) {
+    wait_.wakeOne();
+  }
+}
+
+RenderTicketPtr RenderThread::StealFromPeers() {
+  for (size_t i = 0; i < peers_.size(); i++) {
+    RenderThread *victim = peers_[(next_victim_ + i) % peers_.size()];
+    if (RenderTicketPtr ticket = victim->StealTicket()) {
+      next_victim_ = (next_victim_ + i + 1) % peers_.size();
+      return ticket;
+    }
+  }
+
+  return nullptr;
+}
+
+void RenderThread::ProcessTicket(const RenderTicketPtr &ticket) {
+  // Setup the ticket for ::Process
+  ticket->Start();
+
+  if (ticket->IsCancelled()) {
+    ticket->Finish();
+  } else {
+    RenderProcessor::Process(ticket, context_, decoder_pool_, shader_cache_, static_cache_);
+  }
+}
+
 void RenderThread::run() {
   if (context_) {
     context_->PostInit();
@@ -208,8 +309,25 @@ void RenderThread::run() {
   QMutexLocker locker(&mutex_);
 
   while (!cancelled_) {
-    if (queue_.empty()) {
+    if (queue_.empty() && !peers_.empty()) {
+      // Nothing of our own to do, see if a peer has fallen behind. A stolen ticket keeps its
+      // thread affinity, which is fine since tickets only emit signals from here.
+      locker.unlock();
+      RenderTicketPtr stolen = StealFromPeers();
+      if (stolen) {
+        ProcessTicket(stolen);
+      }
+      locker.relock();
+
+      if (stolen) {
+        continue;
+      }
+    }
+
+    if (queue_.empty() && !cancelled_) {
+      idle_ = true;
       wait_.wait(&mutex_);
+      idle_ = false;
     }
 
     if (cancelled_) {
@@ -222,14 +340,7 @@ void RenderThread::run() {
 
       locker.unlock();
 
-      // Setup the ticket for ::Process
-      ticket->Start();
-
-      if (ticket->IsCancelled()) {
-        ticket->Finish();
-      } else {
-        RenderProcessor::Process(ticket, context_, decoder_cache_, shader_cache_);
-      }
+      ProcessTicket(ticket);
 
       locker.relock();
     }
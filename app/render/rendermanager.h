@@ -9,10 +9,12 @@
 #include "node/output/viewer/viewer.h"         // ViewerOutput 接口或基类定义
 #include "node/project.h"                      // Project 类定义
 #include "node/traverser.h"                    // NodeTraverser (节点遍历器) 定义
+#include "render/decoderpool.h"                // DecoderPool (共享解码器池) 定义
 #include "render/previewautocacher.h"          // PreviewAutoCacher (预览自动缓存器) 定义
 #include "render/renderer.h"                   // Renderer (渲染器抽象基类) 定义
 #include "render/renderticket.h"               // RenderTicket (渲染票据) 定义
-#include "rendercache.h"                       // 包含 DecoderCache 和 ShaderCache 的定义
+#include "render/staticvaluecache.h"           // StaticValueCache (不随时间变化的子图结果缓存) 定义
+#include "rendercache.h"                       // 包含 ShaderCache 的定义
 
 // 假设 QThread, QMutex, QWaitCondition, QTimer, std::list, std::vector,
 // VideoParams, AudioParams, rational, TimeRange, PixelFormat, ColorManager,
@@ -39,12 +41,13 @@ class RenderThread : public QThread {  // RenderThread 继承自 QThread
      /**
       * @brief 构造函数。
       * @param renderer 此线程将使用的 Renderer 实例。
-      * @param decoder_cache 指向共享的解码器缓存的指针。
+      * @param decoder_pool 指向共享的解码器池的指针。
       * @param shader_cache 指向共享的着色器缓存的指针。
+      * @param static_cache 此线程的不随时间变化的子图结果缓存，可以为空。
       * @param parent 父对象指针，默认为 nullptr。
       */
-     RenderThread(Renderer *renderer, DecoderCache *decoder_cache, ShaderCache *shader_cache,
-                  QObject *parent = nullptr);
+     RenderThread(Renderer *renderer, DecoderPool *decoder_pool, ShaderCache *shader_cache,
+                  StaticValueCache *static_cache, QObject *parent = nullptr);
 
   /**
    * @brief 向此线程的任务队列中添加一个新的渲染票据。
@@ -65,6 +68,26 @@ class RenderThread : public QThread {  // RenderThread 继承自 QThread
    */
   void quit();  // Qt 4 风格的退出方法名，通常 QThread::quit() 是一个槽
 
+  /**
+   * @brief 设置同一线程池中的其他线程。
+   *
+   * 设置后，当此线程的队列为空时，会从同伴线程的队列尾部“窃取”尚未开始的票据来执行，
+   * 这样落后的线程会把工作分给空闲线程。必须在线程池中的所有线程开始接收票据之前调用。
+   * @param peers 线程池中的所有线程 (可以包含此线程自身，会被忽略)。
+   */
+  void SetPeers(const std::vector<RenderThread *> &peers);
+
+  /**
+   * @brief 从此线程的队列尾部取走一个尚未开始的票据 (供同伴线程窃取)。
+   * @return 返回被取走的票据；如果队列为空，则返回 nullptr。
+   */
+  RenderTicketPtr StealTicket();
+
+  /**
+   * @brief 如果此线程正处于空闲等待状态，则唤醒它以便尝试窃取工作。
+   */
+  void WakeIfIdle();
+
  protected:
   /**
    * @brief (重写 QThread::run) 线程的主执行函数。
@@ -73,6 +96,17 @@ class RenderThread : public QThread {  // RenderThread 继承自 QThread
   void run() override;
 
  private:
+  /**
+   * @brief 依次尝试从同伴线程窃取一个票据。
+   * @return 返回窃取到的票据；如果所有同伴都没有排队的工作，则返回 nullptr。
+   */
+  RenderTicketPtr StealFromPeers();
+
+  /**
+   * @brief 执行单个票据。
+   */
+  void ProcessTicket(const RenderTicketPtr &ticket);
+
   QMutex mutex_;  // 互斥锁，用于保护对任务队列 `queue_` 和 `cancelled_` 标志的并发访问
 
   QWaitCondition wait_;  // 等待条件变量，用于在队列为空时使线程休眠，并在新任务到达时唤醒
@@ -81,10 +115,18 @@ class RenderThread : public QThread {  // RenderThread 继承自 QThread
 
   bool cancelled_;  // 标记线程是否已被请求取消/退出
 
+  bool idle_;  // 标记线程是否正在等待新任务 (受 mutex_ 保护)
+
+  std::vector<RenderThread *> peers_;  // 同一线程池中可以互相窃取工作的其他线程
+
+  size_t next_victim_;  // 下一次窃取时首先尝试的同伴索引 (仅在本线程中访问)
+
   Renderer *context_;  // 此线程使用的 Renderer 实例 (例如 OpenGLRenderer)
 
-  DecoderCache *decoder_cache_;  // 指向共享的解码器缓存
-  ShaderCache *shader_cache_;    // 指向共享的着色器缓存
+  DecoderPool *decoder_pool_;  // 指向共享的解码器池
+  ShaderCache *shader_cache_;  // 指向共享的着色器缓存
+
+  StaticValueCache *static_cache_;  // 此线程的不随时间变化的子图结果缓存 (仅在本线程中访问)
 };
 
 /**
@@ -94,7 +136,7 @@ class RenderThread : public QThread {  // RenderThread 继承自 QThread
  * - 创建和管理渲染后端 (如 OpenGLRenderer)。
  * - 创建和管理渲染线程 (RenderThread 池)。
  * - 接收渲染请求 (RenderFrame, RenderAudio)，将其包装成 RenderTicket，并分发给渲染线程。
- * - 管理共享资源，如解码器缓存 (DecoderCache) 和着色器缓存 (ShaderCache)。
+ * - 管理共享资源，如解码器池 (DecoderPool) 和着色器缓存 (ShaderCache)。
  * - 与 PreviewAutoCacher 协作，处理自动缓存请求。
  * - 提供接口来控制渲染行为，如设置渲染后端、暂停渲染、垃圾回收策略等。
  */
@@ -104,12 +146,19 @@ class RenderManager : public QObject {  // RenderManager 继承自 QObject
      public :
      // 定义可用的渲染后端枚举
      enum Backend {
-       kOpenGL,  // 使用 OpenGL 提供图形加速
-       kDummy    // 无图形渲染 - 用于测试核心线程逻辑
+       kOpenGL,    // 使用 OpenGL 提供图形加速
+       kSoftware,  // 纯 CPU 渲染 - 用于没有 GPU 的无界面导出
+       kDummy      // 无图形渲染 - 用于测试核心线程逻辑
      };
 
-  // (静态) 创建 RenderManager 的单例实例
-  static void CreateInstance() { instance_ = new RenderManager(); }
+  /**
+   * @brief (静态) 创建 RenderManager 的单例实例。
+   * @param backend 使用的渲染后端。
+   * @param verify 仅对 kSoftware 有效，为 true 时会同时在 OpenGL 上渲染并逐像素比较结果。
+   */
+  static void CreateInstance(Backend backend = kOpenGL, bool verify = false) {
+    instance_ = new RenderManager(backend, verify);
+  }
 
   // (静态) 销毁 RenderManager 的单例实例
   static void DestroyInstance() {
@@ -153,6 +202,7 @@ class RenderManager : public QObject {  // RenderManager 继承自 QObject
       force_channel_count = 0;                           // 默认不强制通道数
       mode = m;                                          // 设置渲染模式
       multicam = nullptr;                                // 默认无多机位节点
+      cache_format = FrameHashCache::kCacheFormatEXR;    // 默认使用 EXR 缓存帧
     }
 
     /**
@@ -163,6 +213,7 @@ class RenderManager : public QObject {  // RenderManager 继承自 QObject
       cache_dir = cache->GetCacheDirectory();  // 获取缓存目录
       cache_timebase = cache->GetTimebase();   // 获取缓存的时间基准
       cache_id = cache->GetUuid().toString();  // 获取缓存的UUID
+      cache_format = cache->GetCacheFormat();  // 获取项目设置的缓存帧格式
     }
 
     Node *node;                   // 要渲染的源节点
@@ -176,9 +227,10 @@ class RenderManager : public QObject {  // RenderManager 继承自 QObject
     MultiCamNode *multicam;       // (可选) 相关的多机位节点
 
     // 缓存相关信息
-    QString cache_dir;        // 缓存目录
-    rational cache_timebase;  // 缓存的时间基准
-    QString cache_id;         // 缓存的UUID
+    QString cache_dir;                         // 缓存目录
+    rational cache_timebase;                   // 缓存的时间基准
+    QString cache_id;                          // 缓存的UUID
+    FrameHashCache::CacheFormat cache_format;  // 缓存帧的磁盘格式
 
     // 强制覆盖参数 (用于特定情况，例如缩略图生成)
     QSize force_size;                      // 强制输出尺寸
@@ -255,6 +307,18 @@ class RenderManager : public QObject {  // RenderManager 继承自 QObject
    */
   [[nodiscard]] Backend backend() const { return backend_; }
 
+  /**
+   * @brief 获取视频渲染线程池中的线程数量。
+   */
+  [[nodiscard]] int GetVideoThreadCount() const { return static_cast<int>(video_threads_.size()); }
+
+  /**
+   * @brief 获取为了让所有视频渲染线程保持忙碌，调用者应同时保持的帧数。
+   *
+   * 每个线程在处理一帧的同时队列中还有一帧等待，这样线程之间可以互相窃取工作。
+   */
+  [[nodiscard]] int GetMaximumFramesInFlight() const { return GetVideoThreadCount() * 2; }
+
   /**
    * @brief 获取预览自动缓存器 (PreviewAutoCacher) 实例。
    * @return 返回 PreviewAutoCacher 指针。
@@ -281,7 +345,7 @@ class RenderManager : public QObject {  // RenderManager 继承自 QObject
 
  private:
   // 私有构造函数 (用于单例模式)
-  explicit RenderManager(QObject *parent = nullptr);
+  explicit RenderManager(Backend backend, bool verify, QObject *parent = nullptr);
 
   // 私有析构函数 (用于单例模式)
   ~RenderManager() override;
@@ -289,18 +353,34 @@ class RenderManager : public QObject {  // RenderManager 继承自 QObject
   /**
    * @brief 创建一个新的渲染线程。
    * @param renderer (可选) 如果提供，则新线程使用此渲染器；否则可能使用默认渲染器。
+   * @param shader_cache (可选) 此渲染器使用的着色器缓存。
+   * @param static_cache (可选) 此渲染器使用的不随时间变化的子图结果缓存。
    * @return 返回创建的 RenderThread 指针。
    */
-  RenderThread *CreateThread(Renderer *renderer = nullptr);
+  RenderThread *CreateThread(Renderer *renderer = nullptr, ShaderCache *shader_cache = nullptr,
+                             StaticValueCache *static_cache = nullptr);
+
+  /**
+   * @brief 为当前后端创建一个新的渲染器实例。
+   * @param verify 仅对 kSoftware 有效，是否附加 OpenGL 参考渲染器。
+   * @return 返回新的 Renderer；如果后端未知，则返回 nullptr。
+   */
+  Renderer *CreateRenderer(bool verify) const;
 
   static RenderManager *instance_;  // RenderManager 的静态单例实例指针
 
-  Renderer *context_;  // 指向当前渲染后端 (如 OpenGLRenderer) 的实例指针
+  std::vector<Renderer *> contexts_;  // 每个视频渲染线程各自使用的渲染后端实例 (如 OpenGLRenderer)
 
   Backend backend_;  // 当前使用的渲染后端类型
 
-  DecoderCache *decoder_cache_;  // 指向共享的解码器缓存
-  ShaderCache *shader_cache_;    // 指向共享的着色器缓存
+  DecoderPool *decoder_pool_;  // 指向共享的解码器池
+
+  // 每个渲染器各自的着色器缓存。OpenGL 的共享上下文虽然共享着色器程序，但 uniform 属于程序对象，
+  // 多个线程同时使用同一个程序会互相覆盖
+  std::vector<ShaderCache *> shader_caches_;
+
+  // 每个渲染器各自的不随时间变化的子图结果缓存，其中的纹理属于对应的渲染器
+  std::vector<StaticValueCache *> static_value_caches_;
 
   // 解码器最大不活动时间的阈值 (毫秒)，用于垃圾回收
   static constexpr auto kDecoderMaximumInactivityAggressive = 1000;  // 激进模式
@@ -311,7 +391,11 @@ class RenderManager : public QObject {  // RenderManager 继承自 QObject
   QTimer *decoder_clear_timer_;  // 用于定期清理旧解码器的定时器
 
   // 不同类型的渲染任务可能使用不同的渲染线程池
-  RenderThread *video_thread_;    // 用于常规视频帧渲染的线程
+  std::vector<RenderThread *> video_threads_;  // 用于常规视频帧渲染的线程池 (线程之间互相窃取工作)
+  size_t last_video_thread_{};                 // 上次分配视频任务的线程索引 (用于轮询)
+
+  // 自动选择线程数时视频渲染线程的最大数量 (可通过 "RenderThreadCount" 配置覆盖)
+  static constexpr int kMaximumDefaultVideoThreads = 4;
   RenderThread *dry_run_thread_;  // 用于干运行 (dry run) 任务的线程
   RenderThread *audio_thread_;    // 用于音频渲染的线程
 
@@ -1,36 +1,94 @@
 #include "renderprocessor.h"
 
 #include <QOpenGLContext>
+#include <QSet>
 #include <QVector2D>
 #include <QVector3D>
 #include <QVector4D>
+#include <QtConcurrent/QtConcurrent>
 #include <utility>
 
 #include "audio/audioprocessor.h"
 #include "node/block/clip/clip.h"
 #include "node/block/transition/transition.h"
 #include "node/project.h"
+#include "node/project/footage/footage.h"
 #include "rendermanager.h"
+#include "tracerecorder.h"
 
 namespace olive {
 
 #define super NodeTraverser
 
-RenderProcessor::RenderProcessor(RenderTicketPtr ticket, Renderer *render_ctx, DecoderCache *decoder_cache,
-                                 ShaderCache *shader_cache)
-    : ticket_(std::move(ticket)), render_ctx_(render_ctx), decoder_cache_(decoder_cache), shader_cache_(shader_cache) {}
+namespace {
+
+struct PendingFootage {
+  const FootageJob *job;
+  rational time;
+};
+
+// Walks a job tree the same way NodeTraverser::ResolveJobs() will, collecting the video footage it's going to decode
+void CollectVideoFootage(const NodeValue &val, QSet<const Texture *> &visited, QVector<PendingFootage> &footage) {
+  if (val.type() != NodeValue::kTexture) {
+    return;
+  }
+
+  TexturePtr job_tex = val.toTexture();
+  if (!job_tex || !job_tex->job() || visited.contains(job_tex.get())) {
+    return;
+  }
+  visited.insert(job_tex.get());
+
+  const AcceleratedJob *base_job = job_tex->job();
+  for (auto it = base_job->GetValues().cbegin(); it != base_job->GetValues().cend(); it++) {
+    CollectVideoFootage(it.value(), visited, footage);
+  }
+
+  if (const auto *ctj = dynamic_cast<const ColorTransformJob *>(base_job)) {
+    CollectVideoFootage(ctj->GetInputTexture(), visited, footage);
+  } else if (const auto *fj = dynamic_cast<const FootageJob *>(base_job)) {
+    const VideoParams &vp = fj->video_params();
+
+    // Image sequences have their own prefetching in ImageSequenceDecoder
+    if (vp.video_type() != VideoParams::kVideoTypeVideo && vp.video_type() != VideoParams::kVideoTypeStill) {
+      return;
+    }
+
+    rational footage_time = Footage::AdjustTimeByLoopMode(fj->time().in(), fj->loop_mode(), fj->length(),
+                                                          vp.video_type(), vp.frame_rate_as_time_base());
+    if (!footage_time.isNaN()) {
+      footage.append({fj, footage_time});
+    }
+  }
+}
+
+}  // namespace
+
+RenderProcessor::RenderProcessor(RenderTicketPtr ticket, Renderer *render_ctx, DecoderPool *decoder_pool,
+                                 ShaderCache *shader_cache, StaticValueCache *static_cache)
+    : ticket_(std::move(ticket)),
+      render_ctx_(render_ctx),
+      decoder_pool_(decoder_pool),
+      shader_cache_(shader_cache),
+      static_cache_(static_cache) {}
 
 TexturePtr RenderProcessor::GenerateTexture(const rational &time, const rational &frame_length) {
   TimeRange range = TimeRange(time, time + frame_length);
 
   NodeValueTable table;
   if (Node *node = QtUtils::ValueToPtr<Node>(ticket_->property("node"))) {
+    TraceScope trace("Traverse", "render");
     table = GenerateTable(node, range);
   }
 
   NodeValue tex_val = table.Get(NodeValue::kTexture);
 
-  ResolveJobs(tex_val);
+  PrefetchFootage({tex_val});
+
+  {
+    TraceScope trace("Resolve Jobs", "render");
+    ResolveJobs(tex_val);
+  }
 
   return tex_val.toTexture();
 }
@@ -71,6 +129,8 @@ FramePtr RenderProcessor::GenerateFrame(TexturePtr texture, const rational &time
     const VideoParams &tex_params = texture->params();
 
     if (output_color_transform) {
+      TraceScope trace("Output Color Transform", "gpu");
+
       TexturePtr transform_tex = render_ctx_->CreateTexture(tex_params);
       ColorTransformJob job;
 
@@ -87,6 +147,8 @@ FramePtr RenderProcessor::GenerateFrame(TexturePtr texture, const rational &time
         tex_params.effective_height() != frame_params.effective_height() ||
         static_cast<PixelFormat::Format>(tex_params.format()) !=
             static_cast<PixelFormat::Format>(frame_params.format())) {
+      TraceScope trace("Output Blit", "gpu");
+
       TexturePtr blit_tex = render_ctx_->CreateTexture(frame_params);
 
       auto matrix = ticket_->property("matrix").value<QMatrix4x4>();
@@ -102,6 +164,8 @@ FramePtr RenderProcessor::GenerateFrame(TexturePtr texture, const rational &time
       texture = blit_tex;
     }
 
+    TraceScope trace("Download", "gpu");
+
     render_ctx_->Flush();
 
     render_ctx_->DownloadFromTexture(texture->id(), texture->params(), frame->data(), frame->linesize_pixels());
@@ -114,6 +178,8 @@ void RenderProcessor::Run() {
   // Depending on the render ticket type, start a job
   auto type = ticket_->property("type").value<RenderManager::TicketType>();
 
+  TraceTicketScope trace(type == RenderManager::kTypeAudio ? "Audio Ticket" : "Video Ticket");
+
   SetCancelPointer(ticket_->GetCancelAtom());
 
   SetCacheVideoParams(ticket_->property("vparam").value<VideoParams>());
@@ -167,7 +233,9 @@ void RenderProcessor::Run() {
             if (!cache.isEmpty()) {
               auto timebase = ticket_->property("cachetimebase").value<rational>();
               auto uuid = ticket_->property("cacheid").value<QUuid>();
-              bool cache_result = FrameHashCache::SaveCacheFrame(cache, uuid, time, timebase, frame);
+              auto format = FrameHashCache::CacheFormat(ticket_->property("cacheformat").toInt());
+              TraceScope cache_trace("Cache Save", "cache");
+              bool cache_result = FrameHashCache::SaveCacheFrame(cache, uuid, time, timebase, frame, format);
               ticket_->setProperty("cached", cache_result);
             }
           }
@@ -194,12 +262,16 @@ void RenderProcessor::Run() {
 
       NodeValueTable table;
       if (Node *node = QtUtils::ValueToPtr<Node>(ticket_->property("node"))) {
+        TraceScope traverse_trace("Traverse", "render");
         table = GenerateTable(node, time);
       }
 
       NodeValue sample_val = table.Get(NodeValue::kSamples);
 
-      ResolveJobs(sample_val);
+      {
+        TraceScope resolve_trace("Resolve Jobs", "render");
+        ResolveJobs(sample_val);
+      }
 
       SampleBuffer samples = sample_val.toSamples();
       if (samples.is_allocated()) {
@@ -208,6 +280,8 @@ void RenderProcessor::Run() {
         }
 
         if (ticket_->property("enablewaveforms").toBool() && !IsCancelled()) {
+          TraceScope waveform_trace("Waveform", "audio");
+
           AudioVisualWaveform vis;
           vis.set_channel_count(samples.audio_params().channel_count());
           vis.OverwriteSamples(samples, samples.audio_params().sample_rate());
@@ -228,41 +302,16 @@ void RenderProcessor::Run() {
   }
 }
 
-DecoderPtr RenderProcessor::ResolveDecoderFromInput(const QString &decoder_id, const Decoder::CodecStream &stream) {
-  if (!stream.IsValid()) {
-    qWarning() << "Attempted to resolve the decoder of a null stream";
-    return nullptr;
-  }
-
-  QMutexLocker locker(decoder_cache_->mutex());
-
-  DecoderPair decoder = decoder_cache_->value(stream);
-
-  qint64 file_last_modified = QFileInfo(stream.filename()).lastModified().toMSecsSinceEpoch();
-
-  DecoderPtr dec = nullptr;
-
-  if (decoder.decoder && decoder.last_modified == file_last_modified) {
-    dec = decoder.decoder;
-  } else {
-    // No decoder
-    decoder.decoder = dec = Decoder::CreateFromID(decoder_id);
-    decoder.last_modified = file_last_modified;
-    decoder_cache_->insert(stream, decoder);
-    locker.unlock();
-
-    if (!dec->Open(stream)) {
-      qWarning() << "Failed to open decoder for" << stream.filename() << "::" << stream.stream();
-      return nullptr;
-    }
+DecoderPool::Lease RenderProcessor::ResolveDecoderFromInput(const QString &decoder_id,
+                                                            const Decoder::CodecStream &stream, const rational &time) {
+  DecoderPool::Lease lease = decoder_pool_->Acquire(decoder_id, stream, time);
 
-    if (!render_ctx_) {
-      // Assume dry run and increment access time
-      decoder.decoder->IncrementAccessTime(RenderManager::kDryRunInterval.toDouble() * 1000);
-    }
+  if (lease.is_new() && !render_ctx_) {
+    // Assume dry run and increment access time
+    lease.decoder()->IncrementAccessTime(RenderManager::kDryRunInterval.toDouble() * 1000);
   }
 
-  return dec;
+  return lease;
 }
 
 NodeValueDatabase RenderProcessor::GenerateDatabase(const Node *node, const TimeRange &range) {
@@ -271,14 +320,20 @@ NodeValueDatabase RenderProcessor::GenerateDatabase(const Node *node, const Time
   if (const auto *multicam = dynamic_cast<const MultiCamNode *>(node)) {
     if (QtUtils::ValueToPtr<MultiCamNode>(ticket_->property("multicam")) == multicam) {
       int sz = multicam->GetSourceCount();
-      QVector<TexturePtr> multicam_tex(sz);
+      QVector<NodeValue> multicam_val(sz);
       for (int i = 0; i < sz; i++) {
         NodeValueTable t =
             GenerateTable(multicam->GetConnectedRenderOutput(olive::MultiCamNode::kSourcesInput, i), range, multicam);
-        NodeValue val = GenerateRowValueElement(multicam, olive::MultiCamNode::kSourcesInput, i, &t, range);
-        ResolveJobs(val);
+        multicam_val[i] = GenerateRowValueElement(multicam, olive::MultiCamNode::kSourcesInput, i, &t, range);
+      }
 
-        multicam_tex[i] = val.toTexture();
+      // Decode every angle at once rather than one after another
+      PrefetchFootage(multicam_val);
+
+      QVector<TexturePtr> multicam_tex(sz);
+      for (int i = 0; i < sz; i++) {
+        ResolveJobs(multicam_val[i]);
+        multicam_tex[i] = multicam_val[i].toTexture();
       }
       ticket_->setProperty("multicam_output", QVariant::fromValue(multicam_tex));
     }
@@ -287,9 +342,9 @@ NodeValueDatabase RenderProcessor::GenerateDatabase(const Node *node, const Time
   return db;
 }
 
-void RenderProcessor::Process(RenderTicketPtr ticket, Renderer *render_ctx, DecoderCache *decoder_cache,
-                              ShaderCache *shader_cache) {
-  RenderProcessor p(std::move(ticket), render_ctx, decoder_cache, shader_cache);
+void RenderProcessor::Process(RenderTicketPtr ticket, Renderer *render_ctx, DecoderPool *decoder_pool,
+                              ShaderCache *shader_cache, StaticValueCache *static_cache) {
+  RenderProcessor p(std::move(ticket), render_ctx, decoder_pool, shader_cache, static_cache);
   p.Run();
 }
 
@@ -318,16 +373,22 @@ void RenderProcessor::ProcessVideoFootage(TexturePtr destination, const FootageJ
 
   const QString &decoder_id = stream->decoder();
 
+  DecoderPool::Lease lease;
   DecoderPtr decoder = nullptr;
 
   switch (stream_data.video_type()) {
     case VideoParams::kVideoTypeVideo:
     case VideoParams::kVideoTypeStill:
-      decoder = ResolveDecoderFromInput(decoder_id, default_codec_stream);
+      lease = ResolveDecoderFromInput(decoder_id, default_codec_stream, input_time);
+      decoder = lease.decoder();
       break;
     case VideoParams::kVideoTypeImageSequence: {
-      if (render_ctx_) {
-        // Since image sequences involve multiple files, we don't engage the decoder cache
+      if (decoder_id == QStringLiteral("oiio")) {
+        // One sequence-aware decoder per sequence, which caches and prefetches the individual frames
+        lease = ResolveDecoderFromInput(QStringLiteral("imagesequence"), default_codec_stream, input_time);
+        decoder = lease.decoder();
+      } else if (render_ctx_) {
+        // Other decoders can only open one file at a time, so we don't engage the decoder cache
         decoder = Decoder::CreateFromID(decoder_id);
 
         QString frame_filename;
@@ -354,12 +415,26 @@ void RenderProcessor::ProcessVideoFootage(TexturePtr destination, const FootageJ
         TexturePtr unmanaged_texture;
 
         p.renderer = render_ctx_;
-        p.time = (stream_data.video_type() == VideoParams::kVideoTypeVideo) ? input_time : Decoder::kAnyTimecode;
+        p.shader_cache = shader_cache_;
+        if (stream_data.video_type() == VideoParams::kVideoTypeVideo) {
+          p.time = input_time;
+        } else if (stream_data.video_type() == VideoParams::kVideoTypeImageSequence &&
+                   decoder->id() == QStringLiteral("imagesequence")) {
+          // The time keeps the decoder's last texture from being reused for a different frame
+          p.time = input_time;
+          p.frame_number = stream_data.get_time_in_timebase_units(input_time);
+        } else {
+          p.time = Decoder::kAnyTimecode;
+        }
         p.cancelled = GetCancelPointer();
         p.force_range = stream_data.color_range();
+        p.cache_path = stream->cache_path();
         p.src_interlacing = stream_data.interlacing();
 
-        unmanaged_texture = decoder->RetrieveVideo(p);
+        {
+          TraceScope trace("Retrieve Video", "decode", stream->filename());
+          unmanaged_texture = decoder->RetrieveVideo(p);
+        }
 
         if (!IsCancelled() && unmanaged_texture) {
           // We convert to our rendering pixel format, since that will always be float-based which
@@ -381,6 +456,7 @@ void RenderProcessor::ProcessVideoFootage(TexturePtr destination, const FootageJ
             job.SetInputAlphaAssociation(kAlphaUnassociated);
           }
 
+          TraceScope trace("Input Color Transform", "gpu", stream->filename());
           render_ctx_->BlitColorManaged(job, destination.get());
         }
       }
@@ -388,14 +464,71 @@ void RenderProcessor::ProcessVideoFootage(TexturePtr destination, const FootageJ
   }
 }
 
+void RenderProcessor::PrefetchFootage(const QVector<NodeValue> &values) {
+  if (!render_ctx_) {
+    return;
+  }
+
+  QVector<PendingFootage> footage;
+  QSet<const Texture *> visited;
+  for (const NodeValue &v : values) {
+    CollectVideoFootage(v, visited, footage);
+  }
+
+  if (footage.size() < 2) {
+    // Nothing to gain from decoding on another thread
+    return;
+  }
+
+  TraceScope trace("Prefetch Footage", "decode");
+
+  PixelFormat format = GetCacheVideoParams().format();
+  CancelAtom *cancelled = GetCancelPointer();
+
+  // Only the CPU half of decoding happens here, ProcessVideoFootage() still uploads the frames on this thread since
+  // that's the only one the renderer's context can be current on
+  QtConcurrent::blockingMap(footage, [this, format, cancelled](const PendingFootage &f) {
+    if (cancelled && cancelled->IsCancelled()) {
+      return;
+    }
+
+    const VideoParams &vp = f.job->video_params();
+
+    DecoderPool::Lease lease =
+        decoder_pool_->Acquire(f.job->decoder(), Decoder::CodecStream(f.job->filename(), vp.stream_index(), nullptr),
+                               f.time);
+    if (!lease.decoder()) {
+      return;
+    }
+
+    // Must match the parameters ProcessVideoFootage() retrieves with, otherwise the decoder decodes again
+    Decoder::RetrieveVideoParams p;
+    p.divider = vp.divider();
+    p.maximum_format = format;
+    p.time = vp.video_type() == VideoParams::kVideoTypeVideo ? f.time : Decoder::kAnyTimecode;
+    p.cancelled = cancelled;
+    p.force_range = vp.color_range();
+    p.cache_path = f.job->cache_path();
+    p.src_interlacing = vp.interlacing();
+
+    TraceScope decode_trace("Prepare Video", "decode", f.job->filename());
+    lease.decoder()->PrepareVideo(p);
+  });
+}
+
 void RenderProcessor::ProcessAudioFootage(SampleBuffer &destination, const FootageJob *stream,
                                           const TimeRange &input_time) {
-  DecoderPtr decoder = ResolveDecoderFromInput(
-      stream->decoder(), Decoder::CodecStream(stream->filename(), stream->audio_params().stream_index(), nullptr));
+  DecoderPool::Lease lease =
+      ResolveDecoderFromInput(stream->decoder(),
+                              Decoder::CodecStream(stream->filename(), stream->audio_params().stream_index(), nullptr),
+                              input_time.in());
+  const DecoderPtr &decoder = lease.decoder();
 
   if (decoder) {
     const AudioParams &audio_params = GetCacheAudioParams();
 
+    TraceScope trace("Retrieve Audio", "decode", stream->filename());
+
     Decoder::RetrieveAudioStatus status =
         decoder->RetrieveAudio(destination, input_time, audio_params, stream->cache_path(), loop_mode(),
                                static_cast<RenderMode::Mode>(ticket_->property("mode").toInt()));
@@ -411,6 +544,8 @@ void RenderProcessor::ProcessShader(TexturePtr destination, const Node *node, co
     return;
   }
 
+  TraceScope trace("Shader", "gpu", node->id());
+
   QString full_shader_id = QStringLiteral("%1:%2").arg(node->id(), job->GetShaderID());
 
   QMutexLocker locker(shader_cache_->mutex());
@@ -441,9 +576,46 @@ void RenderProcessor::ProcessSamples(SampleBuffer &destination, const Node *node
     return;
   }
 
-  NodeValueRow value_db;
+  TraceScope trace("Samples", "audio", node->id());
 
   const AudioParams &audio_params = GetCacheAudioParams();
+  size_t sample_count = job.samples().sample_count();
+  double sample_length = 1.0 / audio_params.sample_rate();
+
+  // Evaluate every parameter once for the whole block. This works for any input that is an unconnected, non-array
+  // number, which covers all nodes that currently create sample jobs. Keyframes are sampled in a single forward pass.
+  SampleParameterBlock block(sample_count);
+  bool block_ok = true;
+
+  for (auto j = job.GetValues().constBegin(); j != job.GetValues().constEnd(); j++) {
+    const QString &input = j.key();
+
+    if (!node->HasInputWithID(input) || node->IsInputConnectedForRender(input) || node->InputIsArray(input)) {
+      block_ok = false;
+      break;
+    }
+
+    TimeRange adjusted = node->InputTimeAdjustment(input, -1, range, true);
+    double step = sample_length;
+    if (range.length() != 0) {
+      // Follow any speed change the input's time adjustment applies
+      step *= adjusted.length().toDouble() / range.length().toDouble();
+    }
+
+    if (!node->GetNumericValuesAtTimes(input, adjusted.in().toDouble(), step,
+                                       block.Insert(input, node->GetInputDataType(input)), sample_count)) {
+      block_ok = false;
+      break;
+    }
+  }
+
+  if (block_ok) {
+    node->ProcessSamples(block, job.samples(), destination);
+    return;
+  }
+
+  // Fall back to traversing every input at every sample
+  NodeValueRow value_db;
 
   for (size_t i = 0; i < job.samples().sample_count(); i++) {
     // Calculate the exact rational time at this sample
@@ -468,6 +640,8 @@ void RenderProcessor::ProcessColorTransform(TexturePtr destination, const Node *
     return;
   }
 
+  TraceScope trace("Color Transform", "gpu", node->id());
+
   render_ctx_->BlitColorManaged(*job, destination.get());
 }
 
@@ -476,6 +650,8 @@ void RenderProcessor::ProcessFrameGeneration(TexturePtr destination, const Node
     return;
   }
 
+  TraceScope trace("Frame Generation", "render", node->id());
+
   FramePtr frame = Frame::Create();
 
   frame->set_video_params(destination->params());
@@ -487,6 +663,8 @@ void RenderProcessor::ProcessFrameGeneration(TexturePtr destination, const Node
 }
 
 TexturePtr RenderProcessor::ProcessVideoCacheJob(const CacheJob *val) {
+  TraceScope trace("Cache Load", "cache", val->GetFilename());
+
   FramePtr frame = FrameHashCache::LoadCacheFrame(val->GetFilename());
   if (frame) {
     TexturePtr tex = CreateTexture(frame->video_params());
@@ -533,4 +711,13 @@ bool RenderProcessor::UseCache() const {
   return static_cast<RenderMode::Mode>(ticket_->property("mode").toInt()) == RenderMode::kOffline;
 }
 
+StaticValueCache *RenderProcessor::GetStaticValueCache() const {
+  // Cached textures belong to this thread's renderer, so only video renders on a thread with a context may use them
+  if (!render_ctx_ || ticket_->property("type").value<RenderManager::TicketType>() != RenderManager::kTypeVideo) {
+    return nullptr;
+  }
+
+  return static_cache_;
+}
+
 }  // namespace olive
@@ -3,9 +3,11 @@
 
 #include "node/block/clip/clip.h"  // 包含 ClipBlock (片段块) 相关的定义
 #include "node/traverser.h"        // 包含 NodeTraverser 基类的定义
+#include "render/decoderpool.h"    // 包含 DecoderPool (共享解码器池) 的定义
 #include "render/renderer.h"       // 包含 Renderer (渲染器抽象基类) 的定义
-#include "rendercache.h"           // 包含 DecoderCache 和 ShaderCache 的类型别名定义
+#include "rendercache.h"           // 包含 ShaderCache 的类型别名定义
 #include "renderticket.h"          // 包含 RenderTicket (渲染票据) 的定义
+#include "staticvaluecache.h"      // 包含 StaticValueCache (不随时间变化的子图结果缓存) 的定义
 
 // 假设 AudioVisualWaveform, TexturePtr, FootageJob, ShaderJob, SampleJob,
 // ColorTransformJob, GenerateJob, CacheJob, VideoParams, AudioParams,
@@ -25,8 +27,8 @@ namespace olive {  // olive 项目的命名空间
  *
  * 它重写了 NodeTraverser 中的许多 Process* 虚函数，以将抽象的渲染任务
  * (如 ShaderJob, FootageJob) 转换为对 Renderer 的具体调用。
- * RenderProcessor 还负责与解码器缓存 (DecoderCache) 和着色器缓存 (ShaderCache) 交互，
- * 以获取或存储解码器实例和编译好的着色器程序。
+ * RenderProcessor 还负责与解码器池 (DecoderPool) 和着色器缓存 (ShaderCache) 交互，
+ * 以租用解码器实例和获取或存储编译好的着色器程序。
  */
 class RenderProcessor : public NodeTraverser {  // RenderProcessor 继承自 NodeTraverser
  public:
@@ -43,11 +45,12 @@ class RenderProcessor : public NodeTraverser {  // RenderProcessor 继承自 Nod
    * 这是执行渲染任务的入口点。它会创建一个 RenderProcessor 实例并调用其 Run() 方法。
    * @param ticket 指向要处理的 RenderTicket 的共享指针。
    * @param render_ctx 指向 Renderer 实例的指针。
-   * @param decoder_cache 指向共享的解码器缓存的指针。
+   * @param decoder_pool 指向共享的解码器池的指针。
    * @param shader_cache 指向共享的着色器缓存的指针。
+   * @param static_cache 渲染器各自的不随时间变化的子图结果缓存，可以为空。
    */
-  static void Process(RenderTicketPtr ticket, Renderer *render_ctx, DecoderCache *decoder_cache,
-                      ShaderCache *shader_cache);
+  static void Process(RenderTicketPtr ticket, Renderer *render_ctx, DecoderPool *decoder_pool,
+                      ShaderCache *shader_cache, StaticValueCache *static_cache = nullptr);
 
   // 结构体，用于存储已渲染的波形数据及其元数据
   struct RenderedWaveform {
@@ -85,15 +88,19 @@ class RenderProcessor : public NodeTraverser {  // RenderProcessor 继承自 Nod
   // (具体逻辑取决于 ticket_ 中的设置)
   [[nodiscard]] bool UseCache() const override;
 
+  [[nodiscard]] StaticValueCache *GetStaticValueCache() const override;
+
  private:
   /**
    * @brief 私有构造函数。RenderProcessor 实例通常通过静态 Process 方法创建。
    * @param ticket 要处理的渲染票据。
    * @param render_ctx 渲染器上下文。
-   * @param decoder_cache 解码器缓存。
+   * @param decoder_pool 解码器池。
    * @param shader_cache 着色器缓存。
+   * @param static_cache 不随时间变化的子图结果缓存。
    */
-  RenderProcessor(RenderTicketPtr ticket, Renderer *render_ctx, DecoderCache *decoder_cache, ShaderCache *shader_cache);
+  RenderProcessor(RenderTicketPtr ticket, Renderer *render_ctx, DecoderPool *decoder_pool, ShaderCache *shader_cache,
+                  StaticValueCache *static_cache);
 
   /**
    * @brief 根据指定时间和帧长度生成一个纹理 (TexturePtr)。
@@ -121,19 +128,31 @@ class RenderProcessor : public NodeTraverser {  // RenderProcessor 继承自 Nod
   void Run();
 
   /**
-   * @brief 根据解码器ID和媒体流信息从解码器缓存中获取或创建一个解码器实例。
+   * @brief 在解析任务之前，用全局线程池同时解码 values 的任务树中所有的视频素材 (见 Decoder::PrepareVideo())。
+   *
+   * 之后 ResolveJobs() 中的 ProcessVideoFootage() 只需要上传解码好的帧，多轨道或多机位的一帧的延迟
+   * 因此取决于最慢的一个解码，而不是所有解码的总和。只有一个素材时不做任何事。
+   */
+  void PrefetchFootage(const QVector<NodeValue> &values);
+
+  /**
+   * @brief 根据解码器ID和媒体流信息从解码器池中租用一个解码器实例。
    * @param decoder_id 解码器的名称或标识符。
    * @param stream 描述媒体流的 Decoder::CodecStream 对象。
-   * @return 返回指向解码器实例的 DecoderPtr。
+   * @param time 请求的时间，用于选择位置最近的解码器。
+   * @return 返回解码器的租用，在其析构之前解码器不会被交给其他位置较远的请求。
    */
-  DecoderPtr ResolveDecoderFromInput(const QString &decoder_id, const Decoder::CodecStream &stream);
+  DecoderPool::Lease ResolveDecoderFromInput(const QString &decoder_id, const Decoder::CodecStream &stream,
+                                             const rational &time);
 
   RenderTicketPtr ticket_;  // 当前正在处理的渲染票据
 
   Renderer *render_ctx_;  // 指向实际执行渲染操作的 Renderer 实例 (例如 OpenGLRenderer)
 
-  DecoderCache *decoder_cache_;  // 指向共享的解码器缓存
-  ShaderCache *shader_cache_;    // 指向共享的着色器缓存
+  DecoderPool *decoder_pool_;  // 指向共享的解码器池
+  ShaderCache *shader_cache_;  // 指向共享的着色器缓存
+
+  StaticValueCache *static_cache_;  // 此渲染器的不随时间变化的子图结果缓存 (可以为空)
 };
 
 }  // namespace olive
@@ -0,0 +1,1230 @@
+#include "softwarerenderer.h"
+
+#include <Imath/half.h>
+#include <OpenColorIO/OpenColorIO.h>
+
+#include <QDebug>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <olive/core/util/cpuoptimize.h>
+
+#include "common/filefunctions.h"
+#include "common/ocioutils.h"
+#include "render/job/shaderjob.h"
+
+namespace olive {
+
+namespace {
+
+using Buffer = SoftwareRenderer::Buffer;
+
+const int kChannels = VideoParams::kRGBAChannelCount;
+
+QString KernelResource(SoftwareRenderer::Kernel kernel) {
+  switch (kernel) {
+    case SoftwareRenderer::kKernelInvalid:
+    case SoftwareRenderer::kKernelDefault:
+      break;
+    case SoftwareRenderer::kKernelAlphaOver:
+      return QStringLiteral(":/shaders/alphaover.frag");
+    case SoftwareRenderer::kKernelCrossDissolve:
+      return QStringLiteral(":/shaders/crossdissolve.frag");
+    case SoftwareRenderer::kKernelOpacity:
+      return QStringLiteral(":/shaders/opacity.frag");
+    case SoftwareRenderer::kKernelOpacityRGB:
+      return QStringLiteral(":/shaders/opacity_rgb.frag");
+    case SoftwareRenderer::kKernelBlur:
+      return QStringLiteral(":/shaders/blur.frag");
+    case SoftwareRenderer::kKernelCrop:
+      return QStringLiteral(":/shaders/crop.frag");
+    case SoftwareRenderer::kKernelFlip:
+      return QStringLiteral(":/shaders/flip.frag");
+    case SoftwareRenderer::kKernelYUV2RGB:
+      return QStringLiteral(":/shaders/yuv2rgb.frag");
+    case SoftwareRenderer::kKernelInterlace:
+      return QStringLiteral(":/shaders/interlace.frag");
+  }
+
+  return {};
+}
+
+const QHash<QString, SoftwareRenderer::Kernel> &KernelSources() {
+  // Shaders are identified by comparing their source against the built-in resources, since the
+  // renderer interface only receives the code itself
+  static const QHash<QString, SoftwareRenderer::Kernel> sources = [] {
+    QHash<QString, SoftwareRenderer::Kernel> h;
+    for (int i = SoftwareRenderer::kKernelAlphaOver; i <= SoftwareRenderer::kKernelInterlace; i++) {
+      auto k = static_cast<SoftwareRenderer::Kernel>(i);
+      h.insert(FileFunctions::ReadFileAsString(KernelResource(k)), k);
+    }
+    h.insert(FileFunctions::ReadFileAsString(QStringLiteral(":/shaders/default.frag")),
+             SoftwareRenderer::kKernelDefault);
+    return h;
+  }();
+
+  return sources;
+}
+
+float ToFloat(const char *src, PixelFormat::Format format) {
+  switch (format) {
+    case PixelFormat::U8:
+      return *reinterpret_cast<const uint8_t *>(src) / 255.0f;
+    case PixelFormat::U16:
+      return *reinterpret_cast<const uint16_t *>(src) / 65535.0f;
+    case PixelFormat::F16:
+      return *reinterpret_cast<const Imath::half *>(src);
+    case PixelFormat::F32:
+      return *reinterpret_cast<const float *>(src);
+    case PixelFormat::INVALID:
+    case PixelFormat::COUNT:
+      break;
+  }
+
+  return 0.0f;
+}
+
+void FromFloat(float f, char *dst, PixelFormat::Format format) {
+  switch (format) {
+    case PixelFormat::U8:
+      *reinterpret_cast<uint8_t *>(dst) = static_cast<uint8_t>(std::lround(std::clamp(f, 0.0f, 1.0f) * 255.0f));
+      break;
+    case PixelFormat::U16:
+      *reinterpret_cast<uint16_t *>(dst) = static_cast<uint16_t>(std::lround(std::clamp(f, 0.0f, 1.0f) * 65535.0f));
+      break;
+    case PixelFormat::F16:
+      *reinterpret_cast<Imath::half *>(dst) = f;
+      break;
+    case PixelFormat::F32:
+      *reinterpret_cast<float *>(dst) = f;
+      break;
+    case PixelFormat::INVALID:
+    case PixelFormat::COUNT:
+      break;
+  }
+}
+
+/**
+ * Runs `func(y)` for every row in [0, height) across the global thread pool
+ */
+template <typename F>
+void ParallelRows(int height, F func) {
+  int chunk_count = std::min(height, QThread::idealThreadCount() * 4);
+  if (chunk_count <= 1) {
+    for (int y = 0; y < height; y++) {
+      func(y);
+    }
+    return;
+  }
+
+  QVector<QPair<int, int> > chunks(chunk_count);
+  for (int i = 0; i < chunk_count; i++) {
+    chunks[i] = {height * i / chunk_count, height * (i + 1) / chunk_count};
+  }
+
+  QtConcurrent::blockingMap(chunks, [&func](const QPair<int, int> &c) {
+    for (int y = c.first; y < c.second; y++) {
+      func(y);
+    }
+  });
+}
+
+/**
+ * Maps destination pixels back to the [0, 1] texture coordinates of the blit quad
+ *
+ * The OpenGL backend transforms the quad's vertices by `ove_mvpmat`; here we invert the 2D
+ * projective part of that matrix so each destination pixel can find its source coordinate.
+ */
+class Geometry {
+ public:
+  Geometry(const QMatrix4x4 &mvp, int width, int height) : width_(width), height_(height) {
+    identity_ = mvp.isIdentity();
+
+    // Homography from quad space to normalized device coordinates
+    double m[3][3] = {{mvp(0, 0), mvp(0, 1), mvp(0, 3)}, {mvp(1, 0), mvp(1, 1), mvp(1, 3)},
+                      {mvp(3, 0), mvp(3, 1), mvp(3, 3)}};
+
+    double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                 m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+
+    valid_ = std::abs(det) > 1e-12;
+
+    if (valid_) {
+      double inv_det = 1.0 / det;
+      inv_[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) * inv_det;
+      inv_[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+      inv_[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+      inv_[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) * inv_det;
+      inv_[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+      inv_[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+      inv_[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) * inv_det;
+      inv_[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+      inv_[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+    }
+  }
+
+  [[nodiscard]] bool identity() const { return identity_; }
+
+  /**
+   * Fills texture coordinates for one destination row. Pixels that fall outside the quad get
+   * `inside[x] == 0` and must be left untouched, just like fragments OpenGL never rasterizes.
+   */
+  void Row(int y, float *u, float *v, uint8_t *inside) const {
+    if (identity_) {
+      float row_v = (y + 0.5f) / height_;
+      for (int x = 0; x < width_; x++) {
+        u[x] = (x + 0.5f) / width_;
+        v[x] = row_v;
+        inside[x] = 1;
+      }
+      return;
+    }
+
+    double ndc_y = (y + 0.5) / height_ * 2.0 - 1.0;
+    for (int x = 0; x < width_; x++) {
+      double ndc_x = (x + 0.5) / width_ * 2.0 - 1.0;
+
+      inside[x] = 0;
+      if (!valid_) {
+        continue;
+      }
+
+      double w = inv_[2][0] * ndc_x + inv_[2][1] * ndc_y + inv_[2][2];
+      if (w <= 0.0) {
+        continue;
+      }
+
+      double px = (inv_[0][0] * ndc_x + inv_[0][1] * ndc_y + inv_[0][2]) / w;
+      double py = (inv_[1][0] * ndc_x + inv_[1][1] * ndc_y + inv_[1][2]) / w;
+
+      if (px >= -1.0 && px <= 1.0 && py >= -1.0 && py <= 1.0) {
+        u[x] = static_cast<float>((px + 1.0) * 0.5);
+        v[x] = static_cast<float>((py + 1.0) * 0.5);
+        inside[x] = 1;
+      }
+    }
+  }
+
+ private:
+  int width_;
+  int height_;
+  bool identity_;
+  bool valid_;
+  double inv_[3][3]{};
+};
+
+/**
+ * Clamp-to-edge texture sampler matching GL_NEAREST/GL_LINEAR semantics
+ */
+class Sampler {
+ public:
+  Sampler() : buffer_(nullptr), interpolation_(Texture::kDefaultInterpolation) {}
+
+  Sampler(const Buffer *buffer, Texture::Interpolation interp) : buffer_(buffer), interpolation_(interp) {}
+
+  [[nodiscard]] bool IsNull() const { return !buffer_; }
+
+  void Sample(float u, float v, float *out) const {
+    if (!buffer_) {
+      out[0] = out[1] = out[2] = out[3] = 0.0f;
+      return;
+    }
+
+    const int w = buffer_->width;
+    const int h = buffer_->height;
+    const float *px = buffer_->pixels.data();
+
+    if (interpolation_ == Texture::kNearest) {
+      int ix = std::clamp(static_cast<int>(std::floor(u * w)), 0, w - 1);
+      int iy = std::clamp(static_cast<int>(std::floor(v * h)), 0, h - 1);
+      memcpy(out, px + (size_t(iy) * w + ix) * kChannels, sizeof(float) * kChannels);
+      return;
+    }
+
+    // Mipmapped sampling is approximated by plain bilinear filtering
+    float fx = u * w - 0.5f;
+    float fy = v * h - 0.5f;
+    float x0f = std::floor(fx);
+    float y0f = std::floor(fy);
+    float tx = fx - x0f;
+    float ty = fy - y0f;
+
+    int x0 = std::clamp(static_cast<int>(x0f), 0, w - 1);
+    int x1 = std::clamp(static_cast<int>(x0f) + 1, 0, w - 1);
+    int y0 = std::clamp(static_cast<int>(y0f), 0, h - 1);
+    int y1 = std::clamp(static_cast<int>(y0f) + 1, 0, h - 1);
+
+    const float *p00 = px + (size_t(y0) * w + x0) * kChannels;
+    const float *p10 = px + (size_t(y0) * w + x1) * kChannels;
+    const float *p01 = px + (size_t(y1) * w + x0) * kChannels;
+    const float *p11 = px + (size_t(y1) * w + x1) * kChannels;
+
+#if defined(OLIVE_PROCESSOR_X86) || defined(OLIVE_PROCESSOR_ARM)
+    __m128 vtx = _mm_set1_ps(tx);
+    __m128 vty = _mm_set1_ps(ty);
+    __m128 a = _mm_loadu_ps(p00);
+    __m128 b = _mm_loadu_ps(p10);
+    __m128 c = _mm_loadu_ps(p01);
+    __m128 d = _mm_loadu_ps(p11);
+    __m128 top = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), vtx));
+    __m128 bottom = _mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(d, c), vtx));
+    _mm_storeu_ps(out, _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), vty)));
+#else
+    for (int i = 0; i < kChannels; i++) {
+      float top = p00[i] + (p10[i] - p00[i]) * tx;
+      float bottom = p01[i] + (p11[i] - p01[i]) * tx;
+      out[i] = top + (bottom - top) * ty;
+    }
+#endif
+  }
+
+  /**
+   * Fetches a whole row of samples. When the blit is untransformed and the texture matches the
+   * destination size, every sample lands exactly on a texel center so we can copy the row as-is.
+   */
+  void FetchRow(const Geometry &geom, int y, int width, int height, const float *u, const float *v,
+                const uint8_t *inside, float *out) const {
+    if (buffer_ && geom.identity() && buffer_->width == width && buffer_->height == height) {
+      memcpy(out, buffer_->pixels.data() + size_t(y) * width * kChannels, sizeof(float) * width * kChannels);
+      return;
+    }
+
+    for (int x = 0; x < width; x++) {
+      if (inside[x]) {
+        Sample(u[x], v[x], out + x * kChannels);
+      }
+    }
+  }
+
+ private:
+  const Buffer *buffer_;
+  Texture::Interpolation interpolation_;
+};
+
+void ScaleRow(float *row, int width, float scale) {
+  size_t count = size_t(width) * kChannels;
+  size_t unopt_start = 0;
+
+#if defined(OLIVE_PROCESSOR_X86) || defined(OLIVE_PROCESSOR_ARM)
+  __m128 mult = _mm_set1_ps(scale);
+  unopt_start = (count / 4) * 4;
+  for (size_t i = 0; i < unopt_start; i += 4) {
+    _mm_storeu_ps(row + i, _mm_mul_ps(_mm_loadu_ps(row + i), mult));
+  }
+#endif
+
+  for (size_t i = unopt_start; i < count; i++) {
+    row[i] *= scale;
+  }
+}
+
+void AlphaOverRow(const float *base, const float *blend, float *out, int width) {
+#if defined(OLIVE_PROCESSOR_X86) || defined(OLIVE_PROCESSOR_ARM)
+  const __m128 one = _mm_set1_ps(1.0f);
+  for (int x = 0; x < width; x++) {
+    __m128 b = _mm_loadu_ps(base + x * kChannels);
+    __m128 f = _mm_loadu_ps(blend + x * kChannels);
+    __m128 fa = _mm_shuffle_ps(f, f, _MM_SHUFFLE(3, 3, 3, 3));
+    _mm_storeu_ps(out + x * kChannels, _mm_add_ps(_mm_mul_ps(b, _mm_sub_ps(one, fa)), f));
+  }
+#else
+  for (int x = 0; x < width; x++) {
+    const float *b = base + x * kChannels;
+    const float *f = blend + x * kChannels;
+    float inv_alpha = 1.0f - f[3];
+    for (int i = 0; i < kChannels; i++) {
+      out[x * kChannels + i] = b[i] * inv_alpha + f[i];
+    }
+  }
+#endif
+}
+
+void MixRow(const float *a, float wa, const float *b, float wb, float *out, int width) {
+  size_t count = size_t(width) * kChannels;
+  size_t unopt_start = 0;
+
+#if defined(OLIVE_PROCESSOR_X86) || defined(OLIVE_PROCESSOR_ARM)
+  __m128 vwa = _mm_set1_ps(wa);
+  __m128 vwb = _mm_set1_ps(wb);
+  unopt_start = (count / 4) * 4;
+  for (size_t i = 0; i < unopt_start; i += 4) {
+    __m128 r = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i), vwa), _mm_mul_ps(_mm_loadu_ps(b + i), vwb));
+    _mm_storeu_ps(out + i, r);
+  }
+#endif
+
+  for (size_t i = unopt_start; i < count; i++) {
+    out[i] = a[i] * wa + b[i] * wb;
+  }
+}
+
+void MultiplyPixel(float *px, float f) {
+#if defined(OLIVE_PROCESSOR_X86) || defined(OLIVE_PROCESSOR_ARM)
+  _mm_storeu_ps(px, _mm_mul_ps(_mm_loadu_ps(px), _mm_set1_ps(f)));
+#else
+  for (int i = 0; i < kChannels; i++) {
+    px[i] *= f;
+  }
+#endif
+}
+
+void AccumulatePixel(float *composite, const float *sample, float weight) {
+#if defined(OLIVE_PROCESSOR_X86) || defined(OLIVE_PROCESSOR_ARM)
+  __m128 c = _mm_loadu_ps(composite);
+  _mm_storeu_ps(composite, _mm_add_ps(c, _mm_mul_ps(_mm_loadu_ps(sample), _mm_set1_ps(weight))));
+#else
+  for (int i = 0; i < kChannels; i++) {
+    composite[i] += sample[i] * weight;
+  }
+#endif
+}
+
+float DissolveCurve(int curve, float linear) {
+  // Matches crossdissolve.frag's TransformCurve()
+  switch (curve) {
+    case 1:
+      return linear * linear;
+    case 2:
+      return std::sqrt(linear);
+    default:
+      return linear;
+  }
+}
+
+double Gaussian2(double x, double y, double sigma) {
+  return (1.0 / ((sigma * sigma) * 2.0 * M_PI)) * std::exp(-0.5 * (((x * x) + (y * y)) / (sigma * sigma)));
+}
+
+/**
+ * Per-blit state handed to each kernel's row function
+ */
+struct KernelContext {
+  const ShaderJob *job;
+  const Geometry *geom;
+  int width;
+  int height;
+  int iteration;
+  QString iterative_input;
+  const Buffer *iterative_buffer;
+
+  [[nodiscard]] Sampler GetSampler(const QString &name) const {
+    if (iterative_buffer && name == iterative_input) {
+      return {iterative_buffer, job->GetInterpolation(name)};
+    }
+
+    TexturePtr tex = job->Get(name).toTexture();
+    if (!tex || tex->IsDummy()) {
+      return {};
+    }
+
+    return {reinterpret_cast<const Buffer *>(tex->id().value<quintptr>()), job->GetInterpolation(name)};
+  }
+
+  [[nodiscard]] float Float(const QString &name) const { return static_cast<float>(job->Get(name).toDouble()); }
+  [[nodiscard]] int Int(const QString &name) const { return static_cast<int>(job->Get(name).toInt()); }
+  [[nodiscard]] bool Bool(const QString &name) const { return job->Get(name).toBool(); }
+  [[nodiscard]] QVector2D Vec2(const QString &name) const { return job->Get(name).toVec2(); }
+};
+
+/**
+ * Scratch space for one row: texture coordinates, coverage mask and per-input sample rows
+ */
+struct RowScratch {
+  explicit RowScratch(int width)
+      : u(width), v(width), inside(width), out(size_t(width) * kChannels), a(out.size()), b(out.size()) {}
+
+  std::vector<float> u;
+  std::vector<float> v;
+  std::vector<uint8_t> inside;
+  std::vector<float> out;
+  std::vector<float> a;
+  std::vector<float> b;
+};
+
+using RowKernel = std::function<void(int y, RowScratch &s)>;
+
+RowKernel CreateRowKernel(SoftwareRenderer::Kernel kernel, const KernelContext &ctx) {
+  const int width = ctx.width;
+  const int height = ctx.height;
+  const Geometry &geom = *ctx.geom;
+
+  switch (kernel) {
+    case SoftwareRenderer::kKernelInvalid:
+      break;
+    case SoftwareRenderer::kKernelDefault: {
+      Sampler tex = ctx.GetSampler(QStringLiteral("ove_maintex"));
+      return [=](int y, RowScratch &s) {
+        tex.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.out.data());
+      };
+    }
+    case SoftwareRenderer::kKernelAlphaOver: {
+      Sampler base = ctx.GetSampler(QStringLiteral("base_in"));
+      Sampler blend = ctx.GetSampler(QStringLiteral("blend_in"));
+      return [=](int y, RowScratch &s) {
+        if (base.IsNull() && blend.IsNull()) {
+          std::fill(s.out.begin(), s.out.end(), 0.0f);
+        } else if (base.IsNull()) {
+          blend.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.out.data());
+        } else if (blend.IsNull()) {
+          base.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.out.data());
+        } else {
+          base.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.a.data());
+          blend.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.b.data());
+          AlphaOverRow(s.a.data(), s.b.data(), s.out.data(), width);
+        }
+      };
+    }
+    case SoftwareRenderer::kKernelCrossDissolve: {
+      Sampler out_block = ctx.GetSampler(QStringLiteral("out_block_in"));
+      Sampler in_block = ctx.GetSampler(QStringLiteral("in_block_in"));
+      int curve = ctx.Int(QStringLiteral("curve_in"));
+      float progress = ctx.Float(QStringLiteral("ove_tprog_all"));
+      float out_weight = out_block.IsNull() ? 0.0f : DissolveCurve(curve, 1.0f - progress);
+      float in_weight = in_block.IsNull() ? 0.0f : DissolveCurve(curve, progress);
+      return [=](int y, RowScratch &s) {
+        std::fill(s.a.begin(), s.a.end(), 0.0f);
+        std::fill(s.b.begin(), s.b.end(), 0.0f);
+        out_block.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.a.data());
+        in_block.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.b.data());
+        MixRow(s.a.data(), out_weight, s.b.data(), in_weight, s.out.data(), width);
+      };
+    }
+    case SoftwareRenderer::kKernelOpacity: {
+      Sampler tex = ctx.GetSampler(QStringLiteral("tex_in"));
+      float opacity = ctx.Float(QStringLiteral("opacity_in"));
+      return [=](int y, RowScratch &s) {
+        tex.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.out.data());
+        ScaleRow(s.out.data(), width, opacity);
+      };
+    }
+    case SoftwareRenderer::kKernelOpacityRGB: {
+      Sampler tex = ctx.GetSampler(QStringLiteral("tex_in"));
+      Sampler opacity = ctx.GetSampler(QStringLiteral("opacity_in"));
+      return [=](int y, RowScratch &s) {
+        tex.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.out.data());
+        opacity.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.a.data());
+        for (int x = 0; x < width; x++) {
+          // The HSV "value" component is simply the maximum of the RGB channels
+          const float *o = s.a.data() + x * kChannels;
+          MultiplyPixel(s.out.data() + x * kChannels, std::max({o[0], o[1], o[2]}));
+        }
+      };
+    }
+    case SoftwareRenderer::kKernelBlur: {
+      Sampler tex = ctx.GetSampler(QStringLiteral("tex_in"));
+      int method = ctx.Int(QStringLiteral("method_in"));
+      float radius = ctx.Float(QStringLiteral("radius_in"));
+      bool horiz = ctx.Bool(QStringLiteral("horiz_in"));
+      bool vert = ctx.Bool(QStringLiteral("vert_in"));
+      bool repeat_edges = ctx.Bool(QStringLiteral("repeat_edge_pixels_in"));
+      QVector2D resolution = ctx.Vec2(QStringLiteral("resolution_in"));
+      float directional_degrees = ctx.Float(QStringLiteral("directional_degrees_in"));
+      QVector2D radial_center = ctx.Vec2(QStringLiteral("radial_center_in"));
+
+      // Mirrors determine_mode() in blur.frag
+      enum { kModeNone, kModeHorizontal, kModeVertical } mode = kModeNone;
+      if (radius != 0.0f && (horiz || vert)) {
+        if (horiz && !vert) {
+          mode = kModeHorizontal;
+        } else if (vert && !horiz) {
+          mode = kModeVertical;
+        } else if (ctx.iteration == 0) {
+          mode = kModeHorizontal;
+        } else {
+          mode = kModeVertical;
+        }
+      }
+
+      return [=](int y, RowScratch &s) {
+        if (mode == kModeNone) {
+          tex.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.out.data());
+          return;
+        }
+
+        auto add_to_composite = [&](float *composite, float cx, float cy, float weight) {
+          if (repeat_edges || (cx >= 0.0f && cx < 1.0f && cy >= 0.0f && cy < 1.0f)) {
+            float sample[kChannels];
+            tex.Sample(cx, cy, sample);
+            AccumulatePixel(composite, sample, weight);
+          }
+        };
+
+        for (int x = 0; x < width; x++) {
+          if (!s.inside[x]) {
+            continue;
+          }
+
+          float *composite = s.out.data() + x * kChannels;
+          std::fill(composite, composite + kChannels, 0.0f);
+
+          float real_radius = std::ceil(radius);
+          if (method == 2 || method == 3) {
+            real_radius *= 2.0f;
+          }
+
+          if (method == 0 || method == 1) {
+            double divider = 0.0;
+            double sigma = 0.0;
+
+            if (method == 0) {
+              divider = 1.0 / real_radius;
+            } else {
+              sigma = real_radius;
+              real_radius *= 3.0f;
+              for (float i = -real_radius + 0.5f; i <= real_radius; i += 2.0f) {
+                divider += Gaussian2(i, 0.0, sigma);
+              }
+            }
+
+            for (float i = -real_radius + 0.5f; i <= real_radius; i += 2.0f) {
+              float weight = (method == 0) ? divider : Gaussian2(i, 0.0, sigma) / divider;
+              float cx = s.u[x];
+              float cy = s.v[x];
+              if (mode == kModeHorizontal) {
+                cx += i / resolution.x();
+              } else {
+                cy += i / resolution.y();
+              }
+              add_to_composite(composite, cx, cy, weight);
+            }
+          } else {
+            float angle;
+            float divider = 1.0f / real_radius;
+
+            if (method == 2) {
+              angle = directional_degrees * M_PI / 180.0;
+            } else {
+              float dx = (s.u[x] - 0.5f) * resolution.x() - radial_center.x();
+              float dy = (s.v[x] - 0.5f) * resolution.y() - radial_center.y();
+              angle = std::atan(dy / dx);
+
+              float multiplier = std::sqrt(dx * dx + dy * dy) / resolution.y() * 2.0f;
+              real_radius = std::ceil(radius * multiplier);
+              divider = 1.0f / real_radius;
+            }
+
+            float sin_angle = std::sin(angle);
+            float cos_angle = std::cos(angle);
+
+            for (float i = -real_radius + 0.5f; i <= real_radius; i += 2.0f) {
+              add_to_composite(composite, s.u[x] + cos_angle * i / resolution.x(),
+                               s.v[x] + sin_angle * i / resolution.y(), divider);
+            }
+          }
+        }
+      };
+    }
+    case SoftwareRenderer::kKernelCrop: {
+      Sampler tex = ctx.GetSampler(QStringLiteral("tex_in"));
+      float left = ctx.Float(QStringLiteral("left_in"));
+      float top = ctx.Float(QStringLiteral("top_in"));
+      float right = ctx.Float(QStringLiteral("right_in"));
+      float bottom = ctx.Float(QStringLiteral("bottom_in"));
+      float feather = ctx.Float(QStringLiteral("feather_in"));
+      QVector2D resolution = ctx.Vec2(QStringLiteral("resolution_in"));
+      return [=](int y, RowScratch &s) {
+        tex.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.out.data());
+
+        float fx = feather / resolution.x();
+        float fy = feather / resolution.y();
+
+        for (int x = 0; x < width; x++) {
+          float u = s.u[x];
+          float v = s.v[x];
+          float multiplier = 1.0f;
+
+          if (feather == 0.0f) {
+            if (u < left || u > (1.0f - right) || v < top || v > (1.0f - bottom)) {
+              multiplier = 0.0f;
+            }
+          } else {
+            multiplier *= std::clamp((u - (left - fx * (1.0f - left))) / fx, 0.0f, 1.0f);
+            multiplier *= 1.0f - std::clamp((u - ((1.0f - right) - fx * right)) / fx, 0.0f, 1.0f);
+            multiplier *= std::clamp((v - (top - fy * (1.0f - top))) / fy, 0.0f, 1.0f);
+            multiplier *= 1.0f - std::clamp((v - ((1.0f - bottom) - fy * bottom)) / fy, 0.0f, 1.0f);
+          }
+
+          MultiplyPixel(s.out.data() + x * kChannels, std::max(multiplier, 0.0f));
+        }
+      };
+    }
+    case SoftwareRenderer::kKernelFlip: {
+      Sampler tex = ctx.GetSampler(QStringLiteral("tex_in"));
+      bool horiz = ctx.Bool(QStringLiteral("horiz_in"));
+      bool vert = ctx.Bool(QStringLiteral("vert_in"));
+      return [=](int y, RowScratch &s) {
+        if (!horiz && !vert) {
+          tex.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.out.data());
+          return;
+        }
+
+        for (int x = 0; x < width; x++) {
+          if (s.inside[x]) {
+            tex.Sample(horiz ? 1.0f - s.u[x] : s.u[x], vert ? 1.0f - s.v[x] : s.v[x], s.out.data() + x * kChannels);
+          }
+        }
+      };
+    }
+    case SoftwareRenderer::kKernelYUV2RGB: {
+      Sampler y_tex = ctx.GetSampler(QStringLiteral("y_channel"));
+      Sampler u_tex = ctx.GetSampler(QStringLiteral("u_channel"));
+      Sampler v_tex = ctx.GetSampler(QStringLiteral("v_channel"));
+      int bits_per_pixel = ctx.Int(QStringLiteral("bits_per_pixel"));
+      bool full_range = ctx.Bool(QStringLiteral("full_range"));
+      float crv = ctx.Float(QStringLiteral("yuv_crv"));
+      float cgu = ctx.Float(QStringLiteral("yuv_cgu"));
+      float cgv = ctx.Float(QStringLiteral("yuv_cgv"));
+      float cbu = ctx.Float(QStringLiteral("yuv_cbu"));
+
+      // Pixels are aligned to 16-bit regardless of their real bit depth (see yuv2rgb.frag)
+      float scale = 1.0f;
+      float chroma_offset = 128.0f / 255.0f;
+      if (bits_per_pixel == 10) {
+        scale = 65535.0f / 1023.0f;
+        chroma_offset = 512.0f / 1023.0f;
+      } else if (bits_per_pixel == 12) {
+        scale = 65535.0f / 4095.0f;
+        chroma_offset = 2048.0f / 4095.0f;
+      }
+
+      return [=](int y, RowScratch &s) {
+        y_tex.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.out.data());
+        u_tex.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.a.data());
+        v_tex.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.b.data());
+
+        for (int x = 0; x < width; x++) {
+          float *px = s.out.data() + x * kChannels;
+
+          float luma = px[0] * scale;
+          float cb = s.a[x * kChannels] * scale - chroma_offset;
+          float cr = s.b[x * kChannels] * scale - chroma_offset;
+
+          luma = (luma - 0.0625f) * 1.1643f;
+
+          float r = luma + crv * cr;
+          float g = luma - cgu * cb - cgv * cr;
+          float b = luma + cbu * cb;
+
+          if (full_range) {
+            r = r / 1.1643f + 0.0625f;
+            g = g / 1.1643f + 0.0625f;
+            b = b / 1.1643f + 0.0625f;
+          }
+
+          px[0] = r;
+          px[1] = g;
+          px[2] = b;
+          px[3] = 1.0f;
+        }
+      };
+    }
+    case SoftwareRenderer::kKernelInterlace: {
+      Sampler top = ctx.GetSampler(QStringLiteral("top_tex_in"));
+      Sampler bottom = ctx.GetSampler(QStringLiteral("bottom_tex_in"));
+      QVector2D resolution = ctx.Vec2(QStringLiteral("resolution_in"));
+      return [=](int y, RowScratch &s) {
+        // Rows are uniform in an untransformed blit, so the field can be picked per row
+        float row_v = s.inside[0] ? s.v[0] : (y + 0.5f) / height;
+        int y_pixel = static_cast<int>(std::floor(row_v * resolution.y()));
+        const Sampler &field = (y_pixel % 2 == 0) ? top : bottom;
+        field.FetchRow(geom, y, width, height, s.u.data(), s.v.data(), s.inside.data(), s.out.data());
+      };
+    }
+  }
+
+  return nullptr;
+}
+
+const char *KernelName(SoftwareRenderer::Kernel kernel) {
+  switch (kernel) {
+    case SoftwareRenderer::kKernelInvalid:
+      break;
+    case SoftwareRenderer::kKernelDefault:
+      return "default";
+    case SoftwareRenderer::kKernelAlphaOver:
+      return "alphaover";
+    case SoftwareRenderer::kKernelCrossDissolve:
+      return "crossdissolve";
+    case SoftwareRenderer::kKernelOpacity:
+      return "opacity";
+    case SoftwareRenderer::kKernelOpacityRGB:
+      return "opacity_rgb";
+    case SoftwareRenderer::kKernelBlur:
+      return "blur";
+    case SoftwareRenderer::kKernelCrop:
+      return "crop";
+    case SoftwareRenderer::kKernelFlip:
+      return "flip";
+    case SoftwareRenderer::kKernelYUV2RGB:
+      return "yuv2rgb";
+    case SoftwareRenderer::kKernelInterlace:
+      return "interlace";
+  }
+
+  return "invalid";
+}
+
+void FillBuffer(Buffer *buffer, float r, float g, float b, float a) {
+  const float color[kChannels] = {r, g, b, a};
+  size_t pixel_count = buffer->pixels.size() / kChannels;
+  for (size_t i = 0; i < pixel_count; i++) {
+    memcpy(buffer->pixels.data() + i * kChannels, color, sizeof(color));
+  }
+}
+
+}  // namespace
+
+SoftwareRenderer::SoftwareRenderer(QObject *parent)
+    : Renderer(parent), verify_renderer_(nullptr), verify_tolerance_(kDefaultVerifyTolerance) {}
+
+SoftwareRenderer::~SoftwareRenderer() {
+  Destroy();
+  PostDestroy();
+}
+
+void SoftwareRenderer::SetVerifyRenderer(Renderer *reference, double tolerance) {
+  verify_renderer_ = reference;
+  verify_tolerance_ = tolerance;
+
+  if (verify_renderer_) {
+    verify_renderer_->setParent(this);
+  }
+}
+
+bool SoftwareRenderer::Init() {
+  if (verify_renderer_ && !verify_renderer_->Init()) {
+    qWarning() << "Failed to initialize reference renderer, software render verification will be disabled";
+    delete verify_renderer_;
+    verify_renderer_ = nullptr;
+  }
+
+  return true;
+}
+
+void SoftwareRenderer::PostDestroy() {
+  if (verify_renderer_) {
+    verify_renderer_->PostDestroy();
+  }
+}
+
+void SoftwareRenderer::PostInit() {
+  if (verify_renderer_) {
+    verify_renderer_->PostInit();
+  }
+}
+
+void SoftwareRenderer::DestroyInternal() {
+  if (verify_renderer_) {
+    for (const QVariant &s : verify_shaders_) {
+      verify_renderer_->DestroyNativeShader(s);
+    }
+    verify_shaders_.clear();
+
+    verify_renderer_->Destroy();
+  }
+}
+
+void SoftwareRenderer::ClearDestination(Texture *texture, double r, double g, double b, double a) {
+  if (Buffer *buf = texture ? BufferFromHandle(texture->id()) : nullptr) {
+    FillBuffer(buf, r, g, b, a);
+  }
+}
+
+QVariant SoftwareRenderer::CreateNativeShader(ShaderCode code) {
+  if (!code.vert_code().isEmpty()) {
+    qWarning() << "Software renderer does not support custom vertex shaders";
+    return {};
+  }
+
+  Kernel k;
+  if (code.frag_code().isEmpty()) {
+    k = kKernelDefault;
+  } else {
+    k = KernelSources().value(code.frag_code(), kKernelInvalid);
+  }
+
+  if (k == kKernelInvalid) {
+    qWarning() << "Software renderer has no kernel for this shader, it will be skipped";
+    return {};
+  }
+
+  return static_cast<int>(k);
+}
+
+void SoftwareRenderer::DestroyNativeShader(QVariant shader) {}
+
+QVariant SoftwareRenderer::CreateNativeTexture(int width, int height, int depth, PixelFormat format, int channel_count,
+                                               const void *data, int linesize) {
+  auto buf = new Buffer{width, height, depth, channel_count, {}};
+  buf->pixels.resize(size_t(width) * height * depth * kChannels, 0.0f);
+
+  QVariant v = QVariant::fromValue(reinterpret_cast<quintptr>(buf));
+
+  if (data) {
+    UploadToTexture(v, VideoParams(width, height, depth, format, channel_count), data, linesize);
+  }
+
+  return v;
+}
+
+void SoftwareRenderer::DestroyNativeTexture(QVariant texture) { delete BufferFromHandle(texture); }
+
+SoftwareRenderer::Buffer *SoftwareRenderer::BufferFromHandle(const QVariant &handle) {
+  return reinterpret_cast<Buffer *>(handle.value<quintptr>());
+}
+
+void SoftwareRenderer::UploadToTexture(const QVariant &handle, const VideoParams &params, const void *data,
+                                       int linesize) {
+  Buffer *buf = BufferFromHandle(handle);
+  if (!buf || !data) {
+    return;
+  }
+
+  auto format = static_cast<PixelFormat::Format>(params.format());
+  int channels = params.channel_count();
+  int bpc = PixelFormat::byte_count(format);
+  int width = std::min(buf->width, params.effective_width());
+  int rows = std::min(buf->height * buf->depth, params.effective_height() * params.effective_depth());
+  size_t src_stride = size_t(linesize > 0 ? linesize : params.effective_width()) * channels * bpc;
+
+  buf->channel_count = channels;
+
+  ParallelRows(rows, [&](int y) {
+    const char *src = static_cast<const char *>(data) + y * src_stride;
+    float *dst = buf->pixels.data() + size_t(y) * buf->width * kChannels;
+
+    for (int x = 0; x < width; x++) {
+      const char *px = src + x * channels * bpc;
+      float *out = dst + x * kChannels;
+
+      switch (channels) {
+        case 1:
+          out[0] = out[1] = out[2] = ToFloat(px, format);
+          out[3] = 1.0f;
+          break;
+        case 3:
+          for (int c = 0; c < 3; c++) out[c] = ToFloat(px + c * bpc, format);
+          out[3] = 1.0f;
+          break;
+        default:
+          for (int c = 0; c < kChannels; c++) out[c] = ToFloat(px + c * bpc, format);
+          break;
+      }
+    }
+  });
+}
+
+void SoftwareRenderer::DownloadFromTexture(const QVariant &handle, const VideoParams &params, void *data,
+                                           int linesize) {
+  Buffer *buf = BufferFromHandle(handle);
+  if (!buf || !data) {
+    return;
+  }
+
+  auto format = static_cast<PixelFormat::Format>(params.format());
+  int channels = params.channel_count();
+  int bpc = PixelFormat::byte_count(format);
+  int width = std::min(buf->width, params.effective_width());
+  int rows = std::min(buf->height, params.effective_height());
+  size_t dst_stride = size_t(linesize > 0 ? linesize : params.effective_width()) * channels * bpc;
+
+  ParallelRows(rows, [&](int y) {
+    const float *src = buf->pixels.data() + size_t(y) * buf->width * kChannels;
+    char *dst = static_cast<char *>(data) + y * dst_stride;
+
+    for (int x = 0; x < width; x++) {
+      for (int c = 0; c < channels; c++) {
+        FromFloat(src[x * kChannels + c], dst + (x * channels + c) * bpc, format);
+      }
+    }
+  });
+}
+
+void SoftwareRenderer::Flush() {}
+
+Color SoftwareRenderer::GetPixelFromTexture(Texture *texture, const QPointF &pt) {
+  Buffer *buf = BufferFromHandle(texture->id());
+  if (!buf) {
+    return {};
+  }
+
+  int x = std::clamp(static_cast<int>(pt.x()), 0, buf->width - 1);
+  int y = std::clamp(static_cast<int>(pt.y()), 0, buf->height - 1);
+  const float *px = buf->pixels.data() + (size_t(y) * buf->width + x) * kChannels;
+
+  return {px[0], px[1], px[2], texture->channel_count() == VideoParams::kRGBChannelCount ? 1.0f : px[3]};
+}
+
+void SoftwareRenderer::Blit(QVariant s, ShaderJob job, Texture *destination, VideoParams destination_params,
+                            bool clear_destination) {
+  auto kernel = static_cast<Kernel>(s.toInt());
+  Buffer *dst = destination ? BufferFromHandle(destination->id()) : nullptr;
+
+  if (!dst) {
+    qWarning() << "Software renderer can only blit to textures";
+    return;
+  }
+
+  if (!job.GetVertexCoordinates().isEmpty()) {
+    qWarning() << "Software renderer does not support vertex coordinate overrides";
+    return;
+  }
+
+  const int width = dst->width;
+  const int height = dst->height;
+
+  Geometry geom(job.Get(QStringLiteral("ove_mvpmat")).toMatrix(), width, height);
+
+  // Iterative shaders ping-pong between scratch buffers, drawing the final pass to the destination
+  int real_iteration_count = 1;
+  if (job.GetIterationCount() > 1 && !job.GetIterativeInput().isEmpty()) {
+    real_iteration_count = job.GetIterationCount();
+  }
+
+  Buffer scratch[2];
+  const Buffer *previous = nullptr;
+
+  for (int iteration = 0; iteration < real_iteration_count; iteration++) {
+    Buffer *output;
+
+    if (iteration == real_iteration_count - 1) {
+      output = dst;
+      if (clear_destination) {
+        FillBuffer(output, 0.0f, 0.0f, 0.0f, 0.0f);
+      }
+    } else {
+      output = &scratch[iteration % 2];
+      *output = Buffer{width, height, 1, destination_params.channel_count(), {}};
+      output->pixels.resize(size_t(width) * height * kChannels, 0.0f);
+    }
+
+    KernelContext ctx{&job, &geom, width, height, iteration, job.GetIterativeInput(), previous};
+
+    RowKernel row_kernel = CreateRowKernel(kernel, ctx);
+    if (!row_kernel) {
+      return;
+    }
+
+    ParallelRows(height, [&](int y) {
+      thread_local std::unique_ptr<RowScratch> scratch_row;
+      if (!scratch_row || scratch_row->u.size() != size_t(width)) {
+        scratch_row = std::make_unique<RowScratch>(width);
+      }
+
+      RowScratch &rs = *scratch_row;
+      geom.Row(y, rs.u.data(), rs.v.data(), rs.inside.data());
+
+      row_kernel(y, rs);
+
+      // Only write pixels covered by the quad, OpenGL never rasterizes the rest
+      float *dst_row = output->pixels.data() + size_t(y) * width * kChannels;
+      if (geom.identity()) {
+        memcpy(dst_row, rs.out.data(), sizeof(float) * width * kChannels);
+      } else {
+        for (int x = 0; x < width; x++) {
+          if (rs.inside[x]) {
+            memcpy(dst_row + x * kChannels, rs.out.data() + x * kChannels, sizeof(float) * kChannels);
+          }
+        }
+      }
+    });
+
+    previous = output;
+  }
+
+  if (verify_renderer_ && clear_destination) {
+    VerifyBlit(kernel, job, dst, destination_params);
+  }
+}
+
+void SoftwareRenderer::BlitColorManaged(const ColorTransformJob &color_job, Texture *destination,
+                                        const VideoParams &params) {
+  Buffer *dst = destination ? BufferFromHandle(destination->id()) : nullptr;
+  if (!dst) {
+    qWarning() << "Software renderer can only blit to textures";
+    return;
+  }
+
+  if (!color_job.GetColorProcessor()) {
+    return;
+  }
+
+  if (color_job.CustomShaderSource()) {
+    qWarning() << "Software renderer does not support custom color shaders, applying plain transform";
+  }
+
+  TexturePtr input = color_job.GetInputTexture().toTexture();
+  Sampler tex;
+  if (input && !input->IsDummy()) {
+    tex = Sampler(BufferFromHandle(input->id()), Texture::kDefaultInterpolation);
+  }
+
+  OCIO::ConstCPUProcessorRcPtr cpu = color_job.GetColorProcessor()->GetCPUProcessor();
+
+  const int width = dst->width;
+  const int height = dst->height;
+  const AlphaAssociated alpha = color_job.GetInputAlphaAssociation();
+  const bool force_opaque = color_job.GetForceOpaque();
+  const QMatrix4x4 crop = color_job.GetCropMatrix().inverted();
+
+  Geometry geom(color_job.GetTransformMatrix(), width, height);
+
+  if (color_job.IsClearDestinationEnabled()) {
+    FillBuffer(dst, 0.0f, 0.0f, 0.0f, 0.0f);
+  }
+
+  ParallelRows(height, [&](int y) {
+    RowScratch rs(width);
+    geom.Row(y, rs.u.data(), rs.v.data(), rs.inside.data());
+
+    // Equivalent to colormanage.frag's `vec4(coord - 0.5, 0.0, 1.0) * ove_cropmatrix`
+    for (int x = 0; x < width; x++) {
+      float *px = rs.out.data() + x * kChannels;
+
+      float tx = rs.u[x] - 0.5f;
+      float ty = rs.v[x] - 0.5f;
+      float cx = tx * crop(0, 0) + ty * crop(1, 0) + crop(3, 0) + 0.5f;
+      float cy = tx * crop(0, 1) + ty * crop(1, 1) + crop(3, 1) + 0.5f;
+
+      if (!rs.inside[x] || cx < 0.0f || cx >= 1.0f || cy < 0.0f || cy >= 1.0f) {
+        std::fill(px, px + kChannels, 0.0f);
+        continue;
+      }
+
+      tex.Sample(cx, cy, px);
+
+      if (alpha == kAlphaAssociated && px[3] != 0.0f) {
+        px[0] /= px[3];
+        px[1] /= px[3];
+        px[2] /= px[3];
+      }
+    }
+
+    OCIO::PackedImageDesc img(rs.out.data(), width, 1, kChannels);
+    cpu->apply(img);
+
+    float *dst_row = dst->pixels.data() + size_t(y) * width * kChannels;
+    for (int x = 0; x < width; x++) {
+      if (!rs.inside[x]) {
+        continue;
+      }
+
+      float *px = rs.out.data() + x * kChannels;
+
+      if ((alpha == kAlphaAssociated && px[3] != 0.0f) || alpha == kAlphaUnassociated) {
+        px[0] *= px[3];
+        px[1] *= px[3];
+        px[2] *= px[3];
+      }
+
+      if (force_opaque) {
+        px[3] = 1.0f;
+      }
+
+      memcpy(dst_row + x * kChannels, px, sizeof(float) * kChannels);
+    }
+  });
+
+  if (verify_renderer_ && color_job.IsClearDestinationEnabled()) {
+    VerifyColorManaged(color_job, dst, params);
+  }
+}
+
+TexturePtr SoftwareRenderer::MirrorTexture(const TexturePtr &texture) {
+  Buffer *buf = BufferFromHandle(texture->id());
+  if (!buf) {
+    return nullptr;
+  }
+
+  VideoParams p = texture->params();
+  p.set_format(PixelFormat(PixelFormat::F32));
+  p.set_channel_count(kChannels);
+
+  return verify_renderer_->CreateTexture(p, buf->pixels.data(), buf->width);
+}
+
+void SoftwareRenderer::VerifyBlit(Kernel kernel, const ShaderJob &job, const Buffer *result,
+                                  const VideoParams &params) {
+  QMutexLocker locker(&verify_mutex_);
+
+  QVariant shader = verify_shaders_.value(kernel);
+  if (shader.isNull()) {
+    QString resource = KernelResource(kernel);
+    shader = verify_renderer_->CreateNativeShader(
+        ShaderCode(resource.isEmpty() ? QString() : FileFunctions::ReadFileAsString(resource)));
+    if (shader.isNull()) {
+      return;
+    }
+    verify_shaders_.insert(kernel, shader);
+  }
+
+  // Replace every texture input with a copy living in the reference renderer
+  ShaderJob mirrored = job;
+  for (auto it = job.GetValues().cbegin(); it != job.GetValues().cend(); it++) {
+    if (it.value().type() == NodeValue::kTexture) {
+      if (TexturePtr t = it.value().toTexture(); t && !t->IsDummy()) {
+        mirrored.Insert(it.key(), NodeValue(NodeValue::kTexture, QVariant::fromValue(MirrorTexture(t))));
+      }
+    }
+  }
+
+  TexturePtr reference = verify_renderer_->CreateTexture(params);
+  verify_renderer_->BlitToTexture(shader, mirrored, reference.get());
+
+  CompareWithReference(QString::fromLatin1(KernelName(kernel)), reference, result);
+}
+
+void SoftwareRenderer::VerifyColorManaged(const ColorTransformJob &color_job, const Buffer *result,
+                                          const VideoParams &params) {
+  QMutexLocker locker(&verify_mutex_);
+
+  ColorTransformJob mirrored = color_job;
+  TexturePtr input = color_job.GetInputTexture().toTexture();
+  if (input && !input->IsDummy()) {
+    mirrored.SetInputTexture(MirrorTexture(input));
+  }
+
+  TexturePtr reference = verify_renderer_->CreateTexture(params);
+  verify_renderer_->BlitColorManaged(mirrored, reference.get());
+
+  CompareWithReference(QStringLiteral("colormanage"), reference, result);
+}
+
+void SoftwareRenderer::CompareWithReference(const QString &name, const TexturePtr &reference, const Buffer *result) {
+  VideoParams p = reference->params();
+  p.set_format(PixelFormat(PixelFormat::F32));
+  p.set_channel_count(kChannels);
+
+  std::vector<float> expected(size_t(p.effective_width()) * p.effective_height() * kChannels);
+
+  verify_renderer_->Flush();
+  verify_renderer_->DownloadFromTexture(reference->id(), p, expected.data(), p.effective_width());
+
+  size_t count = std::min(expected.size(), result->pixels.size());
+  double max_error = 0.0;
+  size_t bad_pixels = 0;
+
+  for (size_t i = 0; i < count; i += kChannels) {
+    double pixel_error = 0.0;
+    for (int c = 0; c < kChannels; c++) {
+      pixel_error = std::max(pixel_error, double(std::abs(expected[i + c] - result->pixels[i + c])));
+    }
+
+    max_error = std::max(max_error, pixel_error);
+    if (pixel_error > verify_tolerance_) {
+      bad_pixels++;
+    }
+  }
+
+  if (bad_pixels) {
+    qWarning().noquote() << QStringLiteral("Software kernel \"%1\" differs from reference: %2 of %3 pixels over %4 "
+                                           "(max error %5)")
+                                .arg(name, QString::number(bad_pixels), QString::number(count / kChannels),
+                                     QString::number(verify_tolerance_), QString::number(max_error));
+  }
+}
+
+}  // namespace olive
@@ -0,0 +1,172 @@
+#ifndef SOFTWARERENDERER_H  // 防止头文件被重复包含的宏
+#define SOFTWARERENDERER_H  // 定义 SOFTWARERENDERER_H 宏
+
+#include <QHash>   // Qt 哈希表容器 (用于校验模式下的着色器缓存)
+#include <QMutex>  // Qt 互斥锁类
+#include <vector>  // 标准库动态数组 (用于存储像素数据)
+
+#include "render/renderer.h"  // 包含 Renderer 抽象基类的定义
+
+namespace olive {  // olive 项目的命名空间
+
+/**
+ * @brief SoftwareRenderer 类是 Renderer 接口的纯 CPU 实现，不需要 GPU 或 OpenGL 上下文。
+ *
+ * 它主要用于无图形硬件的渲染节点 (例如命令行导出)。纹理以 RGBA 32位浮点数的形式保存在
+ * 内存中，内置的着色器 (default/alphaover/crossdissolve/opacity/blur/crop/flip/yuv2rgb/
+ * interlace) 以及色彩管理都由对应的 C++ 内核实现，按行拆分后在线程池上并行执行，
+ * 逐像素的运算使用 SSE/NEON 指令。
+ *
+ * 未实现对应内核的节点着色器会在 CreateNativeShader() 中返回空句柄，与 OpenGL
+ * 编译失败时的行为一致。
+ *
+ * 可以通过 SetVerifyRenderer() 设置一个参考渲染器 (通常是 OpenGLRenderer)，此时每次
+ * Blit 都会在参考渲染器上重复执行并逐像素比较结果，用于验证软件内核的正确性。
+ */
+class SoftwareRenderer : public Renderer {  // SoftwareRenderer 继承自 Renderer 抽象基类
+ Q_OBJECT                                   // 声明此类使用 Qt 的元对象系统
+
+     public :
+     /**
+      * @brief 软件渲染器支持的内核类型，原生着色器句柄中存储的就是此枚举值。
+      */
+     enum Kernel {
+       kKernelInvalid,        // 不支持的着色器
+       kKernelDefault,        // default.frag (带 ove_mvpmat 变换的纹理拷贝)
+       kKernelAlphaOver,      // alphaover.frag
+       kKernelCrossDissolve,  // crossdissolve.frag
+       kKernelOpacity,        // opacity.frag
+       kKernelOpacityRGB,     // opacity_rgb.frag
+       kKernelBlur,           // blur.frag
+       kKernelCrop,           // crop.frag
+       kKernelFlip,           // flip.frag
+       kKernelYUV2RGB,        // yuv2rgb.frag
+       kKernelInterlace       // interlace.frag
+     };
+
+  /**
+   * @brief 构造函数。
+   * @param parent 父对象指针，默认为 nullptr。
+   */
+  explicit SoftwareRenderer(QObject *parent = nullptr);
+
+  ~SoftwareRenderer() override;
+
+  /**
+   * @brief 设置用于逐像素校验的参考渲染器。
+   *
+   * 必须在 Init() 之前调用。SoftwareRenderer 会接管 reference 的所有权，并在自己的
+   * Init/PostInit/Destroy 中转发调用。
+   * @param reference 参考渲染器 (例如 OpenGLRenderer)。
+   * @param tolerance 允许的最大单通道误差，超过时输出警告。
+   */
+  void SetVerifyRenderer(Renderer *reference, double tolerance = kDefaultVerifyTolerance);
+
+  // 校验模式下默认允许的最大单通道误差 (半精度纹理的舍入误差约为 1e-3)
+  static constexpr double kDefaultVerifyTolerance = 0.004;
+
+  // (重写) 初始化渲染器，软件渲染器本身无需任何上下文
+  bool Init() override;
+
+  // (重写) 销毁后的清理，转发给参考渲染器 (如果有)
+  void PostDestroy() override;
+
+  // (重写) 在渲染线程中的初始化，转发给参考渲染器 (如果有)
+  void PostInit() override;
+
+  // (重写) 用指定颜色填充目标纹理
+  void ClearDestination(olive::Texture *texture = nullptr, double r = 0.0, double g = 0.0, double b = 0.0,
+                        double a = 0.0) override;
+
+  /**
+   * @brief (重写) 将着色器代码映射为内置的 C++ 内核。
+   * @return 返回包含 Kernel 枚举值的 QVariant；无法识别的着色器返回空 QVariant。
+   */
+  QVariant CreateNativeShader(olive::ShaderCode code) override;
+
+  // (重写) 内核句柄不持有任何资源，因此无需释放
+  void DestroyNativeShader(QVariant shader) override;
+
+  // (重写) 将任意格式的像素数据转换为内部的 RGBA 浮点格式
+  void UploadToTexture(const QVariant &handle, const VideoParams &params, const void *data, int linesize) override;
+
+  // (重写) 将内部的 RGBA 浮点数据转换为请求的格式和通道数
+  void DownloadFromTexture(const QVariant &handle, const VideoParams &params, void *data, int linesize) override;
+
+  // (重写) 所有操作都是同步完成的，因此无需刷新
+  void Flush() override;
+
+  // (重写) 读取纹理中指定像素的颜色
+  Color GetPixelFromTexture(olive::Texture *texture, const QPointF &pt) override;
+
+  using Renderer::BlitColorManaged;
+
+  /**
+   * @brief (重写) 使用 OCIO 的 CPU 处理器执行色彩管理，替代基于 GLSL 的实现。
+   */
+  void BlitColorManaged(const ColorTransformJob &color_job, Texture *destination, const VideoParams &params) override;
+
+  /**
+   * @brief 软件纹理的原生存储。
+   *
+   * 无论原始格式如何，像素都以 RGBA 32位浮点数紧密排列存储。单通道纹理会被展开为
+   * (r, r, r, 1)，与 OpenGL 中灰度纹理的采样结果一致。
+   */
+  struct Buffer {
+    int width;                  // 宽度
+    int height;                 // 高度
+    int depth;                  // 深度 (仅 3D 纹理大于 1)
+    int channel_count;          // 原始通道数 (用于下载时的格式转换)
+    std::vector<float> pixels;  // width * height * depth * 4 个浮点数
+  };
+
+ protected:
+  // (重写) 执行内核，支持 ove_mvpmat 变换、迭代 (ove_iteration) 以及 *_enabled 标志
+  void Blit(QVariant shader, olive::ShaderJob job, olive::Texture *destination, olive::VideoParams destination_params,
+            bool clear_destination) override;
+
+  // (重写) 分配新的 Buffer，句柄为指向 Buffer 的指针
+  QVariant CreateNativeTexture(int width, int height, int depth, PixelFormat format, int channel_count,
+                               const void *data = nullptr, int linesize = 0) override;
+
+  // (重写) 释放 Buffer
+  void DestroyNativeTexture(QVariant texture) override;
+
+  // (重写) 销毁参考渲染器中的资源
+  void DestroyInternal() override;
+
+ private:
+  static Buffer *BufferFromHandle(const QVariant &handle);
+
+  /**
+   * @brief 在参考渲染器上重复执行同一个 Blit，并将结果与 result 逐像素比较。
+   */
+  void VerifyBlit(Kernel kernel, const ShaderJob &job, const Buffer *result, const VideoParams &params);
+
+  /**
+   * @brief 在参考渲染器上重复执行色彩管理，并与 result 比较。
+   */
+  void VerifyColorManaged(const ColorTransformJob &color_job, const Buffer *result, const VideoParams &params);
+
+  /**
+   * @brief 下载参考纹理并与软件结果比较，超出容差时输出警告。
+   */
+  void CompareWithReference(const QString &name, const TexturePtr &reference, const Buffer *result);
+
+  /**
+   * @brief 将软件纹理复制到参考渲染器中的等价纹理。
+   */
+  TexturePtr MirrorTexture(const TexturePtr &texture);
+
+  Renderer *verify_renderer_;  // 参考渲染器 (可选，由本对象持有)
+
+  double verify_tolerance_;  // 校验时允许的最大单通道误差
+
+  QHash<int, QVariant> verify_shaders_;  // 参考渲染器中每个内核对应的已编译着色器
+
+  QMutex verify_mutex_;  // 保护参考渲染器的调用 (参考渲染器并非线程安全)
+};
+
+}  // namespace olive
+
+#endif  // SOFTWARERENDERER_H
@@ -0,0 +1,70 @@
+#include "staticvaluecache.h"
+
+#include "node/node.h"
+#include "render/texture.h"
+
+namespace olive {
+
+// A handful of full resolution titles or generated backgrounds per render thread
+const qint64 StaticValueCache::kMaximumBytes = 256 * 1024 * 1024;
+
+StaticValueCache::StaticValueCache() : used_bytes_(0), use_count_(0) {}
+
+bool StaticValueCache::Get(const Node *node, const VideoParams &params, NodeValueTable *table) {
+  auto it = entries_.find(node);
+  if (it == entries_.end()) {
+    return false;
+  }
+
+  if (it->generation != node->GetRenderGeneration() || !(it->params == params)) {
+    // Node changed since, or we're rendering at a different resolution now
+    Remove(it);
+    return false;
+  }
+
+  it->last_used = ++use_count_;
+  *table = it->table;
+  return true;
+}
+
+void StaticValueCache::Insert(const Node *node, const VideoParams &params, const NodeValueTable &table) {
+  auto existing = entries_.find(node);
+  if (existing != entries_.end()) {
+    Remove(existing);
+  }
+
+  qint64 bytes = 0;
+  for (int i = 0; i < table.Count(); i++) {
+    const NodeValue &v = table.at(i);
+    if (v.type() == NodeValue::kTexture) {
+      if (TexturePtr tex = v.toTexture()) {
+        const VideoParams &p = tex->params();
+        bytes += VideoParams::GetBufferSize(p.effective_width(), p.effective_height(), p.format(), p.channel_count());
+      }
+    }
+  }
+
+  if (bytes > kMaximumBytes) {
+    return;
+  }
+
+  while (used_bytes_ + bytes > kMaximumBytes && !entries_.isEmpty()) {
+    auto oldest = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); it++) {
+      if (it->last_used < oldest->last_used) {
+        oldest = it;
+      }
+    }
+    Remove(oldest);
+  }
+
+  entries_.insert(node, {node->GetRenderGeneration(), params, table, bytes, ++use_count_});
+  used_bytes_ += bytes;
+}
+
+void StaticValueCache::Remove(QHash<const Node *, Entry>::iterator it) {
+  used_bytes_ -= it->bytes;
+  entries_.erase(it);
+}
+
+}  // namespace olive
@@ -0,0 +1,61 @@
+#ifndef STATICVALUECACHE_H
+#define STATICVALUECACHE_H
+
+#include <QHash>  // 节点到结果的映射
+
+#include "node/value.h"
+#include "render/videoparams.h"
+
+namespace olive {
+
+class Node;
+
+/**
+ * @brief 一个渲染线程跨帧保存的、不随时间变化的子图的渲染结果。
+ *
+ * 标记为 Node::kTimeInvariant、没有关键帧、上游也全部满足这些条件的节点，在任何时间上的输出都相同，
+ * 所以第一次渲染后把它的值表 (纹理已经解析) 保存在这里，之后的帧直接使用，例如整个序列上的一个标题只渲染一次。
+ *
+ * 条目以节点的 Node::GetRenderGeneration() 判断是否失效：节点或它的任何上游被修改时都会经过 Node::InvalidateCache()，
+ * 代数随之改变，旧条目在下次查找时被丢弃。渲染参数 (分辨率、格式等) 不同的结果不会被复用。
+ *
+ * 纹理属于渲染线程自己的渲染器，所以每个渲染线程有一个实例，只在该线程中访问，不需要加锁。
+ */
+class StaticValueCache {
+ public:
+  StaticValueCache();
+
+  /**
+   * @brief 查找节点仍然有效的结果。
+   * @return 找到时写入 table 并返回 true。
+   */
+  bool Get(const Node *node, const VideoParams &params, NodeValueTable *table);
+
+  /**
+   * @brief 保存节点的结果，必要时淘汰最久未使用的条目。
+   */
+  void Insert(const Node *node, const VideoParams &params, const NodeValueTable &table);
+
+  static const qint64 kMaximumBytes;  // 所有条目中纹理占用的显存上限
+
+ private:
+  struct Entry {
+    uint64_t generation;   // 保存时节点的渲染代数
+    VideoParams params;    // 渲染参数
+    NodeValueTable table;  // 结果
+    qint64 bytes;          // 结果中纹理占用的字节数
+    uint64_t last_used;    // 上次使用时 use_count_ 的值
+  };
+
+  void Remove(QHash<const Node *, Entry>::iterator it);
+
+  QHash<const Node *, Entry> entries_;  // 以节点为键的结果
+
+  qint64 used_bytes_;  // 当前所有条目的纹理字节数
+
+  uint64_t use_count_;  // 查找和插入计数，用于近似 LRU
+};
+
+}  // namespace olive
+
+#endif  // STATICVALUECACHE_H
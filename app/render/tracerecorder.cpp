@@ -0,0 +1,219 @@
+#include "tracerecorder.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVector>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace olive {
+
+// 8 MiB per thread that has ever recorded, enough for several minutes of playback
+const int TraceRecorder::kEventsPerThread = 65536;
+
+namespace {
+
+std::atomic<uint64_t> next_ticket_id{1};
+std::atomic<uint64_t> next_thread_id{1};
+
+thread_local uint64_t current_ticket = 0;
+
+}  // namespace
+
+/**
+ * Owns the calling thread's buffer and hands it back when the thread exits, so that thread pools that recycle their
+ * threads don't keep allocating new buffers
+ */
+class TraceThreadHandle {
+ public:
+  ~TraceThreadHandle() {
+    if (buffer) {
+      buffer->in_use.store(false, std::memory_order_release);
+    }
+  }
+
+  TraceRecorder::ThreadBuffer *buffer = nullptr;
+  uint64_t id = next_thread_id.fetch_add(1, std::memory_order_relaxed);
+};
+
+namespace {
+
+thread_local TraceThreadHandle thread_handle;
+
+}  // namespace
+
+TraceRecorder *TraceRecorder::instance() {
+  static TraceRecorder recorder;
+  return &recorder;
+}
+
+int64_t TraceRecorder::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void TraceRecorder::Record(const char *name, const char *category, int64_t start, int64_t end,
+                           const QString &detail) {
+  TraceThreadHandle &handle = thread_handle;
+  if (!handle.buffer) {
+    handle.buffer = AcquireBuffer();
+  }
+
+  ThreadBuffer *b = handle.buffer;
+
+  // Only this thread ever writes to the buffer, so the slot can be filled in without any synchronization. The exporter
+  // discards anything that may have been overwritten while it was reading.
+  uint64_t index = b->write_index.load(std::memory_order_relaxed);
+  Event &e = b->events[index % kEventsPerThread];
+
+  e.name = name;
+  e.category = category;
+  e.start = start;
+  e.end = end;
+  e.ticket = current_ticket;
+  e.thread = handle.id;
+
+  if (detail.isEmpty()) {
+    e.detail[0] = 0;
+  } else {
+    QByteArray utf8 = detail.toUtf8();
+    int len = std::min(int(utf8.size()), kDetailLength - 1);
+
+    // Don't cut a multi-byte character in half
+    if (len < utf8.size()) {
+      while (len > 0 && (uchar(utf8.at(len)) & 0xC0) == 0x80) {
+        len--;
+      }
+    }
+
+    memcpy(e.detail, utf8.constData(), len);
+    e.detail[len] = 0;
+  }
+
+  b->write_index.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::Clear() {
+  QMutexLocker locker(&buffers_lock_);
+
+  for (const std::unique_ptr<ThreadBuffer> &b : buffers_) {
+    b->cleared_index.store(b->write_index.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+}
+
+bool TraceRecorder::ExportChromeTrace(const QString &filename) {
+  QJsonArray events;
+  QVector<uint64_t> threads;
+
+  const qint64 pid = QCoreApplication::applicationPid();
+
+  std::unique_ptr<Event[]> copy(new Event[kEventsPerThread]);
+
+  QMutexLocker locker(&buffers_lock_);
+
+  for (const std::unique_ptr<ThreadBuffer> &b : buffers_) {
+    // Snapshot only what had been published when we started. Event `end` may already be half written, and once the
+    // buffer has wrapped its slot is also the one event `end - kEventsPerThread` lives in, so that one is left out too.
+    uint64_t end = b->write_index.load(std::memory_order_acquire);
+    uint64_t copy_start = b->cleared_index.load(std::memory_order_relaxed);
+    if (end >= uint64_t(kEventsPerThread)) {
+      copy_start = std::max(copy_start, end - kEventsPerThread + 1);
+    }
+    copy_start = std::min(copy_start, end);
+
+    for (uint64_t i = copy_start; i < end; i++) {
+      copy[i - copy_start] = b->events[i % kEventsPerThread];
+    }
+
+    // The owning thread keeps writing while we copy, any slot it may have lapped since is unreliable
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t now = b->write_index.load(std::memory_order_relaxed);
+    uint64_t start = copy_start;
+    if (now >= uint64_t(kEventsPerThread)) {
+      start = std::max(start, now - kEventsPerThread + 1);
+    }
+
+    for (uint64_t i = start; i < end; i++) {
+      const Event &e = copy[i - copy_start];
+
+      // Chrome's trace format uses microseconds
+      QJsonObject o;
+      o.insert(QStringLiteral("name"), QString::fromLatin1(e.name));
+      o.insert(QStringLiteral("cat"), QString::fromLatin1(e.category));
+      o.insert(QStringLiteral("ph"), QStringLiteral("X"));
+      o.insert(QStringLiteral("ts"), double(e.start) / 1000.0);
+      o.insert(QStringLiteral("dur"), double(e.end - e.start) / 1000.0);
+      o.insert(QStringLiteral("pid"), pid);
+      o.insert(QStringLiteral("tid"), double(e.thread));
+
+      QJsonObject args;
+      if (e.ticket) {
+        args.insert(QStringLiteral("ticket"), double(e.ticket));
+      }
+      if (e.detail[0]) {
+        args.insert(QStringLiteral("detail"), QString::fromUtf8(e.detail));
+      }
+      if (!args.isEmpty()) {
+        o.insert(QStringLiteral("args"), args);
+      }
+
+      events.append(o);
+
+      if (!threads.contains(e.thread)) {
+        threads.append(e.thread);
+      }
+    }
+  }
+
+  locker.unlock();
+
+  for (uint64_t t : threads) {
+    QJsonObject o;
+    o.insert(QStringLiteral("name"), QStringLiteral("thread_name"));
+    o.insert(QStringLiteral("ph"), QStringLiteral("M"));
+    o.insert(QStringLiteral("pid"), pid);
+    o.insert(QStringLiteral("tid"), double(t));
+    o.insert(QStringLiteral("args"), QJsonObject({{QStringLiteral("name"), QStringLiteral("Thread %1").arg(t)}}));
+    events.append(o);
+  }
+
+  QJsonObject root;
+  root.insert(QStringLiteral("traceEvents"), events);
+  root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+  QFile f(filename);
+  if (!f.open(QFile::WriteOnly) || f.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0) {
+    return false;
+  }
+
+  return true;
+}
+
+uint64_t TraceRecorder::NewTicketId() { return next_ticket_id.fetch_add(1, std::memory_order_relaxed); }
+
+uint64_t TraceRecorder::CurrentTicket() { return current_ticket; }
+
+void TraceRecorder::SetCurrentTicket(uint64_t id) { current_ticket = id; }
+
+TraceRecorder::ThreadBuffer *TraceRecorder::AcquireBuffer() {
+  QMutexLocker locker(&buffers_lock_);
+
+  for (const std::unique_ptr<ThreadBuffer> &b : buffers_) {
+    bool expected = false;
+    if (b->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+      return b.get();
+    }
+  }
+
+  auto b = std::make_unique<ThreadBuffer>();
+  b->events.reset(new Event[kEventsPerThread]);
+  b->in_use.store(true, std::memory_order_relaxed);
+  buffers_.push_back(std::move(b));
+  return buffers_.back().get();
+}
+
+}  // namespace olive
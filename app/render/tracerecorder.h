@@ -0,0 +1,175 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QMutex>    // 保护线程缓冲区列表
+#include <QString>   // 事件详情
+#include <atomic>    // 无锁写入
+#include <cstdint>   // int64_t
+#include <memory>    // std::unique_ptr
+#include <vector>    // 线程缓冲区列表
+
+namespace olive {
+
+/**
+ * @brief 记录渲染各阶段耗时的轻量级跟踪器，可导出为 Chrome 跟踪事件 JSON (chrome://tracing 或 Perfetto)。
+ *
+ * 每个线程写入自己的环形缓冲区，因此 Record() 不需要加锁；缓冲区写满后覆盖最旧的事件。
+ * 每个事件都带有线程 ID 和所属渲染票据的 ID (见 TraceTicketScope)，详情字段用于记录节点 ID 或素材文件名，
+ * 以便把慢帧归因到具体的节点或素材。
+ *
+ * 默认关闭，关闭时 TraceScope 的开销只有一次原子读取。可以通过命令行参数 "--trace" 或调试菜单启用。
+ */
+class TraceRecorder {
+ public:
+  /**
+   * @brief 获取全局唯一的跟踪器实例。
+   */
+  static TraceRecorder *instance();
+
+  /**
+   * @brief 启用或停止记录。已记录的事件会保留，直到调用 Clear()。
+   */
+  void SetEnabled(bool e) { enabled_.store(e, std::memory_order_relaxed); }
+
+  [[nodiscard]] bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 当前时间 (纳秒，单调时钟)。
+   */
+  static int64_t Now();
+
+  /**
+   * @brief 记录一个已完成的事件。线程安全且不加锁 (每个线程第一次记录时除外)。
+   * @param name 事件名称，必须是字符串常量。
+   * @param category 事件分类，必须是字符串常量。
+   * @param start 开始时间 (Now())。
+   * @param end 结束时间 (Now())。
+   * @param detail 附加详情 (例如节点 ID 或文件名)，过长时会被截断。
+   */
+  void Record(const char *name, const char *category, int64_t start, int64_t end, const QString &detail = QString());
+
+  /**
+   * @brief 丢弃所有已记录的事件。
+   */
+  void Clear();
+
+  /**
+   * @brief 将已记录的事件写入 Chrome 跟踪事件 JSON 文件。可以在记录的同时调用。
+   * @return 如果文件无法写入，则返回 false。
+   */
+  bool ExportChromeTrace(const QString &filename);
+
+  /**
+   * @brief 为一个新的渲染票据分配 ID。
+   */
+  static uint64_t NewTicketId();
+
+  /**
+   * @brief 当前线程正在处理的票据 ID (没有时为 0)。
+   */
+  static uint64_t CurrentTicket();
+
+  static void SetCurrentTicket(uint64_t id);
+
+ private:
+  TraceRecorder() = default;
+
+  static const int kEventsPerThread;  // 每个线程的环形缓冲区大小
+
+  static constexpr int kDetailLength = 80;  // 详情的最大字节数 (UTF-8，包括结尾的 0)
+
+  struct Event {
+    const char *name;
+    const char *category;
+    int64_t start;
+    int64_t end;
+    uint64_t ticket;
+    uint64_t thread;
+    char detail[kDetailLength];
+  };
+
+  struct ThreadBuffer {
+    std::unique_ptr<Event[]> events;         // 环形缓冲区
+    std::atomic<uint64_t> write_index{0};    // 已写入的事件总数 (只由拥有者线程写入)
+    std::atomic<uint64_t> cleared_index{0};  // 此索引之前的事件已被 Clear() 丢弃
+    std::atomic<bool> in_use{false};         // 是否有线程正在使用此缓冲区
+  };
+
+  friend class TraceThreadHandle;
+
+  /**
+   * @brief 为当前线程获取一个缓冲区 (优先复用已退出线程的缓冲区)。
+   */
+  ThreadBuffer *AcquireBuffer();
+
+  std::atomic<bool> enabled_{false};  // 是否正在记录
+
+  QMutex buffers_lock_;  // 保护 buffers_ 列表本身 (不保护缓冲区内容)
+
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;  // 所有线程的缓冲区，只增不减
+};
+
+/**
+ * @brief 记录一个作用域持续时间的 RAII 辅助类。
+ */
+class TraceScope {
+ public:
+  explicit TraceScope(const char *name, const char *category, const QString &detail = QString())
+      : name_(name), category_(category), start_(TraceRecorder::instance()->IsEnabled() ? TraceRecorder::Now() : -1) {
+    if (start_ != -1) {
+      detail_ = detail;
+    }
+  }
+
+  ~TraceScope() {
+    if (start_ != -1) {
+      TraceRecorder::instance()->Record(name_, category_, start_, TraceRecorder::Now(), detail_);
+    }
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+ private:
+  const char *name_;      // 事件名称
+  const char *category_;  // 事件分类
+  int64_t start_;         // 开始时间，未启用时为 -1
+  QString detail_;        // 附加详情
+};
+
+/**
+ * @brief 在作用域内把当前线程标记为正在处理一个新票据，并把整个作用域记录为一个事件。
+ */
+class TraceTicketScope {
+ public:
+  explicit TraceTicketScope(const char *name, const QString &detail = QString())
+      : name_(name), previous_(TraceRecorder::CurrentTicket()) {
+    TraceRecorder *r = TraceRecorder::instance();
+    start_ = r->IsEnabled() ? TraceRecorder::Now() : -1;
+    if (start_ != -1) {
+      detail_ = detail;
+      TraceRecorder::SetCurrentTicket(TraceRecorder::NewTicketId());
+    }
+  }
+
+  ~TraceTicketScope() {
+    if (start_ != -1) {
+      // Recorded before the ticket id is restored so that the event belongs to this ticket
+      TraceRecorder::instance()->Record(name_, "ticket", start_, TraceRecorder::Now(), detail_);
+      TraceRecorder::SetCurrentTicket(previous_);
+    }
+  }
+
+  TraceTicketScope(const TraceTicketScope &) = delete;
+  TraceTicketScope &operator=(const TraceTicketScope &) = delete;
+
+ private:
+  const char *name_;   // 事件名称
+  uint64_t previous_;  // 外层票据 ID
+  int64_t start_;      // 开始时间，未启用时为 -1
+  QString detail_;     // 附加详情
+};
+
+}  // namespace olive
+
+#endif  // TRACERECORDER_H
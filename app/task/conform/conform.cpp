@@ -9,7 +9,8 @@ ConformTask::ConformTask(QString decoder_id, const Decoder::CodecStream &stream,
     : decoder_id_(std::move(decoder_id)),
       stream_(stream),
       params_(std::move(params)),
-      output_filenames_(output_filenames) {
+      output_filenames_(output_filenames),
+      ready_bytes_(0) {
   SetTitle(tr("Conforming Audio %1:%2").arg(stream.filename(), QString::number(stream.stream())));
 }
 
@@ -25,7 +26,7 @@ bool ConformTask::Run() {
 
   qDebug() << "Starting conform of" << stream_.filename() << stream_.stream();
 
-  bool ret = decoder->ConformAudio(output_filenames_, params_, GetCancelAtom());
+  bool ret = decoder->ConformAudio(output_filenames_, params_, GetCancelAtom(), &ready_bytes_);
 
   decoder->Close();
 
@@ -1,6 +1,8 @@
 #ifndef CONFORMTASK_H
 #define CONFORMTASK_H
 
+#include <atomic>  // 已经可以读取的字节数
+
 #include "codec/decoder.h"
 #include "node/project/footage/footage.h"
 #include "task/task.h"
@@ -27,6 +29,13 @@ class ConformTask : public Task {
   ConformTask(QString decoder_id, const Decoder::CodecStream &stream, AudioParams params,
               const QVector<QString> &output_filenames);
 
+  /**
+   * @brief 输出文件中 (每个通道) 已经写入、可以读取的字节数。适配从文件开头顺序写入，所以低于此值的数据都是完整的。
+   *
+   * 此函数是线程安全的。
+   */
+  [[nodiscard]] qint64 ready_bytes() const { return ready_bytes_; }
+
  protected:
   /**
    * @brief 执行整合任务的核心逻辑。
@@ -45,6 +54,8 @@ class ConformTask : public Task {
   AudioParams params_;  ///< @brief 存储音频参数，用于配置输出音频的格式和特性。
 
   QVector<QString> output_filenames_;  ///< @brief 存储输出文件的名称列表。整合后的结果将写入这些文件。
+
+  std::atomic<qint64> ready_bytes_;  ///< @brief 已经可以读取的字节数，见 ready_bytes()。
 };
 
 }  // namespace olive
@@ -139,9 +139,36 @@ bool ExportTask::Run() {
     subtitle_range = export_range_;
   }
 
+  // Frames and audio are written on a dedicated encoder thread so rendering can continue while
+  // libavcodec encodes. Render() only feeds the reorder buffer.
+  render_finished_ = false;
+  encoder_failed_ = false;
+  buffered_bytes_ = 0;
+  stats_ = PipelineStatistics();
+  stall_timer_.invalidate();
+  pipeline_timer_.start();
+
+  encoder_pool_.setMaxThreadCount(1);
+  QFuture<bool> encoder_future =
+#if QT_VERSION_MAJOR >= 6
+      QtConcurrent::run(&encoder_pool_, &ExportTask::EncodeLoop, this);
+#else
+      QtConcurrent::run(&encoder_pool_, this, &ExportTask::EncodeLoop);
+#endif
+
   Render(color_manager_, video_range, audio_range, subtitle_range, RenderMode::kOnline, nullptr, video_force_size,
          video_force_matrix, encoder_->GetDesiredPixelFormat(), VideoParams::kRGBAChannelCount, color_processor_);
 
+  {
+    QMutexLocker locker(&pipeline_mutex_);
+    render_finished_ = true;
+    pipeline_wait_.wakeAll();
+  }
+
+  encoder_future.waitForFinished();
+
+  LogPipelineStatistics();
+
   bool success = true;
 
   encoder_->Close();
@@ -177,43 +204,48 @@ bool ExportTask::Run() {
 bool ExportTask::FrameDownloaded(FramePtr f, const rational &time) {
   rational actual_time = time - export_range_.in();
 
-  time_map_.insert(actual_time, f);
+  QMutexLocker locker(&pipeline_mutex_);
 
-  while (!IsCancelled()) {
-    rational real_time = Timecode::timestamp_to_time(frame_time_, video_params().frame_rate_as_time_base());
+  if (encoder_failed_) {
+    return false;
+  }
 
-    if (!time_map_.contains(real_time)) {
-      break;
-    }
+  qint64 frame_bytes = f ? f->allocated_size() : 0;
+  qint64 buffered = (buffered_bytes_ += frame_bytes);
 
-    // Unfortunately this can't be done in another thread since the frames need to be sent
-    // one after the other chronologically.
-    if (!encoder_->WriteFrame(time_map_.take(real_time), real_time)) {
-      SetError(encoder_->GetError());
-      return false;
-    }
+  time_map_.insert(actual_time, f);
 
-    frame_time_++;
-    emit ProgressChanged(double(frame_time_) / double(GetTotalNumberOfFrames()));
+  stats_.frames_rendered++;
+  stats_.peak_buffered_frames = std::max(stats_.peak_buffered_frames, int(time_map_.size()));
+  stats_.peak_buffered_bytes = std::max(stats_.peak_buffered_bytes, buffered);
+
+  if (buffered >= kReorderBufferCapacity && !stall_timer_.isValid()) {
+    // Render() will stop starting tickets until the encoder catches up
+    stall_timer_.start();
   }
 
+  pipeline_wait_.wakeOne();
+
   return true;
 }
 
 bool ExportTask::AudioDownloaded(const TimeRange &range, const SampleBuffer &samples) {
   TimeRange adjusted_range = range - export_range_.in();
 
-  if (adjusted_range.in() == audio_time_) {
-    if (!WriteAudioLoop(adjusted_range, samples)) {
-      return false;
-    }
-  } else {
-    audio_map_.insert(adjusted_range, samples);
+  QMutexLocker locker(&pipeline_mutex_);
+
+  if (encoder_failed_) {
+    return false;
   }
 
+  audio_map_.insert(adjusted_range, samples);
+  pipeline_wait_.wakeOne();
+
   return true;
 }
 
+bool ExportTask::IsFrameBufferFull() const { return buffered_bytes_ >= kReorderBufferCapacity; }
+
 bool ExportTask::EncodeSubtitle(const SubtitleBlock *sub) {
   if (!subtitle_encoder_->WriteSubtitle(sub)) {
     SetError(subtitle_encoder_->GetError());
@@ -223,7 +255,7 @@ bool ExportTask::EncodeSubtitle(const SubtitleBlock *sub) {
   }
 }
 
-bool ExportTask::WriteAudioLoop(const TimeRange &time, const SampleBuffer &samples) {
+bool ExportTask::WriteAudio(const TimeRange &time, const SampleBuffer &samples) {
   if (!encoder_->WriteAudio(samples)) {
     SetError(encoder_->GetError());
     return false;
@@ -231,25 +263,121 @@ bool ExportTask::WriteAudioLoop(const TimeRange &time, const SampleBuffer &sampl
 
   audio_time_ = time.out();
 
-  for (auto it = audio_map_.begin(); it != audio_map_.end(); it++) {
-    const TimeRange &t = it.key();
-    SampleBuffer s = it.value();
+  return true;
+}
 
-    if (t.in() == audio_time_) {
-      // Erase from audio map since we're just about to write it
-      audio_map_.erase(it);
+bool ExportTask::EncodeLoop() {
+  QMutexLocker locker(&pipeline_mutex_);
+
+  while (!IsCancelled()) {
+    rational real_time = Timecode::timestamp_to_time(frame_time_, video_params().frame_rate_as_time_base());
+    bool have_frame = time_map_.contains(real_time);
 
-      // Call recursively to write the next sample buffer
-      if (!WriteAudioLoop(t, s)) {
-        return false;
+    auto audio_it = audio_map_.begin();
+    while (audio_it != audio_map_.end() && audio_it.key().in() != audio_time_) {
+      audio_it++;
+    }
+    bool have_audio = audio_it != audio_map_.end();
+
+    if (!have_frame && !have_audio) {
+      if (render_finished_) {
+        break;
       }
 
-      // Break out of loop
-      break;
+      // Nothing in order to write yet, wait for the renderer
+      QElapsedTimer starved;
+      starved.start();
+      pipeline_wait_.wait(&pipeline_mutex_);
+      stats_.encoder_starved_ms += starved.elapsed();
+      continue;
+    }
+
+    // Interleave streams by writing whichever one is further behind
+    bool write_audio = have_audio && (!have_frame || audio_time_ <= real_time);
+
+    QElapsedTimer busy;
+    bool ok;
+
+    if (write_audio) {
+      TimeRange range = audio_it.key();
+      SampleBuffer samples = audio_it.value();
+      audio_map_.erase(audio_it);
+
+      locker.unlock();
+
+      busy.start();
+      ok = WriteAudio(range, samples);
+
+      locker.relock();
+
+      stats_.audio_buffers_encoded++;
+    } else {
+      FramePtr frame = time_map_.take(real_time);
+      qint64 frame_bytes = frame ? frame->allocated_size() : 0;
+
+      locker.unlock();
+
+      busy.start();
+      ok = encoder_->WriteFrame(frame, real_time);
+      if (!ok) {
+        SetError(encoder_->GetError());
+      }
+
+      // Release backpressure once we drop below capacity. Must be done unlocked since the render
+      // loop calls IsFrameBufferFull() while holding its own lock.
+      qint64 before = buffered_bytes_.fetch_sub(frame_bytes);
+      if (before >= kReorderBufferCapacity && before - frame_bytes < kReorderBufferCapacity) {
+        WakeRenderLoop();
+      }
+
+      locker.relock();
+
+      if (stall_timer_.isValid() && buffered_bytes_ < kReorderBufferCapacity) {
+        stats_.render_stalled_ms += stall_timer_.elapsed();
+        stall_timer_.invalidate();
+      }
+
+      stats_.frames_encoded++;
+      frame_time_++;
+      emit ProgressChanged(double(frame_time_) / double(GetTotalNumberOfFrames()));
+    }
+
+    stats_.encoder_busy_ms += busy.elapsed();
+
+    if (!ok) {
+      // Drop everything and let the render loop run into the failure on its next frame
+      encoder_failed_ = true;
+      time_map_.clear();
+      audio_map_.clear();
+      buffered_bytes_ = 0;
+
+      locker.unlock();
+      WakeRenderLoop();
+      return false;
     }
   }
 
   return true;
 }
 
+void ExportTask::LogPipelineStatistics() const {
+  double seconds = std::max(pipeline_timer_.elapsed(), qint64(1)) / 1000.0;
+  double encoder_seconds = std::max(stats_.encoder_busy_ms, qint64(1)) / 1000.0;
+
+  qInfo().noquote() << QStringLiteral("Export pipeline: %1 frames in %2s").arg(stats_.frames_encoded).arg(seconds);
+  qInfo().noquote() << QStringLiteral("  render:  %1 fps, stalled by backpressure for %2s")
+                           .arg(stats_.frames_rendered / seconds, 0, 'f', 2)
+                           .arg(stats_.render_stalled_ms / 1000.0);
+  qInfo().noquote() << QStringLiteral("  reorder: peak %1 frames (%2 MiB)")
+                           .arg(stats_.peak_buffered_frames)
+                           .arg(stats_.peak_buffered_bytes / (1024.0 * 1024.0), 0, 'f', 1);
+  qInfo().noquote() << QStringLiteral("  encode:  %1 fps while busy, %2 audio buffers, starved for %3s")
+                           .arg(stats_.frames_encoded / encoder_seconds, 0, 'f', 2)
+                           .arg(stats_.audio_buffers_encoded)
+                           .arg(stats_.encoder_starved_ms / 1000.0);
+  qInfo().noquote() << QStringLiteral("  bottleneck: %1")
+                           .arg(stats_.encoder_starved_ms > stats_.render_stalled_ms ? QStringLiteral("render")
+                                                                                      : QStringLiteral("encode"));
+}
+
 }  // namespace olive
@@ -1,6 +1,11 @@
 #ifndef EXPORTTASK_H  // 防止头文件被重复包含的预处理器指令
 #define EXPORTTASK_H  // 定义 EXPORTTASK_H 宏
 
+#include <QElapsedTimer>   // Qt 计时器，用于统计各阶段耗时
+#include <QThreadPool>     // Qt 线程池，用于运行编码线程
+#include <QWaitCondition>  // Qt 条件变量
+#include <atomic>          // 原子变量
+
 #include "codec/encoder.h"              // 包含了编码器相关的定义
 #include "node/output/viewer/viewer.h"  // 包含了查看器输出节点相关的定义
 #include "render/colorprocessor.h"      // 包含了色彩处理器相关的定义
@@ -75,19 +80,73 @@ class ExportTask : public RenderTask {
    */
   [[nodiscard]] bool TwoStepFrameRendering() const override { return false; }
 
+  /**
+   * @brief 当重排序缓冲区中等待编码的帧超过内存上限时返回 true，使渲染暂停提交新帧。
+   */
+  [[nodiscard]] bool IsFrameBufferFull() const override;
+
  private:
   /**
-   * @brief 循环写入音频数据块。
+   * @brief 将一个音频数据块写入编码器 (在编码线程中调用)。
    *
-   * 这是一个内部辅助函数，用于处理和编码音频样本，确保音频数据按正确的顺序和时间写入。
+   * 调用者需保证 time.in() 等于当前的 `audio_time_`，以确保音频按正确的顺序写入。
    * @param time 当前音频块的时间范围。
    * @param samples 包含要写入的音频样本的 SampleBuffer。
    * @return 如果音频写入和编码成功，则返回 true；否则返回 false。
    */
-  bool WriteAudioLoop(const TimeRange &time, const SampleBuffer &samples);
+  bool WriteAudio(const TimeRange &time, const SampleBuffer &samples);
+
+  /**
+   * @brief 编码线程的主循环。
+   *
+   * 按时间顺序从重排序缓冲区 (`time_map_`) 取出视频帧，并与 `audio_map_` 中连续的音频交错写入编码器，
+   * 直到渲染结束且缓冲区清空，或者发生错误/取消。
+   * @return 如果所有数据都成功写入，则返回 true。
+   */
+  bool EncodeLoop();
+
+  /**
+   * @brief 在编码线程退出后输出各阶段的吞吐量统计，用于判断瓶颈所在。
+   */
+  void LogPipelineStatistics() const;
+
+  // 重排序缓冲区中等待编码的帧所允许占用的最大内存 (字节)
+  static constexpr qint64 kReorderBufferCapacity = 1024LL * 1024LL * 1024LL;
+
+  /**
+   * @brief 导出流水线各阶段的计数器 (渲染 -> 重排序缓冲区 -> 编码)。
+   */
+  struct PipelineStatistics {
+    int64_t frames_rendered = 0;        ///< 渲染阶段交付的帧数
+    int64_t frames_encoded = 0;         ///< 编码阶段写入的帧数
+    int64_t audio_buffers_encoded = 0;  ///< 编码阶段写入的音频块数
+    int peak_buffered_frames = 0;       ///< 重排序缓冲区中同时等待的最大帧数
+    qint64 peak_buffered_bytes = 0;     ///< 重排序缓冲区的最大内存占用
+    qint64 render_stalled_ms = 0;       ///< 渲染因缓冲区已满 (背压) 而暂停的总时间
+    qint64 encoder_busy_ms = 0;         ///< 编码线程实际写入数据的总时间
+    qint64 encoder_starved_ms = 0;      ///< 编码线程等待下一帧的总时间
+  };
 
   ProjectCopier *copier_;  ///< @brief 指向 ProjectCopier 对象的指针，可能用于在导出前复制项目相关数据。
 
+  QMutex pipeline_mutex_;  ///< @brief 保护 `time_map_`、`audio_map_`、统计数据和流水线状态。
+
+  QWaitCondition pipeline_wait_;  ///< @brief 有新的帧/音频或流水线结束时唤醒编码线程。
+
+  QThreadPool encoder_pool_;  ///< @brief 运行编码线程的单线程线程池。
+
+  bool render_finished_{};  ///< @brief 渲染阶段已结束，编码线程应在清空缓冲区后退出。
+
+  bool encoder_failed_{};  ///< @brief 编码线程写入失败，渲染应尽快停止。
+
+  std::atomic<qint64> buffered_bytes_{0};  ///< @brief 重排序缓冲区当前占用的内存 (字节)，无锁读取。
+
+  QElapsedTimer stall_timer_;  ///< @brief 记录缓冲区变满的时刻，用于统计背压时间。
+
+  QElapsedTimer pipeline_timer_;  ///< @brief 整个流水线的运行时间。
+
+  PipelineStatistics stats_;  ///< @brief 各阶段的吞吐量计数器。
+
   QHash<rational, FramePtr> time_map_;  ///< @brief 用于存储已渲染视频帧的哈希表，键为帧的时间戳，值为帧数据。
 
   QHash<TimeRange, SampleBuffer>
@@ -49,14 +49,30 @@ bool RenderTask::Render(ColorManager *manager, const TimeRangeList &video_range,
   // Start a render of a limited amount, and then render one frame for each frame that gets
   // finished. This prevents rendered frames from stacking up in memory indefinitely while the
   // encoder is processing them. The amount is kind of arbitrary, but we use the thread count so
-  // each of the system's threads are utilized as memory allows.
-  const int maximum_rendered_frames = QThread::idealThreadCount();
+  // each of the system's threads are utilized as memory allows, and never fewer than it takes to
+  // keep every video render thread busy.
+  const int maximum_rendered_frames =
+      std::max(QThread::idealThreadCount(), RenderManager::instance()->GetMaximumFramesInFlight());
 
   rational next_frame;
-  for (int i = 0; i < maximum_rendered_frames && iterator.GetNext(&next_frame); i++) {
-    StartTicket(&watcher_thread, manager, next_frame, mode, cache, force_size, force_matrix, force_format,
-                force_channel_count, force_color_output);
-  }
+  int frames_in_flight = 0;
+  bool frames_remaining = true;
+
+  // Starts as many frames as the in-flight limit and the subclass's downstream buffer allow
+  auto start_frames = [&] {
+    while (frames_remaining && frames_in_flight < maximum_rendered_frames && !IsFrameBufferFull()) {
+      if (!iterator.GetNext(&next_frame)) {
+        frames_remaining = false;
+        break;
+      }
+
+      StartTicket(&watcher_thread, manager, next_frame, mode, cache, force_size, force_matrix, force_format,
+                  force_channel_count, force_color_output);
+      frames_in_flight++;
+    }
+  };
+
+  start_frames();
 
   bool result = true;
 
@@ -163,10 +179,7 @@ bool RenderTask::Render(ColorManager *manager, const TimeRangeList &video_range,
           emit ProgressChanged(progress_counter / total_length);
         }
 
-        if (iterator.GetNext(&next_frame)) {
-          StartTicket(&watcher_thread, manager, next_frame, mode, cache, force_size, force_matrix, force_format,
-                      force_channel_count, force_color_output);
-        }
+        frames_in_flight--;
       }
 
       delete watcher;
@@ -179,9 +192,24 @@ bool RenderTask::Render(ColorManager *manager, const TimeRangeList &video_range,
       break;
     }
 
+    // Replace the frames that just finished
+    finished_watcher_mutex_.unlock();
+    start_frames();
+    finished_watcher_mutex_.lock();
+
+    if (!finished_watchers_.empty()) {
+      continue;
+    }
+
     // Run out of finished watchers. If we still have running tickets, wait for the next one to finish.
     if (running_tickets_ > 0) {
       finished_watcher_wait_cond_.wait(&finished_watcher_mutex_);
+    } else if (frames_remaining && frames_in_flight < maximum_rendered_frames) {
+      // Nothing is rendering because the downstream buffer is full. It's checked again while
+      // locked so a WakeRenderLoop() between start_frames() and here isn't missed.
+      if (IsFrameBufferFull()) {
+        finished_watcher_wait_cond_.wait(&finished_watcher_mutex_);
+      }
     } else {
       // No more running tickets or finished tickets, wem ust be
       break;
@@ -145,12 +145,29 @@ class RenderTask : public Task {
    * 此方法重写自基类 Task 的 CancelEvent 方法。当任务接收到取消请求时，
    * 此函数会被调用。它负责唤醒所有可能因等待条件而阻塞的线程。
    */
-  void CancelEvent() override {
+  void CancelEvent() override { WakeRenderLoop(); }
+
+  /**
+   * @brief 唤醒正在 Render() 中等待的渲染循环。
+   *
+   * 派生类在下游缓冲区腾出空间后 (见 IsFrameBufferFull()) 应调用此函数，使渲染循环继续提交新的帧。
+   * 调用时不得持有任何会在 IsFrameBufferFull() 中加锁的互斥锁。
+   */
+  void WakeRenderLoop() {
     finished_watcher_mutex_.lock();         // 加锁以保护共享的等待条件
     finished_watcher_wait_cond_.wakeAll();  // 唤醒所有等待此条件的线程
     finished_watcher_mutex_.unlock();       // 解锁
   }
 
+  /**
+   * @brief （虚方法）指示下游 (例如编码器的重排序缓冲区) 是否已满。
+   *
+   * 返回 true 时 Render() 会暂停提交新的帧 (背压)，直到派生类调用 WakeRenderLoop()。
+   * 此函数会在持有内部互斥锁时被调用，因此不应加锁或阻塞。默认返回 false。
+   * @return 如果暂时不应再提交新帧，则返回 true。
+   */
+  [[nodiscard]] virtual bool IsFrameBufferFull() const { return false; }
+
   /**
    * @brief （虚方法）指示此渲染任务是否采用两步帧渲染流程。
    *
@@ -7,7 +7,7 @@ namespace olive {
 
 TaskManager* TaskManager::instance_ = nullptr;
 
-TaskManager::TaskManager() { thread_pool_.setMaxThreadCount(1); }
+TaskManager::TaskManager() : priority_(0) { thread_pool_.setMaxThreadCount(1); }
 
 TaskManager::~TaskManager() {
   thread_pool_.clear();
@@ -18,6 +18,9 @@ TaskManager::~TaskManager() {
 
   thread_pool_.waitForDone();
 
+  // Includes the runners clear() took off the queue, which the pool doesn't delete since we own them
+  qDeleteAll(runners_);
+
   foreach (Task* t, tasks_) {
     t->deleteLater();
   }
@@ -55,13 +58,10 @@ void TaskManager::AddTask(Task* t) {
   tasks_.insert(watcher, t);
 
   // Run task concurrently
-  watcher->setFuture(
-#if QT_VERSION_MAJOR >= 6
-      QtConcurrent::run(&thread_pool_, &Task::Start, t)
-#else
-      QtConcurrent::run(&thread_pool_, t, &Task::Start)
-#endif
-  );
+  auto* runner = new Runner(t);
+  runners_.insert(t, runner);
+  watcher->setFuture(runner->future());
+  thread_pool_.start(runner);
 
   // Emit signal that a Task was added
   emit TaskAdded(t);
@@ -78,11 +78,21 @@ void TaskManager::CancelTask(Task* t) {
   }
 }
 
+void TaskManager::Prioritize(Task* t) {
+  Runner* r = runners_.value(t);
+
+  // tryTake() only succeeds if the runner hasn't been started yet, in which case we own it again
+  if (r && thread_pool_.tryTake(r)) {
+    thread_pool_.start(r, ++priority_);
+  }
+}
+
 void TaskManager::TaskFinished() {
   auto* watcher = dynamic_cast<QFutureWatcher<bool>*>(sender());
   Task* t = tasks_.value(watcher);
 
   tasks_.remove(watcher);
+  delete runners_.take(t);
 
   if (watcher->result()) {
     // Task completed successfully
@@ -99,4 +109,18 @@ void TaskManager::TaskFinished() {
   emit TaskListChanged();
 }
 
+TaskManager::Runner::Runner(Task* t) : task_(t) {
+  // Owned by the TaskManager so Prioritize() never sees a runner the pool already deleted
+  setAutoDelete(false);
+
+  interface_.reportStarted();
+}
+
+void TaskManager::Runner::run() {
+  bool result = task_->Start();
+
+  interface_.reportResult(result);
+  interface_.reportFinished();
+}
+
 }  // namespace olive
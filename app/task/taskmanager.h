@@ -1,6 +1,7 @@
 #ifndef TASKMANAGER_H
 #define TASKMANAGER_H
 
+#include <QFutureInterface>  // 报告手动排队的任务的结果
 #include <QUndoCommand>  // 引入 QUndoCommand 类，用于撤销/重做操作，但在此文件中似乎未直接使用，可能是上下文依赖或未来用途
 #include <QVector>       // 引入 QVector 类，一种动态数组容器
 #include <QtConcurrent/QtConcurrent>  // 引入 QtConcurrent 模块，用于简化多线程编程
@@ -100,6 +101,14 @@ class TaskManager : public QObject {
    */
   void CancelTask(Task* t);
 
+  /**
+   * @brief 把一个还在排队的任务移到队列最前面
+   *
+   * 用于有人正在等待其结果的任务 (例如播放头处素材的音频适配)。如果任务已经开始或已经结束则不做任何事。
+   * @param t 要优先运行的任务指针。
+   */
+  void Prioritize(Task* t);
+
  signals:
   /**
    * @brief 当通过 AddTask() 添加任务时发出的信号
@@ -130,6 +139,25 @@ class TaskManager : public QObject {
   void TaskFailed(Task* t);
 
  private:
+  /**
+   * @brief 在线程池中运行一个 Task 并通过 QFuture 报告结果
+   *
+   * 代替 QtConcurrent::run()，因为排队中的 QRunnable 可以用 QThreadPool::tryTake() 取出后以更高的优先级重新排队。
+   */
+  class Runner : public QRunnable {
+   public:
+    explicit Runner(Task* t);
+
+    void run() override;
+
+    QFuture<bool> future() { return interface_.future(); }
+
+   private:
+    Task* task_;
+
+    QFutureInterface<bool> interface_;
+  };
+
   /**
    * @brief 存储活动任务的哈希表
    *
@@ -150,6 +178,18 @@ class TaskManager : public QObject {
    */
   QThreadPool thread_pool_;
 
+  /**
+   * @brief 每个活动任务的 Runner，用于 Prioritize()
+   *
+   * Runner 由 TaskManager 持有 (不会被线程池自动删除)，在任务结束时 (TaskFinished()) 删除。
+   */
+  QHash<Task*, Runner*> runners_;
+
+  /**
+   * @brief Prioritize() 使用的线程池优先级，每次递增，使最近被请求的任务最先运行
+   */
+  int priority_;
+
   /**
    * @brief TaskManager 的静态单例实例指针
    */
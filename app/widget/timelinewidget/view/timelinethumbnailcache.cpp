@@ -0,0 +1,187 @@
+#include "timelinethumbnailcache.h"
+
+#include "render/framememorycache.h"
+
+namespace olive {
+
+// Around a thousand thumbnails at typical track heights, several screens' worth of scrolling
+const qint64 TimelineThumbnailCache::kMaximumBytes = 64 * 1024 * 1024;
+
+TimelineThumbnailCache::TimelineThumbnailCache() : used_bytes_(0), request_count_(0) {
+  // Loading is mostly disk bound, a couple of threads keep up with scrolling without competing with the renderers
+  pool_.setMaxThreadCount(2);
+}
+
+TimelineThumbnailCache::~TimelineThumbnailCache() {
+  pool_.clear();
+  pool_.waitForDone();
+}
+
+TimelineThumbnailCache *TimelineThumbnailCache::instance() {
+  static TimelineThumbnailCache cache;
+  return &cache;
+}
+
+QImage TimelineThumbnailCache::Get(const FrameHashCache *thumbs, const rational &time, int height) {
+  QString filename = thumbs->GetValidCacheFilename(time);
+
+  Key key;
+  if (filename.isEmpty() || height <= 0 || !FrameMemoryCache::ParseFilename(filename, &key.uuid, &key.timestamp)) {
+    return {};
+  }
+
+  ConnectCache(thumbs);
+
+  QMutexLocker locker(&mutex_);
+
+  QImage image;
+
+  auto it = map_.find(key);
+  if (it != map_.end()) {
+    // Move to front of LRU
+    lru_.splice(lru_.begin(), lru_, it.value());
+    image = it.value()->image;
+
+    if (image.height() == height) {
+      return image;
+    }
+  }
+
+  // Either not resident or scaled for a different track height, the caller draws whatever we have in the meantime.
+  // Thumbnails that couldn't be read aren't tried again until they're re-rendered.
+  if (!loading_.contains(key) && !failed_.contains(key)) {
+    loading_.insert(key);
+
+    int generation = generations_.value(key.uuid);
+    pool_.start([this, filename, key, height, generation] { Load(filename, key, height, generation); },
+                request_count_++);
+  }
+
+  return image;
+}
+
+void TimelineThumbnailCache::Clear() {
+  QMutexLocker locker(&mutex_);
+
+  lru_.clear();
+  map_.clear();
+  failed_.clear();
+  used_bytes_ = 0;
+
+  // Discard everything still loading, including loads from caches that have never been invalidated
+  for (const Key &k : qAsConst(loading_)) {
+    generations_.insert(k.uuid, generations_.value(k.uuid));
+  }
+  for (int &g : generations_) {
+    g++;
+  }
+}
+
+void TimelineThumbnailCache::Load(const QString &filename, const Key &key, int height, int generation) {
+  QImage image;
+
+  FramePtr frame = FrameHashCache::LoadCacheFrame(filename);
+  if (frame && static_cast<PixelFormat::Format>(frame->format()) == PixelFormat::U8) {
+    QImage::Format fmt = (frame->channel_count() == VideoParams::kRGBAChannelCount)
+                             ? QImage::Format_RGBA8888_Premultiplied
+                             : QImage::Format_RGB888;
+    QImage wrapper(reinterpret_cast<const uchar *>(frame->const_data()), frame->width(), frame->height(),
+                   frame->linesize_bytes(), fmt);
+
+    // Scaling always makes a deep copy, so the image doesn't reference the frame's memory afterwards
+    image = wrapper.scaledToHeight(height, Qt::SmoothTransformation);
+  }
+
+  QMutexLocker locker(&mutex_);
+
+  loading_.remove(key);
+
+  bool current = (generation == generations_.value(key.uuid));
+
+  if (image.isNull()) {
+    // Don't signal, otherwise the repaint would immediately request the broken thumbnail again. If the range was
+    // invalidated meanwhile the file may have been rewritten since, so leave it to the next request to find out.
+    if (current) {
+      failed_.insert(key);
+    }
+    return;
+  }
+
+  if (current) {
+    auto it = map_.find(key);
+    if (it != map_.end()) {
+      used_bytes_ -= it.value()->bytes;
+      lru_.erase(it.value());
+      map_.erase(it);
+    }
+
+    qint64 bytes = image.sizeInBytes();
+    lru_.push_front({key, image, bytes});
+    map_.insert(key, lru_.begin());
+    used_bytes_ += bytes;
+    Trim();
+  }
+
+  locker.unlock();
+
+  // If a thumbnail was invalidated while loading, this repaint requests the new one
+  emit Loaded();
+}
+
+void TimelineThumbnailCache::Trim() {
+  while (used_bytes_ > kMaximumBytes && !lru_.empty()) {
+    const Entry &e = lru_.back();
+    used_bytes_ -= e.bytes;
+    map_.remove(e.key);
+    lru_.pop_back();
+  }
+}
+
+void TimelineThumbnailCache::ConnectCache(const FrameHashCache *thumbs) {
+  if (connected_caches_.contains(thumbs)) {
+    return;
+  }
+
+  connected_caches_.insert(thumbs);
+  connect(thumbs, &PlaybackCache::Invalidated, this, &TimelineThumbnailCache::CacheInvalidated);
+  connect(thumbs, &QObject::destroyed, this, [this, thumbs] { connected_caches_.remove(thumbs); });
+}
+
+void TimelineThumbnailCache::CacheInvalidated(const TimeRange &range) {
+  auto *thumbs = dynamic_cast<FrameHashCache *>(sender());
+  if (!thumbs) {
+    return;
+  }
+
+  QMutexLocker locker(&mutex_);
+
+  QUuid uuid = thumbs->GetUuid();
+  auto in_range = [&](const Key &k) {
+    return k.uuid == uuid && range.Contains(Timecode::timestamp_to_time(k.timestamp, thumbs->GetTimebase()));
+  };
+
+  // Re-rendered thumbnails are written to the same file, so what we have in memory is stale
+  for (auto it = lru_.begin(); it != lru_.end();) {
+    if (in_range(it->key)) {
+      used_bytes_ -= it->bytes;
+      map_.remove(it->key);
+      it = lru_.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  // ...and a thumbnail that failed to load may well load now
+  for (auto it = failed_.begin(); it != failed_.end();) {
+    if (in_range(*it)) {
+      it = failed_.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  // Only loads from this cache are affected, the others' results are still valid
+  generations_[uuid]++;
+}
+
+}  // namespace olive
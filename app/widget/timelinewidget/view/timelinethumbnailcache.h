@@ -0,0 +1,125 @@
+#ifndef TIMELINETHUMBNAILCACHE_H
+#define TIMELINETHUMBNAILCACHE_H
+
+#include <QHash>        // 键到 LRU 节点的映射、每个缓存的失效计数
+#include <QImage>       // 解码并缩放后的缩略图
+#include <QMutex>       // 保护缓存
+#include <QObject>      // 信号
+#include <QSet>         // 正在加载和加载失败的键、已连接的缓存
+#include <QThreadPool>  // 后台加载线程
+#include <QUuid>        // 缓存 UUID
+#include <list>         // LRU 链表
+
+#include "render/framehashcache.h"
+
+namespace olive {
+
+/**
+ * @brief 时间轴上解码并缩放好的缩略图的内存缓存。
+ *
+ * 以 (ThumbnailCache UUID, 时间戳) 为键，保存已经缩放到轨道高度的 QImage，总大小超过 kMaximumBytes 时淘汰最久未使用的图像。
+ * 绘制时只使用已经在内存中的图像，不在的缩略图会交给后台线程从磁盘缓存读取、转换并缩放，完成后发出 Loaded()，
+ * 因此滚动时间轴时 GUI 线程不会读取磁盘或解码图像。最新的请求优先加载，这样当前可见的缩略图先出现。
+ *
+ * 轨道高度改变时，旧尺寸的图像在重新缩放完成之前仍会被返回 (由 QPainter 临时缩放)，避免缩略图闪烁。
+ * 无法读取的缩略图会被记住，直到它所在的范围失效 (重新渲染) 之前不会再次尝试加载。
+ *
+ * Get() 只能在 GUI 线程中调用。
+ */
+class TimelineThumbnailCache : public QObject {
+  Q_OBJECT
+ public:
+  /**
+   * @brief 获取全局唯一的缓存实例。
+   */
+  static TimelineThumbnailCache *instance();
+
+  /**
+   * @brief 获取指定时间的缩略图，如果它还不在内存中则在后台加载。
+   * @param thumbs 缩略图所在的缓存。
+   * @param time 缩略图的时间。
+   * @param height 期望的图像高度 (像素)。
+   * @return 如果缩略图不在内存中，则返回空图像。返回的图像高度可能与 height 不同。
+   */
+  QImage Get(const FrameHashCache *thumbs, const rational &time, int height);
+
+  /**
+   * @brief 清空内存中的所有缩略图，并忘记加载失败的缩略图。
+   */
+  void Clear();
+
+  static const qint64 kMaximumBytes;  // 所有缩略图占用的内存上限
+
+ signals:
+  /**
+   * @brief 一个缩略图加载完成时发出 (从后台线程发出)。
+   */
+  void Loaded();
+
+ private:
+  TimelineThumbnailCache();
+
+  ~TimelineThumbnailCache() override;
+
+  struct Key {
+    QUuid uuid;
+    int64_t timestamp;
+
+    bool operator==(const Key &rhs) const { return uuid == rhs.uuid && timestamp == rhs.timestamp; }
+
+    friend uint qHash(const Key &key, uint seed = 0) { return ::qHash(key.uuid, seed) ^ ::qHash(key.timestamp, seed); }
+  };
+
+  struct Entry {
+    Key key;
+    QImage image;
+    qint64 bytes;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  /**
+   * @brief 在后台线程中读取、转换并缩放缩略图。
+   */
+  void Load(const QString &filename, const Key &key, int height, int generation);
+
+  /**
+   * @brief 淘汰最久未使用的图像直到总大小不超过预算。调用时必须持有 mutex_。
+   */
+  void Trim();
+
+  /**
+   * @brief 开始监听缩略图缓存的失效信号 (每个缓存只连接一次)。
+   */
+  void ConnectCache(const FrameHashCache *thumbs);
+
+  QMutex mutex_;  // 保护 lru_、map_、loading_、failed_、used_bytes_、request_count_ 和 generations_
+
+  EntryList lru_;  // 最近使用的图像在前
+
+  QHash<Key, EntryList::iterator> map_;  // 键到 LRU 节点的映射
+
+  QSet<Key> loading_;  // 已经交给后台线程的键
+
+  QSet<Key> failed_;  // 无法读取的键，在所在范围失效之前不再尝试加载
+
+  qint64 used_bytes_;  // 当前占用的字节数
+
+  int request_count_;  // 请求计数，用作线程池优先级，使最新的请求先执行
+
+  QHash<QUuid, int> generations_;  // 每个缓存有缩略图失效时递增，失效前开始的该缓存的加载结果会被丢弃
+
+  QSet<const FrameHashCache *> connected_caches_;  // 已连接失效信号的缓存 (仅在 GUI 线程中访问)
+
+  QThreadPool pool_;  // 加载缩略图的线程池
+
+ private slots:
+  /**
+   * @brief 缩略图缓存的某个范围失效时，丢弃其中已在内存中的图像 (重新渲染后文件名不变)。
+   */
+  void CacheInvalidated(const TimeRange &range);
+};
+
+}  // namespace olive
+
+#endif  // TIMELINETHUMBNAILCACHE_H
@@ -6,6 +6,7 @@
 #include <QPen>
 #include <QScrollBar>
 #include <QtMath>
+#include <algorithm>
 
 #include "common/qtutils.h"
 #include "config/config.h"
@@ -14,6 +15,7 @@
 #include "panel/timeline/timeline.h"
 #include "ui/colorcoding.h"
 #include "widget/timelinewidget/timelinewidget.h"
+#include "widget/timelinewidget/view/timelinethumbnailcache.h"
 
 namespace olive {
 
@@ -25,6 +27,7 @@ TimelineView::TimelineView(Qt::Alignment vertical_alignment, QWidget *parent)
       ghosts_(nullptr),
       show_beam_cursor_(false),
       connected_track_list_(nullptr),
+      track_offsets_valid_(false),
       transition_overlay_out_(nullptr),
       transition_overlay_in_(nullptr) {
   Q_ASSERT(vertical_alignment == Qt::AlignTop || vertical_alignment == Qt::AlignBottom);
@@ -36,6 +39,8 @@ TimelineView::TimelineView(Qt::Alignment vertical_alignment, QWidget *parent)
   viewport()->setMouseTracking(true);
 
   SetIsTimelineAxes(true);
+
+  connect(TimelineThumbnailCache::instance(), &TimelineThumbnailCache::Loaded, this, [this] { viewport()->update(); });
 }
 
 void TimelineView::mousePressEvent(QMouseEvent *event) {
@@ -328,12 +333,25 @@ void TimelineView::DrawBlocks(QPainter *painter, bool foreground) {
   rational start_time = SceneToTime(GetTimelineLeftBound());
   rational end_time = SceneToTime(GetTimelineRightBound());
 
-  foreach (Track *track, connected_track_list_->GetTracks()) {
+  // Only tracks that are at least partially on screen are drawn
+  QRectF visible = mapToScene(viewport()->rect()).boundingRect();
+  int first_track = SceneToTrack((alignment() & Qt::AlignTop) ? visible.top() : visible.bottom());
+  int last_track = SceneToTrack((alignment() & Qt::AlignTop) ? visible.bottom() : visible.top());
+
+  first_track = qMax(0, first_track);
+  last_track = qMin(connected_track_list_->GetTrackCount() - 1, last_track);
+
+  for (int i = first_track; i <= last_track; i++) {
+    Track *track = connected_track_list_->GetTrackAt(i);
+    if (!track) {
+      continue;
+    }
+
     // Get first visible block in this track
     Block *block = track->NearestBlockBeforeOrAt(start_time);
 
-    qreal track_top = GetTrackY(track->Index());
-    qreal track_height = GetTrackHeight(track->Index());
+    qreal track_top = GetTrackY(i);
+    qreal track_height = GetTrackHeight(i);
 
     while (block) {
       DrawBlock(painter, foreground, block, track_top, track_height);
@@ -640,15 +658,13 @@ qreal TimelineView::GetTimelineRightBound() const { return GetTimelineLeftBound(
 
 void TimelineView::DrawThumbnail(QPainter *painter, const FrameHashCache *thumbs, const rational &time, int x,
                                  const QRect &preview_rect, QRect *thumb_rect) {
-  QString thumbnail = thumbs->GetValidCacheFilename(time);
-
-  if (!thumbnail.isEmpty()) {
-    QImage img;
-    if (img.load(thumbnail, "jpg")) {
-      double scale = double(preview_rect.height()) / double(img.height());
-      *thumb_rect = QRect(x, preview_rect.top(), img.width() * scale, preview_rect.height());
-      painter->drawImage(*thumb_rect, img);
-    }
+  // Only draws what's already in memory, anything else is loaded in the background and triggers another repaint
+  QImage img = TimelineThumbnailCache::instance()->Get(thumbs, time, preview_rect.height());
+
+  if (!img.isNull()) {
+    double scale = double(preview_rect.height()) / double(img.height());
+    *thumb_rect = QRect(x, preview_rect.top(), img.width() * scale, preview_rect.height());
+    painter->drawImage(*thumb_rect, img);
   }
 }
 
@@ -657,17 +673,22 @@ int TimelineView::GetTrackY(int track_index) const {
     return 0;
   }
 
-  int y = 0;
+  UpdateTrackOffsets();
 
   if (alignment() & Qt::AlignBottom) {
     track_index++;
   }
 
-  for (int i = 0; i < track_index; i++) {
-    y += GetTrackHeight(i);
+  int track_count = track_offsets_.size() - 1;
+  int y;
 
-    // One px line between each track
-    y++;
+  if (track_index <= 0) {
+    y = 0;
+  } else if (track_index <= track_count) {
+    y = track_offsets_.at(track_index);
+  } else {
+    // Past the last track, assume more tracks of the same height as the last one (plus one px line between each)
+    y = track_offsets_.last() + (track_index - track_count) * (GetTrackHeight(track_count) + 1);
   }
 
   if (alignment() & Qt::AlignBottom) {
@@ -709,14 +730,15 @@ void TimelineView::SetScrollCoordinates(const QPoint &pt) {
 void TimelineView::ConnectTrackList(TrackList *list) {
   if (connected_track_list_) {
     disconnect(connected_track_list_, &TrackList::TrackListChanged, this, &TimelineView::TrackListChanged);
-    disconnect(connected_track_list_, &TrackList::TrackHeightChanged, this, &TimelineView::TrackListChanged);
+    disconnect(connected_track_list_, &TrackList::TrackHeightChanged, this, &TimelineView::TrackHeightChanged);
   }
 
   connected_track_list_ = list;
+  track_offsets_valid_ = false;
 
   if (connected_track_list_) {
     connect(connected_track_list_, &TrackList::TrackListChanged, this, &TimelineView::TrackListChanged);
-    connect(connected_track_list_, &TrackList::TrackHeightChanged, this, &TimelineView::TrackListChanged);
+    connect(connected_track_list_, &TrackList::TrackHeightChanged, this, &TimelineView::TrackHeightChanged);
   }
 }
 
@@ -769,20 +791,32 @@ void TimelineView::DisableRecordingOverlay() {
   viewport()->update();
 }
 
-int TimelineView::SceneToTrack(double y) {
-  int track = -1;
-  int heights = 0;
-
+int TimelineView::SceneToTrack(double y) const {
   if (alignment() & Qt::AlignBottom) {
     y = -y;
   }
 
-  do {
-    track++;
-    heights += GetTrackHeight(track);
-  } while (y > heights);
+  if (y < 0) {
+    return 0;
+  }
+
+  int track_count = 0;
+  int tracks_bottom = 0;
+
+  if (connected_track_list_) {
+    UpdateTrackOffsets();
 
-  return track;
+    track_count = track_offsets_.size() - 1;
+    tracks_bottom = track_offsets_.last();
+
+    if (y < tracks_bottom) {
+      // Each track owns the pixels from its top down to (and including) the line below it
+      return int(std::upper_bound(track_offsets_.cbegin() + 1, track_offsets_.cend(), y) - track_offsets_.cbegin()) - 1;
+    }
+  }
+
+  // Past the last track, assume more tracks of the same height as the last one
+  return track_count + int((y - tracks_bottom) / (GetTrackHeight(track_count) + 1));
 }
 
 Block *TimelineView::GetItemAtScenePos(const rational &time, int track_index) const {
@@ -790,11 +824,7 @@ Block *TimelineView::GetItemAtScenePos(const rational &time, int track_index) co
     Track *track = connected_track_list_->GetTrackAt(track_index);
 
     if (track) {
-      foreach (Block *b, track->Blocks()) {
-        if (b->in() <= time && b->out() > time) {
-          return b;
-        }
-      }
+      return track->VisibleBlockAtTime(time);
     }
   }
 
@@ -828,7 +858,43 @@ QVector<Block *> TimelineView::GetItemsAtSceneRect(const QRectF &rect) const {
   return list;
 }
 
+void TimelineView::UpdateTrackOffsets() const {
+  if (track_offsets_valid_) {
+    return;
+  }
+
+  int track_count = connected_track_list_->GetTrackCount();
+
+  track_offsets_.resize(track_count + 1);
+  track_offsets_[0] = 0;
+  for (int i = 0; i < track_count; i++) {
+    // One px line between each track
+    track_offsets_[i + 1] = track_offsets_.at(i) + GetTrackHeight(i) + 1;
+  }
+
+  track_offsets_valid_ = true;
+}
+
 void TimelineView::TrackListChanged() {
+  track_offsets_valid_ = false;
+
+  UpdateSceneRect();
+  viewport()->update();
+}
+
+void TimelineView::TrackHeightChanged(Track *track, int height) {
+  int index = track->Index();
+
+  if (track_offsets_valid_ && index >= 0 && index < track_offsets_.size() - 1) {
+    // Only the tracks below this one move
+    int difference = (height + 1) - (track_offsets_.at(index + 1) - track_offsets_.at(index));
+    for (int i = index + 1; i < track_offsets_.size(); i++) {
+      track_offsets_[i] += difference;
+    }
+  } else {
+    track_offsets_valid_ = false;
+  }
+
   UpdateSceneRect();
   viewport()->update();
 }
@@ -116,7 +116,7 @@ class TimelineView : public TimeBasedView {
    * @param y 场景中的 Y 坐标 (double)。
    * @return 对应的轨道索引 (int)，如果坐标不在任何轨道内，可能返回无效值。
    */
-  int SceneToTrack(double y);
+  [[nodiscard]] int SceneToTrack(double y) const;
 
   /**
    * @brief 获取在指定场景位置（时间和轨道索引）的 Block 项。
@@ -355,6 +355,11 @@ class TimelineView : public TimeBasedView {
   static void DrawThumbnail(QPainter *painter, const FrameHashCache *thumbs, const rational &time, int x,
                             const QRect &preview_rect, QRect *thumb_rect);
 
+  /**
+   * @brief 如果轨道偏移表已失效，则重新计算。
+   */
+  void UpdateTrackOffsets() const;
+
   QHash<Track::Reference, TimeRangeList> *selections_;  ///< 指向当前选择信息哈希表的指针。
 
   QVector<TimelineViewGhostItem *> *ghosts_;  ///< 指向当前幽灵项（拖动预览）列表的指针。
@@ -365,6 +370,13 @@ class TimelineView : public TimeBasedView {
 
   TrackList *connected_track_list_;  ///< 指向已连接的 TrackList 对象的指针。
 
+  /**
+   * @brief 轨道高度的前缀和：第 i 项为轨道 i 顶部到第一条轨道顶部的距离 (包括轨道之间 1 像素的分隔线)，共轨道数 + 1 项。
+   *  用于 O(1) 的 GetTrackY() 和 O(log n) 的 SceneToTrack()。
+   */
+  mutable QVector<int> track_offsets_;
+  mutable bool track_offsets_valid_;  ///< 轨道列表改变后置为 false，下次使用时重新计算 track_offsets_。
+
   ClipBlock *transition_overlay_out_;  ///< 指向用于转场叠加层显示的“出点侧”剪辑块的指针。
   ClipBlock *transition_overlay_in_;   ///< 指向用于转场叠加层显示的“入点侧”剪辑块的指针。
 
@@ -380,6 +392,11 @@ class TimelineView : public TimeBasedView {
    * 用于更新视图以反映轨道的更改。
    */
   void TrackListChanged();
+
+  /**
+   * @brief 当某个轨道的高度改变时调用，增量更新 track_offsets_ 并刷新视图。
+   */
+  void TrackHeightChanged(Track *track, int height);
 };
 
 }  // namespace olive
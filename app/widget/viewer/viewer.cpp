@@ -1067,7 +1067,7 @@ RenderTicketWatcher *ViewerWidget::RequestNextFrameForQueue(bool increment) {
 RenderTicketPtr ViewerWidget::GetFrame(const rational &t) {
   QString cache_fn = GetConnectedNode()->video_frame_cache()->GetValidCacheFilename(t);
 
-  if (!QFileInfo::exists(cache_fn)) {
+  if (!FrameHashCache::CacheFrameExists(cache_fn)) {
     // Frame hasn't been cached, start render job
     return GetSingleFrame(t);
   } else {
@@ -3,6 +3,8 @@
 #include <QActionGroup>
 #include <QDesktopServices>
 #include <QEvent>
+#include <QFileDialog>
+#include <QMessageBox>
 #include <QStyleFactory>
 
 #include "config/config.h"
@@ -12,6 +14,7 @@
 #include "dialog/task/task.h"
 #include "mainwindow.h"
 #include "panel/panelmanager.h"
+#include "render/tracerecorder.h"
 #include "tool/tool.h"
 #include "ui/style/style.h"
 #include "undo/undostack.h"
@@ -270,6 +273,14 @@ MainMenu::MainMenu(MainWindow* parent) : QMenuBar(parent) {
 
   tools_preferences_item_ = tools_menu_->AddItem("prefs", Core::instance(), &Core::DialogPreferencesShow, tr("Ctrl+,"));
 
+  tools_debug_menu_ = new Menu(tools_menu_);
+  tools_menu_->addMenu(tools_debug_menu_);
+
+  tools_trace_record_item_ = tools_debug_menu_->AddItem("recordtrace", &MainMenu::RecordRenderTraceTriggered);
+  tools_trace_record_item_->setCheckable(true);
+  tools_trace_export_item_ = tools_debug_menu_->AddItem("exporttrace", this, &MainMenu::ExportRenderTraceTriggered);
+  tools_trace_clear_item_ = tools_debug_menu_->AddItem("cleartrace", &MainMenu::ClearRenderTraceTriggered);
+
 #ifndef NDEBUG
   tools_magic_item_ = tools_menu_->AddItem("magic", Core::instance(), &Core::SetMagic);
   tools_magic_item_->setCheckable(true);
@@ -357,6 +368,9 @@ void MainMenu::ToolsMenuAboutToShow() {
 
   // Ensure snapping value is correct
   tools_snapping_item_->setChecked(Core::instance()->snapping());
+
+  // Tracing may also have been enabled from the command line
+  tools_trace_record_item_->setChecked(TraceRecorder::instance()->IsEnabled());
 }
 
 void MainMenu::PlaybackMenuAboutToShow() { playback_loop_item_->setChecked(OLIVE_CONFIG("Loop").toBool()); }
@@ -535,6 +549,26 @@ void MainMenu::SequenceCacheClearTriggered() {
   DiskCacheDialog::ClearDiskCache(Core::instance()->GetActiveProject()->cache_path(), Core::instance()->main_window());
 }
 
+void MainMenu::RecordRenderTraceTriggered(bool e) { TraceRecorder::instance()->SetEnabled(e); }
+
+void MainMenu::ExportRenderTraceTriggered() {
+  QString fn = QFileDialog::getSaveFileName(parentWidget(), tr("Export Render Trace"), QString(),
+                                            tr("Chrome Trace (*.json)"));
+  if (fn.isEmpty()) {
+    return;
+  }
+
+  if (!fn.endsWith(QStringLiteral(".json"), Qt::CaseInsensitive)) {
+    fn.append(QStringLiteral(".json"));
+  }
+
+  if (!TraceRecorder::instance()->ExportChromeTrace(fn)) {
+    QMessageBox::critical(parentWidget(), tr("Export Render Trace"), tr("Failed to write \"%1\".").arg(fn));
+  }
+}
+
+void MainMenu::ClearRenderTraceTriggered() { TraceRecorder::instance()->Clear(); }
+
 void MainMenu::HelpFeedbackTriggered() {
   QDesktopServices::openUrl(QStringLiteral("https://github.com/olive-editor/olive/issues"));
 }
@@ -634,6 +668,10 @@ void MainMenu::Retranslate() {
   tools_snapping_item_->setText(tr("Enable Snapping"));
   tools_preferences_item_->setText(tr("Preferences"));
   tools_add_item_menu_->setTitle(tr("Add Tool Item"));
+  tools_debug_menu_->setTitle(tr("Debug"));
+  tools_trace_record_item_->setText(tr("Record Render Trace"));
+  tools_trace_export_item_->setText(tr("Export Render Trace..."));
+  tools_trace_clear_item_->setText(tr("Clear Render Trace"));
 #ifndef NDEBUG
   tools_magic_item_->setText("Magic");
 #endif
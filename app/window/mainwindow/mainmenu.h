@@ -296,6 +296,19 @@ class MainMenu : public QMenuBar {
    */
   static void SequenceCacheClearTriggered();
 
+  /**
+   * @brief “记录渲染跟踪”操作触发的槽函数，启用或停止 TraceRecorder。
+   */
+  static void RecordRenderTraceTriggered(bool e);
+  /**
+   * @brief “导出渲染跟踪”操作触发的槽函数，将已记录的事件保存为 Chrome 跟踪 JSON。
+   */
+  void ExportRenderTraceTriggered();
+  /**
+   * @brief “清除渲染跟踪”操作触发的槽函数，丢弃已记录的事件，以便只导出之后的部分。
+   */
+  static void ClearRenderTraceTriggered();
+
   /**
    * @brief “帮助/反馈”操作触发的槽函数。
    */
@@ -399,6 +412,11 @@ class MainMenu : public QMenuBar {
   QAction* tools_preferences_item_;  ///< 工具 -> 首选项
   Menu* tools_add_item_menu_;        ///< 工具 -> 添加 子菜单
 
+  Menu* tools_debug_menu_;            ///< 工具 -> 调试 子菜单
+  QAction* tools_trace_record_item_;  ///< 工具 -> 调试 -> 记录渲染跟踪 (可勾选)
+  QAction* tools_trace_export_item_;  ///< 工具 -> 调试 -> 导出渲染跟踪
+  QAction* tools_trace_clear_item_;   ///< 工具 -> 调试 -> 清除渲染跟踪
+
 #ifndef NDEBUG                 // 仅在非调试（发布）模式下编译以下内容
   QAction* tools_magic_item_;  ///< 工具 -> 魔法棒 (可能是一个调试或特殊功能项)
 #endif
@@ -0,0 +1,263 @@
+#ifndef OLIVE_BENCHMARKUTIL_H
+#define OLIVE_BENCHMARKUTIL_H
+
+#include <QDateTime>      // 结果中的时间戳
+#include <QFile>          // 写入 JSON 结果
+#include <QFileInfo>      // 可执行文件名
+#include <QJsonArray>     // JSON 结果
+#include <QJsonDocument>  // JSON 结果
+#include <QJsonObject>    // JSON 结果
+#include <QSysInfo>       // 记录运行环境
+#include <algorithm>      // std::sort
+#include <chrono>         // 计时
+#include <cstdio>         // printf
+#include <cstdlib>        // atof, atoi
+#include <cstring>        // strcmp
+#include <list>           // 已注册的基准测试
+#include <map>            // 自定义计数
+#include <string>         // 名称和过滤器
+#include <vector>         // 每次采样的耗时
+
+namespace olive {
+
+/**
+ * @brief 一个简单的微基准测试运行器。
+ *
+ * 每个基准测试是一个接受 Benchmark::State 的函数，它先完成准备工作 (不计时)，
+ * 然后调用 State::Measure() 传入要计时的代码。运行器会自动选择每次采样的调用次数，
+ * 使单次采样持续足够长的时间，然后进行多次采样并报告每次调用耗时的最小值、中位数和平均值。
+ *
+ * 命令行参数:
+ *   --json <文件>      将结果以 JSON 格式写入文件，便于比较不同构建之间的性能
+ *   --filter <文本>    只运行名称中包含此文本的基准测试
+ *   --min-time <秒>    每个基准测试的最短总计时时间 (默认 0.5)
+ *   --samples <次数>   每个基准测试的采样次数 (默认 5)
+ */
+class Benchmark {
+ public:
+  /**
+   * @brief 每个基准测试的计时状态和结果。
+   */
+  class State {
+   public:
+    /**
+     * @brief 计时执行 fn。
+     * @param fn 要计时的代码，会被调用多次。
+     * @param items_per_call 每次调用处理的项目数 (用于计算吞吐量)。
+     * @param items_are_bytes 如果为 true，吞吐量以 MB/s 报告，否则以项目/秒报告。
+     */
+    template <typename F>
+    void Measure(F fn, int64_t items_per_call = 1, bool items_are_bytes = false) {
+      using clock = std::chrono::steady_clock;
+
+      items_per_call_ = items_per_call;
+      items_are_bytes_ = items_are_bytes;
+
+      // Warm up caches and lazily initialized state
+      fn();
+
+      // Find an iteration count that makes each sample last long enough for the clock to be accurate
+      double target_sample_sec = min_time_ / samples_;
+      int64_t iterations = 1;
+      while (true) {
+        auto start = clock::now();
+        for (int64_t i = 0; i < iterations; i++) {
+          fn();
+        }
+        double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+
+        if (elapsed >= target_sample_sec || iterations >= kMaximumIterations) {
+          break;
+        }
+
+        // Aim slightly past the target based on how long this attempt took
+        int64_t next = (elapsed > 0) ? int64_t(iterations * target_sample_sec * 1.2 / elapsed) : iterations * 10;
+        iterations = std::min(kMaximumIterations, std::max(iterations * 2, next));
+      }
+
+      iterations_ = iterations;
+      ns_per_call_.clear();
+      for (int s = 0; s < samples_; s++) {
+        auto start = clock::now();
+        for (int64_t i = 0; i < iterations; i++) {
+          fn();
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        ns_per_call_.push_back(elapsed / iterations);
+      }
+    }
+
+    /**
+     * @brief 记录一个额外的数值 (例如压缩率)，会被输出到结果中。
+     */
+    void SetCounter(const char *name, double value) { counters_[name] = value; }
+
+   private:
+    friend class Benchmark;
+
+    static constexpr int64_t kMaximumIterations = 1000000000;
+
+    double min_time_ = 0.5;                   // 总计时时间 (秒)
+    int samples_ = 5;                         // 采样次数
+    int64_t iterations_ = 0;                  // 每次采样的调用次数
+    int64_t items_per_call_ = 0;              // 每次调用处理的项目数
+    bool items_are_bytes_ = false;            // 项目是否为字节
+    std::vector<double> ns_per_call_;         // 每次采样中每次调用的平均耗时 (纳秒)
+    std::map<std::string, double> counters_;  // 自定义计数
+  };
+
+  using Function = void (*)(State &);
+
+  /**
+   * @brief 注册一个基准测试。名称通常为 "分组/名称" 的形式。
+   */
+  void add(const char *name, Function fn) { benchmarks_.push_back({name, fn}); }
+
+  /**
+   * @brief 运行所有 (匹配过滤器的) 基准测试，打印结果，并根据参数写入 JSON。
+   * @return 适合作为程序退出代码的值。
+   */
+  int exec(int argc, char **argv) {
+    const char *json_filename = nullptr;
+    std::string filter;
+    double min_time = 0.5;
+    int samples = 5;
+
+    for (int i = 1; i < argc; i++) {
+      bool has_value = (i + 1 < argc);
+      if (!strcmp(argv[i], "--json") && has_value) {
+        json_filename = argv[++i];
+      } else if (!strcmp(argv[i], "--filter") && has_value) {
+        filter = argv[++i];
+      } else if (!strcmp(argv[i], "--min-time") && has_value) {
+        min_time = atof(argv[++i]);
+      } else if (!strcmp(argv[i], "--samples") && has_value) {
+        samples = atoi(argv[++i]);
+      } else {
+        fprintf(stderr, "Usage: %s [--json file] [--filter text] [--min-time seconds] [--samples count]\n", argv[0]);
+        return 1;
+      }
+    }
+
+    if (min_time <= 0 || samples <= 0) {
+      fprintf(stderr, "--min-time and --samples must be positive\n");
+      return 1;
+    }
+
+    QJsonArray results;
+
+    printf("%-48s %14s %14s %14s %16s\n", "Benchmark", "Min (ns)", "Median (ns)", "Mean (ns)", "Throughput");
+
+    for (const Entry &e : benchmarks_) {
+      if (!filter.empty() && std::string(e.name).find(filter) == std::string::npos) {
+        continue;
+      }
+
+      State state;
+      state.min_time_ = min_time;
+      state.samples_ = samples;
+
+      e.function(state);
+
+      if (state.ns_per_call_.empty()) {
+        fprintf(stderr, "%s: benchmark never called Measure()\n", e.name);
+        return 1;
+      }
+
+      std::vector<double> sorted = state.ns_per_call_;
+      std::sort(sorted.begin(), sorted.end());
+
+      double min = sorted.front();
+      double median = sorted.at(sorted.size() / 2);
+      double mean = 0;
+      for (double d : sorted) {
+        mean += d;
+      }
+      mean /= sorted.size();
+
+      // Throughput is based on the median so that one noisy sample doesn't skew it
+      double items_per_second = state.items_per_call_ * 1e9 / median;
+
+      char throughput[32];
+      if (state.items_are_bytes_) {
+        snprintf(throughput, sizeof(throughput), "%.1f MB/s", items_per_second / 1048576.0);
+      } else {
+        snprintf(throughput, sizeof(throughput), "%.3g/s", items_per_second);
+      }
+
+      printf("%-48s %14.1f %14.1f %14.1f %16s\n", e.name, min, median, mean, throughput);
+      for (const auto &c : state.counters_) {
+        printf("    %s = %g\n", c.first.c_str(), c.second);
+      }
+
+      QJsonObject result;
+      result.insert(QStringLiteral("name"), QString::fromUtf8(e.name));
+      result.insert(QStringLiteral("iterations"), double(state.iterations_));
+      result.insert(QStringLiteral("samples"), int(sorted.size()));
+      result.insert(QStringLiteral("ns_per_call_min"), min);
+      result.insert(QStringLiteral("ns_per_call_median"), median);
+      result.insert(QStringLiteral("ns_per_call_mean"), mean);
+      result.insert(QStringLiteral("items_per_call"), double(state.items_per_call_));
+      result.insert(state.items_are_bytes_ ? QStringLiteral("bytes_per_second") : QStringLiteral("items_per_second"),
+                    items_per_second);
+
+      if (!state.counters_.empty()) {
+        QJsonObject counters;
+        for (const auto &c : state.counters_) {
+          counters.insert(QString::fromStdString(c.first), c.second);
+        }
+        result.insert(QStringLiteral("counters"), counters);
+      }
+
+      results.append(result);
+    }
+
+    if (json_filename) {
+      QJsonObject root;
+      root.insert(QStringLiteral("executable"), QFileInfo(QString::fromLocal8Bit(argv[0])).fileName());
+      root.insert(QStringLiteral("date"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+      root.insert(QStringLiteral("cpu_architecture"), QSysInfo::currentCpuArchitecture());
+      root.insert(QStringLiteral("os"), QSysInfo::prettyProductName());
+#ifdef NDEBUG
+      root.insert(QStringLiteral("build_type"), QStringLiteral("release"));
+#else
+      root.insert(QStringLiteral("build_type"), QStringLiteral("debug"));
+#endif
+      root.insert(QStringLiteral("min_time"), min_time);
+      root.insert(QStringLiteral("results"), results);
+
+      QFile f(QString::fromLocal8Bit(json_filename));
+      if (!f.open(QFile::WriteOnly) || f.write(QJsonDocument(root).toJson()) < 0) {
+        fprintf(stderr, "Failed to write %s\n", json_filename);
+        return 1;
+      }
+    }
+
+    return 0;
+  }
+
+  /**
+   * @brief 防止编译器把计算结果未被使用的代码优化掉。
+   */
+  template <typename T>
+  static void DoNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const volatile void *sink;
+    sink = &value;
+#endif
+  }
+
+ private:
+  struct Entry {
+    const char *name;
+    Function function;
+  };
+
+  std::list<Entry> benchmarks_;  // 已注册的基准测试
+};
+
+}  // namespace olive
+
+#endif  // OLIVE_BENCHMARKUTIL_H
@@ -0,0 +1,273 @@
+#include <olive/core/core.h>
+#include <vector>
+
+#include "benchmarkutil.h"
+
+using namespace olive::core;
+
+namespace olive {
+
+namespace {
+
+// Deterministic so that every run (and every build) measures exactly the same work
+class Random {
+ public:
+  explicit Random(uint32_t seed = 1) : state_(seed) {}
+
+  uint32_t next() {
+    state_ = state_ * 1664525u + 1013904223u;
+    return state_ >> 8;
+  }
+
+  int next(int max) { return int(next() % uint32_t(max)); }
+
+  float nextFloat(float scale) { return (float(next() & 0xFFFF) / 32768.0f - 1.0f) * scale; }
+
+ private:
+  uint32_t state_;
+};
+
+const int kRationalCount = 1024;
+const int kRangeCount = 1000;
+const int kSampleRate = 48000;
+
+std::vector<rational> CreateRationals() {
+  // A mix of the denominators that show up in practice: frame rates, sample rates, and NTSC
+  const int denominators[] = {24, 25, 30, 48000, 30000, 60000, 1001, 44100};
+
+  Random r;
+  std::vector<rational> v(kRationalCount);
+  for (rational &i : v) {
+    i = rational(r.next(100000) + 1, denominators[r.next(8)]);
+  }
+  return v;
+}
+
+SampleBuffer CreateSampleBuffer(float amplitude) {
+  SampleBuffer buf(AudioParams(kSampleRate, AV_CH_LAYOUT_STEREO, SampleFormat::F32P), size_t(kSampleRate));
+
+  Random r;
+  for (int c = 0; c < buf.audio_params().channel_count(); c++) {
+    for (size_t i = 0; i < buf.sample_count(); i++) {
+      buf.data(c)[i] = r.nextFloat(amplitude);
+    }
+  }
+
+  return buf;
+}
+
+int64_t SampleBufferItems(const SampleBuffer &buf) {
+  return int64_t(buf.sample_count()) * buf.audio_params().channel_count();
+}
+
+void RationalArithmetic(Benchmark::State &state) {
+  std::vector<rational> v = CreateRationals();
+
+  state.Measure(
+      [&v] {
+        rational sum;
+        for (int i = 0; i < kRationalCount - 1; i++) {
+          sum += v[i] * v[i + 1] - v[i] / v[i + 1];
+        }
+        Benchmark::DoNotOptimize(sum);
+      },
+      kRationalCount - 1);
+}
+
+void RationalCompare(Benchmark::State &state) {
+  std::vector<rational> v = CreateRationals();
+
+  state.Measure(
+      [&v] {
+        int less = 0;
+        for (int i = 0; i < kRationalCount - 1; i++) {
+          less += (v[i] < v[i + 1]);
+        }
+        Benchmark::DoNotOptimize(less);
+      },
+      kRationalCount - 1);
+}
+
+void RationalToDouble(Benchmark::State &state) {
+  std::vector<rational> v = CreateRationals();
+
+  state.Measure(
+      [&v] {
+        double sum = 0;
+        for (const rational &r : v) {
+          sum += r.toDouble();
+        }
+        Benchmark::DoNotOptimize(sum);
+      },
+      kRationalCount);
+}
+
+void TimeRangeListInsertContiguous(Benchmark::State &state) {
+  // Each new frame extends the last range, like the cacher validating frames in order
+  const rational frame(1, 24);
+
+  state.Measure(
+      [&frame] {
+        TimeRangeList list;
+        for (int i = 0; i < kRangeCount; i++) {
+          list.insert(TimeRange(frame * rational(i), frame * rational(i + 1)));
+        }
+        Benchmark::DoNotOptimize(list);
+      },
+      kRangeCount);
+}
+
+void TimeRangeListInsertScattered(Benchmark::State &state) {
+  const rational frame(1, 24);
+
+  Random r;
+  std::vector<TimeRange> ranges(kRangeCount);
+  for (TimeRange &range : ranges) {
+    int start = r.next(kRangeCount * 4);
+    range = TimeRange(frame * rational(start), frame * rational(start + 1 + r.next(4)));
+  }
+
+  state.Measure(
+      [&ranges] {
+        TimeRangeList list;
+        for (const TimeRange &range : ranges) {
+          list.insert(range);
+        }
+        Benchmark::DoNotOptimize(list);
+      },
+      kRangeCount);
+}
+
+void TimeRangeListRemove(Benchmark::State &state) {
+  // Punch holes into one long range, like invalidating scattered frames in a fully cached sequence
+  const rational frame(1, 24);
+
+  Random r;
+  std::vector<TimeRange> ranges(kRangeCount);
+  for (TimeRange &range : ranges) {
+    int start = r.next(kRangeCount * 4);
+    range = TimeRange(frame * rational(start), frame * rational(start + 1));
+  }
+
+  TimeRangeList full;
+  full.insert(TimeRange(rational(0), frame * rational(kRangeCount * 4)));
+
+  state.Measure(
+      [&ranges, &full] {
+        TimeRangeList list = full;
+        for (const TimeRange &range : ranges) {
+          list.remove(range);
+        }
+        Benchmark::DoNotOptimize(list);
+      },
+      kRangeCount);
+}
+
+void TimeRangeListFrameIteration(Benchmark::State &state) {
+  const rational timebase(1001, 30000);
+
+  // 100 one-second ranges with gaps between them
+  TimeRangeList list;
+  for (int i = 0; i < 100; i++) {
+    list.insert(TimeRange(rational(i * 2), rational(i * 2 + 1)));
+  }
+
+  int64_t frame_count = 0;
+  {
+    TimeRangeListFrameIterator it(list, timebase);
+    rational t;
+    while (it.GetNext(&t)) {
+      frame_count++;
+    }
+  }
+
+  state.Measure(
+      [&list, &timebase] {
+        TimeRangeListFrameIterator it(list, timebase);
+        rational t;
+        while (it.GetNext(&t)) {
+          Benchmark::DoNotOptimize(t);
+        }
+      },
+      frame_count);
+}
+
+void SampleBufferClamp(Benchmark::State &state) {
+  // Half of the samples are out of range
+  SampleBuffer buf = CreateSampleBuffer(2.0f);
+
+  state.Measure([&buf] { buf.clamp(); }, SampleBufferItems(buf));
+}
+
+void SampleBufferTransformVolume(Benchmark::State &state) {
+  SampleBuffer buf = CreateSampleBuffer(1.0f);
+
+  // Alternate so the values don't drift towards zero or infinity
+  bool up = false;
+  state.Measure(
+      [&buf, &up] {
+        buf.transform_volume(up ? 2.0f : 0.5f);
+        up = !up;
+      },
+      SampleBufferItems(buf));
+}
+
+void SampleBufferTransformVolumeEnvelope(Benchmark::State &state) {
+  SampleBuffer buf = CreateSampleBuffer(1.0f);
+
+  std::vector<float> up(buf.sample_count()), down(buf.sample_count());
+  for (size_t i = 0; i < up.size(); i++) {
+    up[i] = 1.0f + float(i) / float(up.size());
+    down[i] = 1.0f / up[i];
+  }
+
+  bool use_up = false;
+  state.Measure(
+      [&] {
+        buf.transform_volume(use_up ? up.data() : down.data());
+        use_up = !use_up;
+      },
+      SampleBufferItems(buf));
+}
+
+void SampleBufferReverse(Benchmark::State &state) {
+  SampleBuffer buf = CreateSampleBuffer(1.0f);
+
+  state.Measure([&buf] { buf.reverse(); }, SampleBufferItems(buf));
+}
+
+void SampleBufferSpeed(Benchmark::State &state) {
+  // speed() resizes the buffer, so each call works on a fresh copy (the copy is included in the time)
+  const SampleBuffer source = CreateSampleBuffer(1.0f);
+
+  state.Measure(
+      [&source] {
+        SampleBuffer buf = source;
+        buf.speed(1.5);
+        Benchmark::DoNotOptimize(buf);
+      },
+      SampleBufferItems(source));
+}
+
+}  // namespace
+
+}  // namespace olive
+
+int main(int argc, char **argv) {
+  olive::Benchmark b;
+
+  b.add("rational/arithmetic", olive::RationalArithmetic);
+  b.add("rational/compare", olive::RationalCompare);
+  b.add("rational/to_double", olive::RationalToDouble);
+  b.add("timerangelist/insert_contiguous", olive::TimeRangeListInsertContiguous);
+  b.add("timerangelist/insert_scattered", olive::TimeRangeListInsertScattered);
+  b.add("timerangelist/remove", olive::TimeRangeListRemove);
+  b.add("timerangelistframeiterator/iterate", olive::TimeRangeListFrameIteration);
+  b.add("samplebuffer/clamp", olive::SampleBufferClamp);
+  b.add("samplebuffer/transform_volume", olive::SampleBufferTransformVolume);
+  b.add("samplebuffer/transform_volume_envelope", olive::SampleBufferTransformVolumeEnvelope);
+  b.add("samplebuffer/reverse", olive::SampleBufferReverse);
+  b.add("samplebuffer/speed", olive::SampleBufferSpeed);
+
+  return b.exec(argc, argv);
+}
@@ -0,0 +1,339 @@
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "audio/audiovisualwaveform.h"
+#include "benchmarkutil.h"
+#include "codec/frame.h"
+#include "node/math/math/math.h"
+#include "node/project.h"
+#include "node/traverser.h"
+#include "render/framehashcache.h"
+
+namespace olive {
+
+namespace {
+
+const int kSampleRate = 48000;
+
+std::unique_ptr<QTemporaryDir> temp_dir;
+
+SampleBuffer CreateSampleBuffer(int seconds) {
+  SampleBuffer buf(AudioParams(kSampleRate, AV_CH_LAYOUT_STEREO, SampleFormat::F32P), size_t(kSampleRate * seconds));
+
+  for (int c = 0; c < buf.audio_params().channel_count(); c++) {
+    for (size_t i = 0; i < buf.sample_count(); i++) {
+      buf.data(c)[i] = std::sin(float(i) * 0.01f * float(c + 1)) * 0.8f;
+    }
+  }
+
+  return buf;
+}
+
+void WaveformOverwriteSamples(Benchmark::State &state) {
+  // Ten seconds of audio written to an empty waveform, like a freshly conformed clip
+  SampleBuffer buf = CreateSampleBuffer(10);
+
+  state.Measure(
+      [&buf] {
+        AudioVisualWaveform waveform;
+        waveform.set_channel_count(buf.audio_params().channel_count());
+        waveform.OverwriteSamples(buf, kSampleRate);
+        Benchmark::DoNotOptimize(waveform);
+      },
+      int64_t(buf.sample_count()));
+}
+
+void WaveformOverwriteSamplesHour(Benchmark::State &state) {
+  // An hour of stereo audio, written in ten second chunks the way rendered audio arrives. Generating the whole hour at
+  // once would need 1.3 GiB.
+  const int kChunkSeconds = 10;
+  const int kChunks = 3600 / kChunkSeconds;
+
+  SampleBuffer buf = CreateSampleBuffer(kChunkSeconds);
+
+  state.Measure(
+      [&buf] {
+        AudioVisualWaveform waveform;
+        waveform.set_channel_count(buf.audio_params().channel_count());
+        for (int i = 0; i < kChunks; i++) {
+          waveform.OverwriteSamples(buf, kSampleRate, rational(i * kChunkSeconds));
+        }
+        Benchmark::DoNotOptimize(waveform);
+      },
+      int64_t(buf.sample_count()) * kChunks);
+}
+
+void WaveformOverwriteSamplesInto(Benchmark::State &state) {
+  // One second of audio written into the middle of an existing ten second waveform, like a re-render after an edit
+  SampleBuffer full = CreateSampleBuffer(10);
+  SampleBuffer second = CreateSampleBuffer(1);
+
+  AudioVisualWaveform waveform;
+  waveform.set_channel_count(full.audio_params().channel_count());
+  waveform.OverwriteSamples(full, kSampleRate);
+
+  state.Measure([&] { waveform.OverwriteSamples(second, kSampleRate, rational(5)); }, int64_t(second.sample_count()));
+}
+
+/**
+ * @brief Measures NodeTraverser::GenerateTable on a graph of MathNodes.
+ *
+ * A fresh traverser is used for each call so that nothing is cached between calls.
+ */
+void MeasureTraversal(Benchmark::State &state, Node *output, int64_t node_count) {
+  const TimeRange range(rational(0), rational(1, 24));
+
+  state.Measure(
+      [output, &range] {
+        NodeTraverser traverser;
+        NodeValueTable table = traverser.GenerateTable(output, range);
+        Benchmark::DoNotOptimize(table);
+      },
+      node_count);
+}
+
+MathNode *CreateMathNode(Project *project) {
+  auto *n = new MathNode();
+  n->setParent(project);
+  return n;
+}
+
+void TraverserChain(Benchmark::State &state) {
+  // A long chain of effects, each consuming the previous one's output
+  const int kNodeCount = 64;
+
+  Project project;
+
+  MathNode *last = nullptr;
+  for (int i = 0; i < kNodeCount; i++) {
+    MathNode *n = CreateMathNode(&project);
+    if (last) {
+      Node::ConnectEdge(last, NodeInput(n, MathNode::kParamAIn));
+    }
+    last = n;
+  }
+
+  MeasureTraversal(state, last, kNodeCount);
+}
+
+MathNode *CreateMathTree(Project *project, int depth) {
+  MathNode *n = CreateMathNode(project);
+
+  if (depth > 1) {
+    Node::ConnectEdge(CreateMathTree(project, depth - 1), NodeInput(n, MathNode::kParamAIn));
+    Node::ConnectEdge(CreateMathTree(project, depth - 1), NodeInput(n, MathNode::kParamBIn));
+  }
+
+  return n;
+}
+
+void TraverserTree(Benchmark::State &state) {
+  // A balanced tree of 63 nodes, like many layers merged together
+  const int kDepth = 6;
+
+  Project project;
+
+  MeasureTraversal(state, CreateMathTree(&project, kDepth), (1 << kDepth) - 1);
+}
+
+void TraverserDiamond(Benchmark::State &state) {
+  // Every node reads the previous node twice. Without memoization the number of visits doubles with every level, so
+  // this shows how well shared upstream nodes are handled.
+  const int kNodeCount = 12;
+
+  Project project;
+
+  MathNode *last = nullptr;
+  for (int i = 0; i < kNodeCount; i++) {
+    MathNode *n = CreateMathNode(&project);
+    if (last) {
+      Node::ConnectEdge(last, NodeInput(n, MathNode::kParamAIn));
+      Node::ConnectEdge(last, NodeInput(n, MathNode::kParamBIn));
+    }
+    last = n;
+  }
+
+  MeasureTraversal(state, last, kNodeCount);
+}
+
+MathNode *CreateKeyframedMathNode(Project *project) {
+  // A minute of bezier animation with a keyframe every second, like a hand-animated parameter or volume automation
+  const int kKeyframeCount = 60;
+
+  MathNode *n = CreateMathNode(project);
+  n->SetInputIsKeyframing(MathNode::kParamAIn, true);
+
+  for (int i = 0; i < kKeyframeCount; i++) {
+    auto *key = new NodeKeyframe(rational(i), double(i % 2), NodeKeyframe::kBezier, 0, -1, MathNode::kParamAIn, n);
+    key->set_bezier_control_in(QPointF(-0.4, 0.0));
+    key->set_bezier_control_out(QPointF(0.4, 0.0));
+  }
+
+  return n;
+}
+
+void KeyframeValueAtTime(Benchmark::State &state) {
+  // One lookup per frame, the way the traverser reads a parameter
+  const int kFrameCount = 60 * 24;
+
+  Project project;
+  MathNode *n = CreateKeyframedMathNode(&project);
+
+  state.Measure(
+      [n] {
+        for (int i = 0; i < kFrameCount; i++) {
+          QVariant v = n->GetValueAtTime(MathNode::kParamAIn, rational(i, 24));
+          Benchmark::DoNotOptimize(v);
+        }
+      },
+      kFrameCount);
+}
+
+void KeyframeValuesAtTimes(Benchmark::State &state) {
+  // One value per sample for a second of audio in the middle of the animation
+  const size_t kSampleCount = kSampleRate;
+
+  Project project;
+  MathNode *n = CreateKeyframedMathNode(&project);
+  std::vector<float> values(kSampleCount);
+
+  state.Measure(
+      [n, &values] {
+        n->GetNumericValuesAtTimes(MathNode::kParamAIn, 30.0, 1.0 / kSampleRate, values.data(), values.size());
+        Benchmark::DoNotOptimize(values);
+      },
+      int64_t(kSampleCount));
+}
+
+FramePtr CreateTestFrame(PixelFormat::Format format) {
+  FramePtr frame = Frame::Create();
+  frame->set_video_params(VideoParams(1920, 1080, PixelFormat(format), VideoParams::kRGBAChannelCount, rational(1),
+                                      VideoParams::kInterlaceNone, 1));
+  frame->allocate();
+
+  // A smooth gradient with some grain, which compresses roughly like rendered footage does
+  uint32_t seed = 1;
+  for (int y = 0; y < frame->height(); y++) {
+    for (int x = 0; x < frame->width(); x++) {
+      seed = seed * 1664525u + 1013904223u;
+      float grain = float(seed >> 24) / 255.0f * 0.02f;
+
+      float r = float(x) / float(frame->width()) + grain;
+      float g = float(y) / float(frame->height()) + grain;
+      float b = 0.5f + 0.5f * std::sin(float(x + y) * 0.01f) + grain;
+
+      frame->set_pixel(x, y, Color(r, g, b, 1.0f));
+    }
+  }
+
+  return frame;
+}
+
+int64_t FramePayloadBytes(const FramePtr &frame) {
+  // Excludes row padding, which is what a consumer actually uses
+  return int64_t(frame->width()) * frame->height() * frame->video_params().GetBytesPerPixel();
+}
+
+/**
+ * @brief Measures FrameHashCache::SaveCacheFrame() for one pixel format and cache format.
+ *
+ * The frame is written straight to disk, bypassing FrameMemoryCache, so this is the cost paid by the background writer.
+ */
+template <PixelFormat::Format P, FrameHashCache::CacheFormat C>
+void CacheSave(Benchmark::State &state) {
+  FramePtr frame = CreateTestFrame(P);
+  QString fn = temp_dir->filePath(QStringLiteral("save"));
+
+  state.Measure([&] { FrameHashCache::SaveCacheFrame(fn, frame, C); }, FramePayloadBytes(frame), true);
+
+  state.SetCounter("size_percent", 100.0 * QFileInfo(fn).size() / FramePayloadBytes(frame));
+}
+
+/**
+ * @brief Measures FrameHashCache::LoadCacheFrame() for one pixel format and cache format.
+ *
+ * Files are read back while still in the OS page cache, so this is the CPU cost of each format. Every byte is touched
+ * like a texture upload would, otherwise mapped raw frames would never be read at all.
+ */
+template <PixelFormat::Format P, FrameHashCache::CacheFormat C>
+void CacheLoad(Benchmark::State &state) {
+  FramePtr frame = CreateTestFrame(P);
+
+  // Not named like a cache frame, so FrameMemoryCache is bypassed
+  QString fn = temp_dir->filePath(QStringLiteral("load"));
+  FrameHashCache::SaveCacheFrame(fn, frame, C);
+
+  std::vector<char> readback(frame->allocated_size());
+
+  state.Measure(
+      [&] {
+        FramePtr loaded = FrameHashCache::LoadCacheFrame(fn);
+        memcpy(readback.data(), loaded->const_data(), std::min<size_t>(readback.size(), loaded->allocated_size()));
+      },
+      FramePayloadBytes(frame), true);
+}
+
+}  // namespace
+
+}  // namespace olive
+
+int main(int argc, char **argv) {
+  QCoreApplication a(argc, argv);
+
+  using namespace olive;
+
+  ColorManager::SetUpDefaultConfig();
+
+  temp_dir = std::make_unique<QTemporaryDir>();
+  if (!temp_dir->isValid()) {
+    fprintf(stderr, "Failed to create temporary directory\n");
+    return 1;
+  }
+
+  Benchmark b;
+
+  b.add("audiovisualwaveform/overwrite_samples", WaveformOverwriteSamples);
+  b.add("audiovisualwaveform/overwrite_samples_hour", WaveformOverwriteSamplesHour);
+  b.add("audiovisualwaveform/overwrite_samples_into", WaveformOverwriteSamplesInto);
+  b.add("nodetraverser/generate_table_chain", TraverserChain);
+  b.add("nodetraverser/generate_table_tree", TraverserTree);
+  b.add("nodetraverser/generate_table_diamond", TraverserDiamond);
+  b.add("node/keyframe_value_at_time", KeyframeValueAtTime);
+  b.add("node/keyframe_values_at_times", KeyframeValuesAtTimes);
+
+  b.add("framehashcache/save/f16/exr", CacheSave<PixelFormat::F16, FrameHashCache::kCacheFormatEXR>);
+  b.add("framehashcache/save/f16/raw", CacheSave<PixelFormat::F16, FrameHashCache::kCacheFormatRaw>);
+  b.add("framehashcache/save/f16/raw_compressed",
+        CacheSave<PixelFormat::F16, FrameHashCache::kCacheFormatRawCompressed>);
+  b.add("framehashcache/save/f32/exr", CacheSave<PixelFormat::F32, FrameHashCache::kCacheFormatEXR>);
+  b.add("framehashcache/save/f32/raw", CacheSave<PixelFormat::F32, FrameHashCache::kCacheFormatRaw>);
+  b.add("framehashcache/save/f32/raw_compressed",
+        CacheSave<PixelFormat::F32, FrameHashCache::kCacheFormatRawCompressed>);
+  b.add("framehashcache/save/u8/jpeg", CacheSave<PixelFormat::U8, FrameHashCache::kCacheFormatEXR>);
+  b.add("framehashcache/save/u8/raw", CacheSave<PixelFormat::U8, FrameHashCache::kCacheFormatRaw>);
+  b.add("framehashcache/save/u8/raw_compressed", CacheSave<PixelFormat::U8, FrameHashCache::kCacheFormatRawCompressed>);
+
+  b.add("framehashcache/load/f16/exr", CacheLoad<PixelFormat::F16, FrameHashCache::kCacheFormatEXR>);
+  b.add("framehashcache/load/f16/raw", CacheLoad<PixelFormat::F16, FrameHashCache::kCacheFormatRaw>);
+  b.add("framehashcache/load/f16/raw_compressed",
+        CacheLoad<PixelFormat::F16, FrameHashCache::kCacheFormatRawCompressed>);
+  b.add("framehashcache/load/f32/exr", CacheLoad<PixelFormat::F32, FrameHashCache::kCacheFormatEXR>);
+  b.add("framehashcache/load/f32/raw", CacheLoad<PixelFormat::F32, FrameHashCache::kCacheFormatRaw>);
+  b.add("framehashcache/load/f32/raw_compressed",
+        CacheLoad<PixelFormat::F32, FrameHashCache::kCacheFormatRawCompressed>);
+  b.add("framehashcache/load/u8/jpeg", CacheLoad<PixelFormat::U8, FrameHashCache::kCacheFormatEXR>);
+  b.add("framehashcache/load/u8/raw", CacheLoad<PixelFormat::U8, FrameHashCache::kCacheFormatRaw>);
+  b.add("framehashcache/load/u8/raw_compressed", CacheLoad<PixelFormat::U8, FrameHashCache::kCacheFormatRawCompressed>);
+
+  int ret = b.exec(argc, argv);
+
+  temp_dir.reset();
+
+  return ret;
+}
@@ -13,6 +13,7 @@ set(Q_HEADERS
         ${CMAKE_SOURCE_DIR}/app/codec/exportformat.h
         ${CMAKE_SOURCE_DIR}/app/codec/ffmpeg/ffmpegdecoder.h
         ${CMAKE_SOURCE_DIR}/app/codec/ffmpeg/ffmpegencoder.h
+        ${CMAKE_SOURCE_DIR}/app/codec/oiio/imagesequencedecoder.h
         ${CMAKE_SOURCE_DIR}/app/codec/oiio/oiiodecoder.h
         ${CMAKE_SOURCE_DIR}/app/codec/oiio/oiioencoder.h
         ${CMAKE_SOURCE_DIR}/app/codec/planarfiledevice.h
@@ -157,6 +158,7 @@ set(Q_HEADERS
         ${CMAKE_SOURCE_DIR}/app/render/framehashcache.h
         ${CMAKE_SOURCE_DIR}/app/render/framemanager.h
         ${CMAKE_SOURCE_DIR}/app/render/opengl/openglrenderer.h
+        ${CMAKE_SOURCE_DIR}/app/render/software/softwarerenderer.h
         ${CMAKE_SOURCE_DIR}/app/render/playbackcache.h
         ${CMAKE_SOURCE_DIR}/app/render/previewaudiodevice.h
         ${CMAKE_SOURCE_DIR}/app/render/previewautocacher.h
@@ -284,6 +286,7 @@ set(Q_HEADERS
         ${CMAKE_SOURCE_DIR}/app/widget/timelinewidget/trackview/trackview.h
         ${CMAKE_SOURCE_DIR}/app/widget/timelinewidget/trackview/trackviewitem.h
         ${CMAKE_SOURCE_DIR}/app/widget/timelinewidget/trackview/trackviewsplitter.h
+        ${CMAKE_SOURCE_DIR}/app/widget/timelinewidget/view/timelinethumbnailcache.h
         ${CMAKE_SOURCE_DIR}/app/widget/timelinewidget/view/timelineview.h
         ${CMAKE_SOURCE_DIR}/app/widget/timeruler/seekablewidget.h
         ${CMAKE_SOURCE_DIR}/app/widget/timeruler/timeruler.h
@@ -161,6 +161,19 @@ class SampleBuffer {
    */
   void transform_volume_for_channel(int channel, float volume);
 
+  /**
+   * @brief 使用逐采样的音量包络对所有声道进行变换。
+   * @param volumes 每个采样对应的音量因子，长度至少为 sample_count()。
+   */
+  void transform_volume(const float* volumes);
+
+  /**
+   * @brief 使用逐采样的音量包络对指定声道进行变换 (使用 SSE/NEON 加速)。
+   * @param channel 目标声道索引。
+   * @param volumes 每个采样对应的音量因子，长度至少为 sample_count()。
+   */
+  void transform_volume_for_channel(int channel, const float* volumes);
+
   /**
    * @brief 对所有声道中指定采样索引处的音量进行变换。
    * @param sample_index 目标采样的索引。
@@ -135,6 +135,31 @@ void SampleBuffer::transform_volume_for_channel(int channel, float volume) {
   }
 }
 
+void SampleBuffer::transform_volume(const float *volumes) {
+  for (int i = 0; i < audio_params().channel_count(); i++) {
+    transform_volume_for_channel(i, volumes);
+  }
+}
+
+void SampleBuffer::transform_volume_for_channel(int channel, const float *volumes) {
+  float *cdat = data_[channel].data();
+  size_t unopt_start = 0;
+
+#if defined(OLIVE_PROCESSOR_X86) || defined(OLIVE_PROCESSOR_ARM)
+  unopt_start = (sample_count_per_channel_ / 4) * 4;
+  for (size_t j = 0; j < unopt_start; j += 4) {
+    float *here = cdat + j;
+    __m128 samples = _mm_loadu_ps(here);
+    __m128 mult = _mm_loadu_ps(volumes + j);
+    _mm_storeu_ps(here, _mm_mul_ps(samples, mult));
+  }
+#endif
+
+  for (size_t j = unopt_start; j < sample_count_per_channel_; j++) {
+    cdat[j] *= volumes[j];
+  }
+}
+
 void SampleBuffer::transform_volume_for_sample(size_t sample_index, float volume) {
   for (int i = 0; i < audio_params().channel_count(); i++) {
     transform_volume_for_sample_on_channel(sample_index, i, volume);
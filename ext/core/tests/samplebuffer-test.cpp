@@ -0,0 +1,66 @@
+#include <cmath>
+
+#include "render/samplebuffer.h"
+#include "util/tests.h"
+
+using namespace olive::core;
+
+bool samplebuffer_volume_envelope_test() {
+  // Use an odd sample count so both the vectorized body and the scalar tail are exercised
+  const size_t count = 11;
+
+  SampleBuffer buf(AudioParams(48000, AV_CH_LAYOUT_STEREO, SampleFormat::F32P), count);
+
+  float envelope[count];
+  for (size_t i = 0; i < count; i++) {
+    buf.data(0)[i] = 1.0f;
+    buf.data(1)[i] = -0.5f;
+    envelope[i] = static_cast<float>(i) * 0.1f;
+  }
+
+  buf.transform_volume(envelope);
+
+  for (size_t i = 0; i < count; i++) {
+    if (std::abs(buf.data(0)[i] - envelope[i]) > 1e-6f) {
+      return false;
+    }
+    if (std::abs(buf.data(1)[i] + 0.5f * envelope[i]) > 1e-6f) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool samplebuffer_volume_envelope_channel_test() {
+  const size_t count = 8;
+
+  SampleBuffer buf(AudioParams(48000, AV_CH_LAYOUT_STEREO, SampleFormat::F32P), count);
+  buf.silence();
+
+  float envelope[count];
+  for (size_t i = 0; i < count; i++) {
+    buf.data(0)[i] = 2.0f;
+    buf.data(1)[i] = 2.0f;
+    envelope[i] = 0.25f;
+  }
+
+  buf.transform_volume_for_channel(1, envelope);
+
+  for (size_t i = 0; i < count; i++) {
+    if (buf.data(0)[i] != 2.0f || buf.data(1)[i] != 0.5f) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main() {
+  Tester t;
+
+  t.add("SampleBuffer::transform_volume(envelope)", samplebuffer_volume_envelope_test);
+  t.add("SampleBuffer::transform_volume_for_channel(envelope)", samplebuffer_volume_envelope_channel_test);
+
+  return t.exec();
+}
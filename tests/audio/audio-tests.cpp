@@ -0,0 +1,146 @@
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <cmath>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+}
+
+#include "audio/audiovisualwaveform.h"
+#include "testutil.h"
+
+namespace olive {
+
+static bool SummariesMatch(const AudioVisualWaveform &a, const AudioVisualWaveform &b, const rational &start,
+                           const rational &length) {
+  AudioVisualWaveform::Sample sa = a.GetSummaryFromTime(start, length);
+  AudioVisualWaveform::Sample sb = b.GetSummaryFromTime(start, length);
+  if (sa.size() != sb.size()) {
+    return false;
+  }
+
+  // Peaks are stored as 16-bit integers
+  const float tolerance = 1.0f / 32767.0f;
+  for (size_t i = 0; i < sa.size(); i++) {
+    if (std::abs(sa[i].min - sb[i].min) > tolerance || std::abs(sa[i].max - sb[i].max) > tolerance) {
+      return false;
+    }
+  }
+  return true;
+}
+
+OLIVE_ADD_TEST(WaveformPeaksRoundTrip)
+{
+  QTemporaryDir dir;
+  OLIVE_ASSERT(dir.isValid());
+
+  const int sample_rate = 48000;
+  AudioParams params(sample_rate, AV_CH_LAYOUT_STEREO, SampleFormat(SampleFormat::F32P));
+  SampleBuffer samples(params, size_t(sample_rate));
+  for (size_t i = 0; i < samples.sample_count(); i++) {
+    samples.data(0)[i] = std::sin(float(i) * 0.01f) * 0.8f;
+    samples.data(1)[i] = float(i % 1000) / 1000.0f - 0.5f;
+  }
+
+  AudioVisualWaveform original;
+  original.set_channel_count(params.channel_count());
+  original.OverwriteSamples(samples, sample_rate);
+
+  QString fn = QDir(dir.path()).filePath(QStringLiteral("test.peaks"));
+  OLIVE_ASSERT(original.SavePeaks(fn));
+
+  AudioVisualWaveform loaded;
+  OLIVE_ASSERT(loaded.LoadPeaks(fn));
+  OLIVE_ASSERT_EQUAL(loaded.channel_count(), original.channel_count());
+  OLIVE_ASSERT(loaded.length() == original.length());
+
+  // Both a coarse and a fine mipmap level
+  OLIVE_ASSERT(SummariesMatch(original, loaded, rational(0), rational(1)));
+  OLIVE_ASSERT(SummariesMatch(original, loaded, rational(1, 4), rational(1, 4)));
+  OLIVE_ASSERT(SummariesMatch(original, loaded, rational(1, 2), rational(1, 512)));
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(WaveformPeaksRejectCorrupt)
+{
+  QTemporaryDir dir;
+  OLIVE_ASSERT(dir.isValid());
+
+  const int sample_rate = 48000;
+  AudioParams params(sample_rate, AV_CH_LAYOUT_STEREO, SampleFormat(SampleFormat::F32P));
+  SampleBuffer samples(params, size_t(sample_rate / 2));
+  for (size_t i = 0; i < samples.sample_count(); i++) {
+    samples.data(0)[i] = 0.5f;
+    samples.data(1)[i] = -0.5f;
+  }
+
+  AudioVisualWaveform original;
+  original.set_channel_count(params.channel_count());
+  original.OverwriteSamples(samples, sample_rate);
+
+  QString fn = QDir(dir.path()).filePath(QStringLiteral("test.peaks"));
+  OLIVE_ASSERT(original.SavePeaks(fn));
+
+  QFile f(fn);
+  OLIVE_ASSERT(f.open(QFile::ReadOnly));
+  QByteArray good = f.readAll();
+  f.close();
+
+  // Writes data over the peak file and tries loading it into a fresh waveform
+  auto load = [&fn](const QByteArray &data, AudioVisualWaveform *w) {
+    QFile out(fn);
+    if (!out.open(QFile::WriteOnly | QFile::Truncate) || out.write(data) != data.size()) {
+      return false;
+    }
+    out.close();
+    return w->LoadPeaks(fn);
+  };
+
+  QByteArray corrupt = good;
+  corrupt[0] = 'X';
+  AudioVisualWaveform bad_magic;
+  OLIVE_ASSERT(!load(corrupt, &bad_magic));
+
+  // Rejected files leave the waveform untouched
+  OLIVE_ASSERT(bad_magic.length() == rational(0));
+  OLIVE_ASSERT_EQUAL(bad_magic.channel_count(), 0);
+
+  corrupt = good;
+  corrupt[4] = char(corrupt[4] + 1);
+  AudioVisualWaveform bad_version;
+  OLIVE_ASSERT(!load(corrupt, &bad_version));
+
+  AudioVisualWaveform truncated;
+  OLIVE_ASSERT(!load(good.left(good.size() - 2), &truncated));
+
+  AudioVisualWaveform no_header;
+  OLIVE_ASSERT(!load(good.left(8), &no_header));
+
+  AudioVisualWaveform trailing;
+  OLIVE_ASSERT(!load(good + QByteArray(4, '\0'), &trailing));
+
+  {
+    // A first level count that wraps back to the real file size once multiplied by the 4 bytes per entry. The count
+    // follows the 32-byte header and the level's rate.
+    const int count_offset = 32 + 8;
+    quint64 count;
+    corrupt = good;
+    memcpy(&count, corrupt.constData() + count_offset, sizeof(count));
+    count += quint64(1) << 62;
+    memcpy(corrupt.data() + count_offset, &count, sizeof(count));
+
+    AudioVisualWaveform wrapped;
+    OLIVE_ASSERT(!load(corrupt, &wrapped));
+  }
+
+  AudioVisualWaveform intact;
+  OLIVE_ASSERT(load(good, &intact));
+  OLIVE_ASSERT(intact.length() == original.length());
+
+  OLIVE_TEST_END;
+}
+
+}  // namespace olive
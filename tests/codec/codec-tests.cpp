@@ -0,0 +1,262 @@
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "codec/boxdownsampler.h"
+#include "codec/ffmpeg/ffmpegkeyframeindex.h"
+#include "testutil.h"
+
+namespace olive {
+
+// Plain average of every source pixel each destination pixel covers, to check the banded SIMD version against
+static double NaiveBoxAverage(const std::vector<double> &src, int src_width, int src_height, int channels,
+                              int dst_width, int dst_height, int x, int y, int c) {
+  int row_begin = int(qint64(y) * src_height / dst_height);
+  int row_end = std::max(row_begin + 1, int(qint64(y + 1) * src_height / dst_height));
+  int col_begin = int(qint64(x) * src_width / dst_width);
+  int col_end = std::max(col_begin + 1, int(qint64(x + 1) * src_width / dst_width));
+
+  double sum = 0;
+  for (int sy = row_begin; sy < row_end; sy++) {
+    for (int sx = col_begin; sx < col_end; sx++) {
+      sum += src[(sy * src_width + sx) * channels + c];
+    }
+  }
+  return sum / ((row_end - row_begin) * (col_end - col_begin));
+}
+
+template <typename T>
+static bool DownsampleMatchesNaive(int src_width, int src_height, int channels, int divider, PixelFormat format,
+                                   double max_value, double tolerance) {
+  // Deterministic, but with no structure that lines up with any box size
+  std::vector<double> values(size_t(src_width) * src_height * channels);
+  quint32 seed = 12345;
+  for (double &v : values) {
+    seed = seed * 1664525u + 1013904223u;
+    v = double(seed >> 8) / double(1 << 24) * max_value;
+    if (std::is_integral<T>::value) {
+      v = std::floor(v);
+    }
+  }
+
+  int src_linesize = Frame::generate_linesize_bytes(src_width, format, channels);
+  std::vector<char> src(size_t(src_linesize) * src_height);
+  for (int y = 0; y < src_height; y++) {
+    T *row = reinterpret_cast<T *>(src.data() + size_t(y) * src_linesize);
+    for (int i = 0; i < src_width * channels; i++) {
+      row[i] = T(values[size_t(y) * src_width * channels + i]);
+    }
+  }
+
+  FramePtr dst = Frame::Create();
+  dst->set_video_params(VideoParams(src_width, src_height, format, channels, rational(1), VideoParams::kInterlaceNone,
+                                    divider));
+  if (!dst->allocate()) {
+    return false;
+  }
+
+  // Fed in uneven bands the way OIIODecoder reads them
+  BoxDownsampler downsampler(src_width, src_height, dst.get());
+  int band_rows = std::max(1, dst->height() / 3);
+  for (int dst_y = 0; dst_y < dst->height(); dst_y += band_rows) {
+    int dst_end = std::min(dst->height(), dst_y + band_rows);
+    int src_begin = downsampler.SourceRowBegin(dst_y);
+    downsampler.Process(src.data() + size_t(src_begin) * src_linesize, src_linesize, src_begin, dst_y, dst_end);
+  }
+
+  for (int y = 0; y < dst->height(); y++) {
+    const T *row = reinterpret_cast<const T *>(dst->data() + size_t(y) * dst->linesize_bytes());
+    for (int x = 0; x < dst->width(); x++) {
+      for (int c = 0; c < channels; c++) {
+        double expected =
+            NaiveBoxAverage(values, src_width, src_height, channels, dst->width(), dst->height(), x, y, c);
+        if (std::abs(double(row[x * channels + c]) - expected) > tolerance) {
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+OLIVE_ADD_TEST(BoxDownsamplerU8)
+{
+  for (int divider : VideoParams::kSupportedDividers) {
+    // Odd sizes so boxes don't all cover the same number of source pixels, and widths past the 16-wide SIMD loop
+    OLIVE_ASSERT((DownsampleMatchesNaive<uint8_t>(101, 57, 4, divider, PixelFormat(PixelFormat::U8), 255, 0.5001)));
+    OLIVE_ASSERT((DownsampleMatchesNaive<uint8_t>(37, 23, 3, divider, PixelFormat(PixelFormat::U8), 255, 0.5001)));
+  }
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(BoxDownsamplerU16)
+{
+  for (int divider : VideoParams::kSupportedDividers) {
+    OLIVE_ASSERT((DownsampleMatchesNaive<uint16_t>(67, 35, 4, divider, PixelFormat(PixelFormat::U16), 65535, 0.6)));
+  }
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(BoxDownsamplerF32)
+{
+  for (int divider : VideoParams::kSupportedDividers) {
+    OLIVE_ASSERT((DownsampleMatchesNaive<float>(101, 57, 4, divider, PixelFormat(PixelFormat::F32), 1, 1e-5)));
+    OLIVE_ASSERT((DownsampleMatchesNaive<float>(37, 23, 3, divider, PixelFormat(PixelFormat::F32), 1, 1e-5)));
+  }
+
+  OLIVE_TEST_END;
+}
+
+// Writes an index file by hand in the layout FFmpegKeyframeIndex::Save() uses
+static bool WriteKeyframeIndex(const QString &filename, quint32 magic, quint32 version, qint32 gop_length,
+                               const std::vector<qint64> &keyframes) {
+  QFile f(filename);
+  if (!f.open(QFile::WriteOnly)) {
+    return false;
+  }
+
+  QDataStream ds(&f);
+  ds << magic << version << gop_length << quint32(keyframes.size());
+  for (qint64 ts : keyframes) {
+    ds << ts;
+  }
+
+  return ds.status() == QDataStream::Ok;
+}
+
+static QByteArray ReadAll(const QString &filename) {
+  QFile f(filename);
+  return f.open(QFile::ReadOnly) ? f.readAll() : QByteArray();
+}
+
+static const quint32 kTestIndexMagic = 0x4F474F50;
+static const quint32 kTestIndexVersion = 1;
+
+OLIVE_ADD_TEST(KeyframeIndexRoundTrip)
+{
+  QTemporaryDir dir;
+  OLIVE_ASSERT(dir.isValid());
+
+  QString written = dir.filePath(QStringLiteral("written.gop"));
+  QString saved = dir.filePath(QStringLiteral("saved.gop"));
+
+  OLIVE_ASSERT(WriteKeyframeIndex(written, kTestIndexMagic, kTestIndexVersion, 48, {12, 60, 108, 170}));
+
+  FFmpegKeyframeIndexPtr index = FFmpegKeyframeIndex::Load(written);
+  OLIVE_ASSERT(index);
+  OLIVE_ASSERT_EQUAL(index->keyframe_count(), 4);
+  OLIVE_ASSERT_EQUAL(index->gop_length(), 48);
+
+  OLIVE_ASSERT(index->Save(saved));
+  OLIVE_ASSERT(ReadAll(saved) == ReadAll(written));
+
+  FFmpegKeyframeIndexPtr reloaded = FFmpegKeyframeIndex::Load(saved);
+  OLIVE_ASSERT(reloaded);
+  OLIVE_ASSERT_EQUAL(reloaded->keyframe_count(), 4);
+  OLIVE_ASSERT_EQUAL(reloaded->gop_length(), 48);
+  for (int64_t ts : {0, 12, 13, 60, 107, 108, 170, 1000}) {
+    OLIVE_ASSERT_EQUAL(reloaded->GetKeyframeAtOrBefore(ts), index->GetKeyframeAtOrBefore(ts));
+    OLIVE_ASSERT_EQUAL(reloaded->GetKeyframeBefore(ts), index->GetKeyframeBefore(ts));
+  }
+
+  // Anything Save() couldn't have written is rejected
+  QString bad = dir.filePath(QStringLiteral("bad.gop"));
+
+  OLIVE_ASSERT(!FFmpegKeyframeIndex::Load(dir.filePath(QStringLiteral("missing.gop"))));
+
+  OLIVE_ASSERT(WriteKeyframeIndex(bad, kTestIndexMagic + 1, kTestIndexVersion, 48, {12, 60}));
+  OLIVE_ASSERT(!FFmpegKeyframeIndex::Load(bad));
+
+  OLIVE_ASSERT(WriteKeyframeIndex(bad, kTestIndexMagic, kTestIndexVersion + 1, 48, {12, 60}));
+  OLIVE_ASSERT(!FFmpegKeyframeIndex::Load(bad));
+
+  OLIVE_ASSERT(WriteKeyframeIndex(bad, kTestIndexMagic, kTestIndexVersion, 0, {12, 60}));
+  OLIVE_ASSERT(!FFmpegKeyframeIndex::Load(bad));
+
+  OLIVE_ASSERT(WriteKeyframeIndex(bad, kTestIndexMagic, kTestIndexVersion, 48, {}));
+  OLIVE_ASSERT(!FFmpegKeyframeIndex::Load(bad));
+
+  OLIVE_ASSERT(WriteKeyframeIndex(bad, kTestIndexMagic, kTestIndexVersion, 48, {60, 12}));
+  OLIVE_ASSERT(!FFmpegKeyframeIndex::Load(bad));
+
+  {
+    QByteArray truncated = ReadAll(written);
+    truncated.chop(3);
+    QFile f(bad);
+    OLIVE_ASSERT(f.open(QFile::WriteOnly));
+    f.write(truncated);
+  }
+  OLIVE_ASSERT(!FFmpegKeyframeIndex::Load(bad));
+
+  {
+    QFile f(bad);
+    OLIVE_ASSERT(f.open(QFile::WriteOnly));
+    f.write(ReadAll(written) + QByteArray(8, '\0'));
+  }
+  OLIVE_ASSERT(!FFmpegKeyframeIndex::Load(bad));
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(KeyframeIndexLookup)
+{
+  QTemporaryDir dir;
+  OLIVE_ASSERT(dir.isValid());
+
+  QString fn = dir.filePath(QStringLiteral("index.gop"));
+  OLIVE_ASSERT(WriteKeyframeIndex(fn, kTestIndexMagic, kTestIndexVersion, 48, {12, 60, 108, 170}));
+
+  FFmpegKeyframeIndexPtr index = FFmpegKeyframeIndex::Load(fn);
+  OLIVE_ASSERT(index);
+
+  // Before the first keyframe both clamp to it
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeAtOrBefore(-100), 12);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeAtOrBefore(11), 12);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeBefore(-100), 12);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeBefore(11), 12);
+  OLIVE_ASSERT(index->IsAtStart(-100));
+  OLIVE_ASSERT(index->IsAtStart(11));
+
+  // Exactly on a keyframe, AtOrBefore returns it and Before the previous one (clamped at the first)
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeAtOrBefore(12), 12);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeBefore(12), 12);
+  OLIVE_ASSERT(index->IsAtStart(12));
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeAtOrBefore(60), 60);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeBefore(60), 12);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeAtOrBefore(170), 170);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeBefore(170), 108);
+
+  // Between keyframes both return the one before
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeAtOrBefore(13), 12);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeBefore(13), 12);
+  OLIVE_ASSERT(!index->IsAtStart(13));
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeAtOrBefore(107), 60);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeBefore(107), 60);
+
+  // After the last keyframe both return it
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeAtOrBefore(171), 170);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeBefore(171), 170);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeAtOrBefore(INT64_MAX), 170);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeBefore(INT64_MAX), 170);
+
+  // A single keyframe has nothing before it
+  OLIVE_ASSERT(WriteKeyframeIndex(fn, kTestIndexMagic, kTestIndexVersion, 1, {0}));
+  index = FFmpegKeyframeIndex::Load(fn);
+  OLIVE_ASSERT(index);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeAtOrBefore(0), 0);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeBefore(0), 0);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeAtOrBefore(500), 0);
+  OLIVE_ASSERT_EQUAL(index->GetKeyframeBefore(500), 0);
+
+  OLIVE_TEST_END;
+}
+
+}  // namespace olive
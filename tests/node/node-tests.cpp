@@ -0,0 +1,223 @@
+#include <olive/core/util/bezier.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "common/lerp.h"
+#include "node/keyframecurve.h"
+#include "node/math/math/math.h"
+#include "node/project.h"
+#include "testutil.h"
+
+namespace olive {
+
+// The old bezier accepted anything within 1e-6 of the right t, the curve is much tighter than that
+static const double kTolerance = 1e-4;
+
+/**
+ * How Node::GetSplitValueAtTimeOnTrack() interpolated before keyframe tracks were compiled into curves, straight from
+ * the keyframes and with Bezier's bisection
+ */
+static double ReferenceValue(const NodeKeyframeTrack &track, double time) {
+  if (time <= track.first()->time().toDouble()) {
+    return track.first()->value().toDouble();
+  }
+  if (time >= track.last()->time().toDouble()) {
+    return track.last()->value().toDouble();
+  }
+
+  int i = 0;
+  while (track.at(i + 1)->time().toDouble() <= time) {
+    i++;
+  }
+
+  const NodeKeyframe *before = track.at(i);
+  const NodeKeyframe *after = track.at(i + 1);
+  double before_time = before->time().toDouble();
+  double before_val = before->value().toDouble();
+  double after_time = after->time().toDouble();
+  double after_val = after->value().toDouble();
+
+  if (before_time == time || before->type() == NodeKeyframe::kHold) {
+    return before_val;
+  }
+
+  if (before->type() == NodeKeyframe::kBezier && after->type() == NodeKeyframe::kBezier) {
+    return Bezier::CubicXtoY(time, Imath::V2d(before_time, before_val),
+                             Imath::V2d(before_time + before->valid_bezier_control_out().x(),
+                                        before_val + before->valid_bezier_control_out().y()),
+                             Imath::V2d(after_time + after->valid_bezier_control_in().x(),
+                                        after_val + after->valid_bezier_control_in().y()),
+                             Imath::V2d(after_time, after_val));
+  } else if (before->type() == NodeKeyframe::kBezier || after->type() == NodeKeyframe::kBezier) {
+    QPointF control = (before->type() == NodeKeyframe::kBezier)
+                          ? before->valid_bezier_control_out() + QPointF(before_time, before_val)
+                          : after->valid_bezier_control_in() + QPointF(after_time, after_val);
+    return Bezier::QuadraticXtoY(time, Imath::V2d(before_time, before_val), Imath::V2d(control.x(), control.y()),
+                                 Imath::V2d(after_time, after_val));
+  } else {
+    return lerp(before_val, after_val, (time - before_time) / (after_time - before_time));
+  }
+}
+
+static NodeKeyframe *AddKeyframe(MathNode *n, const rational &time, double value, NodeKeyframe::Type type,
+                                 const QPointF &control_in = QPointF(), const QPointF &control_out = QPointF()) {
+  auto *key = new NodeKeyframe(time, value, type, 0, -1, MathNode::kParamAIn, n);
+  if (type == NodeKeyframe::kBezier) {
+    key->set_bezier_control_in(control_in);
+    key->set_bezier_control_out(control_out);
+  }
+  return key;
+}
+
+/**
+ * Checks every way of evaluating the node's current curve against the reference: single lookups, a cursor running
+ * forwards and then backwards, the batch fill and the node's own value lookup
+ */
+static bool CurveMatchesReference(MathNode *n) {
+  const NodeKeyframeTrack &track = n->GetKeyframeTracks(MathNode::kParamAIn, -1).at(0);
+  KeyframeCurvePtr curve = n->GetKeyframeCurve(MathNode::kParamAIn, 0);
+  if (!curve || curve->GetKeyframeCount() != track.size()) {
+    return false;
+  }
+
+  // From before the first keyframe to after the last, and exactly on every keyframe
+  std::vector<double> times;
+  double first = track.first()->time().toDouble();
+  double last = track.last()->time().toDouble();
+  // Stepped by index rather than accumulated so a time meant to land on a keyframe does so exactly
+  for (int i = 0; first - 1.0 + double(i) / 48.0 <= last + 1.0; i++) {
+    times.push_back(first - 1.0 + double(i) / 48.0);
+  }
+  for (NodeKeyframe *key : track) {
+    times.push_back(key->time().toDouble());
+  }
+  std::sort(times.begin(), times.end());
+
+  KeyframeCurve::Cursor forwards(curve.get());
+  for (double t : times) {
+    double expected = ReferenceValue(track, t);
+
+    if (std::abs(curve->ValueAt(t) - expected) > kTolerance || std::abs(forwards.ValueAt(t) - expected) > kTolerance ||
+        std::abs(n->GetValueAtTime(MathNode::kParamAIn, rational::fromDouble(t)).toDouble() - expected) > kTolerance) {
+      return false;
+    }
+  }
+
+  KeyframeCurve::Cursor backwards(curve.get());
+  for (auto it = times.rbegin(); it != times.rend(); it++) {
+    if (std::abs(backwards.ValueAt(*it) - ReferenceValue(track, *it)) > kTolerance) {
+      return false;
+    }
+  }
+
+  const double step = 1.0 / 480.0;
+  std::vector<double> batch(size_t((last - first + 2.0) / step));
+  curve->ValuesAt(first - 1.0, step, batch.data(), batch.size());
+  for (size_t i = 0; i < batch.size(); i++) {
+    if (std::abs(batch[i] - ReferenceValue(track, first - 1.0 + step * double(i))) > kTolerance) {
+      return false;
+    }
+  }
+
+  // Values exactly on a keyframe are that keyframe's and nothing interpolated
+  for (int i = 0; i < track.size(); i++) {
+    int held_key;
+    double v = curve->ValueAt(track.at(i)->time().toDouble(), &held_key);
+    if (held_key != i || v != track.at(i)->value().toDouble()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+OLIVE_ADD_TEST(KeyframeCurveInterpolation)
+{
+  Project project;
+
+  auto *n = new MathNode();
+  n->setParent(&project);
+  n->SetInputIsKeyframing(MathNode::kParamAIn, true);
+
+  // Every pairing: linear to linear, linear to bezier (quadratic), bezier to bezier (cubic), bezier to linear
+  // (quadratic), hold, and an overshooting bezier whose control points pull it past both values
+  AddKeyframe(n, rational(0), 0.0, NodeKeyframe::kLinear);
+  AddKeyframe(n, rational(1), 10.0, NodeKeyframe::kLinear);
+  AddKeyframe(n, rational(2), -5.0, NodeKeyframe::kBezier, QPointF(-0.5, 0.0), QPointF(0.3, 8.0));
+  AddKeyframe(n, rational(7, 2), 3.0, NodeKeyframe::kBezier, QPointF(-0.2, -4.0), QPointF(0.5, 2.0));
+  AddKeyframe(n, rational(4), 1.0, NodeKeyframe::kLinear);
+  AddKeyframe(n, rational(5), 6.0, NodeKeyframe::kHold);
+  AddKeyframe(n, rational(6), -2.0, NodeKeyframe::kBezier, QPointF(-0.4, 0.0), QPointF(0.4, 20.0));
+  AddKeyframe(n, rational(13, 2), 4.0, NodeKeyframe::kBezier, QPointF(-0.4, -20.0), QPointF(0.4, 0.0));
+
+  OLIVE_ASSERT(CurveMatchesReference(n));
+
+  // A single keyframe holds its value everywhere
+  auto *single = new MathNode();
+  single->setParent(&project);
+  single->SetInputIsKeyframing(MathNode::kParamAIn, true);
+  AddKeyframe(single, rational(3), 2.5, NodeKeyframe::kBezier);
+
+  KeyframeCurvePtr single_curve = single->GetKeyframeCurve(MathNode::kParamAIn, 0);
+  OLIVE_ASSERT(single_curve->IsConstant());
+  OLIVE_ASSERT(single_curve->ValueAt(-100.0) == 2.5);
+  OLIVE_ASSERT(single_curve->ValueAt(3.0) == 2.5);
+  OLIVE_ASSERT(single_curve->ValueAt(100.0) == 2.5);
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(KeyframeCurveInvalidation)
+{
+  Project project;
+
+  auto *n = new MathNode();
+  n->setParent(&project);
+  n->SetInputIsKeyframing(MathNode::kParamAIn, true);
+
+  NodeKeyframe *a = AddKeyframe(n, rational(0), 0.0, NodeKeyframe::kLinear);
+  NodeKeyframe *b = AddKeyframe(n, rational(2), 4.0, NodeKeyframe::kLinear);
+  NodeKeyframe *c = AddKeyframe(n, rational(4), 0.0, NodeKeyframe::kLinear);
+
+  KeyframeCurvePtr original = n->GetKeyframeCurve(MathNode::kParamAIn, 0);
+  OLIVE_ASSERT(CurveMatchesReference(n));
+  OLIVE_ASSERT(std::abs(original->ValueAt(1.0) - 2.0) < kTolerance);
+
+  // Each kind of edit has to drop the compiled curve
+  b->set_value(8.0);
+  OLIVE_ASSERT(CurveMatchesReference(n));
+  OLIVE_ASSERT(std::abs(n->GetKeyframeCurve(MathNode::kParamAIn, 0)->ValueAt(1.0) - 4.0) < kTolerance);
+
+  b->set_time(rational(1));
+  OLIVE_ASSERT(CurveMatchesReference(n));
+
+  a->set_type(NodeKeyframe::kHold);
+  OLIVE_ASSERT(CurveMatchesReference(n));
+  OLIVE_ASSERT(n->GetKeyframeCurve(MathNode::kParamAIn, 0)->ValueAt(0.5) == 0.0);
+
+  b->set_type(NodeKeyframe::kBezier);
+  c->set_type(NodeKeyframe::kBezier);
+  OLIVE_ASSERT(CurveMatchesReference(n));
+
+  b->set_bezier_control_out(QPointF(1.0, 6.0));
+  OLIVE_ASSERT(CurveMatchesReference(n));
+
+  c->set_bezier_control_in(QPointF(-1.0, -3.0));
+  OLIVE_ASSERT(CurveMatchesReference(n));
+
+  AddKeyframe(n, rational(3), -2.0, NodeKeyframe::kLinear);
+  OLIVE_ASSERT(CurveMatchesReference(n));
+
+  c->setParent(nullptr);
+  delete c;
+  OLIVE_ASSERT(CurveMatchesReference(n));
+
+  // Curves already handed out are immutable, so a render still using one isn't affected by the edits
+  OLIVE_ASSERT_EQUAL(original->GetKeyframeCount(), 3);
+  OLIVE_ASSERT(std::abs(original->ValueAt(1.0) - 2.0) < kTolerance);
+
+  OLIVE_TEST_END;
+}
+
+}  // namespace olive
@@ -0,0 +1,131 @@
+#include <QDir>
+#include <QTemporaryDir>
+
+#include "node/color/colormanager/colormanager.h"
+#include "node/factory.h"
+#include "node/project.h"
+#include "node/project/sequence/sequence.h"
+#include "node/project/serializer/recoveryjournal.h"
+#include "node/project/serializer/serializer.h"
+#include "testutil.h"
+
+namespace olive {
+
+static Sequence *FindSequence(Project *project) {
+  for (Node *n : project->nodes()) {
+    if (auto *s = dynamic_cast<Sequence *>(n)) {
+      return s;
+    }
+  }
+  return nullptr;
+}
+
+OLIVE_ADD_TEST(RecoveryJournalReplay)
+{
+  ColorManager::SetUpDefaultConfig();
+  NodeFactory::Initialize();
+  ProjectSerializer::Initialize();
+
+  QTemporaryDir dir;
+  OLIVE_ASSERT(dir.isValid());
+
+  Project project;
+  project.Initialize();
+
+  auto *sequence = new Sequence();
+  sequence->setParent(&project);
+
+  {
+    RecoveryJournal journal(&project, dir.path());
+
+    // Nothing changed yet, so nothing to write
+    OLIVE_ASSERT(!journal.Flush());
+
+    // The first change writes a snapshot that already contains it
+    auto *first = new TimelineMarker(1, TimeRange(0, 1), QStringLiteral("first"));
+    first->setParent(sequence->GetMarkers());
+    OLIVE_ASSERT(journal.Flush());
+
+    // These only exist in the journal
+    auto *second = new TimelineMarker(2, TimeRange(2, 3), QStringLiteral("second"));
+    second->setParent(sequence->GetMarkers());
+    OLIVE_ASSERT(journal.Flush());
+
+    first->set_name(QStringLiteral("renamed"));
+    sequence->GetWorkArea()->set_enabled(true);
+    sequence->GetWorkArea()->set_range(TimeRange(1, 2));
+    OLIVE_ASSERT(journal.Flush());
+
+    // Destroying the journal waits for its writes
+  }
+
+  QStringList snapshots = QDir(dir.path()).entryList({QStringLiteral("*") + RecoveryJournal::kSnapshotExtension});
+  OLIVE_ASSERT_EQUAL(snapshots.size(), 1);
+
+  QString snapshot = QDir(dir.path()).filePath(snapshots.first());
+  QString journal = RecoveryJournal::GetJournalFilename(snapshot);
+  QString replayed = QDir(dir.path()).filePath(QStringLiteral("replayed.ove"));
+
+  {
+    // The snapshot alone has been through Graph::Write() and loads on its own
+    Project loaded;
+    OLIVE_ASSERT(ProjectSerializer::Load(&loaded, snapshot, ProjectSerializer::kProject).code() ==
+                 ProjectSerializer::kSuccess);
+    OLIVE_ASSERT(loaded.GetUuid() == project.GetUuid());
+
+    Sequence *s = FindSequence(&loaded);
+    OLIVE_ASSERT(s);
+    OLIVE_ASSERT_EQUAL(s->GetMarkers()->size(), 1);
+    OLIVE_ASSERT(!s->GetWorkArea()->enabled());
+  }
+
+  // Graph::Load() of the snapshot, the journal's records, then Graph::Write()
+  OLIVE_ASSERT(RecoveryJournal::Replay(journal, replayed));
+
+  {
+    Project loaded;
+    OLIVE_ASSERT(ProjectSerializer::Load(&loaded, replayed, ProjectSerializer::kProject).code() ==
+                 ProjectSerializer::kSuccess);
+    OLIVE_ASSERT(loaded.GetUuid() == project.GetUuid());
+    OLIVE_ASSERT_EQUAL(loaded.nodes().size(), project.nodes().size());
+
+    Sequence *s = FindSequence(&loaded);
+    OLIVE_ASSERT(s);
+    OLIVE_ASSERT_EQUAL(s->GetMarkers()->size(), 2);
+
+    bool found_renamed = false;
+    bool found_second = false;
+    for (TimelineMarker *m : *s->GetMarkers()) {
+      found_renamed |= (m->name() == QStringLiteral("renamed") && m->time() == TimeRange(0, 1));
+      found_second |= (m->name() == QStringLiteral("second") && m->time() == TimeRange(2, 3));
+    }
+    OLIVE_ASSERT(found_renamed);
+    OLIVE_ASSERT(found_second);
+
+    OLIVE_ASSERT(s->GetWorkArea()->enabled());
+    OLIVE_ASSERT(s->GetWorkArea()->range() == TimeRange(1, 2));
+  }
+
+  {
+    // A record torn off by a crash is dropped, the ones before it still apply
+    QFile f(journal);
+    OLIVE_ASSERT(f.open(QFile::ReadWrite));
+    OLIVE_ASSERT(f.resize(f.size() - 3));
+    f.close();
+
+    OLIVE_ASSERT(RecoveryJournal::Replay(journal, replayed));
+
+    Project loaded;
+    OLIVE_ASSERT(ProjectSerializer::Load(&loaded, replayed, ProjectSerializer::kProject).code() ==
+                 ProjectSerializer::kSuccess);
+
+    Sequence *s = FindSequence(&loaded);
+    OLIVE_ASSERT(s);
+    OLIVE_ASSERT_EQUAL(s->GetMarkers()->size(), 2);
+    OLIVE_ASSERT(!s->GetWorkArea()->enabled());
+  }
+
+  OLIVE_TEST_END;
+}
+
+}  // namespace olive
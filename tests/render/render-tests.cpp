@@ -0,0 +1,470 @@
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QMatrix4x4>
+#include <QSet>
+#include <QTemporaryDir>
+#include <cmath>
+#include <vector>
+
+#include "common/filefunctions.h"
+#include "common/ocioutils.h"
+#include "render/colorprocessor.h"
+#include "render/diskmanager.h"
+#include "render/job/colortransformjob.h"
+#include "render/job/shaderjob.h"
+#include "render/software/softwarerenderer.h"
+#include "testutil.h"
+
+namespace olive {
+
+static bool WriteCacheFile(const QString &filename, int size) {
+  QFile f(filename);
+  return f.open(QFile::WriteOnly) && f.write(QByteArray(size, 'x')) == size;
+}
+
+// Returns every file the folder has indexed, clearing it in the process
+static QSet<QString> TakeIndexedFiles(DiskCacheFolder *folder) {
+  QSet<QString> files;
+  QMetaObject::Connection connection =
+      QObject::connect(folder, &DiskCacheFolder::DeletedFrame,
+                       [&files](const QString &, const QString &filename) { files.insert(filename); });
+  folder->ClearCache();
+
+  // files doesn't outlive this function, but the folder may emit again (e.g. clearing on close)
+  QObject::disconnect(connection);
+  return files;
+}
+
+OLIVE_ADD_TEST(DiskCacheJournalReplay)
+{
+  QTemporaryDir dir;
+  OLIVE_ASSERT(dir.isValid());
+
+  QDir cache_dir(dir.path());
+  OLIVE_ASSERT(cache_dir.mkpath(QStringLiteral("frames")));
+
+  QString a = cache_dir.filePath(QStringLiteral("frames/a"));
+  QString b = cache_dir.filePath(QStringLiteral("frames/b"));
+  QString c = cache_dir.filePath(QStringLiteral("frames/c"));
+  QString d = cache_dir.filePath(QStringLiteral("frames/d"));
+  OLIVE_ASSERT(WriteCacheFile(a, 100));
+  OLIVE_ASSERT(WriteCacheFile(b, 200));
+  OLIVE_ASSERT(WriteCacheFile(c, 300));
+  OLIVE_ASSERT(WriteCacheFile(d, 400));
+
+  {
+    // Closing writes a snapshot with a and b and no journal
+    DiskCacheFolder folder(dir.path());
+    folder.CreatedFile(a);
+    folder.CreatedFile(b);
+  }
+
+  QString index = cache_dir.filePath(QStringLiteral("index"));
+  QString journal = cache_dir.filePath(QStringLiteral("index.journal"));
+  OLIVE_ASSERT(QFile::exists(index));
+  OLIVE_ASSERT(!QFile::exists(journal));
+
+  {
+    // What a session that crashed before compacting leaves behind: c added and a removed after the snapshot, then d
+    // torn off half way through its record
+    QByteArray records;
+    QDataStream ds(&records, QIODevice::WriteOnly);
+    ds << quint8(0) << c << qint64(300) << qint64(1);
+    ds << quint8(1) << a;
+
+    QByteArray torn;
+    QDataStream torn_ds(&torn, QIODevice::WriteOnly);
+    torn_ds << quint8(0) << d << qint64(400) << qint64(2);
+
+    QFile f(journal);
+    OLIVE_ASSERT(f.open(QFile::WriteOnly));
+    OLIVE_ASSERT(f.write(records) == records.size());
+    OLIVE_ASSERT(f.write(torn.left(torn.size() - 3)) == torn.size() - 3);
+  }
+
+  // An eviction that was renamed but not deleted yet, and an unrelated file that merely looks like one
+  QString doomed = cache_dir.filePath(QStringLiteral("frames/e.olive-evicted.1"));
+  QString bystander = cache_dir.filePath(QStringLiteral("notes.deleted.txt"));
+  OLIVE_ASSERT(WriteCacheFile(doomed, 10));
+  OLIVE_ASSERT(WriteCacheFile(bystander, 10));
+
+  {
+    DiskCacheFolder folder(dir.path());
+
+    // a is still on disk, so it's only missing because the journal removed it
+    QSet<QString> expected = {b, c};
+    OLIVE_ASSERT(TakeIndexedFiles(&folder) == expected);
+
+    // Clearing waits for the background deletions, including the sweep
+    OLIVE_ASSERT(!QFile::exists(doomed));
+    OLIVE_ASSERT(QFile::exists(bystander));
+  }
+
+  // The clean close compacted everything into the snapshot
+  OLIVE_ASSERT(!QFile::exists(journal));
+
+  {
+    OLIVE_ASSERT(WriteCacheFile(b, 200));
+    OLIVE_ASSERT(WriteCacheFile(c, 300));
+
+    DiskCacheFolder folder(dir.path());
+    OLIVE_ASSERT(TakeIndexedFiles(&folder).isEmpty());
+  }
+
+  OLIVE_TEST_END;
+}
+
+static TexturePtr CreateFloatTexture(Renderer *renderer, int width, int height, int channels,
+                                     const std::vector<float> &pixels) {
+  return renderer->CreateTexture(VideoParams(width, height, PixelFormat(PixelFormat::F32), channels), pixels.data());
+}
+
+static std::vector<float> DownloadPixels(SoftwareRenderer *renderer, const TexturePtr &texture) {
+  VideoParams p = texture->params();
+  p.set_format(PixelFormat(PixelFormat::F32));
+  p.set_channel_count(VideoParams::kRGBAChannelCount);
+
+  std::vector<float> pixels(size_t(p.effective_width()) * p.effective_height() * VideoParams::kRGBAChannelCount);
+  renderer->DownloadFromTexture(texture->id(), p, pixels.data(), p.effective_width());
+  return pixels;
+}
+
+static bool PixelEquals(const std::vector<float> &pixels, int width, int x, int y, const float *expected,
+                        float tolerance = 1e-5f) {
+  const float *px = pixels.data() + (size_t(y) * width + x) * VideoParams::kRGBAChannelCount;
+  for (int c = 0; c < VideoParams::kRGBAChannelCount; c++) {
+    if (std::abs(px[c] - expected[c]) > tolerance) {
+      std::cout << " - pixel " << x << "," << y << " channel " << c << " is " << px[c] << ", expected "
+                << expected[c];
+      return false;
+    }
+  }
+  return true;
+}
+
+static QVariant CreateKernel(SoftwareRenderer *renderer, const QString &resource) {
+  return renderer->CreateNativeShader(ShaderCode(FileFunctions::ReadFileAsString(resource)));
+}
+
+static NodeValue TextureValue(const TexturePtr &texture) {
+  return NodeValue(NodeValue::kTexture, QVariant::fromValue(texture));
+}
+
+OLIVE_ADD_TEST(SoftwareBlendKernels)
+{
+  SoftwareRenderer renderer;
+  OLIVE_ASSERT(renderer.Init());
+
+  // Odd width so the SIMD loops have a remainder
+  const int w = 5, h = 3;
+  const VideoParams params(w, h, PixelFormat(PixelFormat::F32), VideoParams::kRGBAChannelCount);
+
+  // Opaque base, premultiplied blend whose alpha ramps from 0 to 1 across the row
+  std::vector<float> base, blend;
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      float a = x / 4.0f;
+      base.insert(base.end(), {x / 8.0f, y / 4.0f, 0.5f, 1.0f});
+      blend.insert(blend.end(), {0.2f * a, 0.8f * a, 0.4f * a, a});
+    }
+  }
+
+  TexturePtr base_tex = CreateFloatTexture(&renderer, w, h, VideoParams::kRGBAChannelCount, base);
+  TexturePtr blend_tex = CreateFloatTexture(&renderer, w, h, VideoParams::kRGBAChannelCount, blend);
+  TexturePtr dst = renderer.CreateTexture(params);
+
+  {
+    QVariant shader = CreateKernel(&renderer, QStringLiteral(":/shaders/alphaover.frag"));
+    OLIVE_ASSERT(!shader.isNull());
+
+    ShaderJob job;
+    job.Insert(QStringLiteral("base_in"), TextureValue(base_tex));
+    job.Insert(QStringLiteral("blend_in"), TextureValue(blend_tex));
+    renderer.BlitToTexture(shader, job, dst.get());
+
+    std::vector<float> result = DownloadPixels(&renderer, dst);
+
+    // Fully transparent blend leaves the base, fully opaque replaces it
+    const float transparent[] = {0.0f, 0.5f, 0.5f, 1.0f};
+    const float opaque[] = {0.2f, 0.8f, 0.4f, 1.0f};
+    OLIVE_ASSERT(PixelEquals(result, w, 0, 2, transparent));
+    OLIVE_ASSERT(PixelEquals(result, w, 4, 2, opaque));
+
+    // Half way: base * 0.5 + blend
+    const float half[] = {0.25f * 0.5f + 0.1f, 0.25f * 0.5f + 0.4f, 0.5f * 0.5f + 0.2f, 1.0f};
+    OLIVE_ASSERT(PixelEquals(result, w, 2, 1, half));
+
+    for (int y = 0; y < h; y++) {
+      for (int x = 0; x < w; x++) {
+        const float *b = base.data() + (y * w + x) * 4;
+        const float *f = blend.data() + (y * w + x) * 4;
+        const float expected[] = {b[0] * (1 - f[3]) + f[0], b[1] * (1 - f[3]) + f[1], b[2] * (1 - f[3]) + f[2],
+                                  b[3] * (1 - f[3]) + f[3]};
+        OLIVE_ASSERT(PixelEquals(result, w, x, y, expected));
+      }
+    }
+  }
+
+  {
+    QVariant shader = CreateKernel(&renderer, QStringLiteral(":/shaders/opacity.frag"));
+    OLIVE_ASSERT(!shader.isNull());
+
+    ShaderJob job;
+    job.Insert(QStringLiteral("tex_in"), TextureValue(base_tex));
+    job.Insert(QStringLiteral("opacity_in"), NodeValue(NodeValue::kFloat, 0.25));
+    renderer.BlitToTexture(shader, job, dst.get());
+
+    std::vector<float> result = DownloadPixels(&renderer, dst);
+
+    // Premultiplied, so every channel including alpha is scaled
+    const float expected[] = {0.5f * 0.25f, 0.25f * 0.25f, 0.5f * 0.25f, 0.25f};
+    OLIVE_ASSERT(PixelEquals(result, w, 4, 1, expected));
+  }
+
+  {
+    QVariant shader = CreateKernel(&renderer, QStringLiteral(":/shaders/crossdissolve.frag"));
+    OLIVE_ASSERT(!shader.isNull());
+
+    // Linear, then squared curve
+    for (int curve : {0, 1}) {
+      ShaderJob job;
+      job.Insert(QStringLiteral("out_block_in"), TextureValue(base_tex));
+      job.Insert(QStringLiteral("in_block_in"), TextureValue(blend_tex));
+      job.Insert(QStringLiteral("curve_in"), NodeValue(NodeValue::kInt, curve));
+      job.Insert(QStringLiteral("ove_tprog_all"), NodeValue(NodeValue::kFloat, 0.25));
+      renderer.BlitToTexture(shader, job, dst.get());
+
+      std::vector<float> result = DownloadPixels(&renderer, dst);
+
+      float out_weight = (curve == 0) ? 0.75f : 0.5625f;
+      float in_weight = (curve == 0) ? 0.25f : 0.0625f;
+
+      // Base (0.5, 0.25, 0.5, 1) and blend (0.2, 0.8, 0.4, 1) at x = 4, y = 1
+      const float expected[] = {0.5f * out_weight + 0.2f * in_weight, 0.25f * out_weight + 0.8f * in_weight,
+                                0.5f * out_weight + 0.4f * in_weight, out_weight + in_weight};
+      OLIVE_ASSERT(PixelEquals(result, w, 4, 1, expected));
+    }
+  }
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(SoftwareTransformKernel)
+{
+  SoftwareRenderer renderer;
+  OLIVE_ASSERT(renderer.Init());
+
+  // Every texel is distinct, so each destination pixel shows exactly which one it sampled
+  const int size = 4;
+  std::vector<float> source;
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      source.insert(source.end(), {x / 4.0f, y / 4.0f, 0.5f, 1.0f});
+    }
+  }
+
+  TexturePtr src = CreateFloatTexture(&renderer, size, size, VideoParams::kRGBAChannelCount, source);
+  TexturePtr dst = renderer.CreateTexture(
+      VideoParams(size, size, PixelFormat(PixelFormat::F32), VideoParams::kRGBAChannelCount));
+
+  auto blit = [&](const QMatrix4x4 &matrix) {
+    ShaderJob job;
+    job.Insert(QStringLiteral("ove_maintex"), TextureValue(src));
+    job.Insert(QStringLiteral("ove_mvpmat"), NodeValue(NodeValue::kMatrix, matrix));
+    job.SetInterpolation(QStringLiteral("ove_maintex"), Texture::kNearest);
+    renderer.BlitToTexture(renderer.GetDefaultShader(), job, dst.get());
+    return DownloadPixels(&renderer, dst);
+  };
+
+  auto texel = [](int x, int y) {
+    return std::vector<float>{x / 4.0f, y / 4.0f, 0.5f, 1.0f};
+  };
+
+  const float cleared[] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+  {
+    // Half size: the quad covers the middle 2x2 pixels, sampling every other texel, and the rest stays clear
+    QMatrix4x4 m;
+    m.scale(0.5f, 0.5f);
+    std::vector<float> result = blit(m);
+
+    OLIVE_ASSERT(PixelEquals(result, size, 1, 1, texel(1, 1).data()));
+    OLIVE_ASSERT(PixelEquals(result, size, 2, 1, texel(3, 1).data()));
+    OLIVE_ASSERT(PixelEquals(result, size, 1, 2, texel(1, 3).data()));
+    OLIVE_ASSERT(PixelEquals(result, size, 2, 2, texel(3, 3).data()));
+    OLIVE_ASSERT(PixelEquals(result, size, 0, 0, cleared));
+    OLIVE_ASSERT(PixelEquals(result, size, 3, 2, cleared));
+    OLIVE_ASSERT(PixelEquals(result, size, 2, 3, cleared));
+  }
+
+  {
+    // Half the NDC width is one pixel to the right
+    QMatrix4x4 m;
+    m.translate(0.5f, 0.0f);
+    std::vector<float> result = blit(m);
+
+    for (int y = 0; y < size; y++) {
+      OLIVE_ASSERT(PixelEquals(result, size, 0, y, cleared));
+      for (int x = 1; x < size; x++) {
+        OLIVE_ASSERT(PixelEquals(result, size, x, y, texel(x - 1, y).data()));
+      }
+    }
+  }
+
+  {
+    // Mirrored horizontally
+    QMatrix4x4 m;
+    m.scale(-1.0f, 1.0f);
+    std::vector<float> result = blit(m);
+
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        OLIVE_ASSERT(PixelEquals(result, size, x, y, texel(size - 1 - x, y).data()));
+      }
+    }
+  }
+
+  {
+    // Untransformed upscale with bilinear filtering, clamped at the edges like GL_CLAMP_TO_EDGE
+    TexturePtr ramp = CreateFloatTexture(&renderer, 2, 1, VideoParams::kRGBAChannelCount,
+                                         {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f});
+    TexturePtr wide = renderer.CreateTexture(
+        VideoParams(4, 1, PixelFormat(PixelFormat::F32), VideoParams::kRGBAChannelCount));
+
+    ShaderJob job;
+    job.Insert(QStringLiteral("ove_maintex"), TextureValue(ramp));
+    job.Insert(QStringLiteral("ove_mvpmat"), NodeValue(NodeValue::kMatrix, QMatrix4x4()));
+    job.SetInterpolation(QStringLiteral("ove_maintex"), Texture::kLinear);
+    renderer.BlitToTexture(renderer.GetDefaultShader(), job, wide.get());
+
+    std::vector<float> result = DownloadPixels(&renderer, wide);
+
+    const float expected[][4] = {{0.0f, 0.0f, 0.0f, 1.0f},
+                                 {0.25f, 0.25f, 0.25f, 1.0f},
+                                 {0.75f, 0.75f, 0.75f, 1.0f},
+                                 {1.0f, 1.0f, 1.0f, 1.0f}};
+    for (int x = 0; x < 4; x++) {
+      OLIVE_ASSERT(PixelEquals(result, 4, x, 0, expected[x]));
+    }
+  }
+
+  OLIVE_TEST_END;
+}
+
+OLIVE_ADD_TEST(SoftwareColorKernels)
+{
+  SoftwareRenderer renderer;
+  OLIVE_ASSERT(renderer.Init());
+
+  {
+    QVariant shader = CreateKernel(&renderer, QStringLiteral(":/shaders/yuv2rgb.frag"));
+    OLIVE_ASSERT(!shader.isNull());
+
+    // BT.709 coefficients as FFmpegDecoder passes them (ffmpeg's table divided by 65536)
+    auto yuv_job = [&](const TexturePtr &y, const TexturePtr &u, const TexturePtr &v, int bits, bool full_range) {
+      ShaderJob job;
+      job.Insert(QStringLiteral("y_channel"), TextureValue(y));
+      job.Insert(QStringLiteral("u_channel"), TextureValue(u));
+      job.Insert(QStringLiteral("v_channel"), TextureValue(v));
+      job.Insert(QStringLiteral("bits_per_pixel"), NodeValue(NodeValue::kInt, bits));
+      job.Insert(QStringLiteral("full_range"), NodeValue(NodeValue::kBoolean, full_range));
+      job.Insert(QStringLiteral("yuv_crv"), NodeValue(NodeValue::kFloat, 1.7927));
+      job.Insert(QStringLiteral("yuv_cgu"), NodeValue(NodeValue::kFloat, 0.2132));
+      job.Insert(QStringLiteral("yuv_cgv"), NodeValue(NodeValue::kFloat, 0.5329));
+      job.Insert(QStringLiteral("yuv_cbu"), NodeValue(NodeValue::kFloat, 2.1124));
+      return job;
+    };
+
+    const float neutral = 128.0f / 255.0f;
+
+    // Limited range black, white, and mid grey with some red difference
+    TexturePtr y = CreateFloatTexture(&renderer, 3, 1, 1, {16.0f / 255.0f, 235.0f / 255.0f, 0.5f});
+    TexturePtr u = CreateFloatTexture(&renderer, 3, 1, 1, {neutral, neutral, neutral});
+    TexturePtr v = CreateFloatTexture(&renderer, 3, 1, 1, {neutral, neutral, neutral + 0.1f});
+    TexturePtr dst = renderer.CreateTexture(VideoParams(3, 1, PixelFormat(PixelFormat::F32),
+                                                        VideoParams::kRGBAChannelCount));
+
+    renderer.BlitToTexture(shader, yuv_job(y, u, v, 8, false), dst.get());
+    std::vector<float> result = DownloadPixels(&renderer, dst);
+
+    const float black[] = {0.0f, 0.0f, 0.0f, 1.0f};
+    const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    const float reddish[] = {0.68865f, 0.45609f, 0.50938f, 1.0f};
+    OLIVE_ASSERT(PixelEquals(result, 3, 0, 0, black, 1e-3f));
+    OLIVE_ASSERT(PixelEquals(result, 3, 1, 0, white, 1e-3f));
+    OLIVE_ASSERT(PixelEquals(result, 3, 2, 0, reddish, 1e-4f));
+
+    // Full range passes luma straight through
+    TexturePtr grey = CreateFloatTexture(&renderer, 3, 1, 1, {0.0f, 0.5f, 1.0f});
+    renderer.BlitToTexture(shader, yuv_job(grey, u, u, 8, true), dst.get());
+    result = DownloadPixels(&renderer, dst);
+
+    for (int x = 0; x < 3; x++) {
+      const float expected[] = {x * 0.5f, x * 0.5f, x * 0.5f, 1.0f};
+      OLIVE_ASSERT(PixelEquals(result, 3, x, 0, expected, 1e-4f));
+    }
+
+    // 10-bit samples arrive in 16-bit containers and are rescaled, with the chroma midpoint at 512
+    const float ten_bit = 512.0f / 65535.0f;
+    TexturePtr y10 = CreateFloatTexture(&renderer, 3, 1, 1, {ten_bit, ten_bit, ten_bit});
+    renderer.BlitToTexture(shader, yuv_job(y10, y10, y10, 10, true), dst.get());
+    result = DownloadPixels(&renderer, dst);
+
+    const float mid[] = {512.0f / 1023.0f, 512.0f / 1023.0f, 512.0f / 1023.0f, 1.0f};
+    OLIVE_ASSERT(PixelEquals(result, 3, 0, 0, mid, 1e-4f));
+  }
+
+  {
+    // A plain gamma of 2 through OCIO's CPU processor, leaving alpha alone
+    OCIO::ExponentTransformRcPtr exponent = OCIO::ExponentTransform::Create();
+    const double value[4] = {2.0, 2.0, 2.0, 1.0};
+    exponent->setValue(value);
+    ColorProcessorPtr processor = ColorProcessor::Create(OCIO::Config::CreateRaw()->getProcessor(exponent));
+
+    TexturePtr src = CreateFloatTexture(&renderer, 3, 1, VideoParams::kRGBAChannelCount,
+                                        {0.5f, 0.25f, 1.0f, 1.0f, 0.25f, 0.25f, 0.25f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f});
+    TexturePtr dst = renderer.CreateTexture(VideoParams(3, 1, PixelFormat(PixelFormat::F32),
+                                                        VideoParams::kRGBAChannelCount));
+
+    auto convert = [&](AlphaAssociated alpha, bool force_opaque) {
+      ColorTransformJob job;
+      job.SetColorProcessor(processor);
+      job.SetInputTexture(src);
+      job.SetInputAlphaAssociation(alpha);
+      job.SetForceOpaque(force_opaque);
+      renderer.BlitColorManaged(job, dst.get());
+      return DownloadPixels(&renderer, dst);
+    };
+
+    {
+      std::vector<float> result = convert(kAlphaNone, false);
+      const float expected[] = {0.25f, 0.0625f, 1.0f, 1.0f};
+      OLIVE_ASSERT(PixelEquals(result, 3, 0, 0, expected, 1e-4f));
+    }
+
+    {
+      // Premultiplied 0.25 at alpha 0.5 is unpremultiplied to 0.5 before the transform and premultiplied after
+      std::vector<float> result = convert(kAlphaAssociated, false);
+      const float expected[] = {0.125f, 0.125f, 0.125f, 0.5f};
+      OLIVE_ASSERT(PixelEquals(result, 3, 1, 0, expected, 1e-4f));
+    }
+
+    {
+      // Straight alpha is only multiplied in afterwards
+      std::vector<float> result = convert(kAlphaUnassociated, false);
+      const float expected[] = {0.125f, 0.125f, 0.125f, 0.5f};
+      OLIVE_ASSERT(PixelEquals(result, 3, 2, 0, expected, 1e-4f));
+    }
+
+    {
+      std::vector<float> result = convert(kAlphaUnassociated, true);
+      const float expected[] = {0.125f, 0.125f, 0.125f, 1.0f};
+      OLIVE_ASSERT(PixelEquals(result, 3, 2, 0, expected, 1e-4f));
+    }
+  }
+
+  OLIVE_TEST_END;
+}
+
+}  // namespace olive
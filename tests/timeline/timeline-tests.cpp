@@ -581,4 +581,57 @@ OLIVE_ADD_TEST(InsertGaps_SingleTrack)
   OLIVE_TEST_END;
 }
 
+OLIVE_ADD_TEST(BlockLookup)
+{
+  TIMELINE_TEST_START;
+
+  sequence.add_default_nodes();
+
+  Track *track = sequence.GetTracks().first();
+
+  // A: 0 - 1, B: 1 - 3, C: 3 - 4
+  ClipBlock *a = new ClipBlock();
+  a->set_length_and_media_out(rational(1));
+  a->setParent(&project);
+  track->AppendBlock(a);
+
+  ClipBlock *b = new ClipBlock();
+  b->set_length_and_media_out(rational(2));
+  b->setParent(&project);
+  track->AppendBlock(b);
+
+  ClipBlock *c = new ClipBlock();
+  c->set_length_and_media_out(rational(1));
+  c->setParent(&project);
+  track->AppendBlock(c);
+
+  OLIVE_ASSERT(track->NearestBlockBeforeOrAt(rational(0)) == a);
+  OLIVE_ASSERT(track->NearestBlockBeforeOrAt(rational(1)) == b);
+  OLIVE_ASSERT(track->NearestBlockBeforeOrAt(rational(2)) == b);
+  OLIVE_ASSERT(track->NearestBlockBeforeOrAt(rational(4)) == nullptr);
+
+  OLIVE_ASSERT(track->NearestBlockBefore(rational(0)) == nullptr);
+  OLIVE_ASSERT(track->NearestBlockBefore(rational(1)) == a);
+  OLIVE_ASSERT(track->NearestBlockBefore(rational(2)) == b);
+  OLIVE_ASSERT(track->NearestBlockBefore(rational(3)) == b);
+
+  OLIVE_ASSERT(track->NearestBlockAfterOrAt(rational(1)) == b);
+  OLIVE_ASSERT(track->NearestBlockAfterOrAt(rational(2)) == c);
+  OLIVE_ASSERT(track->NearestBlockAfterOrAt(rational(5)) == nullptr);
+
+  OLIVE_ASSERT(track->NearestBlockAfter(rational(0)) == b);
+  OLIVE_ASSERT(track->NearestBlockAfter(rational(1)) == c);
+  OLIVE_ASSERT(track->NearestBlockAfter(rational(3)) == nullptr);
+
+  OLIVE_ASSERT(track->BlockContainingTime(rational(1, 2)) == a);
+  OLIVE_ASSERT(track->BlockContainingTime(rational(1)) == nullptr);
+  OLIVE_ASSERT(track->BlockContainingTime(rational(2)) == b);
+  OLIVE_ASSERT(track->BlockContainingTime(rational(4)) == nullptr);
+
+  OLIVE_ASSERT(track->VisibleBlockAtTime(rational(1)) == b);
+  OLIVE_ASSERT(track->VisibleBlockAtTime(rational(4)) == nullptr);
+
+  OLIVE_TEST_END;
+}
+
 }